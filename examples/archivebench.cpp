@@ -0,0 +1,158 @@
+#include "../include/wheel_core_archive.h"
+
+#include <iostream>
+#include <vector>
+#include <chrono>
+
+// Encodes and decodes records like the cache metadata of the resource
+// system, hand-packed at fixed widths with buffer_t::write and with
+// wheel::archive, and reports the size and millions of records per second.
+
+namespace
+{
+   const size_t count = 1000000;
+
+   struct entry_t
+   {
+      uint64_t             hash;
+      uint32_t             size;
+      uint32_t             offset;
+      int32_t              mtime_delta;
+      uint16_t             format;
+      std::vector<uint32_t> dependencies;
+
+      WHEEL_SERIALIZE(hash, size, offset, mtime_delta, format, dependencies)
+   };
+
+   uint64_t state = 0x9e3779b97f4a7c15ull;
+
+   inline uint64_t next()
+   {
+      state ^= state << 13;
+      state ^= state >> 7;
+      state ^= state << 17;
+
+      return state;
+   }
+
+   std::vector<entry_t> make_entries()
+   {
+      std::vector<entry_t> entries(count);
+      uint32_t offset = 0;
+
+      for (entry_t& e : entries)
+      {
+         e.hash = next();
+         e.size = next() % 100000;
+         e.offset = offset;
+         e.mtime_delta = (int32_t)(next() % 2000) - 1000;
+         e.format = next() % 16;
+
+         offset += e.size;
+
+         for (size_t i = next() % 4; i > 0; --i)
+            e.dependencies.push_back(next() % 5000);
+      }
+
+      return entries;
+   }
+
+   void pack(wheel::buffer_t& out, const entry_t& e)
+   {
+      out.write(e.hash);
+      out.write(e.size);
+      out.write(e.offset);
+      out.write(e.mtime_delta);
+      out.write(e.format);
+      out.write((uint32_t)e.dependencies.size());
+      out.write_span(e.dependencies.data(), e.dependencies.size());
+   }
+
+   void unpack(wheel::buffer_t& in, entry_t& e)
+   {
+      e.hash = in.read<uint64_t>();
+      e.size = in.read<uint32_t>();
+      e.offset = in.read<uint32_t>();
+      e.mtime_delta = in.read<int32_t>();
+      e.format = in.read<uint16_t>();
+      e.dependencies.resize(in.read<uint32_t>());
+
+      for (uint32_t& d : e.dependencies)
+         d = in.read<uint32_t>();
+   }
+
+   uint64_t sink = 0;
+
+   template <typename F>
+   double time(F work)
+   {
+      auto start = std::chrono::steady_clock::now();
+
+      sink += work();
+
+      return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+   }
+
+   void report(const char* name, size_t bytes, double encode, double decode)
+   {
+      std::cout << name << "\t" << bytes << "\t" << (double)count / encode / 1e6 << "\t" << (double)count / decode / 1e6 << "\n";
+   }
+}
+
+int main(void)
+{
+   std::vector<entry_t> entries = make_entries();
+   std::vector<entry_t> decoded(count);
+
+   std::cout << "\t\tbytes\t\tencode M/s\tdecode M/s\n";
+
+   {
+      wheel::buffer_t data;
+
+      double encode = time([&]()
+      {
+         for (const entry_t& e : entries)
+            pack(data, e);
+
+         return data.size();
+      });
+
+      double decode = time([&]()
+      {
+         for (entry_t& e : decoded)
+            unpack(data, e);
+
+         return decoded.back().hash;
+      });
+
+      report("fixed width", data.size(), encode, decode);
+   }
+
+   {
+      wheel::buffer_t data;
+
+      double encode = time([&]()
+      {
+         wheel::archive_writer out(data);
+
+         for (const entry_t& e : entries)
+            out.field(e);
+
+         return data.size();
+      });
+
+      double decode = time([&]()
+      {
+         wheel::archive_reader in(data);
+
+         for (entry_t& e : decoded)
+            in.field(e);
+
+         return in.status() == WHEEL_OK ? decoded.back().hash : 0;
+      });
+
+      report("archive\t", data.size(), encode, decode);
+   }
+
+   return sink == 0;
+}
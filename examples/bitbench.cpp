@@ -0,0 +1,166 @@
+#include "../include/wheel_core_bitstream.h"
+
+#include <iostream>
+#include <vector>
+#include <chrono>
+
+// Writes and reads streams of bit fields of fixed and of mixed widths, in
+// both bit orders, and reports millions of fields and megabytes per second.
+// The mixed widths go from 1 to 16 bits, like the codes of Huffman coded
+// formats.  A plain reader that takes one bit at a time is the baseline.
+
+namespace
+{
+   const size_t count = 4000000;
+
+   uint64_t state = 0x9e3779b97f4a7c15ull;
+
+   inline uint64_t next()
+   {
+      state ^= state << 13;
+      state ^= state >> 7;
+      state ^= state << 17;
+
+      return state;
+   }
+
+   struct field_t
+   {
+      uint64_t value;
+      uint32_t width;
+   };
+
+   std::vector<field_t> make_fields(uint32_t width)
+   {
+      std::vector<field_t> fields(count);
+
+      for (field_t& f : fields)
+      {
+         f.width = width ? width : 1 + next() % 16;
+         f.value = next() >> (64 - f.width);
+      }
+
+      return fields;
+   }
+
+   //! One bit at a time, most significant first
+   uint64_t read_bitwise(const wheel::buffer_t& data, size_t& position, uint32_t n)
+   {
+      uint64_t rval = 0;
+
+      for (uint32_t i = 0; i < n; ++i, ++position)
+         rval = (rval << 1) | ((data[position >> 3] >> (7 - (position & 7))) & 1);
+
+      return rval;
+   }
+
+   uint64_t sink = 0;
+
+   template <typename F>
+   void report(const char* name, size_t bytes, F work)
+   {
+      auto start = std::chrono::steady_clock::now();
+
+      sink += work();
+
+      double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+      std::cout << name << "\t" << (double)count / secs / 1e6 << "\t" << (double)bytes / secs / 1e6 << "\n";
+   }
+
+   template <wheel::bit_order_t Order>
+   void run(const char* order, const std::vector<field_t>& fields, const char* widths)
+   {
+      wheel::buffer_t data;
+      size_t bytes = 0;
+
+      for (const field_t& f : fields)
+         bytes += f.width;
+
+      bytes /= 8;
+      data.reserve(bytes + 8);
+
+      std::cout << order << ", " << widths << "\n";
+
+      report("  write", bytes, [&]()
+      {
+         data.clear();
+         wheel::bit_writer<Order> out(data);
+
+         for (const field_t& f : fields)
+            out.write(f.value, f.width);
+
+         out.flush();
+
+         return data.size();
+      });
+
+      report("  read", bytes, [&]()
+      {
+         wheel::bit_reader<Order> in(data);
+         uint64_t sum = 0;
+
+         for (const field_t& f : fields)
+            sum += in.read(f.width);
+
+         return sum;
+      });
+
+      report("  refill", bytes, [&]()
+      {
+         // One refill covers three fields of up to 16 bits
+         wheel::bit_reader<Order> in(data);
+         uint64_t sum = 0;
+         size_t i = 0;
+
+         for (; i + 3 <= fields.size() && fields[i].width <= 16; i += 3)
+         {
+            in.refill();
+
+            sum += in.peek(fields[i].width);
+            in.consume(fields[i].width);
+            sum += in.peek(fields[i + 1].width);
+            in.consume(fields[i + 1].width);
+            sum += in.peek(fields[i + 2].width);
+            in.consume(fields[i + 2].width);
+         }
+
+         for (; i < fields.size(); ++i)
+            sum += in.read(fields[i].width);
+
+         return sum;
+      });
+
+      if (Order == wheel::WHEEL_MSB_FIRST)
+      {
+         report("  bitwise", bytes, [&]()
+         {
+            size_t position = 0;
+            uint64_t sum = 0;
+
+            for (const field_t& f : fields)
+               sum += read_bitwise(data, position, f.width);
+
+            return sum;
+         });
+      }
+   }
+}
+
+int main(void)
+{
+   std::cout << "\t\tmillions of fields/s\tMB/s\n";
+
+   static const uint32_t widths[] = { 1, 5, 13, 0, 32 };
+
+   for (uint32_t width : widths)
+   {
+      std::vector<field_t> fields = make_fields(width);
+      std::string name = width ? std::to_string(width) + " bits" : "1 to 16 bits";
+
+      run<wheel::WHEEL_LSB_FIRST>("LSB first", fields, name.c_str());
+      run<wheel::WHEEL_MSB_FIRST>("MSB first", fields, name.c_str());
+   }
+
+   return sink == 0;
+}
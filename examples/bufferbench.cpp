@@ -0,0 +1,138 @@
+#include "../include/wheel_core_string.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+
+// Serialises integers, arrays and strings into a buffer_t, the way buffer_t
+// used to write them and with the current write paths, and reports the
+// throughput and how many times the buffer was reallocated.
+
+namespace
+{
+   // What write<T>() used to do, reserve the exact size and push byte by byte
+   template <typename T>
+   void old_write(wheel::buffer_t& out, const T& value)
+   {
+      out.reserve(out.size() + sizeof(T));
+
+      const uint8_t* bytes = (const uint8_t*)&value;
+
+      for (size_t i = 0; i < sizeof(T); ++i)
+         out.push_back(bytes[i]);
+   }
+
+   void old_write_string(wheel::buffer_t& out, const wheel::string& s)
+   {
+      std::string actual = s.std_str();
+      out.reserve(out.size() + actual.size());
+
+      for (auto c : actual)
+         out.push_back(c);
+   }
+
+   size_t sink = 0;
+
+   //! Fills a new buffer with f, reports MB/s and reallocations
+   template <typename F>
+   void report(const char* name, size_t rounds, F fill)
+   {
+      size_t bytes = 0;
+      size_t reallocations = 0;
+
+      auto start = std::chrono::steady_clock::now();
+
+      for (size_t r = 0; r < rounds; ++r)
+      {
+         wheel::buffer_t out;
+         reallocations = fill(out);
+
+         bytes += out.size();
+         sink += out.back();
+      }
+
+      double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+      std::cout << name << "\t" << (double)bytes / secs / (1024.0 * 1024.0) << "\t" << reallocations << "\n";
+   }
+
+   //! Calls write for each of count values, counting the reallocations
+   template <typename W>
+   size_t count_reallocations(wheel::buffer_t& out, size_t count, W write)
+   {
+      size_t reallocations = 0;
+      size_t capacity = out.capacity();
+
+      for (size_t i = 0; i < count; ++i)
+      {
+         write(out, i);
+
+         if (out.capacity() != capacity)
+         {
+            capacity = out.capacity();
+            ++reallocations;
+         }
+      }
+
+      return reallocations;
+   }
+}
+
+int main(void)
+{
+   const size_t count = 20000;
+   const size_t rounds = 200;
+
+   // Reallocating for every value is quadratic, fewer rounds are enough
+   const size_t old_rounds = 4;
+
+   std::vector<uint32_t> values(count);
+   std::vector<wheel::string> names;
+
+   for (size_t i = 0; i < count; ++i)
+   {
+      values[i] = (uint32_t)(i * 2654435761u);
+      names.push_back(wheel::string(("textures/props/crate_" + std::to_string(i) + ".png").c_str()));
+   }
+
+   std::cout << count << " values per buffer\n";
+   std::cout << "write\t\t\tMB/s\treallocations\n";
+
+   report("old write<uint32_t>", old_rounds, [&](wheel::buffer_t& out)
+   {
+      return count_reallocations(out, count, [&](wheel::buffer_t& b, size_t i) { old_write<uint32_t>(b, values[i]); });
+   });
+
+   report("write<uint32_t>\t", rounds, [&](wheel::buffer_t& out)
+   {
+      return count_reallocations(out, count, [&](wheel::buffer_t& b, size_t i) { b.write<uint32_t>(values[i]); });
+   });
+
+   report("old write<uint64_t>", old_rounds, [&](wheel::buffer_t& out)
+   {
+      return count_reallocations(out, count, [&](wheel::buffer_t& b, size_t i) { old_write<uint64_t>(b, values[i]); });
+   });
+
+   report("write<uint64_t>\t", rounds, [&](wheel::buffer_t& out)
+   {
+      return count_reallocations(out, count, [&](wheel::buffer_t& b, size_t i) { b.write<uint64_t>(values[i]); });
+   });
+
+   report("write_span<uint32_t>", rounds, [&](wheel::buffer_t& out)
+   {
+      return count_reallocations(out, count / 100, [&](wheel::buffer_t& b, size_t i) { b.write_span(&values[i * 100], 100); });
+   });
+
+   report("old write<string>", old_rounds, [&](wheel::buffer_t& out)
+   {
+      return count_reallocations(out, count, [&](wheel::buffer_t& b, size_t i) { old_write_string(b, names[i]); });
+   });
+
+   report("write<string>\t", rounds, [&](wheel::buffer_t& out)
+   {
+      return count_reallocations(out, count, [&](wheel::buffer_t& b, size_t i) { b.write(names[i]); });
+   });
+
+   return sink == 0;
+}
@@ -0,0 +1,85 @@
+#include "../include/wheel_core_utility.h"
+
+#include <iostream>
+#include <vector>
+#include <chrono>
+
+// Computes CRC32 over buffers of a few sizes with every method the CPU
+// supports and reports GB/s.  The small buffers are the size of typical
+// PNG chunks, where the setup of the wide methods is not paid back; the
+// large one shows their peak.  crc32_combine is timed last.
+
+namespace
+{
+   const size_t total = 256 * 1024 * 1024;
+
+   struct method_t
+   {
+      wheel::internal::crc32_method_t  method;
+      const char*                      name;
+   };
+
+   const method_t methods[] =
+   {
+      { wheel::internal::WHEEL_CRC32_BYTEWISE,  "bytewise" },
+      { wheel::internal::WHEEL_CRC32_SLICE8,    "slice-by-8" },
+      { wheel::internal::WHEEL_CRC32_SLICE16,   "slice-by-16" },
+      { wheel::internal::WHEEL_CRC32_PCLMUL,    "pclmul" },
+      { wheel::internal::WHEEL_CRC32_ARMV8,     "armv8" },
+   };
+
+   uint32_t sink = 0;
+
+   void run(const std::vector<uint8_t>& data, size_t size)
+   {
+      std::cout << size << " bytes\n";
+
+      for (const method_t& m : methods)
+      {
+         if (!wheel::internal::crc32_supported(m.method))
+            continue;
+
+         size_t rounds = total / size;
+
+         auto start = std::chrono::steady_clock::now();
+
+         for (size_t i = 0; i < rounds; ++i)
+            sink += wheel::internal::update_crc(m.method, 0xffffffff, data.data() + (i & 63), size);
+
+         double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+         std::cout << "  " << m.name << "\t" << (double)(rounds * size) / secs / 1e9 << "\n";
+      }
+   }
+}
+
+int main(void)
+{
+   static const size_t sizes[] = { 16, 64, 1024, 64 * 1024, 4 * 1024 * 1024 };
+
+   std::vector<uint8_t> data(4 * 1024 * 1024 + 64);
+   uint32_t state = 0x12345678;
+
+   for (uint8_t& byte : data)
+   {
+      state = state * 1103515245 + 12345;
+      byte = state >> 23;
+   }
+
+   std::cout << "\tGB/s\n";
+
+   for (size_t size : sizes)
+      run(data, size);
+
+   const size_t combines = 1000000;
+   auto start = std::chrono::steady_clock::now();
+
+   for (size_t i = 0; i < combines; ++i)
+      sink += wheel::crc32_combine(sink, (uint32_t)i, 1 + i * 4099);
+
+   double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+   std::cout << "crc32_combine\t" << secs / combines * 1e9 << " ns\n";
+
+   return sink == 0;
+}
@@ -0,0 +1,137 @@
+#include "../include/wheel_core_flat_map.h"
+#include "../include/wheel_core_hash.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <unordered_map>
+
+// Compares std::unordered_map and wheel::flat_map keyed by asset names, at
+// the sizes wheel's registries have: a few shaders, a library of a thousand
+// resources and a large file cache.  Reports nanoseconds per operation for
+// filling the map, finding names that are in it and names that are not, and
+// per entry for iterating over it.
+
+namespace
+{
+   typedef wheel::fast_hash<wheel::string> name_hash;
+
+   std::vector<wheel::string> asset_names(size_t count, const char* dir)
+   {
+      std::vector<wheel::string> rval;
+
+      for (size_t n = 0; n < count; ++n)
+         rval.push_back(wheel::string((std::string(dir) + "/props/crate_" + std::to_string(n) + ".png").c_str()));
+
+      return rval;
+   }
+
+   size_t sink = 0;
+
+   struct timer
+   {
+      std::chrono::steady_clock::time_point start;
+
+      timer() : start(std::chrono::steady_clock::now()) {}
+
+      double ns_per(size_t ops) const
+      {
+         return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1e9 / (double)ops;
+      }
+   };
+
+   template <typename Map>
+   void report(const char* name, const std::vector<wheel::string>& names, const std::vector<wheel::string>& missing)
+   {
+      const size_t rounds = 4000000 / names.size() + 1;
+
+      // Fill
+      timer t;
+
+      for (size_t r = 0; r < rounds / 8 + 1; ++r)
+      {
+         Map map;
+
+         for (size_t i = 0; i < names.size(); ++i)
+            map[names[i]] = i;
+
+         sink += map.size();
+      }
+
+      double fill = t.ns_per((rounds / 8 + 1) * names.size());
+
+      Map map;
+
+      for (size_t i = 0; i < names.size(); ++i)
+         map[names[i]] = i;
+
+      // Hits
+      t = timer();
+
+      for (size_t r = 0; r < rounds; ++r)
+         for (const wheel::string& s : names)
+            sink += map.find(s)->second;
+
+      double hit = t.ns_per(rounds * names.size());
+
+      // Misses
+      t = timer();
+
+      for (size_t r = 0; r < rounds; ++r)
+         for (const wheel::string& s : missing)
+            sink += map.find(s) == map.end();
+
+      double miss = t.ns_per(rounds * missing.size());
+
+      // Iteration
+      t = timer();
+
+      for (size_t r = 0; r < rounds; ++r)
+         for (auto& entry : map)
+            sink += entry.second;
+
+      double iterate = t.ns_per(rounds * names.size());
+
+      std::cout << name << "\t" << fill << "\t" << hit << "\t" << miss << "\t" << iterate << "\n";
+   }
+
+   // Lookups with a view of a literal, which std::unordered_map cannot do without a string
+   void report_views(const std::vector<wheel::string>& names)
+   {
+      const size_t rounds = 4000000 / names.size() + 1;
+
+      std::vector<wheel::string_ref> views(names.begin(), names.end());
+      wheel::flat_map<wheel::string, size_t, name_hash> map;
+
+      for (size_t i = 0; i < names.size(); ++i)
+         map[names[i]] = i;
+
+      timer t;
+
+      for (size_t r = 0; r < rounds; ++r)
+         for (const wheel::string_ref& s : views)
+            sink += map.find(s)->second;
+
+      std::cout << "flat_map string_ref\t\t" << t.ns_per(rounds * views.size()) << "\n";
+   }
+}
+
+int main(void)
+{
+   std::cout << "map\t\t\tfill\thit\tmiss\titerate\t(ns per op)\n";
+
+   for (size_t count = 64; count <= 16384; count *= 16)
+   {
+      std::vector<wheel::string> names = asset_names(count, "textures");
+      std::vector<wheel::string> missing = asset_names(count, "sounds");
+
+      std::cout << "-- " << count << " names\n";
+
+      report<std::unordered_map<wheel::string, size_t, name_hash>>("unordered_map\t", names, missing);
+      report<wheel::flat_map<wheel::string, size_t, name_hash>>("flat_map\t", names, missing);
+      report_views(names);
+   }
+
+   return sink == 0;
+}
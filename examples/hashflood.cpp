@@ -0,0 +1,117 @@
+#include "../include/wheel_core_string.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <unordered_map>
+
+// Fills hash maps with asset names crafted so that their unseeded FNV-1a
+// hashes all land in the same bucket, like a malicious archive could, and
+// compares the lookup time to ordinary names.  With unseeded FNV-1a the
+// cost per lookup grows with the number of names, with the seeded
+// Hash<string> it stays flat.  The library must be built with
+// WHEEL_SEEDED_HASH for that, otherwise both show the same growth.
+
+namespace
+{
+   // Hash<string> without a seed
+   struct unseeded_fnv1a
+   {
+      size_t operator()(const wheel::string& s) const
+      {
+         uint64_t hash = 0xCBF29CE484222325;
+
+         for (size_t i = 0; i < s.length(); ++i)
+         {
+            uint32_t c = s[i];
+
+            hash = (hash ^ (c & 0xff)) * 0x100000001B3;
+            hash = (hash ^ ((c >> 8) & 0xff)) * 0x100000001B3;
+            hash = (hash ^ ((c >> 16) & 0xff)) * 0x100000001B3;
+            hash = (hash ^ (c >> 24)) * 0x100000001B3;
+         }
+
+         return hash;
+      }
+   };
+
+   wheel::string asset_name(size_t n)
+   {
+      return wheel::string(("textures/props/crate_" + std::to_string(n) + ".png").c_str());
+   }
+
+   //! Names whose unseeded hashes share bucket 0 of a table with the given bucket count
+   std::vector<wheel::string> crafted_names(size_t count, size_t buckets)
+   {
+      std::vector<wheel::string> rval;
+      unseeded_fnv1a fnv;
+
+      for (size_t n = 0; rval.size() < count; ++n)
+      {
+         wheel::string name = asset_name(n);
+
+         if (fnv(name) % buckets == 0)
+            rval.push_back(name);
+      }
+
+      return rval;
+   }
+
+   std::vector<wheel::string> ordinary_names(size_t count)
+   {
+      std::vector<wheel::string> rval;
+
+      for (size_t n = 0; n < count; ++n)
+         rval.push_back(asset_name(n));
+
+      return rval;
+   }
+
+   size_t sink = 0;
+
+   //! Nanoseconds per lookup after filling a map with the names
+   template <typename H>
+   double lookup_ns(const std::vector<wheel::string>& names)
+   {
+      std::unordered_map<wheel::string, size_t, H> map;
+      map.reserve(names.size());
+
+      for (size_t i = 0; i < names.size(); ++i)
+         map[names[i]] = i;
+
+      const size_t rounds = 2000000 / names.size() + 1;
+      auto start = std::chrono::steady_clock::now();
+
+      for (size_t r = 0; r < rounds; ++r)
+         for (const wheel::string& s : names)
+            sink += map.find(s)->second;
+
+      double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      return secs * 1e9 / (double)(rounds * names.size());
+   }
+}
+
+int main(void)
+{
+   std::cout << "hash seed: " << (wheel::hash_seed() ? "random" : "none (deterministic)") << "\n";
+   std::cout << "names\tfnv ordinary\tfnv crafted\tseeded ordinary\tseeded crafted\t(ns per lookup)\n";
+
+   for (size_t count = 250; count <= 4000; count *= 2)
+   {
+      // The bucket count the maps will have after reserve()
+      std::unordered_map<wheel::string, size_t> probe;
+      probe.reserve(count);
+
+      std::vector<wheel::string> ordinary = ordinary_names(count);
+      std::vector<wheel::string> crafted = crafted_names(count, probe.bucket_count());
+
+      std::cout << count << "\t"
+                << lookup_ns<unseeded_fnv1a>(ordinary) << "\t\t"
+                << lookup_ns<unseeded_fnv1a>(crafted) << "\t\t"
+                << lookup_ns<wheel::Hash<wheel::string>>(ordinary) << "\t\t"
+                << lookup_ns<wheel::Hash<wheel::string>>(crafted) << "\n";
+   }
+
+   return sink == 0;
+}
@@ -0,0 +1,86 @@
+#include "../include/wheel_core_perfect_hash.h"
+#include "../include/wheel_core_flat_map.h"
+#include "../include/wheel_core_hash.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <unordered_map>
+
+// Looks up the names of a fixed manifest in a perfect hash index and in the
+// dynamic maps, in nanoseconds per lookup, for names that are in the
+// manifest and names that are not.
+
+namespace
+{
+   typedef wheel::fast_hash<wheel::string> name_hash;
+
+   std::vector<wheel::string> asset_names(size_t count, const char* dir)
+   {
+      std::vector<wheel::string> rval;
+
+      for (size_t n = 0; n < count; ++n)
+         rval.push_back(wheel::string((std::string(dir) + "/props/crate_" + std::to_string(n) + ".png").c_str()));
+
+      return rval;
+   }
+
+   size_t sink = 0;
+
+   template <typename F>
+   double ns_per_lookup(const std::vector<wheel::string>& names, F find)
+   {
+      const size_t rounds = 4000000 / names.size() + 1;
+      auto start = std::chrono::steady_clock::now();
+
+      for (size_t r = 0; r < rounds; ++r)
+         for (const wheel::string& s : names)
+            sink += find(s);
+
+      double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      return secs * 1e9 / (double)(rounds * names.size());
+   }
+}
+
+int main(void)
+{
+   std::cout << "names\tbuild ms\tblob\t\tperfect hit/miss\tflat_map hit/miss\tunordered_map hit/miss\t(ns)\n";
+
+   for (size_t count = 64; count <= 65536; count *= 16)
+   {
+      std::vector<wheel::string> names = asset_names(count, "textures");
+      std::vector<wheel::string> missing = asset_names(count, "sounds");
+
+      wheel::buffer_t blob;
+      auto start = std::chrono::steady_clock::now();
+
+      if (wheel::build_perfect_index(names, blob) != WHEEL_OK)
+         return 1;
+
+      double build_ms = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1000.0;
+
+      wheel::perfect_index index;
+      index.assign(blob.data(), blob.size());
+
+      wheel::flat_map<wheel::string, size_t, name_hash> flat;
+      std::unordered_map<wheel::string, size_t, name_hash> unordered;
+
+      for (size_t i = 0; i < names.size(); ++i)
+      {
+         flat[names[i]] = i;
+         unordered[names[i]] = i;
+      }
+
+      auto perfect_find = [&](const wheel::string& s) { return index.find(s); };
+      auto flat_find = [&](const wheel::string& s) { return flat.find(s) != flat.end(); };
+      auto unordered_find = [&](const wheel::string& s) { return unordered.find(s) != unordered.end(); };
+
+      std::cout << count << "\t" << build_ms << "\t\t" << blob.size() << "\t\t"
+                << ns_per_lookup(names, perfect_find) << " / " << ns_per_lookup(missing, perfect_find) << "\t\t"
+                << ns_per_lookup(names, flat_find) << " / " << ns_per_lookup(missing, flat_find) << "\t\t"
+                << ns_per_lookup(names, unordered_find) << " / " << ns_per_lookup(missing, unordered_find) << "\n";
+   }
+
+   return sink == 0;
+}
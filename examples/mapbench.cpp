@@ -0,0 +1,90 @@
+#include "../include/wheel_core_resource.h"
+
+#include <iostream>
+#include <fstream>
+#include <chrono>
+
+// Reads a large file through the resource system in full and through a
+// mapping, touching every 64th page of it, and reports the time and how
+// much the resident set grew.
+//
+//    mapbench assets textures/terrain.png
+//
+// For cold-start numbers, drop the page cache before each run.
+
+namespace
+{
+   //! Resident set size in kilobytes, 0 where /proc is not available
+   size_t resident_kb()
+   {
+      std::ifstream statm("/proc/self/statm");
+      size_t pages = 0, resident = 0;
+
+      statm >> pages >> resident;
+
+      return resident * 4;
+   }
+
+   size_t sink = 0;
+
+   //! Times read, which returns the resident set size while it still holds the file
+   template <typename F>
+   void report(const char* name, F read)
+   {
+      size_t rss = resident_kb();
+      auto start = std::chrono::steady_clock::now();
+
+      size_t peak = read();
+
+      double ms = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1000.0;
+
+      std::cout << name << "\t" << ms << " ms\t+" << (peak - rss) << " kB resident\n";
+   }
+}
+
+int main(int argc, char* argv[])
+{
+   if (argc != 3)
+   {
+      std::cerr << "usage: " << argv[0] << " directory file\n";
+      return 1;
+   }
+
+   if (wheel::Filesystem_Init(argc, argv) != WHEEL_OK || wheel::AddToPath(argv[1], "/") != WHEEL_OK)
+   {
+      std::cerr << "cannot mount " << argv[1] << "\n";
+      return 1;
+   }
+
+   wheel::string file(argv[2]);
+   const size_t stride = 64 * 4096;
+
+   report("GetFile", [&]()
+   {
+      wheel::buffer_t data = wheel::GetFile(file);
+
+      for (size_t i = 0; i < data.size(); i += stride)
+         sink += data[i];
+
+      return resident_kb();
+   });
+
+   report("MapFile", [&]()
+   {
+      wheel::mapped_buffer data;
+
+      if (wheel::MapFile(file, data, wheel::WHEEL_ADVICE_RANDOM) != WHEEL_OK)
+         return resident_kb();
+
+      for (size_t i = 0; i < data.size(); i += stride)
+         sink += data[i];
+
+      std::cout << (data.is_mapped() ? "mapped" : "read, not mapped") << ", " << data.size() << " bytes\n";
+
+      return resident_kb();
+   });
+
+   wheel::Filesystem_Deinit();
+
+   return sink == 0;
+}
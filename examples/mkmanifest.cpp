@@ -0,0 +1,113 @@
+#include "../include/wheel_core_perfect_hash.h"
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cctype>
+
+// Builds the perfect hash index of a resource manifest at build time.  The
+// manifest lists one name per line, in UTF-8.
+//
+//    mkmanifest assets.txt assets.idx                 blob to ship as a file
+//    mkmanifest assets.txt assets_manifest.h assets   header with an array
+//
+// The header defines assets_data, to be given to perfect_index::assign().
+// Positions in the index are the line numbers of the names, counting from
+// zero and skipping empty lines.
+
+namespace
+{
+   bool write_blob(const char* path, const wheel::buffer_t& blob)
+   {
+      std::ofstream out(path, std::ios::binary);
+      out.write((const char*)blob.data(), blob.size());
+
+      return (bool)out;
+   }
+
+   bool write_header(const char* path, const char* source, const std::string& name, const wheel::buffer_t& blob)
+   {
+      std::string guard;
+
+      for (char c : name)
+         guard += std::isalnum((unsigned char)c) ? (char)std::toupper((unsigned char)c) : '_';
+
+      guard += "_MANIFEST_H";
+
+      std::ofstream out(path);
+
+      out << "// Generated by mkmanifest from " << source << ", do not edit.\n\n"
+          << "#ifndef " << guard << "\n"
+          << "#define " << guard << "\n\n"
+          << "#include <cstdint>\n\n"
+          << "static const uint8_t " << name << "_data[] =\n{";
+
+      const char* digits = "0123456789abcdef";
+
+      for (size_t i = 0; i < blob.size(); ++i)
+      {
+         out << ((i % 16 == 0) ? "\n   " : " ") << "0x" << digits[blob[i] >> 4] << digits[blob[i] & 0xf];
+
+         if (i + 1 < blob.size())
+            out << ",";
+      }
+
+      out << "\n};\n\n#endif\n";
+
+      return (bool)out;
+   }
+}
+
+int main(int argc, char* argv[])
+{
+   if (argc != 3 && argc != 4)
+   {
+      std::cerr << "usage: " << argv[0] << " manifest output [array name]\n";
+      return 1;
+   }
+
+   std::ifstream in(argv[1]);
+
+   if (!in)
+   {
+      std::cerr << "cannot read " << argv[1] << "\n";
+      return 1;
+   }
+
+   std::vector<wheel::string> names;
+   std::string line;
+
+   while (std::getline(in, line))
+   {
+      if (!line.empty() && line[line.size() - 1] == '\r')
+         line.erase(line.size() - 1);
+
+      if (!line.empty())
+         names.push_back(wheel::string(line));
+   }
+
+   wheel::buffer_t blob;
+   uint32_t rval = wheel::build_perfect_index(names, blob);
+
+   if (rval == WHEEL_INVALID_VALUE)
+   {
+      std::cerr << argv[1] << ": a name is listed twice\n";
+      return 1;
+   } else if (rval != WHEEL_OK) {
+      std::cerr << argv[1] << ": unable to build the index\n";
+      return 1;
+   }
+
+   bool written = (argc == 3) ? write_blob(argv[2], blob) : write_header(argv[2], argv[1], argv[3], blob);
+
+   if (!written)
+   {
+      std::cerr << "cannot write " << argv[2] << "\n";
+      return 1;
+   }
+
+   std::cout << names.size() << " names, " << blob.size() << " bytes\n";
+
+   return 0;
+}
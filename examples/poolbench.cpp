@@ -0,0 +1,150 @@
+#include "../include/wheel_core_buffer_pool.h"
+#include "../include/wheel_core_event.h"
+
+#include <iostream>
+#include <list>
+#include <vector>
+#include <thread>
+#include <chrono>
+
+// Creates and drops transient buffers of mixed sizes, the way event
+// handling and decoders do, with fresh buffers and with the buffer pool,
+// on one and on several threads.  Events are made both with plain
+// buffers, as Event did before, and as Event now does.  Reports millions
+// of buffers per second and the pool counters.
+
+namespace
+{
+   const size_t count = 2000000;
+
+   //! Sizes of events, small chunks and the occasional decoded image row
+   inline size_t size_of(size_t i)
+   {
+      static const size_t sizes[8] = { 3, 9, 17, 64, 200, 700, 4096, 50000 };
+      return sizes[(i * 2654435761u) >> 29 & 7];
+   }
+
+   size_t fresh(size_t n)
+   {
+      size_t sink = 0;
+
+      for (size_t i = 0; i < n; ++i)
+      {
+         wheel::buffer_t b;
+         b.reserve(size_of(i));
+         b.push_back((uint8_t)i);
+
+         sink += b[0];
+      }
+
+      return sink;
+   }
+
+   size_t pooled(size_t n)
+   {
+      size_t sink = 0;
+
+      for (size_t i = 0; i < n; ++i)
+      {
+         wheel::pooled_buffer b(size_of(i));
+         b->push_back((uint8_t)i);
+
+         sink += (*b)[0];
+      }
+
+      return sink;
+   }
+
+   //! Event as it was before it used the pool
+   struct plain_event_t
+   {
+      wheel::buffer_t data;
+   };
+
+   size_t plain_events(size_t n)
+   {
+      size_t sink = 0;
+      std::list<plain_event_t> list;
+
+      for (size_t i = 0; i < n; ++i)
+      {
+         plain_event_t e;
+         e.data.write_bytes(WHEEL_EVENT_KEYBOARD, WHEEL_PRESS, (uint8_t)i);
+
+         list.push_back(std::move(e));
+
+         if (list.size() == 64)
+         {
+            sink += list.back().data[2];
+            list.clear();
+         }
+      }
+
+      return sink;
+   }
+
+   size_t events(size_t n)
+   {
+      size_t sink = 0;
+      wheel::EventList list;
+
+      for (size_t i = 0; i < n; ++i)
+      {
+         list.push_back(wheel::describe_event(WHEEL_EVENT_KEYBOARD, WHEEL_PRESS, (uint8_t)i));
+
+         // A frame worth of events
+         if (list.size() == 64)
+         {
+            sink += list.back().data[2];
+            list.clear();
+         }
+      }
+
+      return sink;
+   }
+
+   size_t sink = 0;
+
+   template <typename F>
+   void report(const char* name, size_t threads, F work)
+   {
+      std::vector<std::thread> pool;
+      std::vector<size_t> sinks(threads);
+
+      auto start = std::chrono::steady_clock::now();
+
+      for (size_t t = 0; t < threads; ++t)
+         pool.emplace_back([&, t]() { sinks[t] = work(count / threads); });
+
+      for (auto& t : pool)
+         t.join();
+
+      double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+      for (size_t s : sinks)
+         sink += s;
+
+      std::cout << name << "\t" << threads << "\t" << (double)count / secs / 1e6 << "\n";
+   }
+}
+
+int main(void)
+{
+   std::cout << "buffers\t\tthreads\tmillions/s\n";
+
+   for (size_t threads = 1; threads <= 4; threads *= 4)
+   {
+      report("fresh\t", threads, fresh);
+      report("pooled\t", threads, pooled);
+      report("plain events", threads, plain_events);
+      report("events\t", threads, events);
+   }
+
+   wheel::buffer_pool_stats_t stats = wheel::buffer_pool::stats();
+
+   std::cout << "\nacquired " << stats.acquired << ", thread cache " << stats.thread_hits
+             << ", shared cache " << stats.shared_hits << ", allocated " << stats.misses
+             << ", dropped " << stats.dropped << ", shared bytes " << stats.shared_bytes << "\n";
+
+   return sink == 0;
+}
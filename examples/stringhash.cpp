@@ -1,43 +1,152 @@
-#include "../include/wheel_core.h"
+#include "../include/wheel_core_hash.h"
 
 #include <iostream>
 #include <string>
 #include <map>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <unordered_map>
+#include <unordered_set>
 
-int main(void)
+// Reads names, one per line, from stdin and compares the hash functions on
+// them, e.g.
+//
+//    find /usr/share -type f | ./stringhash
+//
+// For each hash it reports full width collisions, how many names share a
+// bucket in a table with a bucket per name compared to an ideal random hash,
+// hashing throughput and the time to fill and search an unordered_map.
+
+namespace
 {
-   std::string input;
+   // What Hash<string> used to do, four multiplies per character
+   size_t old_fnv1a(const wheel::string& s)
+   {
+      uint64_t hash = 0xCBF29CE484222325;
+
+      for (size_t i = 0; i < s.length(); ++i)
+      {
+         uint32_t c = s[i];
 
-   std::map<size_t, wheel::string> hashlist;
-   std::map<size_t, wheel::string>::iterator it;
+         hash = (hash ^ (c & 0xff)) * 0x100000001B3;
+         hash = (hash ^ ((c >> 8) & 0xff)) * 0x100000001B3;
+         hash = (hash ^ ((c >> 16) & 0xff)) * 0x100000001B3;
+         hash = (hash ^ (c >> 24)) * 0x100000001B3;
+      }
+
+      return hash;
+   }
+
+   struct old_hash
+   {
+      size_t operator()(const wheel::string& s) const { return old_fnv1a(s); }
+   };
 
-   size_t hash;
+   size_t sink = 0;
+
+   template <typename H>
+   void report(const char* name, const std::vector<wheel::string>& names, size_t bytes)
+   {
+      H hasher;
+
+      // Collisions
+      std::map<size_t, const wheel::string*> seen;
+      size_t collisions = 0;
+
+      size_t buckets = 1;
+      while (buckets < names.size())
+         buckets *= 2;
+
+      std::vector<uint8_t> used(buckets, 0);
+      size_t shared = 0;
+
+      for (const wheel::string& s : names)
+      {
+         size_t h = hasher(s);
+         auto it = seen.find(h);
+
+         if (it == seen.end())
+            seen[h] = &s;
+         else if (!(*it->second == s))
+            ++collisions;
+
+         if (used[h & (buckets - 1)]++)
+            ++shared;
+      }
 
-   int collision_count = 0;
+      // Throughput
+      const size_t rounds = (64 * 1024 * 1024) / (bytes + 1) + 1;
+      auto start = std::chrono::steady_clock::now();
+
+      for (size_t r = 0; r < rounds; ++r)
+         for (const wheel::string& s : names)
+            sink += hasher(s);
+
+      double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      double mbs = (double)(rounds * bytes) / secs / (1024.0 * 1024.0);
+      double ns = secs * 1e9 / (double)(rounds * names.size());
+
+      // Map fill and lookup
+      start = std::chrono::steady_clock::now();
+
+      for (size_t r = 0; r < 8; ++r)
+      {
+         std::unordered_map<wheel::string, size_t, H> map;
+
+         for (size_t i = 0; i < names.size(); ++i)
+            map[names[i]] = i;
+
+         for (const wheel::string& s : names)
+            sink += map.find(s)->second;
+      }
+
+      double map_ms = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1000.0 / 8;
+
+      std::cout << name << "\t" << collisions << "\t" << shared << "\t"
+                << mbs << "\t" << ns << "\t" << map_ms << "\n";
+   }
+}
+
+int main(void)
+{
+   std::string input;
+
+   std::vector<wheel::string> names;
+   std::unordered_set<std::string> unique;
+   size_t bytes = 0;
    int total_words = 0;
-   int duplicates = 0;
 
    while(getline(std::cin, input))
    {
       total_words++;
-      wheel::string output(input);
-      hash = output.hash();
 
-      if ((it = hashlist.find(hash)) != hashlist.end())
+      if (unique.insert(input).second)
       {
-         if (it->second == output)
-            duplicates++;
-         else
-         {
-            std::cout << "Hash collision with " << output << " and " << it->second << "::" << hash << "\n";
-            collision_count++;
-         }
-      } else {
-         hashlist.insert(std::pair<size_t, wheel::string>(hash, output));
+         names.push_back(wheel::string(input));
+         bytes += names.back().length() * names.back().char_width();
       }
    }
 
-   std::cout << "Words checked:" << total_words << " (" << total_words - duplicates << ")  Collisions:" << collision_count << "\n";
+   if (names.empty())
+      return 0;
+
+   // Expected number of names landing in a used bucket for a random hash
+   size_t buckets = 1;
+   while (buckets < names.size())
+      buckets *= 2;
+
+   double n = (double)names.size(), m = (double)buckets;
+   double ideal = n - m * (1.0 - std::pow(1.0 - 1.0 / m, n));
+
+   std::cout << "Words checked:" << total_words << " (" << names.size() << ")  "
+             << "Buckets:" << buckets << "  Ideal shared:" << (size_t)ideal << "\n";
+   std::cout << "hash\t\tcollide\tshared\tMB/s\tns/key\tmap ms\n";
+
+   report<old_hash>("old fnv1a", names, bytes);
+   report<wheel::Hash<wheel::string>>("Hash<string>", names, bytes);
+   report<wheel::hash_with<wheel::string, wheel::fnv1a_policy>>("fnv1a_policy", names, bytes);
+   report<wheel::fast_hash<wheel::string>>("wyhash_policy", names, bytes);
 
-   return collision_count;
-}
\ No newline at end of file
+   return sink == 0;
+}
@@ -0,0 +1,96 @@
+#include "../include/wheel_core_search.h"
+
+#include <iostream>
+#include <string>
+#include <chrono>
+
+// Searches long texts for needles of different lengths that only appear at
+// the very end, and reports MB/s of text scanned for the old substr based
+// contains(), std::string::find, string::find and a precompiled searcher.
+
+namespace
+{
+   const char* words[] = { "wheel", "module", "texture", "shader", "buffer",
+                           "resource", "string", "library", "event", "sound" };
+
+   std::string make_text(size_t bytes, const std::string& tail)
+   {
+      std::string rval;
+      size_t state = 1;
+
+      while (rval.size() < bytes)
+      {
+         state = state * 1103515245 + 12345;
+         rval += words[(state >> 16) % 10];
+         rval += ' ';
+      }
+
+      return rval + tail;
+   }
+
+   template <typename F>
+   double measure(size_t bytes, F func)
+   {
+      const size_t target = 512 * 1024 * 1024;
+      size_t rounds = target / bytes + 1;
+
+      auto start = std::chrono::steady_clock::now();
+
+      for (size_t i = 0; i < rounds; ++i)
+         func();
+
+      auto end = std::chrono::steady_clock::now();
+
+      double secs = std::chrono::duration<double>(end - start).count();
+      return (double)(rounds * bytes) / secs / (1024.0 * 1024.0);
+   }
+
+   size_t sink = 0;
+
+   // What string::contains used to do
+   bool old_contains(const wheel::string& text, const wheel::string& seq)
+   {
+      if (text.length() < seq.length())
+         return false;
+
+      size_t lastpos = text.length() - seq.length() + 1;
+
+      for (size_t i = 0; i < lastpos; ++i)
+         if (text.substr(i, seq.length()) == seq)
+            return true;
+
+      return false;
+   }
+}
+
+int main(void)
+{
+   const char* needles[] = { "zq", "zqxj", "resource_zqxj", "shader texture module zqxj",
+                             "the quick brown fox jumps over the lazy dog zqxj 0123456789 abcdefghijklmnopqrstuvwxyz" };
+
+   std::cout << "needle   old MB/s    std MB/s    find MB/s   searcher MB/s\n";
+
+   for (const char* n : needles)
+   {
+      std::string needle(n);
+      std::string text = make_text(1024 * 1024, needle);
+
+      wheel::string wtext(text);
+      wheel::string wneedle(needle);
+      wheel::searcher search(wneedle);
+
+      // The old implementation allocates at every position, so it gets a shorter text
+      std::string short_text = make_text(16 * 1024, needle);
+      wheel::string wshort(short_text);
+
+      double old_rate = measure(short_text.size(), [&]() { sink += old_contains(wshort, wneedle); });
+      double std_rate = measure(text.size(), [&]() { sink += text.find(needle); });
+      double find_rate = measure(text.size(), [&]() { sink += wtext.find(wneedle); });
+      double search_rate = measure(text.size(), [&]() { sink += search.find(wtext); });
+
+      std::cout << needle.size() << "\t" << old_rate << "\t" << std_rate << "\t"
+                << find_rate << "\t" << search_rate << "\n";
+   }
+
+   return sink == 0;
+}
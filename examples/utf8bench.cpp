@@ -0,0 +1,127 @@
+#include "../include/wheel_core_string.h"
+#include "../src/utf8.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+
+// Compares string construction from UTF-8 against the old two-pass
+// replace_invalid + utf8to32 path, and std_str() against the old
+// utf32to8 + back_inserter path, in MB/s of UTF-8.
+
+namespace
+{
+   std::string make_text(const char* piece, size_t bytes)
+   {
+      std::string rval;
+      while (rval.size() < bytes)
+         rval += piece;
+
+      return rval;
+   }
+
+   template <typename F>
+   double measure(const std::string& input, F func)
+   {
+      const size_t target = 256 * 1024 * 1024;
+      size_t rounds = target / input.size() + 1;
+
+      auto start = std::chrono::steady_clock::now();
+
+      for (size_t i = 0; i < rounds; ++i)
+         func(input);
+
+      auto end = std::chrono::steady_clock::now();
+
+      double secs = std::chrono::duration<double>(end - start).count();
+      return (double)(rounds * input.size()) / secs / (1024.0 * 1024.0);
+   }
+
+   size_t sink = 0;
+
+   void old_path(const std::string& in)
+   {
+      std::string result;
+      std::vector<char32_t> data;
+
+      utf8::replace_invalid(in.begin(), in.end(), std::back_inserter(result));
+      utf8::utf8to32(result.begin(), result.end(), std::back_inserter(data));
+
+      sink += data.size();
+   }
+
+   void new_path(const std::string& in)
+   {
+      wheel::string s(in);
+      sink += s.length();
+   }
+
+   const wheel::string* encode_input = nullptr;
+
+   void old_encode(const std::string&)
+   {
+      std::string result;
+      utf8::utf32to8(encode_input->begin(), encode_input->end(), std::back_inserter(result));
+
+      sink += result.size();
+   }
+
+   void new_encode(const std::string&)
+   {
+      sink += encode_input->std_str().size();
+   }
+}
+
+int main(void)
+{
+   struct
+   {
+      const char* name;
+      const char* piece;
+   } inputs[] =
+   {
+      { "ascii", "resources/textures/terrain_grass_01.png " },
+      { "latin-1", "Pyörä käy ja äänet kuuluvat hyvin. " },
+      { "mixed", "wheel ホイール колесо € 𝄞 " },
+      { "cjk", "車輪の再発明は楽しいです。" },
+   };
+
+   size_t sizes[] = { 16, 256, 64 * 1024 };
+
+   std::cout << "input      size       old MB/s     new MB/s    speedup\n";
+
+   for (auto& input : inputs)
+      for (size_t size : sizes)
+      {
+         std::string text = make_text(input.piece, size);
+
+         double old_rate = measure(text, old_path);
+         double new_rate = measure(text, new_path);
+
+         std::cout << input.name << "\t" << text.size() << "\t"
+                   << old_rate << "\t" << new_rate << "\t"
+                   << new_rate / old_rate << "x\n";
+      }
+
+   std::cout << "\nencoding\n";
+   std::cout << "input      size       old MB/s     new MB/s    speedup\n";
+
+   for (auto& input : inputs)
+      for (size_t size : sizes)
+      {
+         std::string text = make_text(input.piece, size);
+         wheel::string str(text);
+
+         encode_input = &str;
+
+         double old_rate = measure(text, old_encode);
+         double new_rate = measure(text, new_encode);
+
+         std::cout << input.name << "\t" << text.size() << "\t"
+                   << old_rate << "\t" << new_rate << "\t"
+                   << new_rate / old_rate << "x\n";
+      }
+
+   return sink == 0;
+}
@@ -9,7 +9,23 @@
 
 // Core
 #include "wheel_core_common.h"
+#include "wheel_core_buffer_view.h"
+#include "wheel_core_buffer_chain.h"
+#include "wheel_core_bitstream.h"
+#include "wheel_core_archive.h"
+#include "wheel_core_buffer_pool.h"
+#include "wheel_core_mapped_buffer.h"
 #include "wheel_core_string.h"
+#include "wheel_core_string_ref.h"
+#include "wheel_core_search.h"
+#include "wheel_core_charconv.h"
+#include "wheel_core_string_builder.h"
+#include "wheel_core_rope.h"
+#include "wheel_core_hash.h"
+#include "wheel_core_flat_map.h"
+#include "wheel_core_perfect_hash.h"
+#include "wheel_core_hashed_name.h"
+#include "wheel_core_symbol.h"
 #include "wheel_core_utility.h"
 #include "wheel_core_module.h"
 #include "wheel_core_debug.h"
@@ -0,0 +1,547 @@
+/*!
+   @file
+   \brief Contains definitions for compact binary serialization
+   \author Jari Ronkainen
+*/
+
+#ifndef WHEEL_ARCHIVE_HEADER
+#define WHEEL_ARCHIVE_HEADER
+
+#include "wheel_core_common.h"
+#include "wheel_core_buffer_view.h"
+#include "wheel_core_string.h"
+
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+//! Lists the fields of a type for wheel::archive, inside its definition
+/*!
+   Generates a serialize() member that the archive reader and writer both
+   call, so the fields are listed once for both directions.
+
+   \code
+      struct save_slot_t
+      {
+         wheel::string           name;
+         uint32_t                level;
+         std::vector<int32_t>    scores;
+
+         WHEEL_SERIALIZE(name, level, scores)
+      };
+   \endcode
+*/
+#define WHEEL_SERIALIZE(...)                                        \
+   template <typename Archive>                                      \
+   void serialize(Archive& wheel_archive) { wheel_archive(__VA_ARGS__); }
+
+//! As WHEEL_SERIALIZE, for a type whose fields change between versions
+/*!
+   Records of the type store their version and length.  Fields added after
+   the first version are marked with wheel::since(), and are left as they
+   are when an older record is read.  Fields that a newer version has added
+   at the end are skipped by older readers.
+
+   \code
+      struct save_slot_t
+      {
+         wheel::string           name;
+         uint32_t                level;
+         uint32_t                playtime;
+
+         WHEEL_SERIALIZE_VERSION(2, name, level, wheel::since(2, playtime))
+      };
+   \endcode
+*/
+#define WHEEL_SERIALIZE_VERSION(version, ...)                       \
+   static constexpr uint32_t serialize_version() { return version; } \
+   WHEEL_SERIALIZE(__VA_ARGS__)
+
+namespace wheel
+{
+   //! A field that is only in records of a version or newer
+   template <typename T>
+   struct since_t
+   {
+      uint32_t    version;
+      T&          value;
+   };
+
+   template <typename T>
+   inline since_t<T> since(uint32_t version, T& value)
+   {
+      return since_t<T> { version, value };
+   }
+
+   namespace internal
+   {
+      template <typename...>
+      struct make_void { typedef void type; };
+
+      template <typename T, typename = void>
+      struct is_versioned : std::false_type {};
+
+      template <typename T>
+      struct is_versioned<T, typename make_void<decltype(T::serialize_version())>::type> : std::true_type {};
+
+      template <typename T, bool = is_versioned<T>::value>
+      struct version_of { static uint32_t get() { return 0; } };
+
+      template <typename T>
+      struct version_of<T, true> { static uint32_t get() { return T::serialize_version(); } };
+
+      //! Vectors of these are copied as they are, bools are not as std::vector<bool> packs them
+      template <typename T>
+      struct is_byte : std::integral_constant<bool, std::is_integral<T>::value && sizeof(T) == 1 && !std::is_same<T, bool>::value> {};
+
+      inline uint64_t zigzag(int64_t value)
+      {
+         return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+      }
+
+      inline int64_t unzigzag(uint64_t value)
+      {
+         return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+      }
+   }
+
+   //! Writes values into a buffer_t in the archive format
+   /*!
+      - Integers wider than a byte are LEB128 varints, signed ones zigzag
+        coded first, so small values of any type take one byte
+      - Bytes and bools take one byte, floats four or eight, little-endian
+      - Enumerations are stored as their underlying type
+      - Strings, vectors and buffers are a varint length and the elements
+      - Types with WHEEL_SERIALIZE are their fields in order, and types with
+        WHEEL_SERIALIZE_VERSION a varint version and length before them
+
+      Nothing describes the types, so records are only read back by the
+      same definitions, or other versions of them.
+
+      The writer appends to the buffer.  Small values are collected in a
+      block inside the writer and appended a block at a time, so flush()
+      it, or let it go out of scope, before using the buffer.
+   */
+   class archive_writer
+   {
+      private:
+         static const size_t block_size = 256;
+
+         buffer_t&         out;
+
+         uint8_t           block[block_size];
+         size_t            used;
+
+         void              write_varint_long(uint64_t value);
+         void              write_fixed(uint64_t bits, size_t bytes);
+         void              write_bytes(const void* src, size_t n);
+         size_t            begin_record(uint32_t version);
+         void              end_record(size_t mark);
+
+         inline void write_byte(uint8_t value)
+         {
+            if (used == block_size)
+               flush();
+
+            block[used++] = value;
+         }
+
+         inline void write_varint(uint64_t value)
+         {
+            if (value < 0x80)
+               write_byte((uint8_t)value);
+            else
+               write_varint_long(value);
+         }
+
+         template <typename T>
+         inline void elements(const std::vector<T>& value, std::true_type)
+         {
+            write_bytes(value.data(), value.size());
+         }
+
+         template <typename T>
+         inline void elements(const std::vector<T>& value, std::false_type)
+         {
+            for (const T& element : value)
+               field(element);
+         }
+
+      public:
+         explicit archive_writer(buffer_t& buffer) : out(buffer), used(0) {}
+        ~archive_writer() { flush(); }
+
+         //! Append what has been written to the buffer
+         inline void flush()
+         {
+            out.append(block, used);
+            used = 0;
+         }
+
+         archive_writer(const archive_writer&) = delete;
+         archive_writer& operator=(const archive_writer&) = delete;
+
+         //! Write fields in order
+         template <typename... Args>
+         inline void operator()(Args&&... args)
+         {
+            int expand[] = { 0, (field(args), 0)... };
+            (void)expand;
+         }
+
+         template <typename T>
+         inline typename std::enable_if<std::is_integral<T>::value>::type field(const T& value)
+         {
+            if (sizeof(T) == 1)
+               write_byte((uint8_t)value);
+            else if (std::is_signed<T>::value)
+               write_varint(internal::zigzag((int64_t)value));
+            else
+               write_varint((uint64_t)value);
+         }
+
+         template <typename T>
+         inline typename std::enable_if<std::is_enum<T>::value>::type field(const T& value)
+         {
+            field((typename std::underlying_type<T>::type)value);
+         }
+
+         inline void field(const float& value)
+         {
+            uint32_t bits;
+            memcpy(&bits, &value, 4);
+
+            write_fixed(bits, 4);
+         }
+
+         inline void field(const double& value)
+         {
+            uint64_t bits;
+            memcpy(&bits, &value, 8);
+
+            write_fixed(bits, 8);
+         }
+
+         void field(const string& value);
+         void field(const std::string& value);
+
+         template <typename T>
+         void field(const std::vector<T>& value)
+         {
+            write_varint(value.size());
+            elements(value, internal::is_byte<T>());
+         }
+
+         template <typename T, size_t N>
+         void field(const T (&value)[N])
+         {
+            for (const T& element : value)
+               field(element);
+         }
+
+         template <typename A, typename B>
+         inline void field(const std::pair<A, B>& value)
+         {
+            field(value.first);
+            field(value.second);
+         }
+
+         template <typename T>
+         inline void field(const since_t<T>& value)
+         {
+            field(value.value);
+         }
+
+         //! Types with WHEEL_SERIALIZE
+         template <typename T>
+         inline typename std::enable_if<std::is_class<T>::value>::type field(const T& value, decltype(&T::template serialize<archive_writer>) = nullptr)
+         {
+            // serialize() is shared with reading, so it is not const
+            T& fields = const_cast<T&>(value);
+
+            if (!internal::is_versioned<T>::value)
+            {
+               fields.serialize(*this);
+               return;
+            }
+
+            size_t mark = begin_record(internal::version_of<T>::get());
+            fields.serialize(*this);
+            end_record(mark);
+         }
+   };
+
+   //! Reads values written by archive_writer
+   /*!
+      Reads are bounds checked.  The first error is kept in status(), and
+      after it nothing more is read; the fields that were not read are left
+      as they were.
+
+      A length is an error if there are fewer bytes left than it has
+      elements, so vectors of types with no fields cannot be read.
+   */
+   class archive_reader
+   {
+      private:
+         const uint8_t*    ptr;
+         const uint8_t*    stop;
+
+         uint32_t          error;
+         uint32_t          version;       //!< Version of the record being read
+
+         bool              read_varint_long(uint64_t& value);
+         bool              read_fixed(uint64_t& bits, size_t bytes);
+         bool              read_length(size_t& length);
+         void              fail(uint32_t status);
+
+         inline bool read_varint(uint64_t& value)
+         {
+            if (ptr < stop && *ptr < 0x80)
+            {
+               value = *ptr++;
+               return true;
+            }
+
+            return read_varint_long(value);
+         }
+
+         template <typename T>
+         inline void elements(std::vector<T>& value, size_t length, std::true_type)
+         {
+            value.resize(length);
+
+            if (length > 0)
+               memcpy(value.data(), ptr, length);
+
+            ptr += length;
+         }
+
+         template <typename T>
+         inline void elements(std::vector<T>& value, size_t length, std::false_type)
+         {
+            value.reserve(length);
+
+            for (size_t i = 0; i < length && error == WHEEL_OK; ++i)
+            {
+               value.emplace_back();
+               field(value.back());
+            }
+         }
+
+         inline bool read_byte(uint8_t& value)
+         {
+            if (ptr == stop)
+            {
+               fail(WHEEL_UNEXPECTED_END_OF_FILE);
+               return false;
+            }
+
+            value = *ptr++;
+            return true;
+         }
+
+         template <typename T>
+         inline void narrow(T& value, uint64_t wide)
+         {
+            if (wide > (uint64_t)std::numeric_limits<T>::max())
+               fail(WHEEL_OUT_OF_RANGE);
+            else
+               value = (T)wide;
+         }
+
+         template <typename T>
+         inline void narrow_signed(T& value, int64_t wide)
+         {
+            if (wide > (int64_t)std::numeric_limits<T>::max() || wide < (int64_t)std::numeric_limits<T>::min())
+               fail(WHEEL_OUT_OF_RANGE);
+            else
+               value = (T)wide;
+         }
+
+      public:
+         archive_reader(const buffer_view& in) : ptr(in.data()), stop(in.data() + in.size()), error(WHEEL_OK), version(~0u) {}
+
+         archive_reader(const archive_reader&) = delete;
+         archive_reader& operator=(const archive_reader&) = delete;
+
+         //! <code>WHEEL_OK</code>, or the first error met
+         inline uint32_t status() const { return error; }
+
+         //! Bytes after what has been read
+         inline size_t remaining() const { return stop - ptr; }
+
+         //! Read fields in order
+         template <typename... Args>
+         inline void operator()(Args&&... args)
+         {
+            int expand[] = { 0, (field(args), 0)... };
+            (void)expand;
+         }
+
+         template <typename T>
+         inline typename std::enable_if<std::is_integral<T>::value>::type field(T& value)
+         {
+            if (sizeof(T) == 1)
+            {
+               uint8_t byte;
+
+               if (read_byte(byte))
+                  value = (T)byte;
+
+               return;
+            }
+
+            uint64_t wide;
+
+            if (!read_varint(wide))
+               return;
+
+            if (std::is_signed<T>::value)
+               narrow_signed(value, internal::unzigzag(wide));
+            else
+               narrow(value, wide);
+         }
+
+         template <typename T>
+         inline typename std::enable_if<std::is_enum<T>::value>::type field(T& value)
+         {
+            typename std::underlying_type<T>::type underlying {};
+
+            field(underlying);
+
+            if (error == WHEEL_OK)
+               value = (T)underlying;
+         }
+
+         inline void field(float& value)
+         {
+            uint64_t bits;
+
+            if (read_fixed(bits, 4))
+            {
+               uint32_t narrow_bits = (uint32_t)bits;
+               memcpy(&value, &narrow_bits, 4);
+            }
+         }
+
+         inline void field(double& value)
+         {
+            uint64_t bits;
+
+            if (read_fixed(bits, 8))
+               memcpy(&value, &bits, 8);
+         }
+
+         void field(string& value);
+         void field(std::string& value);
+
+         template <typename T>
+         void field(std::vector<T>& value)
+         {
+            size_t length;
+
+            if (!read_length(length))
+               return;
+
+            value.clear();
+            elements(value, length, internal::is_byte<T>());
+         }
+
+         void field(std::vector<bool>& value);
+
+         template <typename T, size_t N>
+         void field(T (&value)[N])
+         {
+            for (T& element : value)
+               field(element);
+         }
+
+         template <typename A, typename B>
+         inline void field(std::pair<A, B>& value)
+         {
+            field(value.first);
+            field(value.second);
+         }
+
+         template <typename T>
+         inline void field(const since_t<T>& value)
+         {
+            if (value.version <= version)
+               field(value.value);
+         }
+
+         //! Types with WHEEL_SERIALIZE
+         template <typename T>
+         inline typename std::enable_if<std::is_class<T>::value>::type field(T& value, decltype(&T::template serialize<archive_reader>) = nullptr)
+         {
+            uint32_t outer_version = version;
+
+            if (!internal::is_versioned<T>::value)
+            {
+               version = ~0u;
+               value.serialize(*this);
+               version = outer_version;
+
+               return;
+            }
+
+            uint64_t record_version;
+            size_t length;
+
+            if (!read_varint(record_version) || !read_length(length))
+               return;
+
+            const uint8_t* outer_stop = stop;
+            const uint8_t* record_end = ptr + length;
+
+            stop = record_end;
+            version = (uint32_t)std::min<uint64_t>(record_version, ~0u);
+
+            value.serialize(*this);
+
+            version = outer_version;
+
+            // Skip fields that a newer version has added
+            if (error == WHEEL_OK)
+            {
+               ptr = record_end;
+               stop = outer_stop;
+            }
+         }
+   };
+
+   //! Saves and loads values in the archive format
+   /*!
+      Example usage:
+      \code
+         wheel::buffer_t data;
+         wheel::archive::save(slot, data);
+         ...
+         if (wheel::archive::load(slot, data) != WHEEL_OK)
+            ...
+      \endcode
+   */
+   class archive
+   {
+      public:
+         //! Append a value to a buffer
+         template <typename T>
+         static void save(const T& value, buffer_t& out)
+         {
+            archive_writer writer(out);
+            writer.field(value);
+         }
+
+         //! Read a value, returns <code>WHEEL_OK</code> or the first error
+         template <typename T>
+         static uint32_t load(T& value, const buffer_view& in)
+         {
+            archive_reader reader(in);
+            reader.field(value);
+
+            return reader.status();
+         }
+   };
+}
+
+#endif //WHEEL_ARCHIVE_HEADER
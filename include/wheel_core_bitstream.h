@@ -0,0 +1,341 @@
+/*!
+   @file
+   \brief Contains definitions for bit-granular reading and writing
+   \author Jari Ronkainen
+*/
+
+#ifndef WHEEL_BITSTREAM_HEADER
+#define WHEEL_BITSTREAM_HEADER
+
+#include "wheel_core_common.h"
+#include "wheel_core_buffer_view.h"
+
+#include <cstring>
+
+namespace wheel
+{
+   //! Order in which bits are packed into bytes
+   enum bit_order_t
+   {
+      WHEEL_LSB_FIRST,     //!< First bit is the lowest bit of the first byte, as in deflate
+      WHEEL_MSB_FIRST      //!< First bit is the highest bit of the first byte, as in JPEG and MPEG
+   };
+
+   namespace internal
+   {
+      //! Eight bytes as a number, first byte lowest for LSB-first streams and highest for MSB-first
+      template <bit_order_t Order>
+      inline uint64_t load_bits64(const uint8_t* src)
+      {
+         return Order == WHEEL_MSB_FIRST ? load_be<uint64_t>(src) : load_le<uint64_t>(src);
+      }
+
+      template <bit_order_t Order>
+      inline void store_bits64(uint8_t* dst, uint64_t value)
+      {
+         if (Order == WHEEL_MSB_FIRST)
+            store_be(dst, value);
+         else
+            store_le(dst, value);
+      }
+   }
+
+   //! Reads a stream of bit fields
+   /*!
+      Keeps up to 63 bits in a register and refills it eight bytes at a
+      time.  While eight bytes are left, a refill is one unaligned load with
+      no branches on the bit count; the last bytes are loaded one at a time.
+      Reading past the end gives zero bits and sets overrun(), so a decoder
+      can check once at the end of a block instead of on every field.
+
+      Example usage, reading a deflate block header:
+      \code
+         wheel::bit_reader<wheel::WHEEL_LSB_FIRST> in(data);
+
+         bool last = in.read_bit();
+         uint32_t type = in.read(2);
+
+         if (in.overrun())
+            return WHEEL_UNEXPECTED_END_OF_FILE;
+      \endcode
+
+      In a decoding loop, refill() once, then peek() and consume() up to 56
+      bits without it checking for more.
+
+      The data must outlive the reader.
+   */
+   template <bit_order_t Order = WHEEL_LSB_FIRST>
+   class bit_reader
+   {
+      private:
+         const uint8_t*    start;
+         const uint8_t*    ptr;           //!< Next byte to load into the register
+         const uint8_t*    stop;
+
+         uint64_t          bits;          //!< LSB-first bits at the bottom, MSB-first at the top
+         uint32_t          count;         //!< Bits in the register
+         size_t            padding;       //!< Zero bits loaded past the end
+
+         void refill_tail()
+         {
+            while (count <= 56)
+            {
+               uint64_t byte = 0;
+
+               if (ptr < stop)
+                  byte = *ptr++;
+               else
+                  padding += 8;
+
+               if (Order == WHEEL_LSB_FIRST)
+                  bits |= byte << count;
+               else
+                  bits |= byte << (56 - count);
+
+               count += 8;
+            }
+         }
+
+      public:
+         bit_reader() : start(nullptr), ptr(nullptr), stop(nullptr), bits(0), count(0), padding(0) {}
+
+         bit_reader(const void* data, size_t length) : start((const uint8_t*)data), ptr(start), stop(start + length),
+                                                       bits(0), count(0), padding(0) {}
+
+         bit_reader(const buffer_view& view) : bit_reader(view.data(), view.size()) {}
+
+         //! Fill the register to at least 56 bits
+         inline void refill()
+         {
+            if (stop - ptr >= 8)
+            {
+               if (Order == WHEEL_LSB_FIRST)
+                  bits |= internal::load_bits64<Order>(ptr) << count;
+               else
+                  bits |= internal::load_bits64<Order>(ptr) >> count;
+
+               // Load whole bytes, as many as fit
+               ptr += (63 - count) >> 3;
+               count |= 56;
+            }
+            else
+            {
+               refill_tail();
+            }
+         }
+
+         //! Next n bits without reading them, n at most 56
+         inline uint64_t peek(uint32_t n)
+         {
+            assert(n <= 56);
+
+            if (count < n)
+               refill();
+
+            if (Order == WHEEL_LSB_FIRST)
+               return bits & ((1ull << n) - 1);
+
+            // Two shifts, so that n = 0 does not shift by 64
+            return (bits >> 1) >> (63 - n);
+         }
+
+         //! Drop n bits that have been peeked at
+         inline void consume(uint32_t n)
+         {
+            assert(n <= count);
+
+            if (Order == WHEEL_LSB_FIRST)
+               bits >>= n;
+            else
+               bits <<= n;
+
+            count -= n;
+         }
+
+         //! Read n bits, n at most 56
+         inline uint64_t read(uint32_t n)
+         {
+            uint64_t rval = peek(n);
+            consume(n);
+
+            return rval;
+         }
+
+         inline bool read_bit()
+         {
+            return read(1) != 0;
+         }
+
+         //! Skip to the start of the next byte
+         inline void align_to_byte()
+         {
+            // Whole bytes are loaded, so the bits of a partly read byte are count % 8
+            consume(count & 7);
+         }
+
+         //! Bits read from the start
+         inline size_t bit_position() const
+         {
+            return (size_t)(ptr - start) * 8 + padding - count;
+         }
+
+         //! Bits that can be read before the end
+         inline size_t bits_left() const
+         {
+            size_t total = (size_t)(stop - start) * 8;
+            size_t position = bit_position();
+
+            return position < total ? total - position : 0;
+         }
+
+         //! Has more been read than there was
+         inline bool overrun() const
+         {
+            return padding > count;
+         }
+   };
+
+   //! Writes a stream of bit fields
+   /*!
+      Collects bits in a register and stores all eight bytes of it after
+      every write, advancing only by the whole bytes; the partial byte is
+      stored again by the next write.  This needs eight bytes of room at the
+      write position, so a buffer_t is grown ahead of it and trimmed by
+      flush().
+
+      Writing to a buffer_t appends to what is already in it.  Writing to a
+      raw span drops what does not fit and sets overflow().
+
+      Example usage:
+      \code
+         wheel::buffer_t out;
+         wheel::bit_writer<wheel::WHEEL_MSB_FIRST> bits(out);
+
+         bits.write(code, length);
+         ...
+         bits.flush();
+      \endcode
+   */
+   template <bit_order_t Order = WHEEL_LSB_FIRST>
+   class bit_writer
+   {
+      private:
+         buffer_t*         target;
+         uint8_t*          out;
+         size_t            limit;
+         size_t            pos;           //!< Byte of the first bit in the register
+
+         uint64_t          bits;
+         uint32_t          count;
+         bool              overflowed;
+
+         //! Makes eight bytes of room, returns false if only the tail fits
+         bool make_room()
+         {
+            if (target != nullptr)
+            {
+               target->resize(std::max(pos + 8, target->size() * 2));
+
+               out = target->data();
+               limit = target->size();
+
+               return true;
+            }
+
+            return false;
+         }
+
+         void store_tail()
+         {
+            size_t room = pos < limit ? limit - pos : 0;
+            size_t needed = (count + 7) >> 3;
+
+            for (size_t i = 0; i < std::min<size_t>(room, needed); ++i)
+            {
+               if (Order == WHEEL_LSB_FIRST)
+                  out[pos + i] = (uint8_t)(bits >> (8 * i));
+               else
+                  out[pos + i] = (uint8_t)(bits >> (56 - 8 * i));
+            }
+
+            if (needed > room)
+               overflowed = true;
+         }
+
+      public:
+         bit_writer(buffer_t& buffer) : target(&buffer), out(buffer.data()), limit(buffer.size()), pos(buffer.size()),
+                                        bits(0), count(0), overflowed(false) {}
+
+         bit_writer(void* data, size_t length) : target(nullptr), out((uint8_t*)data), limit(length), pos(0),
+                                                 bits(0), count(0), overflowed(false) {}
+
+         bit_writer(const bit_writer&) = delete;
+         bit_writer& operator=(const bit_writer&) = delete;
+
+         //! Write the n low bits of value, n at most 56
+         inline void write(uint64_t value, uint32_t n)
+         {
+            assert(n <= 56);
+            assert((value >> n) == 0);
+
+            if (Order == WHEEL_LSB_FIRST)
+               bits |= value << count;
+            else
+               bits |= (value << 1) << (63 - count - n);
+
+            count += n;
+
+            if (pos + 8 <= limit || make_room())
+               internal::store_bits64<Order>(out + pos, bits);
+            else
+               store_tail();
+
+            pos += count >> 3;
+
+            if (Order == WHEEL_LSB_FIRST)
+               bits >>= count & ~7u;
+            else
+               bits <<= count & ~7u;
+
+            count &= 7;
+         }
+
+         inline void write_bit(bool bit)
+         {
+            write(bit ? 1 : 0, 1);
+         }
+
+         //! Pad the partial byte with zero bits
+         inline void align_to_byte()
+         {
+            // Every write has already stored the partial byte
+            pos += (count + 7) >> 3;
+
+            bits = 0;
+            count = 0;
+         }
+
+         //! Pad to a byte and cut the buffer to what was written
+         void flush()
+         {
+            align_to_byte();
+
+            if (target != nullptr && target->size() > pos)
+               target->resize(pos);
+         }
+
+         //! Bits written, including those of a buffer_t before the writer
+         inline size_t bit_position() const
+         {
+            return pos * 8 + count;
+         }
+
+         //! Did a raw span run out of room
+         inline bool overflow() const
+         {
+            return overflowed;
+         }
+   };
+}
+
+#endif //WHEEL_BITSTREAM_HEADER
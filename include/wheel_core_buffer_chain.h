@@ -0,0 +1,239 @@
+/*!
+   @file
+   \brief Contains definitions for chains of buffers
+   \author Jari Ronkainen
+*/
+
+#ifndef WHEEL_BUFFER_CHAIN_HEADER
+#define WHEEL_BUFFER_CHAIN_HEADER
+
+#include "wheel_core_common.h"
+#include "wheel_core_buffer_view.h"
+
+namespace wheel
+{
+   //! Bytes in several pieces, read as one
+   /*!
+      Joins data without copying it: chunks of a file, frames from the
+      network or headers in front of a payload.  Each segment is a view,
+      either to memory the caller keeps alive or to a buffer_t the chain
+      has taken over.  Iterating gives the segments in order, like an
+      iovec array, so they can be passed to zlib, writev and the like one
+      at a time.
+
+      Nothing is copied unless flatten() or gather() is called.
+
+      Example usage, inflating the IDAT chunks of a PNG file:
+      \code
+         wheel::buffer_chain compressed;
+
+         for (const PNGChunk& c : chunks)
+            if (c.is("IDAT"))
+               compressed.append(c.data);
+
+         z_uncompress(compressed, image_data);
+      \endcode
+   */
+   class buffer_chain
+   {
+      private:
+         std::vector<buffer_view>   segments;
+         std::vector<buffer_t>      owned;         //!< The storage stays put when these move
+         size_t                     length;
+
+      public:
+         buffer_chain() : length(0) {}
+
+         buffer_chain(buffer_chain&&) = default;
+         buffer_chain& operator=(buffer_chain&&) = default;
+
+         // Copies would refer to the owned buffers of the original
+         buffer_chain(const buffer_chain&) = delete;
+         buffer_chain& operator=(const buffer_chain&) = delete;
+
+         //! Append a view, the data must outlive the chain
+         inline void append(const buffer_view& view)
+         {
+            if (view.empty())
+               return;
+
+            segments.push_back(view);
+            length += view.size();
+         }
+
+         //! Append a buffer, which the chain keeps
+         inline void append(buffer_t&& buffer)
+         {
+            if (buffer.empty())
+               return;
+
+            owned.push_back(std::move(buffer));
+            append(buffer_view(owned.back()));
+         }
+
+         //! Append views to the segments of another chain, or of this one
+         inline void append(const buffer_chain& other)
+         {
+            // Appending would grow the vector being read
+            if (&other == this)
+            {
+               std::vector<buffer_view> copy(segments);
+
+               for (const buffer_view& segment : copy)
+                  append(segment);
+
+               return;
+            }
+
+            for (const buffer_view& segment : other)
+               append(segment);
+         }
+
+         inline void clear()
+         {
+            segments.clear();
+            owned.clear();
+            length = 0;
+         }
+
+         //! Total bytes in all segments
+         inline size_t     size() const { return length; }
+         inline bool       empty() const { return length == 0; }
+
+         //! Number of segments, none of which are empty
+         inline size_t     segment_count() const { return segments.size(); }
+
+         inline const buffer_view& segment(size_t i) const
+         {
+            assert(i < segments.size());
+            return segments[i];
+         }
+
+         inline const buffer_view* begin() const { return segments.data(); }
+         inline const buffer_view* end() const { return segments.data() + segments.size(); }
+
+         //! Copy up to n bytes from an offset, returns the bytes copied
+         size_t            gather(size_t offset, void* dst, size_t n) const;
+
+         //! All of the chain in one piece
+         /*!
+            A chain of one segment is returned as it is.  Others are copied
+            into scratch, which the returned view then refers to.
+         */
+         buffer_view       flatten(buffer_t& scratch) const;
+   };
+
+   //! Reads a buffer_chain from front to back
+   /*!
+      Works as byte_cursor, across segments.  Values that straddle two
+      segments are put together from their pieces; take() gives a view
+      without copying when the bytes are in one segment.
+
+      As with byte_cursor, read_be() and read_le() past the end return 0,
+      move the cursor to the end and set failed().
+   */
+   class chain_cursor
+   {
+      private:
+         const buffer_chain*  chain;
+         size_t               index;         //!< Segment being read, segment_count() at the end
+         size_t               offset;        //!< ...and the position in it
+         size_t               position;
+         bool                 fail;
+
+         void                 advance(size_t n);
+         void                 copy(void* dst, size_t n);
+
+         template <typename T>
+         inline bool short_read()
+         {
+            if (can_read(sizeof(T)))
+               return false;
+
+            advance(remaining());
+            fail = true;
+
+            return true;
+         }
+
+      public:
+         chain_cursor(const buffer_chain& source) : chain(&source), index(0), offset(0), position(0), fail(false) {}
+
+         inline size_t     pos() const { return position; }
+         inline bool       failed() const { return fail; }
+         inline size_t     remaining() const { return chain->size() - position; }
+         inline bool       can_read(size_t n) const { return n <= remaining(); }
+
+         inline bool skip(size_t n)
+         {
+            if (!can_read(n))
+               return false;
+
+            advance(n);
+            return true;
+         }
+
+         //! Copy the next n bytes out, returns false if there are fewer
+         inline bool read(void* dst, size_t n)
+         {
+            if (!can_read(n))
+               return false;
+
+            copy(dst, n);
+            return true;
+         }
+
+         //! Next n bytes as a view, copied into scratch only if they span segments
+         bool              take(size_t n, buffer_view& out, buffer_t& scratch);
+
+         //! Next n bytes as a chain of views to the segments
+         bool              take(size_t n, buffer_chain& out);
+
+         //! Read values, 0 and failed() if they are not there
+         template <typename T>
+         inline T read_be()
+         {
+            if (short_read<T>())
+               return 0;
+
+            const buffer_view& current = chain->segment(index);
+
+            if (current.has(offset, sizeof(T)))
+            {
+               T rval = current.read_be<T>(offset);
+               advance(sizeof(T));
+
+               return rval;
+            }
+
+            uint8_t bytes[sizeof(T)];
+            copy(bytes, sizeof(T));
+
+            return load_be<T>(bytes);
+         }
+
+         template <typename T>
+         inline T read_le()
+         {
+            if (short_read<T>())
+               return 0;
+
+            const buffer_view& current = chain->segment(index);
+
+            if (current.has(offset, sizeof(T)))
+            {
+               T rval = current.read_le<T>(offset);
+               advance(sizeof(T));
+
+               return rval;
+            }
+
+            uint8_t bytes[sizeof(T)];
+            copy(bytes, sizeof(T));
+
+            return load_le<T>(bytes);
+         }
+   };
+}
+
+#endif //WHEEL_BUFFER_CHAIN_HEADER
@@ -0,0 +1,87 @@
+/*!
+   @file
+   \brief Contains definitions for recycling buffer storage
+   \author Jari Ronkainen
+*/
+
+#ifndef WHEEL_BUFFER_POOL_HEADER
+#define WHEEL_BUFFER_POOL_HEADER
+
+#include "wheel_core_common.h"
+
+namespace wheel
+{
+   //! Counters of the buffer pool, summed over all threads
+   struct buffer_pool_stats_t
+   {
+      uint64_t    acquired;         //!< Buffers handed out
+      uint64_t    thread_hits;      //!< ...from the cache of the calling thread
+      uint64_t    shared_hits;      //!< ...from the shared cache
+      uint64_t    misses;           //!< ...newly allocated
+      uint64_t    released;         //!< Buffers given back
+      uint64_t    dropped;          //!< ...and freed, because they were too small, too large or the caches were full
+
+      size_t      shared_bytes;     //!< Capacity held in the shared cache
+   };
+
+   //! Process-wide pool of buffer storage
+   /*!
+      Keeps the storage of released buffers and hands it out again, so
+      short-lived buffers do not go through malloc every time.  Storage is
+      sorted by capacity into power of two size classes from
+      <code>min_capacity</code> to <code>max_capacity</code>; a buffer of
+      any other capacity is freed on release.
+
+      Each thread has a small cache of its own, which is used without
+      locking.  When it is full or empty, buffers move to or from a shared
+      cache behind a mutex, which holds at most 64 MiB unless told
+      otherwise with set_shared_limit().  The counters are kept per thread
+      as well and only summed by stats().
+
+      The buffers are plain buffer_t, which can be released from another
+      thread, or not at all.
+   */
+   class buffer_pool
+   {
+      public:
+         static const size_t  min_capacity   = 32;
+         static const size_t  max_capacity   = 16 * 1024 * 1024;
+         static const size_t  class_count    = 20;
+         static const size_t  thread_bytes   = 64 * 1024;   //!< Per size class, at least two buffers
+
+         //! Empty buffer with room for at least capacity bytes
+         static buffer_t      acquire(size_t capacity);
+
+         //! Give the storage of a buffer back, leaves it empty
+         static void          release(buffer_t&& buffer);
+
+         //! Free the cached storage of the calling thread and the shared cache
+         static void          trim();
+
+         static void          set_shared_limit(size_t bytes);
+         static buffer_pool_stats_t stats();
+   };
+
+   //! Buffer from the pool, given back when it goes out of scope
+   class pooled_buffer
+   {
+      private:
+         buffer_t    buffer;
+
+      public:
+         explicit pooled_buffer(size_t capacity = buffer_pool::min_capacity) : buffer(buffer_pool::acquire(capacity)) {}
+        ~pooled_buffer() { buffer_pool::release(std::move(buffer)); }
+
+         pooled_buffer(pooled_buffer&& other) : buffer(std::move(other.buffer)) {}
+
+         pooled_buffer(const pooled_buffer&) = delete;
+         pooled_buffer& operator=(const pooled_buffer&) = delete;
+
+         inline buffer_t&        operator*() { return buffer; }
+         inline const buffer_t&  operator*() const { return buffer; }
+         inline buffer_t*        operator->() { return &buffer; }
+         inline const buffer_t*  operator->() const { return &buffer; }
+   };
+}
+
+#endif //WHEEL_BUFFER_POOL_HEADER
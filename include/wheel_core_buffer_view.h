@@ -0,0 +1,217 @@
+/*!
+   @file
+   \brief Contains definitions for non-owning views of binary data
+   \author Jari Ronkainen
+*/
+
+#ifndef WHEEL_BUFFER_VIEW_HEADER
+#define WHEEL_BUFFER_VIEW_HEADER
+
+#include "wheel_core_common.h"
+
+#include <cstring>
+#include <type_traits>
+
+namespace wheel
+{
+   //! Non-owning view of bytes
+   /*!
+      Refers to a range of memory, usually a part of a buffer_t, and reads
+      values from it without copying the data.  Reads are not bounds checked
+      in release builds: a parser checks that a whole record is there once,
+      with has() or byte_cursor::take(), and then reads its fields freely.
+
+      Values are loaded with memcpy, so they may lie at any alignment.
+
+      The data must outlive the view.
+   */
+   class buffer_view
+   {
+      private:
+         const uint8_t*    ptr;
+         size_t            len;
+
+      public:
+         static const size_t npos = ~(size_t)0;
+
+         buffer_view() : ptr(nullptr), len(0) {}
+         buffer_view(const void* data, size_t length) : ptr((const uint8_t*)data), len(length) {}
+         buffer_view(const buffer_t& buffer) : ptr(buffer.data()), len(buffer.size()) {}
+
+         inline const uint8_t*   data() const { return ptr; }
+         inline size_t           size() const { return len; }
+         inline bool             empty() const { return len == 0; }
+
+         inline const uint8_t*   begin() const { return ptr; }
+         inline const uint8_t*   end() const { return ptr + len; }
+
+         inline uint8_t operator[](size_t i) const
+         {
+            assert(i < len);
+            return ptr[i];
+         }
+
+         //! Are there length bytes at offset
+         inline bool has(size_t offset, size_t length) const
+         {
+            return offset <= len && length <= len - offset;
+         }
+
+         //! Part of the view, cut at its end
+         inline buffer_view subview(size_t offset, size_t length = npos) const
+         {
+            if (offset > len)
+               offset = len;
+
+            if (length > len - offset)
+               length = len - offset;
+
+            return buffer_view(ptr + offset, length);
+         }
+
+         //! Do the bytes equal the given ones, such as a chunk tag
+         inline bool equals(const void* bytes, size_t length) const
+         {
+            return len == length && (length == 0 || memcmp(ptr, bytes, length) == 0);
+         }
+
+         //! Read a value stored in native byte order
+         template <typename T>
+         inline T read(size_t offset) const
+         {
+            static_assert(std::is_trivially_copyable<T>::value, "buffer_view reads trivially copyable values");
+            assert(has(offset, sizeof(T)));
+
+            T rval;
+            memcpy(&rval, ptr + offset, sizeof(T));
+
+            return rval;
+         }
+
+         //! Read a big-endian value
+         template <typename T>
+         inline T read_be(size_t offset) const
+         {
+            assert(has(offset, sizeof(T)));
+            return load_be<T>(ptr + offset);
+         }
+
+         //! Read a little-endian value
+         template <typename T>
+         inline T read_le(size_t offset) const
+         {
+            assert(has(offset, sizeof(T)));
+            return load_le<T>(ptr + offset);
+         }
+   };
+
+   //! Reads a buffer_view from front to back
+   /*!
+      Example usage, reading a chunk with a 4-byte length and a 4-byte tag:
+      \code
+         wheel::byte_cursor in(buffer);
+         wheel::buffer_view header, body;
+
+         while (in.take(8, header))
+         {
+            if (!in.take(header.read_be<uint32_t>(0), body))
+               return WHEEL_UNEXPECTED_END_OF_FILE;
+
+            if (header.subview(4, 4).equals("IDAT", 4))
+               ...
+         }
+      \endcode
+
+      read_be() and read_le() past the end return 0, move the cursor to the
+      end and set failed(), so a run of reads can be checked once after it.
+   */
+   class byte_cursor
+   {
+      private:
+         buffer_view       view;
+         size_t            position;
+         bool              fail;
+
+         template <typename T>
+         inline bool short_read()
+         {
+            if (can_read(sizeof(T)))
+               return false;
+
+            position = view.size();
+            fail = true;
+
+            return true;
+         }
+
+      public:
+         byte_cursor() : position(0), fail(false) {}
+         byte_cursor(const buffer_view& source) : view(source), position(0), fail(false) {}
+
+         inline size_t     pos() const { return position; }
+         inline bool       failed() const { return fail; }
+         inline size_t     remaining() const { return view.size() - position; }
+         inline bool       can_read(size_t n) const { return n <= remaining(); }
+
+         //! The part that has not been read yet
+         inline buffer_view rest() const { return view.subview(position); }
+
+         //! Move to a position, returns false if it is past the end
+         inline bool seek(size_t target)
+         {
+            if (target > view.size())
+               return false;
+
+            position = target;
+            return true;
+         }
+
+         inline bool skip(size_t n)
+         {
+            if (!can_read(n))
+               return false;
+
+            position += n;
+            return true;
+         }
+
+         //! Take the next n bytes as a view, returns false if there are fewer
+         inline bool take(size_t n, buffer_view& out)
+         {
+            if (!can_read(n))
+               return false;
+
+            out = buffer_view(view.data() + position, n);
+            position += n;
+
+            return true;
+         }
+
+         //! Read values, 0 and failed() if they are not there
+         template <typename T>
+         inline T read_be()
+         {
+            if (short_read<T>())
+               return 0;
+
+            T rval = view.read_be<T>(position);
+            position += sizeof(T);
+
+            return rval;
+         }
+
+         template <typename T>
+         inline T read_le()
+         {
+            if (short_read<T>())
+               return 0;
+
+            T rval = view.read_le<T>(position);
+            position += sizeof(T);
+
+            return rval;
+         }
+   };
+}
+
+#endif //WHEEL_BUFFER_VIEW_HEADER
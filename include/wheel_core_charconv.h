@@ -0,0 +1,64 @@
+/*!
+   @file
+   \brief Contains definitions for converting numbers to and from text
+   \author Jari Ronkainen
+*/
+
+#ifndef WHEEL_CHARCONV_HEADER
+#define WHEEL_CHARCONV_HEADER
+
+#include "wheel_core_common.h"
+#include "wheel_core_string_ref.h"
+
+namespace wheel
+{
+   //! Outcome of a number conversion
+   struct number_result
+   {
+      //! Characters written by to_chars(), or consumed by from_chars()
+      size_t   length;
+
+      //! WHEEL_OK, WHEEL_INVALID_VALUE if there is no number, WHEEL_OUT_OF_RANGE if it does not fit
+      uint32_t error;
+   };
+
+   //! Longest output of to_chars() for any value
+   static const size_t max_number_chars = 32;
+
+   //! Format a number as ASCII
+   /*!
+      Writes to [first, last) without a terminator and never allocates.
+      Doubles are written with the fewest significant digits that parse back
+      to the same value, so 0.1 is written as "0.1".
+
+      If the output does not fit, nothing is written and the error is
+      WHEEL_OUT_OF_RANGE.  A buffer of max_number_chars always suffices.
+   */
+   number_result to_chars(char* first, char* last, int32_t value);
+   number_result to_chars(char* first, char* last, int64_t value);
+   number_result to_chars(char* first, char* last, uint32_t value);
+   number_result to_chars(char* first, char* last, uint64_t value);
+   number_result to_chars(char* first, char* last, double value);
+
+   //! Parse a number from the start of a view
+   /*!
+      Reads the characters straight from the view, whatever its width, and
+      never allocates.  Leading whitespace is not skipped and parsing stops at
+      the first character that is not part of the number, length tells how
+      far it got.  value is only modified on success.
+
+      Integers take an optional '-' and digits in the given base, 2 to 36.
+      Base 0 picks the base from the prefix like strtoul() does: "0x" for 16,
+      "0" for 8, otherwise 10.  Unsigned types do not accept '-'.
+
+      Doubles take an optional '-', digits with an optional fraction and
+      exponent, or "inf", "infinity" and "nan" in any case.
+   */
+   number_result from_chars(const string_ref& text, int32_t& value, int base = 10);
+   number_result from_chars(const string_ref& text, int64_t& value, int base = 10);
+   number_result from_chars(const string_ref& text, uint32_t& value, int base = 10);
+   number_result from_chars(const string_ref& text, uint64_t& value, int base = 10);
+   number_result from_chars(const string_ref& text, double& value);
+}
+
+#endif //WHEEL_CHARCONV_HEADER
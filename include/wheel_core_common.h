@@ -9,7 +9,10 @@
 
 #include <cstdint>
 #include <cstdlib>
+#include <cstring>
 #include <cassert>
+#include <algorithm>
+#include <type_traits>
 #include <vector>
 #include <unordered_map>
 #include <list>
@@ -25,6 +28,13 @@
    #define WHEEL_DEBUG_LEVEL 4
 #endif
 
+// Byte order of the target, Windows targets are all little-endian
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+   #define WHEEL_BIG_ENDIAN_HOST 1
+#else
+   #define WHEEL_BIG_ENDIAN_HOST 0
+#endif
+
 #if WHEEL_DEBUG_LEVEL==0
    #define WCL_DEBUG_VERBOSE     if(0) wheel::log
    #define WCL_DEBUG             if(0) wheel::log
@@ -83,6 +93,7 @@
 #define WHEEL_UNINITIALISED_RESOURCE      0x0008
 #define WHEEL_INVALID_FORMAT              0x0009
 #define WHEEL_UNINITIALISED_DEPENDENCY    0x000a
+#define WHEEL_OUT_OF_RANGE                0x000b
 #define WHEEL_ERROR                       0xffff
 
 #define WHEEL_ERROR_INIT_FILESYSTEM       0x0100
@@ -222,36 +233,128 @@ namespace wheel
 
    //! Checks if the system is big-endian
    /*!
-      Performs fast check if the system is big-endian
+      Known at compile time, so branches on it are removed.
    */
-   inline bool big_endian()
+   constexpr bool big_endian()
    {
-      uint16_t t = 0xbe1e;
-      if ((uint8_t) *(&t) == 0x1e)
-         return false;
-
-      return true;
+      return WHEEL_BIG_ENDIAN_HOST != 0;
    }
 
-   //! Swaps endianness of an value
+   //! Reverses the bytes of an integer
    /*!
-       Swaps endianness of an value
+      Comes out as a single bswap, rev or similar instruction.
    */
-   template <typename T>
-   T endian_swap(T value)
+   inline uint8_t byte_swap(uint8_t value)
+   {
+      return value;
+   }
+
+   inline uint16_t byte_swap(uint16_t value)
+   {
+#ifdef __GNUC__
+      return __builtin_bswap16(value);
+#else
+      return (uint16_t)((value >> 8) | (value << 8));
+#endif
+   }
+
+   inline uint32_t byte_swap(uint32_t value)
+   {
+#ifdef __GNUC__
+      return __builtin_bswap32(value);
+#else
+      return  (value >> 24) | ((value >> 8) & 0xff00) | ((value << 8) & 0xff0000) | (value << 24);
+#endif
+   }
+
+   inline uint64_t byte_swap(uint64_t value)
    {
-      union
+#ifdef __GNUC__
+      return __builtin_bswap64(value);
+#else
+      return ((uint64_t)byte_swap((uint32_t)value) << 32) | byte_swap((uint32_t)(value >> 32));
+#endif
+   }
+
+   namespace internal
+   {
+      template <size_t Size> struct uint_of_size {};
+      template <> struct uint_of_size<1> { typedef uint8_t  type; };
+      template <> struct uint_of_size<2> { typedef uint16_t type; };
+      template <> struct uint_of_size<4> { typedef uint32_t type; };
+      template <> struct uint_of_size<8> { typedef uint64_t type; };
+
+      //! Values of integer sizes are swapped as that integer
+      template <typename T>
+      inline T endian_swap(T value, typename uint_of_size<sizeof(T)>::type*)
+      {
+         typename uint_of_size<sizeof(T)>::type bits;
+
+         memcpy(&bits, &value, sizeof(T));
+         bits = byte_swap(bits);
+         memcpy(&value, &bits, sizeof(T));
+
+         return value;
+      }
+
+      //! Other sizes byte by byte
+      template <typename T>
+      inline T endian_swap(T value, ...)
       {
-         T value;
-         uint8_t value_u8[sizeof(T)];
-      } src, dst;
+         uint8_t bytes[sizeof(T)];
 
-      src.value = value;
+         memcpy(bytes, &value, sizeof(T));
+         std::reverse(bytes, bytes + sizeof(T));
+         memcpy(&value, bytes, sizeof(T));
 
-      for (size_t i = 0; i < sizeof(T); ++i)
-         dst.value_u8[i] = src.value_u8[sizeof(T)-1-i];
+         return value;
+      }
+   }
+
+   //! Swaps endianness of an value
+   template <typename T>
+   inline T endian_swap(T value)
+   {
+      static_assert(std::is_trivially_copyable<T>::value, "endian_swap needs a trivially copyable value");
+      return internal::endian_swap(value, nullptr);
+   }
+
+   //! Loads a big-endian value from memory at any alignment
+   template <typename T>
+   inline T load_be(const void* src)
+   {
+      T rval;
+      memcpy(&rval, src, sizeof(T));
 
-      return dst.value;
+      return big_endian() ? rval : endian_swap(rval);
+   }
+
+   //! Loads a little-endian value from memory at any alignment
+   template <typename T>
+   inline T load_le(const void* src)
+   {
+      T rval;
+      memcpy(&rval, src, sizeof(T));
+
+      return big_endian() ? endian_swap(rval) : rval;
+   }
+
+   template <typename T>
+   inline void store_be(void* dst, T value)
+   {
+      if (!big_endian())
+         value = endian_swap(value);
+
+      memcpy(dst, &value, sizeof(T));
+   }
+
+   template <typename T>
+   inline void store_le(void* dst, T value)
+   {
+      if (big_endian())
+         value = endian_swap(value);
+
+      memcpy(dst, &value, sizeof(T));
    }
 
    //! Performs circular rotation right (ror on x86)
@@ -301,8 +404,72 @@ namespace wheel
 
          inline void from_stl_string(const std::string& s)
          {
-            this->clear();
-            std::copy(s.begin(), s.end(), back_inserter(*this));
+            this->assign(s.begin(), s.end());
+         }
+
+         //! Make room for n more bytes
+         /*!
+            Grows the capacity at least twice as large, so that appending a
+            piece at a time stays amortised O(1).  reserve(size() + n) would
+            reallocate for every piece.
+         */
+         inline void reserve_extra(size_t n)
+         {
+            if (this->capacity() - this->size() < n)
+               this->reserve(std::max(this->size() + n, 2 * this->capacity()));
+         }
+
+         //! Append raw bytes
+         inline void append(const void* src, size_t n)
+         {
+            if (n == 0)
+               return;
+
+            reserve_extra(n);
+
+            this->insert(this->end(), (const uint8_t*)src, (const uint8_t*)src + n);
+         }
+
+         //! Write an array of little-endian values
+         template <typename T>
+         inline void write_span(const T* values, size_t count)
+         {
+            write_span_le(values, count);
+         }
+
+         template <typename T>
+         inline void write_span_le(const T* values, size_t count)
+         {
+            static_assert(std::is_trivially_copyable<T>::value, "write_span_le needs trivially copyable values");
+
+            if (!big_endian() || sizeof(T) == 1)
+            {
+               append(values, count * sizeof(T));
+               return;
+            }
+
+            reserve_extra(count * sizeof(T));
+
+            for (size_t i = 0; i < count; ++i)
+               write_swapped(values[i]);
+         }
+
+         //! Write an array of big-endian values
+         template <typename T>
+         inline void write_span_be(const T* values, size_t count)
+         {
+            static_assert(std::is_trivially_copyable<T>::value, "write_span_be needs trivially copyable values");
+
+            if (big_endian() || sizeof(T) == 1)
+            {
+               append(values, count * sizeof(T));
+               return;
+            }
+
+            reserve_extra(count * sizeof(T));
+
+            for (size_t i = 0; i < count; ++i)
+               write_swapped(values[i]);
          }
 
 /*
@@ -329,93 +496,101 @@ namespace wheel
             return true;
          };
 
+         //! Read a little-endian value, the default byte order of buffers
+         /*!
+            Reads past the end throw std::out_of_range, as at() does.  Code
+            that has checked the size already can use read_le_unchecked()
+            and read_be_unchecked().
+         */
          template <typename T>
          inline T read(size_t where) const
          {
-            T rval = *(T*)&(this->at(where));
-
-            if (big_endian())
-               rval = endian_swap(rval);
-
-            return rval;
+            return read_le<T>(where);
          }
 
          template <typename T>
          inline T read()
          {
-            T rval = *(T*)&(this->at(read_ptr));
-
-            if (big_endian())
-               rval = endian_swap(rval);
-
-            read_ptr += sizeof(T);
-
-            return rval;
+            return read_le<T>();
          }
 
          template <typename T>
          inline T read_le(size_t where) const
          {
-            T rval = *(T*)&(this->at(where));
+            T rval = load<T>(where);
+            return big_endian() ? endian_swap(rval) : rval;
+         }
 
-            if (!big_endian())
-               rval = endian_swap(rval);
+         template <typename T>
+         inline T read_le()
+         {
+            T rval = read_le<T>(read_ptr);
+            read_ptr += sizeof(T);
 
             return rval;
          }
 
+         //! Read a big-endian value
          template <typename T>
-         inline T read_le()
+         inline T read_be(size_t where) const
          {
-            T rval = *(T*)&(this->at(read_ptr));
-
-            if (!big_endian())
-               rval = endian_swap(rval);
+            T rval = load<T>(where);
+            return big_endian() ? rval : endian_swap(rval);
+         }
 
+         template <typename T>
+         inline T read_be()
+         {
+            T rval = read_be<T>(read_ptr);
             read_ptr += sizeof(T);
 
             return rval;
          }
 
-
+         //! Read a little-endian value that is known to be there
          template <typename T>
-         inline void write(const T& data)
+         inline T read_le_unchecked(size_t where) const
          {
-            this->reserve(this->size() + sizeof(T));
-
-            uint8_t* dataptr = nullptr;
-            T t_val;
+            T rval = load_unchecked<T>(where);
+            return big_endian() ? endian_swap(rval) : rval;
+         }
 
-            if (big_endian())
-            {
-               t_val = endian_swap(data);
-               dataptr = (uint8_t*)&t_val;
-            } else {
-               dataptr = (uint8_t*)&data;
-            }
+         //! Read a big-endian value that is known to be there
+         template <typename T>
+         inline T read_be_unchecked(size_t where) const
+         {
+            T rval = load_unchecked<T>(where);
+            return big_endian() ? rval : endian_swap(rval);
+         }
 
-            for (size_t it = 0; it < sizeof(T); ++it)
-               this->push_back(*(dataptr+it));
+         //! Write a little-endian value, the default byte order of buffers
+         template <typename T>
+         inline void write(const T& data)
+         {
+            write_le(data);
          }
 
          template <typename T>
          inline void write_le(const T& data)
          {
-            this->reserve(this->size() + sizeof(T));
+            static_assert(std::is_trivially_copyable<T>::value, "write_le needs a trivially copyable value");
 
-            uint8_t* dataptr = nullptr;
-            T t_val;
+            if (big_endian())
+               write_swapped(data);
+            else
+               append(&data, sizeof(T));
+         }
 
-            if (!big_endian())
-            {
-               t_val = endian_swap(data);
-               dataptr = (uint8_t*)&t_val;
-            } else {
-               dataptr = (uint8_t*)&data;
-            }
+         //! Write a big-endian value
+         template <typename T>
+         inline void write_be(const T& data)
+         {
+            static_assert(std::is_trivially_copyable<T>::value, "write_be needs a trivially copyable value");
 
-            for (size_t it = 0; it < sizeof(T); ++it)
-               this->push_back(*(dataptr+it));
+            if (big_endian())
+               append(&data, sizeof(T));
+            else
+               write_swapped(data);
          }
 
          inline void write_byte()
@@ -433,11 +608,15 @@ namespace wheel
             this->write<uint8_t>(byte);
             this->write_byte(bytes...);
          }
+         inline void write_bytes()
+         {
+         }
+
          template <typename... Ts>
          inline void write_bytes(Ts... bytes)
          {
-            this->reserve(this->size() + sizeof...(bytes));
-            this->write_byte(bytes...);
+            const uint8_t values[] = { (uint8_t)bytes... };
+            append(values, sizeof...(bytes));
          }
 
          inline size_t pos() const
@@ -449,12 +628,43 @@ namespace wheel
          {
             if (target < size()) read_ptr = target;
          }
+
+      private:
+         //! Loads a value in native byte order, unaligned
+         template <typename T>
+         inline T load(size_t where) const
+         {
+            // Throws for the first byte that is not there
+            if (where > size() || sizeof(T) > size() - where)
+               (void)this->at(std::max(where, size()));
+
+            return load_unchecked<T>(where);
+         }
+
+         template <typename T>
+         inline T load_unchecked(size_t where) const
+         {
+            static_assert(std::is_trivially_copyable<T>::value, "read needs a trivially copyable value");
+            assert(where <= size() && sizeof(T) <= size() - where);
+
+            T rval;
+            memcpy(&rval, this->data() + where, sizeof(T));
+
+            return rval;
+         }
+
+         template <typename T>
+         inline void write_swapped(const T& data)
+         {
+            T swapped = endian_swap(data);
+            append(&swapped, sizeof(T));
+         }
    };
 
    template<>
    inline void buffer_t::write(const buffer_t& buf)
    {
-      this->insert(std::end(*this), std::begin(buf), std::end(buf));
+      append(buf.data(), buf.size());
    }
 
    /*!
@@ -502,6 +712,22 @@ namespace wheel
 
 namespace wheel
 {
+   //! Per-process random seed of Hash<> and hash_with<>
+   /*!
+      0 unless the library is built with WHEEL_SEEDED_HASH, then Hash<> is
+      plain FNV-1a and names hashed at compile time are used as they are.
+      Programs that load names from untrusted archives can turn seeding on:
+      the seed is chosen once per process, so names crafted to collide in
+      one run do not collide in the next and cannot flood the hash tables.
+   */
+   uint64_t hash_seed() noexcept;
+
+   namespace internal
+   {
+      //! Seeded 64-bit hash of raw bytes, salt tells apart keys of different kinds
+      size_t seeded_hash(const void* data, size_t length, uint64_t salt) noexcept;
+   }
+
    // This voodoo is to find out whether size_t is 8 or 4 bytes long, it could be
    // easily extended to different sizes, but for now this is enough.
    template<typename T, bool is_x86_64 = size_t_x64()>
@@ -524,6 +750,9 @@ namespace wheel
             if (s.size() == 0)
                return 0;
 
+            if (hash_seed() != 0)
+               return internal::seeded_hash(s.getptr(), s.size(), 0);
+
             size_t hash  = 0xCBF29CE484222325;
             const uint64_t prime = 0x100000001B3;
 
@@ -548,6 +777,9 @@ namespace wheel
             if (s.size() == 0)
                return 0;
 
+            if (hash_seed() != 0)
+               return internal::seeded_hash(s.getptr(), s.size(), 0);
+
             size_t hash = 0x811C9DC5;
             const uint32_t prime = 0x1000193;
 
@@ -563,9 +795,9 @@ namespace wheel
    };
 
    /*!
-      Return hash of the string, note that the hash is not currently cached.
+      Return hash of the buffer, note that the hash is not currently cached.
 
-      \return FNV-1a hash.
+      \return Seeded hash, or FNV-1a if hashing is deterministic.
    */
    inline size_t buffer_t::hash() const noexcept
    {
@@ -580,8 +812,6 @@ namespace wheel
    int         initialise(int argc, char* argv[]);
    void        terminate();
 
-   bool        big_endian();
-
    static std::unordered_map<std::string, std::string> arguments;
 }
 
@@ -2,7 +2,11 @@
 #define WHEEL_CORE_EVENT_HEADER
 
 #include "wheel_core_string.h"
+#include "wheel_core_hash.h"
+#include "wheel_core_symbol.h"
 #include "wheel_core_utility.h"
+#include "wheel_core_flat_map.h"
+#include "wheel_core_buffer_pool.h"
 
 #include <unordered_map>
 
@@ -22,6 +26,8 @@ namespace wheel
 
    //! Event
    /*!
+      The data of events is taken from and given back to the buffer pool,
+      as events are created and dropped every frame.
    */
    class Event
    {
@@ -29,18 +35,26 @@ namespace wheel
          buffer_t    data;
 
          string      get_event_string() const;
+
+         Event();
+         Event(const Event& other);
+         Event(Event&& other);
+        ~Event();
+
+         Event& operator=(const Event& other);
+         Event& operator=(Event&& other);
    };
 
    typedef std::list<Event> EventList;
 
    struct eventinfo_t
    {
-      wcl::string                            ident;
+      wheel::symbol                          ident;
       std::function<void(wheel::Event& e)>   func;
    };
 
    // Move to .cpp?
-   typedef std::unordered_map<wheel::buffer_t, eventinfo_t> eventlinks_t;
+   typedef wheel::flat_map<wheel::buffer_t, eventinfo_t, wheel::fast_hash<wheel::buffer_t>> eventlinks_t;
 
    struct event_map_t
    {
@@ -53,12 +67,7 @@ namespace wheel
    inline wheel::Event describe_event(Args ... codes)
    {
       wheel::Event rval;
-      uint8_t args[] { (uint8_t)codes ... };
-
-      for (uint8_t c : args)
-      {
-         rval.data.push_back(c);
-      }
+      rval.data.write_bytes(codes...);
 
       return rval;
    }
@@ -107,7 +116,11 @@ namespace wheel
 
 //         bool           is_active() const;
          void           map_event(const wheel::Event&, const wheel::string& ident, std::function<void(wheel::Event&)>);
+         void           map_event(const wheel::Event&, const wheel::symbol& ident, std::function<void(wheel::Event&)>);
+         void           map_event(const wheel::Event&, const wheel::hashed_name& ident, std::function<void(wheel::Event&)>);
          void           unmap_event(const wheel::string& ident);
+         void           unmap_event(const wheel::symbol& ident);
+         void           unmap_event(const wheel::hashed_name& ident);
 
          void           process(EventList& el);
          void           process();
@@ -0,0 +1,542 @@
+/*!
+   @file
+   \brief Contains definitions for the open addressing hash map
+   \author Jari Ronkainen
+*/
+
+#ifndef WHEEL_FLAT_MAP_HEADER
+#define WHEEL_FLAT_MAP_HEADER
+
+#include "wheel_core_common.h"
+
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <tuple>
+
+namespace wheel
+{
+   //! Hash map with open addressing
+   /*!
+      Entries live in a single array, placed with Robin Hood linear probing:
+      an entry that is further from its home bucket takes the place of one
+      that is closer, which keeps every probe sequence short.  Each bucket
+      remembers the full hash of its key and its distance from home, so
+      lookups compare keys only when the hashes are equal and stop as soon as
+      they pass the distance the key could be at.  Erasing shifts the
+      following entries back instead of leaving tombstones.
+
+      The table grows to twice its size when it becomes 7/8 full.  Inserting
+      and erasing move entries, so they invalidate iterators and pointers to
+      values, unlike std::unordered_map.  As in std::unordered_map, entries
+      are std::pair<const K, V>, so keys cannot be changed in place.  They
+      are stored as std::pair<K, V>, so the map itself can move keys.
+
+      Keys can be looked up with any type that compares equal to the key
+      type and hashes the same, such as a string_ref in a map keyed by
+      strings, or with a hash that was computed beforehand.
+
+      Example usage:
+      \code
+         wheel::flat_map<wheel::string, int, wheel::fast_hash<wheel::string>> shaders;
+
+         shaders.try_emplace(wheel::string("default"), 3);
+
+         auto it = shaders.find(wheel::string_ref(U"default"));
+
+         if (it != shaders.end())
+            use(it->second);
+      \endcode
+   */
+   template <typename K, typename V, typename H = Hash<K>, typename E = std::equal_to<K>>
+   class flat_map
+   {
+      public:
+         typedef K                  key_type;
+         typedef V                  mapped_type;
+         typedef std::pair<const K, V>    value_type;
+
+      private:
+         //! Storage of an entry, seen as a value_type through the iterators
+         typedef std::pair<K, V>    slot_t;
+
+         struct bucket_t
+         {
+            size_t   hash;
+
+            //! Distance from the home bucket plus one, 0 for an empty bucket
+            uint32_t distance;
+         };
+
+         //! Iterator over the occupied buckets
+         template <typename T>
+         class basic_iterator
+         {
+            private:
+               typedef typename std::conditional<std::is_const<T>::value, const slot_t, slot_t>::type stored_t;
+
+               const bucket_t*   bucket;
+               const bucket_t*   last;
+               stored_t*         value;
+
+               inline void skip()
+               {
+                  while (bucket != last && bucket->distance == 0)
+                  {
+                     ++bucket;
+                     ++value;
+                  }
+               }
+
+               friend class flat_map;
+
+               template <typename U>
+               friend class basic_iterator;
+
+            public:
+               typedef std::forward_iterator_tag   iterator_category;
+               typedef std::pair<const K, V>       value_type;
+               typedef ptrdiff_t                   difference_type;
+               typedef T*                          pointer;
+               typedef T&                          reference;
+
+               basic_iterator() : bucket(nullptr), last(nullptr), value(nullptr) {}
+               basic_iterator(const bucket_t* b, const bucket_t* l, stored_t* v) : bucket(b), last(l), value(v) { skip(); }
+
+               //! Iterators convert to const iterators
+               template <typename U>
+               basic_iterator(const basic_iterator<U>& o) : bucket(o.bucket), last(o.last), value(o.value) {}
+
+               inline T& operator*() const { return *as_value(value); }
+               inline T* operator->() const { return as_value(value); }
+
+               inline basic_iterator& operator++() { ++bucket; ++value; skip(); return *this; }
+               inline basic_iterator operator++(int) { basic_iterator r(*this); ++(*this); return r; }
+
+               inline bool operator==(const basic_iterator& o) const { return bucket == o.bucket; }
+               inline bool operator!=(const basic_iterator& o) const { return bucket != o.bucket; }
+         };
+
+      public:
+         typedef basic_iterator<value_type>        iterator;
+         typedef basic_iterator<const value_type>  const_iterator;
+
+      private:
+         static const size_t npos = ~(size_t)0;
+         static const size_t min_capacity = 8;
+
+         bucket_t*      buckets;
+         slot_t*        values;
+
+         //! Capacity minus one, capacity is zero or a power of two
+         size_t         mask;
+         size_t         used;
+
+         H              hasher;
+         E              equal;
+
+         inline size_t capacity_of() const { return buckets ? mask + 1 : 0; }
+
+         //! An entry as users of the map see it, with a const key
+         static inline value_type* as_value(slot_t* slot) { return reinterpret_cast<value_type*>(slot); }
+         static inline const value_type* as_value(const slot_t* slot) { return reinterpret_cast<const value_type*>(slot); }
+
+         //! Move an entry to an unused slot and destroy it where it was
+         static inline void relocate(slot_t* dst, slot_t* src)
+         {
+            new (dst) slot_t(std::move(*src));
+            src->~slot_t();
+         }
+
+         //! Most entries the table holds before it grows
+         static inline size_t max_load(size_t capacity) { return capacity - capacity / 8; }
+
+         inline bool same_key(const K& stored, const K& key) const { return equal(stored, key); }
+
+         template <typename Q>
+         inline bool same_key(const K& stored, const Q& key) const { return key == stored; }
+
+         template <typename Q>
+         size_t find_index(const Q& key, size_t hash) const
+         {
+            if (used == 0)
+               return npos;
+
+            size_t i = hash & mask;
+
+            for (uint32_t d = 1;; ++d, i = (i + 1) & mask)
+            {
+               const bucket_t& b = buckets[i];
+
+               // An empty bucket, or an entry closer to home than the key would be
+               if (b.distance < d)
+                  return npos;
+
+               if (b.hash == hash && same_key(values[i].first, key))
+                  return i;
+            }
+         }
+
+         //! Free the bucket a key that is not in the table belongs in, returns its index
+         /*!
+            Entries are ordered by their home bucket, so making room is
+            shifting the entries between the key's place and the next empty
+            bucket one step on.  The bucket is marked used, the caller must
+            construct the value in it.
+         */
+         size_t make_room(size_t hash)
+         {
+            size_t i = hash & mask;
+            uint32_t d = 1;
+
+            // Entries at least as far from home as the key stay in place
+            while (buckets[i].distance >= d)
+            {
+               i = (i + 1) & mask;
+               ++d;
+            }
+
+            size_t j = i;
+
+            while (buckets[j].distance != 0)
+               j = (j + 1) & mask;
+
+            while (j != i)
+            {
+               size_t prev = (j - 1) & mask;
+
+               relocate(&values[j], &values[prev]);
+
+               buckets[j].hash = buckets[prev].hash;
+               buckets[j].distance = buckets[prev].distance + 1;
+
+               j = prev;
+            }
+
+            buckets[i].hash = hash;
+            buckets[i].distance = d;
+
+            return i;
+         }
+
+         void allocate(size_t capacity)
+         {
+            buckets = new bucket_t[capacity]();
+            values = static_cast<slot_t*>(::operator new(capacity * sizeof(slot_t)));
+            mask = capacity - 1;
+         }
+
+         void release()
+         {
+            if (buckets == nullptr)
+               return;
+
+            for (size_t i = 0; i <= mask; ++i)
+               if (buckets[i].distance != 0)
+                  values[i].~slot_t();
+
+            delete[] buckets;
+            ::operator delete(values);
+
+            buckets = nullptr;
+            values = nullptr;
+            mask = 0;
+            used = 0;
+         }
+
+         void rehash(size_t capacity)
+         {
+            bucket_t* old_buckets = buckets;
+            slot_t* old_values = values;
+            size_t old_capacity = capacity_of();
+
+            allocate(capacity);
+
+            for (size_t i = 0; i < old_capacity; ++i)
+            {
+               if (old_buckets[i].distance != 0)
+               {
+                  size_t j = make_room(old_buckets[i].hash);
+
+                  relocate(&values[j], &old_values[i]);
+               }
+            }
+
+            delete[] old_buckets;
+            ::operator delete(old_values);
+         }
+
+         inline void grow_for_one()
+         {
+            size_t capacity = capacity_of();
+
+            if (used + 1 > max_load(capacity))
+               rehash(capacity ? capacity * 2 : min_capacity);
+         }
+
+         //! Remove the entry at i, shifting the entries after it back
+         void erase_index(size_t i)
+         {
+            values[i].~slot_t();
+
+            size_t next = (i + 1) & mask;
+
+            while (buckets[next].distance > 1)
+            {
+               relocate(&values[i], &values[next]);
+
+               buckets[i].hash = buckets[next].hash;
+               buckets[i].distance = buckets[next].distance - 1;
+
+               i = next;
+               next = (next + 1) & mask;
+            }
+
+            buckets[i].distance = 0;
+            --used;
+         }
+
+         inline iterator iterator_at(size_t i)
+         {
+            if (i == npos)
+               return end();
+
+            return iterator(buckets + i, buckets + capacity_of(), values + i);
+         }
+
+         inline const_iterator iterator_at(size_t i) const
+         {
+            if (i == npos)
+               return end();
+
+            return const_iterator(buckets + i, buckets + capacity_of(), values + i);
+         }
+
+         //! Types other than the key type that find() accepts
+         template <typename Q>
+         using other_key = typename std::enable_if<!std::is_convertible<const Q&, const K&>::value>::type;
+
+      public:
+         flat_map() : buckets(nullptr), values(nullptr), mask(0), used(0) {}
+
+         flat_map(const flat_map& other) : buckets(nullptr), values(nullptr), mask(0), used(0),
+                                           hasher(other.hasher), equal(other.equal)
+         {
+            *this = other;
+         }
+
+         flat_map(flat_map&& other) : buckets(other.buckets), values(other.values), mask(other.mask), used(other.used),
+                                      hasher(std::move(other.hasher)), equal(std::move(other.equal))
+         {
+            other.buckets = nullptr;
+            other.values = nullptr;
+            other.mask = 0;
+            other.used = 0;
+         }
+
+         ~flat_map()
+         {
+            release();
+         }
+
+         flat_map& operator=(const flat_map& other)
+         {
+            if (this == &other)
+               return *this;
+
+            release();
+
+            // The entries are placed by the hashes of the other map
+            hasher = other.hasher;
+            equal = other.equal;
+
+            if (other.buckets == nullptr)
+               return *this;
+
+            // Same capacity, so every entry goes to the same bucket
+            allocate(other.capacity_of());
+
+            for (size_t i = 0; i <= mask; ++i)
+            {
+               buckets[i] = other.buckets[i];
+
+               if (buckets[i].distance != 0)
+                  new (&values[i]) slot_t(other.values[i]);
+            }
+
+            used = other.used;
+
+            return *this;
+         }
+
+         flat_map& operator=(flat_map&& other)
+         {
+            if (this == &other)
+               return *this;
+
+            release();
+
+            using std::swap;
+
+            swap(buckets, other.buckets);
+            swap(values, other.values);
+            swap(mask, other.mask);
+            swap(used, other.used);
+            swap(hasher, other.hasher);
+            swap(equal, other.equal);
+
+            return *this;
+         }
+
+         inline size_t size() const { return used; }
+         inline bool empty() const { return used == 0; }
+
+         //! Number of buckets
+         inline size_t capacity() const { return capacity_of(); }
+
+         //! Make room for n entries without growing
+         void reserve(size_t n)
+         {
+            size_t capacity = min_capacity;
+
+            while (max_load(capacity) < n)
+               capacity *= 2;
+
+            if (capacity > capacity_of())
+               rehash(capacity);
+         }
+
+         //! Remove all entries, keeping the memory
+         void clear()
+         {
+            for (size_t i = 0; i < capacity_of(); ++i)
+            {
+               if (buckets[i].distance != 0)
+               {
+                  values[i].~slot_t();
+                  buckets[i].distance = 0;
+               }
+            }
+
+            used = 0;
+         }
+
+         iterator begin() { return iterator(buckets, buckets + capacity_of(), values); }
+         iterator end() { return iterator(buckets + capacity_of(), buckets + capacity_of(), values + capacity_of()); }
+
+         const_iterator begin() const { return const_iterator(buckets, buckets + capacity_of(), values); }
+         const_iterator end() const { return const_iterator(buckets + capacity_of(), buckets + capacity_of(), values + capacity_of()); }
+
+         iterator find(const K& key) { return iterator_at(find_index(key, hasher(key))); }
+         const_iterator find(const K& key) const { return iterator_at(find_index(key, hasher(key))); }
+
+         //! Find with a key of another type, which the hash function must accept and key == stored must compare
+         template <typename Q, typename = other_key<Q>>
+         iterator find(const Q& key) { return iterator_at(find_index(key, hasher(key))); }
+
+         template <typename Q, typename = other_key<Q>>
+         const_iterator find(const Q& key) const { return iterator_at(find_index(key, hasher(key))); }
+
+         //! Find with a hash computed beforehand, the hash must equal the hash of the stored key
+         template <typename Q>
+         iterator find(const Q& key, size_t hash) { return iterator_at(find_index(key, hash)); }
+
+         template <typename Q>
+         const_iterator find(const Q& key, size_t hash) const { return iterator_at(find_index(key, hash)); }
+
+         inline bool contains(const K& key) const { return find_index(key, hasher(key)) != npos; }
+         inline size_t count(const K& key) const { return contains(key) ? 1 : 0; }
+
+         //! Insert a value constructed from args, unless the key is already in the map
+         /*!
+            The key is hashed once, and nothing is constructed if it is found.
+
+            \return  Iterator to the entry with the key, and whether it was inserted.
+         */
+         template <typename... Args>
+         std::pair<iterator, bool> try_emplace(const K& key, Args&&... args)
+         {
+            size_t hash = hasher(key);
+            size_t i = find_index(key, hash);
+
+            if (i != npos)
+               return std::make_pair(iterator_at(i), false);
+
+            grow_for_one();
+
+            i = make_room(hash);
+            new (&values[i]) slot_t(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(std::forward<Args>(args)...));
+            ++used;
+
+            return std::make_pair(iterator_at(i), true);
+         }
+
+         template <typename... Args>
+         std::pair<iterator, bool> try_emplace(K&& key, Args&&... args)
+         {
+            size_t hash = hasher(key);
+            size_t i = find_index(key, hash);
+
+            if (i != npos)
+               return std::make_pair(iterator_at(i), false);
+
+            grow_for_one();
+
+            i = make_room(hash);
+            new (&values[i]) slot_t(std::piecewise_construct, std::forward_as_tuple(std::move(key)), std::forward_as_tuple(std::forward<Args>(args)...));
+            ++used;
+
+            return std::make_pair(iterator_at(i), true);
+         }
+
+         std::pair<iterator, bool> insert(const value_type& entry) { return try_emplace(entry.first, entry.second); }
+         std::pair<iterator, bool> insert(value_type&& entry) { return try_emplace(entry.first, std::move(entry.second)); }
+
+         //! Value of a key, inserting a default constructed value if it is not there
+         V& operator[](const K& key) { return try_emplace(key).first->second; }
+         V& operator[](K&& key) { return try_emplace(std::move(key)).first->second; }
+
+         //! Erase the entry at an iterator, other iterators are invalidated
+         void erase(const_iterator it)
+         {
+            erase_index(it.bucket - buckets);
+         }
+
+         //! Erase a key, returns the number of entries erased
+         size_t erase(const K& key)
+         {
+            size_t i = find_index(key, hasher(key));
+
+            if (i == npos)
+               return 0;
+
+            erase_index(i);
+            return 1;
+         }
+
+         //! Erase every entry the predicate returns true for, returns the number erased
+         template <typename P>
+         size_t erase_if(P pred)
+         {
+            size_t erased = 0;
+
+            // After an erase the next entry has moved into i, so look at i again.
+            // An entry may wrap around from the start and be looked at twice.
+            for (size_t i = 0; i < capacity_of();)
+            {
+               if (buckets[i].distance != 0 && pred(*as_value(&values[i])))
+               {
+                  erase_index(i);
+                  ++erased;
+               } else {
+                  ++i;
+               }
+            }
+
+            return erased;
+         }
+   };
+}
+
+#endif //WHEEL_FLAT_MAP_HEADER
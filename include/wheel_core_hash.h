@@ -0,0 +1,190 @@
+/*!
+   @file
+   \brief Contains definitions for the selectable hash functions
+   \author Jari Ronkainen
+*/
+
+#ifndef WHEEL_HASH_HEADER
+#define WHEEL_HASH_HEADER
+
+#include "wheel_core_common.h"
+#include "wheel_core_string.h"
+#include "wheel_core_string_ref.h"
+
+namespace wheel
+{
+   //! FNV-1a one byte at a time
+   /*!
+      Slow, but simple and stable.  Kept for data that must hash the same way
+      as before.
+   */
+   struct fnv1a_policy
+   {
+      static size_t hash_bytes(const void* data, size_t length, uint64_t seed) noexcept;
+
+      //! hash_bytes() of the characters stored width bytes each, without storing them
+      static size_t hash_chars(const string_ref& s, uint8_t width, uint64_t seed) noexcept;
+   };
+
+   //! wyhash, 64-bit hash eight bytes at a time
+   /*!
+      Keys up to 16 bytes are hashed with two 64-bit multiplies, longer ones
+      consume 48 bytes per round.  Passes SMHasher and is several times
+      faster than FNV-1a on anything but single characters.  On 32-bit
+      targets the 64-bit result is truncated.
+   */
+   struct wyhash_policy
+   {
+      static size_t hash_bytes(const void* data, size_t length, uint64_t seed) noexcept;
+
+      //! hash_bytes() of the characters stored width bytes each, without storing them
+      static size_t hash_chars(const string_ref& s, uint8_t width, uint64_t seed) noexcept;
+   };
+
+   namespace internal
+   {
+      //! Narrowest width the characters of a view fit in
+      uint8_t narrowest_width(const string_ref& s) noexcept;
+
+      //! wyhash with the full 64-bit result on every target, for hashes that are stored
+      uint64_t wyhash64(const void* data, size_t length, uint64_t seed) noexcept;
+      uint64_t wyhash64(const string_ref& s, uint8_t width, uint64_t seed) noexcept;
+   }
+
+   //! Hash functor with a selectable hash function
+   /*!
+      Unlike wheel::Hash, which hashes the characters of a string as UTF-32
+      when hashing is deterministic so that compile time hashes can match it,
+      hash_with always hashes the bytes of the storage.  Strings are always stored at the narrowest width
+      their characters fit in, so equal strings have equal bytes.  The width
+      is mixed into the seed, which keeps "\x01\0" and "\u0001" apart.  The
+      seed is hash_seed(), so the hashes change from run to run when the
+      library is built with WHEEL_SEEDED_HASH.
+
+      Choose it per container:
+      \code
+         std::unordered_map<wheel::string, int, wheel::fast_hash<wheel::string>> names;
+      \endcode
+
+      string and string_ref hash the same way, so a map keyed by strings can
+      be searched with a view hashed by hash_with<string_ref>.
+   */
+   template <typename T, typename Policy>
+   class hash_with;
+
+   template <typename Policy>
+   class hash_with<string_ref, Policy>
+   {
+      public:
+         size_t operator()(const string_ref& s) const noexcept
+         {
+            // Views of literals may be wider than their characters need
+            if (s.char_width() != 1)
+            {
+               uint8_t width = internal::narrowest_width(s);
+
+               if (width != s.char_width())
+                  return Policy::hash_chars(s, width, hash_seed() ^ width);
+            }
+
+            return Policy::hash_bytes(s.raw_data(), s.length() * s.char_width(), hash_seed() ^ s.char_width());
+         }
+   };
+
+   template <typename Policy>
+   class hash_with<string, Policy>
+   {
+      public:
+         size_t operator()(const string& s) const noexcept
+         {
+            return Policy::hash_bytes(s.raw_data(), s.length() * s.char_width(), hash_seed() ^ s.char_width());
+         }
+
+         //! Views hash like the strings they equal, for lookups without a string
+         size_t operator()(const string_ref& s) const noexcept
+         {
+            return hash_with<string_ref, Policy>()(s);
+         }
+   };
+
+   template <typename Policy>
+   class hash_with<buffer_t, Policy>
+   {
+      public:
+         size_t operator()(const buffer_t& b) const noexcept
+         {
+            return Policy::hash_bytes(b.data(), b.size(), hash_seed());
+         }
+   };
+
+   //! The fast default for containers that do not need FNV-1a
+   template <typename T>
+   using fast_hash = hash_with<T, wyhash_policy>;
+
+   //! 128-bit content fingerprint
+   struct fingerprint_t
+   {
+      uint64_t low;
+      uint64_t high;
+
+      //! 64-bit fingerprint, the low half
+      inline uint64_t value64() const { return low; }
+
+      inline bool operator==(const fingerprint_t& other) const { return low == other.low && high == other.high; }
+      inline bool operator!=(const fingerprint_t& other) const { return !(*this == other); }
+   };
+
+   //! Incremental hash for fingerprinting content
+   /*!
+      MurmurHash3 x64 128, fed in pieces of any size.  The result only
+      depends on the concatenated bytes, not on how they were split, so a
+      file can be fingerprinted while it is read a chunk at a time and the
+      result equals the fingerprint of the whole file.
+
+      Strings are fed as UTF-8, the same bytes as a text file holding them.
+
+      Example usage:
+      \code
+         wheel::hasher h;
+
+         while (size_t n = read_chunk(chunk))
+            h.update(chunk, n);
+
+         wheel::fingerprint_t fp = h.finalize();
+      \endcode
+   */
+   class hasher
+   {
+      private:
+         uint64_t    h1;
+         uint64_t    h2;
+         uint64_t    total;
+
+         uint8_t     tail[16];
+         size_t      tail_length;
+
+         void        blocks(const uint8_t* data, size_t count);
+
+      public:
+         explicit hasher(uint64_t seed = 0);
+
+         //! Start over
+         void        reset(uint64_t seed = 0);
+
+         void        update(const void* data, size_t length);
+         void        update(const buffer_t& buffer);
+         void        update(const string& s);
+
+         //! Number of bytes fed so far
+         inline uint64_t length() const { return total; }
+
+         //! Fingerprint of everything fed so far, the hasher can still be updated
+         fingerprint_t  finalize() const;
+         uint64_t       finalize64() const;
+   };
+
+   //! Fingerprint of a single piece of memory
+   fingerprint_t fingerprint(const void* data, size_t length, uint64_t seed = 0);
+}
+
+#endif //WHEEL_HASH_HEADER
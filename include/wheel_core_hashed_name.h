@@ -0,0 +1,320 @@
+/*!
+   @file
+   \brief Contains definitions for names hashed at compile time
+   \author Jari Ronkainen
+*/
+
+#ifndef WHEEL_HASHED_NAME_HEADER
+#define WHEEL_HASHED_NAME_HEADER
+
+#include "wheel_core_common.h"
+#include "wheel_core_string.h"
+#include "wheel_core_string_ref.h"
+
+#include <cstring>
+
+namespace wheel
+{
+   namespace internal
+   {
+      //! One character of FNV-1a, fed as four little-endian bytes like Hash<string>
+      template <typename H>
+      constexpr H fnv1a_step(H hash, H prime, uint32_t c)
+      {
+         hash = (hash ^ (c & 0xff)) * prime;
+         hash = (hash ^ ((c >> 8) & 0xff)) * prime;
+         hash = (hash ^ ((c >> 16) & 0xff)) * prime;
+         hash = (hash ^ (c >> 24)) * prime;
+
+         return hash;
+      }
+
+      constexpr bool utf8_trail(uint8_t c)
+      {
+         return (c >> 6) == 0x2;
+      }
+
+      //! Decode the character at s[i] and advance i past it
+      /*!
+         Mirrors the runtime decoder: invalid and truncated sequences become
+         U+FFFD and are skipped the same way, so the hash of any literal matches
+         the hash of the string made from it.
+      */
+      constexpr uint32_t utf8_next(const char* s, size_t n, size_t& i)
+      {
+         const size_t start = i;
+         const uint8_t lead = s[i];
+
+         size_t length = 0;
+
+         if (lead < 0x80)
+            length = 1;
+         else if ((lead >> 5) == 0x6)
+            length = 2;
+         else if ((lead >> 4) == 0xe)
+            length = 3;
+         else if ((lead >> 3) == 0x1e)
+            length = 4;
+
+         if (length == 0)
+         {
+            ++i;
+            return 0xfffd;
+         }
+
+         uint32_t cp = lead;
+
+         for (size_t k = 1; k < length; ++k)
+         {
+            if (start + k == n)
+            {
+               i = n;
+               return 0xfffd;
+            }
+
+            if (!utf8_trail(s[start + k]))
+            {
+               i = start + 1;
+               while (i != n && utf8_trail(s[i]))
+                  ++i;
+
+               return 0xfffd;
+            }
+
+            cp = (cp << 6) | ((uint8_t)s[start + k] & 0x3f);
+         }
+
+         if (length == 2)
+            cp &= 0x7ff;
+         else if (length == 3)
+            cp &= 0xffff;
+         else
+            cp &= 0x1fffff;
+
+         bool valid = (cp <= 0x10ffff) && ((cp < 0xd800) || (cp > 0xdfff));
+         bool overlong = (length == 2 && cp < 0x80)
+                      || (length == 3 && cp < 0x800)
+                      || (length == 4 && cp < 0x10000);
+
+         if (!valid || overlong)
+         {
+            i = start + 1;
+            while (i != n && utf8_trail(s[i]))
+               ++i;
+
+            return 0xfffd;
+         }
+
+         i = start + length;
+         return cp;
+      }
+
+      template <typename H>
+      constexpr H fnv1a_utf32(const char32_t* s, size_t n, H hash, H prime)
+      {
+         for (size_t i = 0; i < n; ++i)
+            hash = fnv1a_step<H>(hash, prime, s[i]);
+
+         return hash;
+      }
+
+      template <typename H>
+      constexpr H fnv1a_utf8(const char* s, size_t n, H hash, H prime)
+      {
+         size_t i = 0;
+
+         while (i < n)
+            hash = fnv1a_step<H>(hash, prime, utf8_next(s, n, i));
+
+         return hash;
+      }
+   }
+
+   //! Deterministic Hash<string> of a UTF-32 literal, computed at compile time
+   constexpr size_t hash_literal(const char32_t* s, size_t n)
+   {
+      return size_t_x64() ? (size_t)internal::fnv1a_utf32<uint64_t>(s, n, 0xCBF29CE484222325, 0x100000001B3)
+                          : (size_t)internal::fnv1a_utf32<uint32_t>(s, n, 0x811C9DC5, 0x1000193);
+   }
+
+   //! Deterministic Hash<string> of a UTF-8 literal, computed at compile time
+   constexpr size_t hash_literal(const char* s, size_t n)
+   {
+      return size_t_x64() ? (size_t)internal::fnv1a_utf8<uint64_t>(s, n, 0xCBF29CE484222325, 0x100000001B3)
+                          : (size_t)internal::fnv1a_utf8<uint32_t>(s, n, 0x811C9DC5, 0x1000193);
+   }
+
+   //! hash_literal() of a runtime string, for comparing against _hash values
+   /*!
+      Unlike Hash<string> this is never seeded, so it can be used to switch
+      on names whatever the hashing mode.
+   */
+   inline size_t literal_hash(const string_ref& s) noexcept
+   {
+      const void* chars = s.raw_data();
+
+      if (size_t_x64())
+      {
+         if (s.char_width() == 1)
+            return internal::fnv1a_chars((const uint8_t*)chars, s.length(), (uint64_t)0xCBF29CE484222325, (uint64_t)0x100000001B3);
+         else if (s.char_width() == 2)
+            return internal::fnv1a_chars((const char16_t*)chars, s.length(), (uint64_t)0xCBF29CE484222325, (uint64_t)0x100000001B3);
+
+         return internal::fnv1a_chars((const char32_t*)chars, s.length(), (uint64_t)0xCBF29CE484222325, (uint64_t)0x100000001B3);
+      }
+
+      if (s.char_width() == 1)
+         return internal::fnv1a_chars((const uint8_t*)chars, s.length(), (uint32_t)0x811C9DC5, (uint32_t)0x1000193);
+      else if (s.char_width() == 2)
+         return internal::fnv1a_chars((const char16_t*)chars, s.length(), (uint32_t)0x811C9DC5, (uint32_t)0x1000193);
+
+      return internal::fnv1a_chars((const char32_t*)chars, s.length(), (uint32_t)0x811C9DC5, (uint32_t)0x1000193);
+   }
+
+   //! Name with its hash computed at compile time
+   /*!
+      Refers to a string literal and carries its hash_literal(), which is the
+      value Hash<string> gives for it when hashing is deterministic, as it is
+      by default.  Resource, library and event lookups take hashed names
+      directly and do not hash them at runtime.  In a library built with
+      WHEEL_SEEDED_HASH the hash cannot be known at compile time, and hash()
+      computes it on use from the literal, without making a string of it.
+
+      literal_hash() of a string can be compared against the _hash of a
+      literal in any mode, to dispatch on names with a switch.
+
+      The literal must outlive the hashed_name, which is always the case for
+      string literals.
+
+      Example usage:
+      \code
+         using namespace wheel::literals;
+
+         wheel::buffer_t* buf = wheel::GetBuffer("tri.vs"_name);
+
+         switch (wheel::literal_hash(ident.str()))
+         {
+            case "default"_hash:
+               if (ident.str() == U"default")
+                  ...
+         }
+      \endcode
+   */
+   class hashed_name
+   {
+      private:
+         const char*       utf8;
+         const char32_t*   utf32;
+         size_t            len;
+         size_t            hash_value;
+
+      public:
+         constexpr explicit hashed_name(const char* s, size_t n)
+            : utf8(s), utf32(nullptr), len(n), hash_value(hash_literal(s, n)) {}
+
+         constexpr explicit hashed_name(const char32_t* s, size_t n)
+            : utf8(nullptr), utf32(s), len(n), hash_value(hash_literal(s, n)) {}
+
+         template <size_t N>
+         constexpr explicit hashed_name(const char (&s)[N]) : hashed_name(s, N - 1) {}
+
+         template <size_t N>
+         constexpr explicit hashed_name(const char32_t (&s)[N]) : hashed_name(s, N - 1) {}
+
+         //! hash_literal() of the name
+         constexpr size_t literal_hash() const { return hash_value; }
+
+         //! Same value as wheel::Hash<string> for the named string
+         inline size_t hash() const
+         {
+            if (hash_seed() == 0)
+               return hash_value;
+
+            string_ref chars;
+
+            if (view(chars))
+               return chars.hash();
+
+            return str().hash();
+         }
+
+         //! Make a runtime string of the name
+         inline string str() const
+         {
+            return utf8 ? string(utf8, len) : string(string_ref(utf32, len));
+         }
+
+         //! View the name without converting it
+         /*!
+            UTF-32 names can always be viewed, UTF-8 names only when they
+            are ASCII.
+
+            \return <code>true</code> if out now views the name.
+         */
+         inline bool view(string_ref& out) const
+         {
+            if (utf32)
+            {
+               out = string_ref(utf32, len);
+               return true;
+            }
+
+            for (size_t i = 0; i < len; ++i)
+               if ((uint8_t)utf8[i] >= 0x80)
+                  return false;
+
+            out = string_ref(utf8, 1, len);
+            return true;
+         }
+
+         //! Does the string hold this name
+         /*!
+            UTF-8 names are decoded a character at a time and compared to
+            the characters of the string, as the string made from the name
+            would be.
+         */
+         inline bool matches(const string& s) const
+         {
+            if (utf32)
+               return string_ref(utf32, len) == string_ref(s);
+
+            size_t i = 0;
+            size_t n = 0;
+
+            while (i < len)
+            {
+               if (n == s.length() || internal::utf8_next(utf8, len, i) != s[n])
+                  return false;
+
+               ++n;
+            }
+
+            return n == s.length();
+         }
+   };
+
+   namespace literals
+   {
+      constexpr hashed_name operator"" _name(const char* s, size_t n)
+      {
+         return hashed_name(s, n);
+      }
+
+      constexpr hashed_name operator"" _name(const char32_t* s, size_t n)
+      {
+         return hashed_name(s, n);
+      }
+
+      constexpr size_t operator"" _hash(const char* s, size_t n)
+      {
+         return hash_literal(s, n);
+      }
+
+      constexpr size_t operator"" _hash(const char32_t* s, size_t n)
+      {
+         return hash_literal(s, n);
+      }
+   }
+}
+
+#endif //WHEEL_HASHED_NAME_HEADER
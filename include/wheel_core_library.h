@@ -3,6 +3,7 @@
 
 #include "wheel_core_common.h"
 #include "wheel_core_resource.h"
+#include "wheel_core_flat_map.h"
 
 namespace wheel
 {
@@ -10,12 +11,18 @@ namespace wheel
    {
       uint32_t    type;
       Resource*   ptr;
+      size_t      slot;       //!< Position in the manifest, perfect_index::npos if not named in it
    };
 
    class Library
    {
       private:
-         static std::unordered_map<wcl::string, resource_entry_t> resources;
+         // Every resource by its symbol, those in the manifest only by their slot
+         static flat_map<symbol, resource_entry_t> resources;
+
+         // Resources named in the manifest, by their position in it
+         static perfect_index manifest;
+         static std::vector<resource_entry_t> manifest_resources;
 
          // TODO: the first uint32_t should be wheel_filetype_t
          std::unordered_map<uint32_t, std::function<uint32_t(const wheel::string&, wheel::buffer_t&)>> file_handlers;
@@ -25,16 +32,33 @@ namespace wheel
          static uint32_t   load_unknown(const string& entry, buffer_t& buffer);
          void              unload_resource(resource_entry_t);
 
+         static resource_entry_t* holder_of(resource_entry_t& entry);
+         static resource_entry_t* find_entry(const symbol& name);
+         static resource_entry_t& entry_for(const symbol& name);
+         uint32_t          unload_at(size_t index);
+
       public:
          static uint32_t   AddBuffer(wheel_resource_t type, const string& name, const buffer_t&);
+         static uint32_t   AddBuffer(wheel_resource_t type, const symbol& name, const buffer_t&);
+         static uint32_t   AddBuffer(wheel_resource_t type, const hashed_name& name, const buffer_t&);
          static uint32_t   AddResource(wheel_resource_t type, const string& name, Resource* rptr);
+         static uint32_t   AddResource(wheel_resource_t type, const symbol& name, Resource* rptr);
+         static uint32_t   AddResource(wheel_resource_t type, const hashed_name& name, Resource* rptr);
+
+         static void       SetManifest(const perfect_index& index);
 
          static void       debug_listfiles();
 
          Resource*         operator[](const string& name);
+         Resource*         operator[](const symbol& name);
+         Resource*         operator[](const hashed_name& name);
 
          uint32_t          Load(const wcl::string& file);
+         uint32_t          Load(const symbol& file);
+         uint32_t          Load(const hashed_name& file);
          uint32_t          Unload(const wcl::string& file);
+         uint32_t          Unload(const symbol& file);
+         uint32_t          Unload(const hashed_name& file);
 
          void              SetHandler(wheel_filetype_t fileformat, std::function<uint32_t(const wheel::string&, wheel::buffer_t&)> func);
          void              RemoveHandler(wheel_filetype_t fileformat);
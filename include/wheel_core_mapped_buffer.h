@@ -0,0 +1,194 @@
+/*!
+   @file
+   \brief Contains definitions for memory-mapped file buffers
+   \author Jari Ronkainen
+*/
+
+#ifndef WHEEL_MAPPED_BUFFER_HEADER
+#define WHEEL_MAPPED_BUFFER_HEADER
+
+#include "wheel_core_common.h"
+#include "wheel_core_buffer_view.h"
+
+namespace wheel
+{
+   //! Access pattern hints for mapped files
+   enum mapping_advice_t
+   {
+      WHEEL_ADVICE_NORMAL        = 0x00,
+      WHEEL_ADVICE_SEQUENTIAL    = 0x01,
+      WHEEL_ADVICE_RANDOM        = 0x02,
+      WHEEL_ADVICE_WILLNEED      = 0x03,
+      WHEEL_ADVICE_DONTNEED      = 0x04
+   };
+
+   //! Read-only file contents, mapped to memory when possible
+   /*!
+      A file on a native filesystem is mapped, so only the pages that are
+      touched are read and they stay in the page cache instead of anonymous
+      memory.  Where mapping is not possible, such as for files inside
+      archives, the contents are read into a buffer_t owned by the object
+      instead, behind the same interface.
+
+      Reads work like the reads of buffer_t, including the byte order.
+   */
+   class mapped_buffer
+   {
+      private:
+         const uint8_t*    ptr;
+         size_t            len;
+         bool              mapped;
+         buffer_t          contents;
+
+         size_t            read_ptr;
+
+         void unmap();
+
+      public:
+         static const size_t npos = ~(size_t)0;
+
+         mapped_buffer() : ptr(nullptr), len(0), mapped(false), read_ptr(0) {}
+        ~mapped_buffer() { unmap(); }
+
+         mapped_buffer(mapped_buffer&& other);
+         mapped_buffer& operator=(mapped_buffer&& other);
+
+         mapped_buffer(const mapped_buffer&) = delete;
+         mapped_buffer& operator=(const mapped_buffer&) = delete;
+
+         uint32_t map(const char* path, mapping_advice_t advice = WHEEL_ADVICE_NORMAL);
+         void     assign(buffer_t&& data);
+         void     clear();
+
+         uint32_t advise(mapping_advice_t advice, size_t offset = 0, size_t length = npos) const;
+
+         inline bool             is_mapped() const { return mapped; }
+
+         inline const uint8_t*   data() const { return ptr; }
+         inline const uint8_t*   getptr() const { return ptr; }
+         inline size_t           size() const { return len; }
+         inline bool             empty() const { return len == 0; }
+
+         inline const uint8_t*   begin() const { return ptr; }
+         inline const uint8_t*   end() const { return ptr + len; }
+
+         inline uint8_t operator[](size_t i) const
+         {
+            assert(i < len);
+            return ptr[i];
+         }
+
+         inline buffer_view view() const { return buffer_view(ptr, len); }
+         inline operator buffer_view() const { return view(); }
+
+         inline bool can_read(size_t s) const
+         {
+            return s <= len - read_ptr;
+         }
+
+         inline size_t pos() const
+         {
+            return read_ptr;
+         }
+
+         inline void seek(size_t target)
+         {
+            if (target < len) read_ptr = target;
+         }
+
+         //! Read a little-endian value, the default byte order of buffers
+         /*!
+            As with buffer_t, reads past the end throw std::out_of_range,
+            so the contents of a file are never read beyond its size.  Code
+            that has checked the size already can use read_le_unchecked()
+            and read_be_unchecked().
+         */
+         template <typename T>
+         inline T read(size_t where) const
+         {
+            return read_le<T>(where);
+         }
+
+         template <typename T>
+         inline T read()
+         {
+            return read_le<T>();
+         }
+
+         template <typename T>
+         inline T read_le(size_t where) const
+         {
+            T rval = load<T>(where);
+            return big_endian() ? endian_swap(rval) : rval;
+         }
+
+         template <typename T>
+         inline T read_le()
+         {
+            T rval = read_le<T>(read_ptr);
+            read_ptr += sizeof(T);
+
+            return rval;
+         }
+
+         //! Read a big-endian value
+         template <typename T>
+         inline T read_be(size_t where) const
+         {
+            T rval = load<T>(where);
+            return big_endian() ? rval : endian_swap(rval);
+         }
+
+         template <typename T>
+         inline T read_be()
+         {
+            T rval = read_be<T>(read_ptr);
+            read_ptr += sizeof(T);
+
+            return rval;
+         }
+
+         //! Read a little-endian value that is known to be there
+         template <typename T>
+         inline T read_le_unchecked(size_t where) const
+         {
+            T rval = load_unchecked<T>(where);
+            return big_endian() ? endian_swap(rval) : rval;
+         }
+
+         //! Read a big-endian value that is known to be there
+         template <typename T>
+         inline T read_be_unchecked(size_t where) const
+         {
+            T rval = load_unchecked<T>(where);
+            return big_endian() ? rval : endian_swap(rval);
+         }
+
+      private:
+         void out_of_range(size_t where) const;
+
+         //! Loads a value in native byte order, unaligned
+         template <typename T>
+         inline T load(size_t where) const
+         {
+            if (where > len || sizeof(T) > len - where)
+               out_of_range(std::max(where, len));
+
+            return load_unchecked<T>(where);
+         }
+
+         template <typename T>
+         inline T load_unchecked(size_t where) const
+         {
+            static_assert(std::is_trivially_copyable<T>::value, "read needs a trivially copyable value");
+            assert(where <= len && sizeof(T) <= len - where);
+
+            T rval;
+            memcpy(&rval, ptr + where, sizeof(T));
+
+            return rval;
+         }
+   };
+}
+
+#endif //WHEEL_MAPPED_BUFFER_HEADER
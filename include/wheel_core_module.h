@@ -11,7 +11,10 @@
 
 #include "wheel_core_common.h"
 #include "wheel_core_string.h"
+#include "wheel_core_string_ref.h"
+#include "wheel_core_symbol.h"
 #include "wheel_core_event.h"
+#include "wheel_core_flat_map.h"
 
 #ifndef _WIN32
 #include <dlfcn.h>
@@ -110,16 +113,18 @@ namespace wheel
 
       modset_t() { is_loaded = false; }
 
+      //! Orders by type, then name, then version
       friend inline bool operator<(const modset_t& one, const modset_t& other)
       {
-         if (one.details.type < other.details.type)
-            return true;
-         if (one.details.name < other.details.name)
-            return true;
-         if (one.details.version < other.details.version)
-            return true;
-
-         return false;
+         int order = one.details.type.compare(other.details.type);
+
+         if (order == 0)
+            order = one.details.name.compare(other.details.name);
+
+         if (order == 0)
+            order = one.details.version.compare(other.details.version);
+
+         return order < 0;
       }
    };
 
@@ -153,7 +158,7 @@ namespace wheel
    {
       private:
          std::vector<string> searchpath;
-         std::unordered_map<string, Module*> modules;
+         flat_map<symbol, Module*> modules;
 
          std::set<modset_t> known_modules;
 
@@ -162,6 +167,7 @@ namespace wheel
       public:
          uint32_t Add(const string& file);
          void Remove(const string& ident);
+         void Remove(const symbol& ident);
 
          uint32_t Search(const string& path);
 
@@ -170,6 +176,7 @@ namespace wheel
          modulelist_t GetList(const string& type = "") const;
 
          Module* operator[](const string& ident);
+         Module* operator[](const symbol& ident);
 
          ModuleLibrary();
         ~ModuleLibrary();
@@ -0,0 +1,107 @@
+/*!
+   @file
+   \brief Contains definitions for the minimal perfect hash index of fixed name sets
+   \author Jari Ronkainen
+*/
+
+#ifndef WHEEL_PERFECT_HASH_HEADER
+#define WHEEL_PERFECT_HASH_HEADER
+
+#include "wheel_core_common.h"
+#include "wheel_core_string.h"
+#include "wheel_core_string_ref.h"
+#include "wheel_core_hashed_name.h"
+
+#include <vector>
+
+namespace wheel
+{
+   //! Minimal perfect hash index of a fixed set of names
+   /*!
+      Maps each name of a set known beforehand, such as the resource
+      manifest of a release, to its position in the set.  Every name hashes
+      to its own slot, so a lookup is one hash, one probe and one compare,
+      and names outside the set are rejected by the compare.
+
+      The index is built by build_perfect_index(), usually at build time by
+      the mkmanifest tool, into a blob that is loaded with assign() from a
+      file or from an array in a generated header.  Blobs are little-endian
+      and hash the names as stored by wheel::string, so a blob holding names
+      wider than Latin-1 is rejected on a big-endian host.
+
+      Example usage:
+      \code
+         #include "assets_manifest.h"      // made with mkmanifest assets.txt assets_manifest.h assets
+
+         wheel::perfect_index index;
+         index.assign(assets_data, sizeof(assets_data));
+
+         size_t i = index.find(wheel::string_ref(U"textures/crate.png"));
+
+         if (i != wheel::perfect_index::npos)
+            ...
+      \endcode
+   */
+   class perfect_index
+   {
+      private:
+         //! Blob copied by assign(buffer_t&&), empty when referring to outside data
+         buffer_t          owned;
+
+         const uint8_t*    blob;
+         size_t            blob_size;
+
+         uint32_t          count;
+         uint32_t          bucket_count;
+         uint64_t          seed;
+
+         const uint8_t*    pilots;
+         const uint8_t*    order;
+         const uint8_t*    offsets;
+         const uint8_t*    widths;
+         const uint8_t*    names;
+
+         uint32_t          parse(const uint8_t* data, size_t size);
+
+      public:
+         static const size_t npos = ~(size_t)0;
+
+         perfect_index();
+         perfect_index(const perfect_index& other);
+         perfect_index& operator=(const perfect_index& other);
+
+         //! Use a blob that stays valid as long as the index, such as a static array
+         uint32_t          assign(const void* data, size_t size);
+
+         //! Take over a blob, such as one read from a file
+         uint32_t          assign(buffer_t&& data);
+
+         void              clear();
+
+         inline size_t     size() const { return count; }
+         inline bool       empty() const { return count == 0; }
+
+         //! The blob, to write to a file
+         inline const uint8_t* data() const { return blob; }
+         inline size_t     data_size() const { return blob_size; }
+
+         //! Position of a name in the set, or npos
+         size_t            find(const string_ref& name) const;
+         size_t            find(const hashed_name& name) const;
+
+         //! Name at a position in the set
+         string            name(size_t index) const;
+   };
+
+   //! Build a perfect hash index of names
+   /*!
+      The names keep their positions, find() returns the position a name
+      had in the vector.  The same names always give the same blob.
+
+      \return <code>WHEEL_OK</code> on success, <code>WHEEL_INVALID_VALUE</code> if a name
+              appears twice, or <code>WHEEL_OUT_OF_RANGE</code> if the set is too large.
+   */
+   uint32_t build_perfect_index(const std::vector<string>& names, buffer_t& blob);
+}
+
+#endif //WHEEL_PERFECT_HASH_HEADER
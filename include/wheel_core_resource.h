@@ -9,6 +9,10 @@
 
 #include "wheel_core_common.h"
 #include "wheel_core_string.h"
+#include "wheel_core_symbol.h"
+#include "wheel_core_hash.h"
+#include "wheel_core_perfect_hash.h"
+#include "wheel_core_mapped_buffer.h"
 
 #include <unordered_map>
 #include <vector>
@@ -28,6 +32,7 @@ namespace wheel
       public:
          Resource() : format(WHEEL_FILE_FORMAT_UNKNOWN) {}
          Resource(wheel_resource_t type, const buffer_t& buf);
+         virtual ~Resource() {}
 
          static Resource* Load(const wheel::string& file);
 
@@ -48,19 +53,41 @@ namespace wheel
    uint32_t          AddToPath(const string& resource, const string& where, int search_last = 1);
 
    buffer_t*         GetBuffer(const string& filename);
+   buffer_t*         GetBuffer(const symbol& filename);
+   buffer_t*         GetBuffer(const hashed_name& filename);
 
    size_t            BufferSize(const string& filename);
+   size_t            BufferSize(const symbol& filename);
+   size_t            BufferSize(const hashed_name& filename);
 
    bool              IsCached(const string& filename);
+   bool              IsCached(const symbol& filename);
+   bool              IsCached(const hashed_name& filename);
 
    uint32_t          Buffer(const string& filename);
+   uint32_t          Buffer(const symbol& filename);
+   uint32_t          Buffer(const hashed_name& filename);
    void              DeleteBuffer(const string& filename);
+   void              DeleteBuffer(const symbol& filename);
+   void              DeleteBuffer(const hashed_name& filename);
 
    void              EmptyCache();
 
    uint32_t          WriteBuffer(const string& file, const buffer_t& buffer);
 
    buffer_t          GetFile(const string& filename);
+   buffer_t          GetFile(const string& filename, fingerprint_t& fingerprint);
+
+   uint32_t          MapFile(const string& filename, mapped_buffer& out, mapping_advice_t advice = WHEEL_ADVICE_NORMAL);
+
+   const mapped_buffer* GetMappedBuffer(const string& filename);
+   const mapped_buffer* GetMappedBuffer(const symbol& filename);
+   const mapped_buffer* GetMappedBuffer(const hashed_name& filename);
+
+   uint32_t          BufferFingerprint(const string& filename, fingerprint_t& fingerprint);
+   uint32_t          BufferFingerprint(const symbol& filename, fingerprint_t& fingerprint);
+
+   void              SetManifest(const perfect_index& manifest);
 }
 
 #endif
\ No newline at end of file
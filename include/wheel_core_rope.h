@@ -0,0 +1,127 @@
+/*!
+   @file
+   \brief Contains definitions for ropes, strings for very large texts
+   \author Jari Ronkainen
+*/
+
+#ifndef WHEEL_ROPE_HEADER
+#define WHEEL_ROPE_HEADER
+
+#include "wheel_core_common.h"
+#include "wheel_core_string.h"
+#include "wheel_core_string_ref.h"
+
+#include <memory>
+
+namespace wheel
+{
+   namespace internal
+   {
+      struct rope_node;
+      typedef std::shared_ptr<const rope_node> rope_ptr;
+
+      //! Immutable node of a rope
+      /*!
+         A leaf refers to length characters of a shared string starting at
+         offset, a concatenation node to its two children.  Nodes are never
+         modified after creation, so ropes share them freely.
+      */
+      struct rope_node
+      {
+         size_t                           length;
+         uint32_t                         height;
+
+         std::shared_ptr<const string>    leaf;
+         size_t                           offset;
+
+         rope_ptr                         left;
+         rope_ptr                         right;
+
+         inline string_ref piece() const
+         {
+            size_t width = leaf->char_width();
+            return string_ref((const uint8_t*)leaf->raw_data() + offset * width, width, length);
+         }
+      };
+   }
+
+   //! String for very large texts
+   /*!
+      A rope is a balanced tree of string pieces.  Concatenating two ropes and
+      taking a substring take O(log n) time and copy no characters, the pieces
+      are shared between the ropes.  Small pieces are merged as they are
+      appended, so building a rope one character at a time does not end up
+      with a leaf per character.
+
+      The characters are only copied into a single string when str() is
+      called, and the rope keeps that flat copy afterwards.  for_each_piece()
+      walks the text without flattening it.
+
+      Ropes are values: copying one copies a pointer, and modifying a copy does
+      not change the original.  A single rope must not be used from several
+      threads at once, even through const methods, as str() replaces the tree.
+   */
+   class rope
+   {
+      private:
+         mutable internal::rope_ptr root;
+
+         explicit rope(const internal::rope_ptr& node) : root(node) {}
+
+         template <typename F>
+         static void visit(const internal::rope_node* node, F& func)
+         {
+            if (node->leaf)
+            {
+               func(node->piece());
+               return;
+            }
+
+            visit(node->left.get(), func);
+            visit(node->right.get(), func);
+         }
+
+      public:
+         static const size_t npos = ~(size_t)0;
+
+         rope() {}
+         rope(const string& s);
+         rope(string&& s);
+         explicit rope(const string_ref& s);
+
+         inline size_t length() const { return root ? root->length : 0; }
+         inline bool empty() const { return !root; }
+
+         //! Height of the tree, 0 for a single piece
+         inline size_t depth() const { return root ? root->height : 0; }
+
+         //! Character at pos, O(log n)
+         char32_t operator[](size_t pos) const;
+
+         rope operator+(const rope& other) const;
+         rope& operator+=(const rope& other);
+         rope& append(const string_ref& s);
+
+         //! Characters from pos on, O(log n), shares storage with this rope
+         rope substr(size_t pos, size_t length = npos) const;
+
+         //! Flatten the rope into a single string
+         const string& str() const;
+
+         //! Call func with a string_ref for every piece, in order
+         template <typename F>
+         void for_each_piece(F func) const
+         {
+            if (root)
+               visit(root.get(), func);
+         }
+
+         friend inline std::ostream& operator<<(std::ostream& out, const wheel::rope& r)
+         {
+            r.for_each_piece([&out](const string_ref& piece) { out << piece; });
+            return out;
+         }
+   };
+}
+
+#endif //WHEEL_ROPE_HEADER
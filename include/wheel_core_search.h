@@ -0,0 +1,72 @@
+/*!
+   @file
+   \brief Contains definitions for substring search
+   \author Jari Ronkainen
+*/
+
+#ifndef WHEEL_SEARCH_HEADER
+#define WHEEL_SEARCH_HEADER
+
+#include "wheel_core_common.h"
+#include "wheel_core_string.h"
+#include "wheel_core_string_ref.h"
+
+#include <vector>
+
+namespace wheel
+{
+   namespace internal
+   {
+      //! Horspool shift tables, indexed by the low byte of a character
+      typedef uint32_t search_table_t[256];
+
+      void build_skip(const string_ref& needle, search_table_t& skip);
+      void build_rskip(const string_ref& needle, search_table_t& rskip);
+
+      size_t search_forward(const string_ref& text, const string_ref& needle, size_t pos, const search_table_t* skip);
+      size_t search_backward(const string_ref& text, const string_ref& needle, size_t pos, const search_table_t* rskip);
+   }
+
+   //! Precompiled substring search
+   /*!
+      Keeps a copy of the needle together with its Boyer-Moore-Horspool shift
+      tables, so searching for the same sequence in many texts does not redo
+      any setup.  Short needles in texts of the same width are found with an
+      SSE2 filter on the first and last character instead.  Searching never
+      allocates.
+
+      Example usage:
+      \code
+         static const wheel::searcher ext(U".so");
+
+         if (ext.find(filename) != wheel::string_ref::npos)
+            load(filename);
+      \endcode
+   */
+   class searcher
+   {
+      private:
+         string                     needle;
+         internal::search_table_t   skip;
+         internal::search_table_t   rskip;
+
+      public:
+         explicit searcher(const string_ref& seq);
+
+         //! Position of the first match at or after pos, npos if none
+         size_t find(const string_ref& text, size_t pos = 0) const;
+
+         //! Position of the last match starting at or before pos, npos if none
+         size_t rfind(const string_ref& text, size_t pos = string_ref::npos) const;
+
+         //! Positions of all non-overlapping matches
+         std::vector<size_t> find_all(const string_ref& text) const;
+
+         inline bool found_in(const string_ref& text) const { return find(text) != string_ref::npos; }
+
+         inline size_t length() const { return needle.length(); }
+         inline const string& str() const { return needle; }
+   };
+}
+
+#endif //WHEEL_SEARCH_HEADER
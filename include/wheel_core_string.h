@@ -9,6 +9,8 @@
 #include "wheel_core_common.h"
 
 #include <cstdint>
+#include <cstddef>
+#include <iterator>
 #include <vector>
 #include <string>
 #include <locale>
@@ -16,19 +18,171 @@
 
 namespace wheel
 {
+  class string_ref;
+
   /*!
      \brief Unicode string class
 
-     The string class stores series of char32_t characters in an
+     The string class stores a series of unicode characters in an
      array.  The class can be used in similar manner as the std::string class.
 
-     Strings stored in the class are UTF-32 -encoded.  They are not guaranteed to be
-     null-terminated, so it is not recommended to use raw pointers obtained with getptr().
+     Characters are stored with 1, 2 or 4 bytes per character (Latin-1, UCS-2 or
+     UTF-32), whichever is the narrowest width that can hold the widest character
+     in the string.  The width is always kept at that minimum, so two equal strings
+     always have identical storage.  Mutations widen or narrow the storage as
+     needed, length() and indexing stay O(1).
+
+     Short strings (up to local_bytes / char_width() characters) are stored inside
+     the object itself, longer ones spill over to the heap.  The object is 32
+     bytes on 64-bit systems.
   */
   class string
   {
+     public:
+        //! Random access iterator over the characters of a string
+        /*!
+           Dereferencing yields the character by value, as the string
+           does not necessarily store it as a char32_t.
+        */
+        class const_iterator
+        {
+           private:
+              const string*  str;
+              size_t         idx;
+
+           public:
+              typedef std::random_access_iterator_tag   iterator_category;
+              typedef char32_t                          value_type;
+              typedef ptrdiff_t                         difference_type;
+              typedef const char32_t*                   pointer;
+              typedef char32_t                          reference;
+
+              const_iterator() : str(nullptr), idx(0) {}
+              const_iterator(const string* s, size_t i) : str(s), idx(i) {}
+
+              inline char32_t operator*() const { return (*str)[idx]; }
+              inline char32_t operator[](difference_type n) const { return (*str)[idx + n]; }
+
+              inline const_iterator& operator++() { ++idx; return *this; }
+              inline const_iterator& operator--() { --idx; return *this; }
+              inline const_iterator operator++(int) { const_iterator r(*this); ++idx; return r; }
+              inline const_iterator operator--(int) { const_iterator r(*this); --idx; return r; }
+
+              inline const_iterator& operator+=(difference_type n) { idx += n; return *this; }
+              inline const_iterator& operator-=(difference_type n) { idx -= n; return *this; }
+              inline const_iterator operator+(difference_type n) const { return const_iterator(str, idx + n); }
+              inline const_iterator operator-(difference_type n) const { return const_iterator(str, idx - n); }
+              inline difference_type operator-(const const_iterator& o) const { return (difference_type)idx - (difference_type)o.idx; }
+
+              inline bool operator==(const const_iterator& o) const { return idx == o.idx; }
+              inline bool operator!=(const const_iterator& o) const { return idx != o.idx; }
+              inline bool operator<(const const_iterator& o) const { return idx < o.idx; }
+              inline bool operator>(const const_iterator& o) const { return idx > o.idx; }
+              inline bool operator<=(const const_iterator& o) const { return idx <= o.idx; }
+              inline bool operator>=(const const_iterator& o) const { return idx >= o.idx; }
+        };
+
+        //! Reference to a character of a string, what an iterator yields
+        /*!
+           Reads give the character as a char32_t, and assigning one stores
+           it with set(), which widens or narrows the storage as needed.
+        */
+        class char_reference
+        {
+           private:
+              string*  str;
+              size_t   idx;
+
+           public:
+              char_reference(string* s, size_t i) : str(s), idx(i) {}
+
+              inline operator char32_t() const { return (*(const string*)str)[idx]; }
+
+              inline char_reference& operator=(char32_t c) { str->set(idx, c); return *this; }
+              inline char_reference& operator=(const char_reference& o) { return *this = (char32_t)o; }
+
+              friend inline void swap(char_reference a, char_reference b)
+              {
+                 char32_t c = a;
+                 a = (char32_t)b;
+                 b = c;
+              }
+        };
+
+        //! Random access iterator that can also change the characters
+        class iterator
+        {
+           private:
+              string*  str;
+              size_t   idx;
+
+           public:
+              typedef std::random_access_iterator_tag   iterator_category;
+              typedef char32_t                          value_type;
+              typedef ptrdiff_t                         difference_type;
+              typedef void                              pointer;
+              typedef char_reference                    reference;
+
+              iterator() : str(nullptr), idx(0) {}
+              iterator(string* s, size_t i) : str(s), idx(i) {}
+
+              inline operator const_iterator() const { return const_iterator(str, idx); }
+
+              inline char_reference operator*() const { return char_reference(str, idx); }
+              inline char_reference operator[](difference_type n) const { return char_reference(str, idx + n); }
+
+              inline iterator& operator++() { ++idx; return *this; }
+              inline iterator& operator--() { --idx; return *this; }
+              inline iterator operator++(int) { iterator r(*this); ++idx; return r; }
+              inline iterator operator--(int) { iterator r(*this); --idx; return r; }
+
+              inline iterator& operator+=(difference_type n) { idx += n; return *this; }
+              inline iterator& operator-=(difference_type n) { idx -= n; return *this; }
+              inline iterator operator+(difference_type n) const { return iterator(str, idx + n); }
+              inline iterator operator-(difference_type n) const { return iterator(str, idx - n); }
+              inline difference_type operator-(const iterator& o) const { return (difference_type)idx - (difference_type)o.idx; }
+
+              inline bool operator==(const iterator& o) const { return idx == o.idx; }
+              inline bool operator!=(const iterator& o) const { return idx != o.idx; }
+              inline bool operator<(const iterator& o) const { return idx < o.idx; }
+              inline bool operator>(const iterator& o) const { return idx > o.idx; }
+              inline bool operator<=(const iterator& o) const { return idx <= o.idx; }
+              inline bool operator>=(const iterator& o) const { return idx >= o.idx; }
+        };
+
+        typedef char32_t        value_type;
+
+        //! Number of bytes of character data that fit in the object without allocating.
+        static const size_t     local_bytes = 24;
+
      private:
-        std::vector<char32_t>   data;
+        // The heap pointer and capacity take the place of the local characters
+        union
+        {
+           struct
+           {
+              uint8_t*    ptr;
+              size_t      cap;
+           }              heap;
+
+           uint8_t        local[local_bytes];
+        };
+
+        size_t      len      : 56;
+        size_t      width    : 7;
+        size_t      on_heap  : 1;
+
+        inline bool is_local() const { return !on_heap; }
+
+        inline uint8_t* data() { return on_heap ? heap.ptr : local; }
+        inline const uint8_t* data() const { return on_heap ? heap.ptr : local; }
+
+        void        assign(const void* src, uint8_t src_width, size_t n);
+        void        assign_utf8(const char* in, size_t n);
+        void        reserve_bytes(size_t n);
+        void        change_width(uint8_t new_width);
+        void        shrink_width();
+        void        release();
 
      public:
         // Constructors
@@ -48,6 +202,9 @@ namespace wheel
         string(const char32_t*);
         string(const char*, size_t length);
 
+        // Copy the characters of a view
+        explicit string(const string_ref&);
+
         string(double);
 
         string(int32_t);
@@ -58,13 +215,42 @@ namespace wheel
         ~string();
 
         // Convenience (stupid) constructors
-        string(const char32_t c) { data.push_back(c); }
+        string(const char32_t c);
 
         // C++ stl compatibility
-        std::vector<char32_t>::iterator begin() { return data.begin(); }
-        std::vector<char32_t>::const_iterator begin() const { return data.begin(); }
-        std::vector<char32_t>::iterator end() { return data.end(); }
-        std::vector<char32_t>::const_iterator end() const { return data.end(); }
+        iterator begin() { return iterator(this, 0); }
+        iterator end() { return iterator(this, len); }
+        const_iterator begin() const { return const_iterator(this, 0); }
+        const_iterator end() const { return const_iterator(this, len); }
+        const_iterator cbegin() const { return const_iterator(this, 0); }
+        const_iterator cend() const { return const_iterator(this, len); }
+
+        void push_back(char32_t c);
+
+        // Character access
+        inline char32_t operator[](size_t pos) const
+        {
+           const uint8_t* chars = data();
+
+           if (width == 1)
+              return chars[pos];
+           else if (width == 2)
+              return ((const char16_t*)chars)[pos];
+
+           return ((const char32_t*)chars)[pos];
+        }
+
+        void set(size_t pos, char32_t c);
+
+        // Storage
+        void reserve(size_t n);
+        size_t capacity() const;
+
+        //! Bytes per character in the internal storage, 1, 2 or 4.
+        inline size_t char_width() const { return width; }
+
+        //! Pointer to the internal storage, length() * char_width() bytes.
+        inline const void* raw_data() const { return data(); }
 
         // Operator overloads
         string& operator=(string&& other);
@@ -72,24 +258,34 @@ namespace wheel
         string operator+(const string& other) const;
         string& operator+=(const string& other);
 
+        // Append in place, growing the storage geometrically
+        string& append(const string_ref& other);
+        string& append(const char* utf8);
+        string& append(const char* utf8, size_t length);
+
         bool operator==(const string& other) const;
         bool operator!=(const string& other) const;
         bool operator<(const string& other) const;
         bool operator>(const string& other) const;
+        bool operator<=(const string& other) const;
+        bool operator>=(const string& other) const;
 
-        // Conversion operators
-//            operator const char*();
-
-        // Get pointer to the string
-        const char32_t* getptr() const;
+        // Three-way comparison by code point, negative, zero or positive
+        int compare(const string_ref& other) const;
+        int compare(const char* other) const;
 
         // Implicit conversion to std::string
         operator std::string() const;
 
-        // Get C string
-//            const char* const c_str() const;
+        // Write a C string into an array of utf8_length() + 1 bytes
         void to_c_str(char* array) const;
 
+        // Length of the string in UTF-8 bytes
+        size_t utf8_length() const;
+
+        // Encode as UTF-8 without a terminator, returns the bytes written
+        size_t encode_utf8(char* out) const;
+
         // Returns std string
         const std::string std_str() const;
 
@@ -97,10 +293,10 @@ namespace wheel
         std::vector<string> split(const string& delim = " \n\t");
 
         // Return unsigned integer
-        uint32_t to_uint32();
+        uint32_t to_uint32() const;
 
         // Return floating point value
-        double to_float();
+        double to_float() const;
 
         // Return string size
         size_t length() const;
@@ -108,8 +304,26 @@ namespace wheel
         // Substring
         string substr(size_t start, size_t length) const;
 
+        // Searching, positions are in characters
+        static const size_t npos = ~(size_t)0;
+
+        size_t find(const string_ref& seq, size_t pos = 0) const;
+        size_t find(const char* seq, size_t pos = 0) const;
+        size_t find(char32_t c, size_t pos = 0) const;
+
+        size_t rfind(const string_ref& seq, size_t pos = npos) const;
+        size_t rfind(const char* seq, size_t pos = npos) const;
+        size_t rfind(char32_t c, size_t pos = npos) const;
+
+        size_t find_first_of(const string_ref& chars, size_t pos = 0) const;
+        size_t find_first_of(const char* chars, size_t pos = 0) const;
+
+        std::vector<size_t> find_all(const string_ref& seq) const;
+        std::vector<size_t> find_all(const char* seq) const;
+
         // Contains
-        bool contains(const string&);
+        bool contains(const string_ref& seq) const;
+        bool contains(const char* seq) const;
 
         // Is empty?
         bool empty() const;
@@ -127,12 +341,99 @@ namespace wheel
            return out;
         }
 
-        // FVN-1a
+        // Hash<string> of the string
         inline size_t hash() const noexcept;
   };
+
+  //! NUL-terminated UTF-8 of a string, for C APIs
+  /*!
+     Encodes the string once, into the object when it fits, so handing a
+     path to PhysFS, dlopen() or opendir() needs no std::string.  Strings
+     handed to C APIs over and over are better kept as a symbol, which has
+     its UTF-8 form at hand.
+
+     Example usage:
+     \code
+        PHYSFS_mount(utf8_cstr(path), nullptr, 1);
+     \endcode
+  */
+  class utf8_cstr
+  {
+     private:
+        char                    local[256];
+        std::unique_ptr<char[]> heap;
+        const char*             ptr;
+
+     public:
+        explicit utf8_cstr(const string& s);
+
+        utf8_cstr(const utf8_cstr&) = delete;
+        utf8_cstr& operator=(const utf8_cstr&) = delete;
+
+        inline const char*   c_str() const { return ptr; }
+        inline operator const char*() const { return ptr; }
+  };
+}
+
+namespace wheel
+{
+  namespace internal
+  {
+    //! FNV-1a over the characters of a string, as if they were stored as little-endian UTF-32
+    /*!
+       Xoring in a zero byte does nothing, so the bytes above the storage
+       width only multiply by the prime.  Those steps are folded into a single
+       multiply by a power of the prime, which gives the same value with one
+       multiply per character for 1 byte strings instead of four.
+    */
+    template <typename T, typename H>
+    inline H fnv1a_chars(const T* chars, size_t n, H hash, H prime) noexcept
+    {
+      const H prime2 = prime * prime;
+      const H prime3 = prime2 * prime;
+      const H prime4 = prime2 * prime2;
+
+      for (size_t it = 0; it < n; ++it)
+      {
+        uint32_t c = chars[it];
+
+        if (sizeof(T) == 1)
+        {
+          hash = (hash ^ c) * prime4;
+        } else if (sizeof(T) == 2) {
+          hash = (hash ^ (c & 0xff)) * prime;
+          hash = (hash ^ (c >> 8)) * prime3;
+        } else {
+          hash = (hash ^ (c & 0xff)) * prime;
+          hash = (hash ^ ((c >> 8) & 0xff)) * prime;
+          hash = (hash ^ ((c >> 16) & 0xff)) * prime;
+          hash = (hash ^ (c >> 24)) * prime;
+        }
+      }
+
+      return hash;
+    }
+
+    template <typename H>
+    inline H fnv1a_string(const string& s, H hash, H prime) noexcept
+    {
+      if (s.char_width() == 1)
+        return fnv1a_chars((const uint8_t*)s.raw_data(), s.length(), hash, prime);
+      else if (s.char_width() == 2)
+        return fnv1a_chars((const char16_t*)s.raw_data(), s.length(), hash, prime);
+
+      return fnv1a_chars((const char32_t*)s.raw_data(), s.length(), hash, prime);
+    }
+  }
 }
 
 //! wheel::Hash specialisation for wheel::core::string
+/*!
+   The hash does not depend on the width the string is stored at.  Seeded
+   hashes go over the storage, which is always the narrowest width that
+   fits.  Deterministic hashes are FNV-1a over the characters as UTF-32,
+   which hash_literal() can compute at compile time.
+*/
 namespace wheel
 {
   // 64-bit version of string hash
@@ -142,18 +443,14 @@ namespace wheel
     public:
       size_t operator()(const string& s) const noexcept
       {
-        size_t hash  = 0xCBF29CE484222325;
-        const uint64_t prime = 0x100000001B3;
-
-        uint8_t* bytep = (uint8_t*)s.getptr();
+        if (hash_seed() != 0)
+          return internal::seeded_hash(s.raw_data(), s.length() * s.char_width(), s.char_width());
 
-        for (size_t it = 0; it < s.length() * 4; ++it)
-        {
-          hash = (hash ^ *(bytep+it)) * prime;
-        }
-
-      return hash;
+        return internal::fnv1a_string<uint64_t>(s, 0xCBF29CE484222325, 0x100000001B3);
       }
+
+      // Views hash like the strings they equal, defined with string_ref
+      size_t operator()(const string_ref& s) const noexcept;
  };
 
   // 32-bit version of string hash
@@ -163,24 +460,20 @@ namespace wheel
     public:
       size_t operator()(const string& s) const noexcept
       {
-        size_t hash = 0x811C9DC5;
-        const uint32_t prime = 0x1000193;
+        if (hash_seed() != 0)
+          return internal::seeded_hash(s.raw_data(), s.length() * s.char_width(), s.char_width());
 
-        uint8_t* bytep = (uint8_t*)s.getptr();
-
-        for (size_t it = 0; it < s.length() * 4; ++it)
-        {
-          hash = (hash ^ *(bytep+it)) * prime;
-        }
-
-        return hash;
+        return internal::fnv1a_string<uint32_t>(s, 0x811C9DC5, 0x1000193);
       }
+
+      // Views hash like the strings they equal, defined with string_ref
+      size_t operator()(const string_ref& s) const noexcept;
   };
 
   /*!
     Return hash of the string, note that the hash is not currently cached.
 
-    \return FNV-1a hash.
+    \return Seeded hash, or FNV-1a if hashing is deterministic.
   */
   inline size_t string::hash() const noexcept
   {
@@ -194,17 +487,49 @@ namespace wheel
   template<>
   inline void buffer_t::write(const string& input)
   {
-    std::string actual = input.std_str();
-    this->reserve(this->size() + actual.size());
+    size_t start = size();
+    size_t length = input.utf8_length();
 
-    for (auto c : actual)
-    {
-      this->push_back(c);
-    }
+    reserve_extra(length);
+    resize(start + length);
+    input.encode_utf8((char*)data() + start);
   }
 }
 
 namespace wheel {
+  //! Precomputed key for sorting strings
+  /*!
+     Keys order the same way as string::compare().  A key holds the UTF-8 form
+     of its string, whose byte order is code point order, with the first eight
+     bytes packed into an integer, so most comparisons while sorting a large
+     list of names are a single integer compare and no character decoding.
+  */
+  class sort_key
+  {
+    private:
+      uint64_t    prefix;
+      std::string bytes;
+
+    public:
+      sort_key() : prefix(0) {}
+      explicit sort_key(const string& s);
+
+      inline int compare(const sort_key& other) const
+      {
+        if (prefix != other.prefix)
+          return (prefix < other.prefix) ? -1 : 1;
+
+        return bytes.compare(other.bytes);
+      }
+
+      inline bool operator<(const sort_key& other) const { return compare(other) < 0; }
+      inline bool operator==(const sort_key& other) const { return (prefix == other.prefix) && (bytes == other.bytes); }
+      inline bool operator!=(const sort_key& other) const { return !(*this == other); }
+  };
+
+  //! Sort strings by code point, computing a sort key for each string once
+  void sort_strings(std::vector<string>& list);
+
   /*!
     compares a character to number of other characters
 
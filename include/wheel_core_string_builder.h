@@ -0,0 +1,85 @@
+/*!
+   @file
+   \brief Contains definitions for building strings piece by piece
+   \author Jari Ronkainen
+*/
+
+#ifndef WHEEL_STRING_BUILDER_HEADER
+#define WHEEL_STRING_BUILDER_HEADER
+
+#include "wheel_core_common.h"
+#include "wheel_core_string.h"
+#include "wheel_core_string_ref.h"
+
+namespace wheel
+{
+   //! Appends pieces into a single growing string
+   /*!
+      Every append copies only the new characters, and the storage grows
+      geometrically, so building a log line or a path from many pieces takes
+      linear time.  Numbers are formatted into a stack buffer and appended
+      without temporary strings.  When done, str() or release() hands out the
+      result.
+
+      Example usage:
+      \code
+         wheel::string_builder line;
+
+         line << "loaded " << count << " files from " << path << '\n';
+         wheel::log << line.str();
+      \endcode
+   */
+   class string_builder
+   {
+      private:
+         string buffer;
+
+      public:
+         string_builder() {}
+         explicit string_builder(size_t reserve_chars) { buffer.reserve(reserve_chars); }
+
+         //! Make room for at least n characters at the current width
+         inline void reserve(size_t n) { buffer.reserve(n); }
+         inline size_t capacity() const { return buffer.capacity(); }
+
+         inline size_t length() const { return buffer.length(); }
+         inline bool empty() const { return buffer.empty(); }
+         inline void clear() { buffer.clear(); }
+
+         // Text
+         string_builder& append(const string_ref& text);
+         string_builder& append(const string& text);
+         string_builder& append(const char32_t* text);
+         string_builder& append(const char* utf8);
+         string_builder& append(const char* utf8, size_t length);
+
+         // Code points
+         string_builder& append(char32_t c);
+         string_builder& append(char c);
+         string_builder& append(char32_t c, size_t count);
+
+         // Numbers
+         string_builder& append(int32_t value);
+         string_builder& append(int64_t value);
+         string_builder& append(uint32_t value);
+         string_builder& append(uint64_t value);
+         string_builder& append(double value);
+
+         template <typename T>
+         inline string_builder& operator<<(const T& value)
+         {
+            return append(value);
+         }
+
+         //! View of the characters appended so far, valid until the next append
+         inline string_ref view() const { return string_ref(buffer); }
+
+         //! The string built so far
+         inline const string& str() const { return buffer; }
+
+         //! Move the string out, leaving the builder empty
+         string release();
+   };
+}
+
+#endif //WHEEL_STRING_BUILDER_HEADER
@@ -0,0 +1,179 @@
+/*!
+   @file
+   \brief Contains definitions for the non-owning string view class
+   \author Jari Ronkainen
+*/
+
+#ifndef WHEEL_STRING_REF_HEADER
+#define WHEEL_STRING_REF_HEADER
+
+#include "wheel_core_common.h"
+#include "wheel_core_string.h"
+
+#include <vector>
+
+namespace wheel
+{
+   //! Non-owning view into a string
+   /*!
+      A string_ref points to characters stored elsewhere, usually in a
+      wheel::string, and never allocates.  Splitting, trimming and taking
+      substrings return new views into the same storage, so parsing a string
+      does not copy any characters until the caller asks for a wheel::string
+      with str().
+
+      The view is only valid as long as the storage it points to is, modifying
+      or destroying the string it was made from invalidates it.
+
+      Unlike wheel::string, the storage width of a view is whatever the
+      underlying string uses, so views with equal contents may have different
+      widths.  Comparisons and hashing work on characters and do not care.
+   */
+   class string_ref
+   {
+      private:
+         const uint8_t* data;
+         size_t         len;
+         uint8_t        width;
+
+      public:
+         //! Random access iterator over the characters of a view
+         class const_iterator
+         {
+            private:
+               const string_ref* ref;
+               size_t            idx;
+
+            public:
+               typedef std::random_access_iterator_tag   iterator_category;
+               typedef char32_t                          value_type;
+               typedef ptrdiff_t                         difference_type;
+               typedef const char32_t*                   pointer;
+               typedef char32_t                          reference;
+
+               const_iterator() : ref(nullptr), idx(0) {}
+               const_iterator(const string_ref* r, size_t i) : ref(r), idx(i) {}
+
+               inline char32_t operator*() const { return (*ref)[idx]; }
+
+               inline const_iterator& operator++() { ++idx; return *this; }
+               inline const_iterator& operator--() { --idx; return *this; }
+               inline const_iterator operator++(int) { const_iterator r(*this); ++idx; return r; }
+               inline const_iterator operator--(int) { const_iterator r(*this); --idx; return r; }
+
+               inline const_iterator operator+(difference_type n) const { return const_iterator(ref, idx + n); }
+               inline difference_type operator-(const const_iterator& o) const { return (difference_type)idx - (difference_type)o.idx; }
+
+               inline bool operator==(const const_iterator& o) const { return idx == o.idx; }
+               inline bool operator!=(const const_iterator& o) const { return idx != o.idx; }
+         };
+
+         static const size_t npos = ~(size_t)0;
+
+         string_ref() : data(nullptr), len(0), width(1) {}
+         string_ref(const void* chars, uint8_t char_width, size_t length) : data((const uint8_t*)chars), len(length), width(char_width) {}
+
+         string_ref(const string& s) : data((const uint8_t*)s.raw_data()), len(s.length()), width(s.char_width()) {}
+         string_ref(const char32_t* s);
+         string_ref(const char32_t* s, size_t length) : data((const uint8_t*)s), len(length), width(4) {}
+
+         // Storage
+         inline size_t length() const { return len; }
+         inline bool empty() const { return len == 0; }
+         inline size_t char_width() const { return width; }
+         inline const void* raw_data() const { return data; }
+
+         // Character access
+         inline char32_t operator[](size_t pos) const
+         {
+            if (width == 1)
+               return data[pos];
+            else if (width == 2)
+               return ((const char16_t*)data)[pos];
+
+            return ((const char32_t*)data)[pos];
+         }
+
+         const_iterator begin() const { return const_iterator(this, 0); }
+         const_iterator end() const { return const_iterator(this, len); }
+
+         // Views
+         string_ref substr(size_t pos, size_t length = npos) const;
+
+         string_ref trim(const string_ref& chars = U" \n\t\r") const;
+         string_ref trim_left(const string_ref& chars = U" \n\t\r") const;
+         string_ref trim_right(const string_ref& chars = U" \n\t\r") const;
+
+         std::vector<string_ref> split(const string_ref& delim = U" \n\t") const;
+         bool tokenize(string_ref& token, const string_ref& delim = U" \n\t");
+
+         // Searching
+         size_t find(char32_t c, size_t pos = 0) const;
+         size_t find(const string_ref& seq, size_t pos = 0) const;
+         size_t rfind(char32_t c, size_t pos = npos) const;
+         size_t rfind(const string_ref& seq, size_t pos = npos) const;
+         size_t find_first_of(const string_ref& chars, size_t pos = 0) const;
+         std::vector<size_t> find_all(const string_ref& seq) const;
+         bool contains(const string_ref& seq) const { return find(seq) != npos; }
+
+         bool starts_with(const string_ref& seq) const;
+         bool ends_with(const string_ref& seq) const;
+
+         // Comparison
+         int compare(const string_ref& other) const;
+
+         inline bool operator==(const string_ref& other) const
+         {
+            return (len == other.len) && (compare(other) == 0);
+         }
+         inline bool operator!=(const string_ref& other) const { return !(*this == other); }
+         inline bool operator<(const string_ref& other) const { return compare(other) < 0; }
+         inline bool operator>(const string_ref& other) const { return compare(other) > 0; }
+
+         // Conversion
+         string str() const;
+
+         size_t hash() const noexcept;
+
+         friend inline std::ostream& operator<<(std::ostream& out, const wheel::string_ref& ref)
+         {
+            out << ref.str();
+            return out;
+         }
+   };
+
+   inline size_t Hash<string, true>::operator()(const string_ref& s) const noexcept
+   {
+      return s.hash();
+   }
+
+   inline size_t Hash<string, false>::operator()(const string_ref& s) const noexcept
+   {
+      return s.hash();
+   }
+
+   //! Hash of a view matches the hash of a wheel::string with the same contents.
+   template<bool is_x86_64>
+   class Hash<string_ref, is_x86_64>
+   {
+      public:
+         size_t operator()(const string_ref& s) const noexcept
+         {
+            return s.hash();
+         }
+   };
+}
+
+namespace std
+{
+   template<>
+   struct hash<wheel::string_ref>
+   {
+      size_t operator()(const wheel::string_ref& __s) const noexcept
+      {
+         return __s.hash();
+      }
+   };
+}
+
+#endif //WHEEL_STRING_REF_HEADER
@@ -0,0 +1,123 @@
+/*!
+   @file
+   \brief Contains definitions for interned strings (symbols)
+   \author Jari Ronkainen
+*/
+
+#ifndef WHEEL_SYMBOL_HEADER
+#define WHEEL_SYMBOL_HEADER
+
+#include "wheel_core_common.h"
+#include "wheel_core_string.h"
+#include "wheel_core_hashed_name.h"
+
+namespace wheel
+{
+   namespace internal
+   {
+      //! Entry in the global symbol table
+      struct symbol_entry
+      {
+         string         str;
+         size_t         hash;
+         std::string    utf8;          //!< Encoded once, for C APIs
+      };
+
+      const symbol_entry* empty_symbol();
+   }
+
+   //! Interned string handle
+   /*!
+      A symbol refers to a single shared copy of a string in a global,
+      thread-safe intern table.  Two symbols made from equal strings refer
+      to the same entry, so comparing them is a pointer comparison, and the
+      hash is computed once when the string is first interned.
+
+      Interning takes a lock and hashes the string, so symbols should be
+      created once and kept around rather than built for every lookup.
+      Interned strings are never freed.
+
+      Example usage:
+      \code
+         static const wheel::symbol tri_vs("tri.vs");
+
+         wheel::Buffer(tri_vs);
+         wheel::buffer_t* buf = wheel::GetBuffer(tri_vs);
+      \endcode
+   */
+   class symbol
+   {
+      private:
+         const internal::symbol_entry* entry;
+
+         explicit symbol(const internal::symbol_entry* e) : entry(e) {}
+
+      public:
+         symbol() : entry(internal::empty_symbol()) {}
+
+         explicit symbol(const string& s);
+         explicit symbol(const char* s);
+         explicit symbol(const char32_t* s);
+         explicit symbol(const hashed_name& name);
+
+         //! Look up an already interned string without interning it
+         static bool find(const string& s, symbol& result);
+         static bool find(const hashed_name& name, symbol& result);
+
+         //! Number of strings in the intern table
+         static size_t table_size();
+
+         inline const string& str() const { return entry->str; }
+         inline const char* c_str() const { return entry->utf8.c_str(); }
+         inline size_t hash() const noexcept { return entry->hash; }
+
+         inline size_t length() const { return entry->str.length(); }
+         inline bool empty() const { return entry->str.empty(); }
+
+         inline bool operator==(const symbol& other) const { return entry == other.entry; }
+         inline bool operator!=(const symbol& other) const { return entry != other.entry; }
+
+         friend inline std::ostream& operator<<(std::ostream& out, const wheel::symbol& sym)
+         {
+            out << sym.str();
+            return out;
+         }
+   };
+
+   //! Hash of a symbol is the hash of its string, computed when it was interned.
+   template<bool is_x86_64>
+   class Hash<symbol, is_x86_64>
+   {
+      public:
+         size_t operator()(const symbol& s) const noexcept
+         {
+            return s.hash();
+         }
+
+         //! Names hash like the symbols they equal, for lookups without interning
+         size_t operator()(const hashed_name& name) const noexcept
+         {
+            return name.hash();
+         }
+   };
+
+   inline bool operator==(const hashed_name& name, const symbol& s)
+   {
+      return name.matches(s.str());
+   }
+}
+
+namespace std
+{
+   //! std::hash specialisation for wheel::symbol
+   template<>
+   struct hash<wheel::symbol>
+   {
+      size_t operator()(const wheel::symbol& __s) const noexcept
+      {
+         return __s.hash();
+      }
+   };
+}
+
+#endif //WHEEL_SYMBOL_HEADER
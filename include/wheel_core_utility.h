@@ -7,7 +7,9 @@
 #define WHEEL_UTILITY_HEADER
 
 #include "wheel_core_common.h"
+#include "wheel_core_buffer_view.h"
 #include "wheel_core_string.h"
+#include "wheel_core_string_ref.h"
 
 #include <cstdint>
 #include <algorithm>
@@ -20,10 +22,7 @@ namespace wheel
    */
    inline bool IsBigEndian()
    {
-      static const uint16_t endian_check_value        = 0xbe1e;
-      static const uint8_t  endian_check_value_first  = *(uint8_t*)&endian_check_value;
-
-      return (endian_check_value_first == 0x1e);
+      return big_endian();
    }
 
    //! Split by delim
@@ -43,6 +42,32 @@ namespace wheel
       }
    }
 
+   //! Split a view by delim
+   /*!
+      Calls binary_op with a view of every field between delimiters, including
+      empty ones, without copying any characters.
+
+      \param text       Text to split
+      \param delim      Characters that separate fields
+      \param binary_op  Called with each field as a string_ref
+   */
+   template <class BinOp>
+   void for_each_token(const string_ref& text, const string_ref& delim, BinOp binary_op)
+   {
+      size_t first = 0;
+
+      for (size_t i = 0; i < text.length(); ++i)
+      {
+         if (delim.find(text[i]) != string_ref::npos)
+         {
+            binary_op(text.substr(first, i - first));
+            first = i + 1;
+         }
+      }
+
+      binary_op(text.substr(first));
+   }
+
    //! Reads a big-endian value from a buffer and increments pointer.
    /*!
       \param buffer     Buffer to be read
@@ -53,45 +78,9 @@ namespace wheel
    template <typename T>
    T buffer_read(const buffer_t& buffer, size_t& location)
    {
-      //T rval = *(T*)(&buffer[0] + location);
-      T rval = *(T*)(buffer.getptr() + location);
+      T rval = buffer.read_be<T>(location);
       location += sizeof(T);
 
-      if (!IsBigEndian())
-         return rval;
-
-      if (sizeof(T) == 2)
-      {
-         uint16_t tmpval = *(uint16_t*)(&rval);
-
-         tmpval = (tmpval & 0xff00) >> 8
-                | (tmpval & 0x00ff) << 8;
-
-         rval = *(T*)(&tmpval);
-      }
-      else if (sizeof(T) == 4)
-      {
-         uint32_t tmpval = *(uint32_t*)(&rval);
-
-         tmpval = (tmpval & 0xff000000) >> 24
-                | (tmpval & 0x00ff0000) >> 8
-                | (tmpval & 0x0000ff00) << 8
-                | (tmpval & 0x000000ff) << 24;
-
-         rval = *(T*)(&tmpval);
-      }
-      else if (sizeof(T) == 8)
-      {
-         rval = (rval & 0xff00000000000000) >> 56
-              | (rval & 0x00ff000000000000) >> 40
-              | (rval & 0x0000ff0000000000) >> 24
-              | (rval & 0x000000ff00000000) >> 8
-              | (rval & 0x00000000ff000000) << 8
-              | (rval & 0x0000000000ff0000) << 24
-              | (rval & 0x000000000000ff00) << 40
-              | (rval & 0x00000000000000ff) << 56;
-      }
-
       return rval;
    }
 
@@ -105,55 +94,52 @@ namespace wheel
    template <typename T>
    T buffer_read_le(const buffer_t& buffer, size_t& location)
    {
-//      T rval = *(T*)(&buffer[0] + location);
-      T rval = *(T*)(buffer.getptr() + location);
-
+      T rval = buffer.read_le<T>(location);
       location += sizeof(T);
 
-      if (IsBigEndian())
-         return rval;
-
-      if (sizeof(T) == 2)
-      {
-         uint16_t tmpval = *(uint16_t*)(&rval);
-
-         tmpval = (tmpval & 0xff00) >> 8
-                | (tmpval & 0x00ff) << 8;
-
-         rval = *(T*)(&tmpval);
-      }
-      else if (sizeof(T) == 4)
-      {
-         uint32_t tmpval = *(uint32_t*)(&rval);
-
-         tmpval = (tmpval & 0xff000000) >> 24
-                | (tmpval & 0x00ff0000) >> 8
-                | (tmpval & 0x0000ff00) << 8
-                | (tmpval & 0x000000ff) << 24;
-
-         rval = *(T*)(&tmpval);
-      }
-      else if (sizeof(T) == 8)
-      {
-         rval = (rval & 0xff00000000000000) >> 56
-              | (rval & 0x00ff000000000000) >> 40
-              | (rval & 0x0000ff0000000000) >> 24
-              | (rval & 0x000000ff00000000) >> 8
-              | (rval & 0x00000000ff000000) << 8
-              | (rval & 0x0000000000ff0000) << 24
-              | (rval & 0x000000000000ff00) << 40
-              | (rval & 0x00000000000000ff) << 56;
-      }
-
       return rval;
    }
 
    //! Calculate crc32
    /*!
+      Safe to call from several threads at once.  Uses PCLMULQDQ or the
+      ARMv8 CRC32 instructions when the CPU has them.
+
       \return CRC32 value of the buffer given
    */
-   uint32_t crc32(uint8_t* buffer, size_t len);
-   uint32_t update_crc(uint32_t crc, uint8_t* buf, size_t len);
+   uint32_t crc32(const uint8_t* buffer, size_t len);
+
+   //! Continue a CRC32 register, which starts at 0xffffffff and is inverted at the end
+   uint32_t update_crc(uint32_t crc, const uint8_t* buf, size_t len);
+
+   //! CRC32 of two buffers one after the other, from the CRC32 of each
+   /*!
+      \param crc1  crc32() of the first buffer
+      \param crc2  crc32() of the second buffer
+      \param len2  Length of the second buffer
+
+      \return crc32() of the two together
+   */
+   uint32_t crc32_combine(uint32_t crc1, uint32_t crc2, size_t len2);
+
+   namespace internal
+   {
+      //! Ways of computing a CRC32, for benchmarks and tests
+      enum crc32_method_t
+      {
+         WHEEL_CRC32_BYTEWISE,
+         WHEEL_CRC32_SLICE8,
+         WHEEL_CRC32_SLICE16,
+         WHEEL_CRC32_PCLMUL,
+         WHEEL_CRC32_ARMV8
+      };
+
+      //! Can this build and CPU use the method
+      bool crc32_supported(crc32_method_t method);
+
+      //! update_crc() with a given method, which must be supported
+      uint32_t update_crc(crc32_method_t method, uint32_t crc, const uint8_t* buf, size_t len);
+   }
 
    //! Timer
    /*!
@@ -7,6 +7,7 @@
 #define WHEEL_SOUND_LIBRARY_HEADER
 
 #include "wheel_sound_common.h"
+#include "wheel_core_hash.h"
 
 #include <unordered_map>
 
@@ -20,7 +21,7 @@ namespace wheel
       class Library
       {
          private:
-            std::unordered_map<string, Sound*> soundcache;
+            std::unordered_map<string, Sound*, fast_hash<string>> soundcache;
 
          public:
             const uint8_t* GetRawData();
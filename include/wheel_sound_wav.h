@@ -12,12 +12,22 @@ namespace wheel
 {
    namespace audio
    {
-      struct WAVChunk;
+      //! Type and length of a WAV/RIFF chunk
+      struct WAVChunk
+      {
+         char        type[4];
+         uint32_t    len;
+      };
 
       class WAV : public Sound
       {
          private:
-            std::vector<WAVChunk*> chunks;
+            std::vector<WAVChunk> chunks;
+
+            uint16_t    format_code;
+            uint32_t    byte_rate;
+            uint16_t    block_align;
+            uint16_t    bits_per_sample;
 
          public:
             uint32_t Load(const buffer_t& buffer);
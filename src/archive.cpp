@@ -0,0 +1,338 @@
+/*!
+   @file
+   \brief Contains implementations for compact binary serialization
+   \author Jari Ronkainen
+
+   Varints are LEB128: seven bits per byte, lowest first, with the high bit
+   set on every byte but the last.  A 64-bit value takes at most ten bytes.
+
+   Varints of up to eight bytes, values below 2^56, are encoded and decoded
+   a word at a time: the 7-bit groups are spread out to bytes, or gathered
+   back, with three mask-and-shift steps, and the length comes from the
+   highest set bit or the first byte without the high bit.  Only the
+   length decides how far the position moves, so there is no branch per
+   byte.
+
+   A versioned record is written before its length is known, so one byte
+   is left for the length and the rest of a longer length is inserted
+   after it once the record is done.  Most records are shorter than 128
+   bytes and need no moving.
+*/
+
+#include "../include/wheel_core_archive.h"
+#include "../include/wheel_core_bitstream.h"
+
+#include <cstring>
+
+namespace wheel
+{
+   namespace
+   {
+      const size_t max_varint_bytes = 10;
+
+      const uint64_t high_bits = 0x8080808080808080ull;
+      const uint64_t low_bits  = 0x7f7f7f7f7f7f7f7full;
+
+      //! Number of bits needed for value, at least 1
+      inline uint32_t bit_width(uint64_t value)
+      {
+#ifdef __GNUC__
+         return 64 - __builtin_clzll(value | 1);
+#else
+         uint32_t rval = 1;
+
+         while (value >>= 1)
+            ++rval;
+
+         return rval;
+#endif
+      }
+
+      //! Index of the lowest set bit, value is not 0
+      inline uint32_t lowest_bit(uint64_t value)
+      {
+#ifdef __GNUC__
+         return __builtin_ctzll(value);
+#else
+         uint32_t rval = 0;
+
+         while (!(value & 1))
+         {
+            value >>= 1;
+            ++rval;
+         }
+
+         return rval;
+#endif
+      }
+
+      //! 7-bit groups of a value below 2^56 moved to the low bits of each byte
+      inline uint64_t spread_groups(uint64_t value)
+      {
+         value = (value & 0x000000000fffffffull) | ((value & 0x00fffffff0000000ull) << 4);
+         value = (value & 0x00003fff00003fffull) | ((value & 0x0fffc0000fffc000ull) << 2);
+         value = (value & 0x007f007f007f007full) | ((value & 0x3f803f803f803f80ull) << 1);
+
+         return value;
+      }
+
+      //! Inverse of spread_groups()
+      inline uint64_t gather_groups(uint64_t value)
+      {
+         value = (value & 0x007f007f007f007full) | ((value & 0x7f007f007f007f00ull) >> 1);
+         value = (value & 0x00003fff00003fffull) | ((value & 0x3fff00003fff0000ull) >> 2);
+         value = (value & 0x000000000fffffffull) | ((value & 0x0fffffff00000000ull) >> 4);
+
+         return value;
+      }
+
+      //! Encodes a varint, returns its length
+      inline size_t encode_varint(uint8_t* dst, uint64_t value)
+      {
+         size_t n = 0;
+
+         while (value >= 0x80)
+         {
+            dst[n++] = (uint8_t)value | 0x80;
+            value >>= 7;
+         }
+
+         dst[n++] = (uint8_t)value;
+
+         return n;
+      }
+   }
+
+   const size_t archive_writer::block_size;
+
+   void archive_writer::write_varint_long(uint64_t value)
+   {
+      if (block_size - used < max_varint_bytes)
+         flush();
+
+      if (value >> 56)
+      {
+         used += encode_varint(block + used, value);
+         return;
+      }
+
+      // All eight bytes are stored, but only the used ones are kept
+      size_t n = (bit_width(value) + 6) / 7;
+      uint64_t continued = high_bits & ((1ull << (8 * n - 8)) - 1);
+
+      internal::store_bits64<WHEEL_LSB_FIRST>(block + used, spread_groups(value) | continued);
+      used += n;
+   }
+
+   void archive_writer::write_fixed(uint64_t bits, size_t bytes)
+   {
+      if (block_size - used < bytes)
+         flush();
+
+      if (bytes == 4)
+         store_le(block + used, (uint32_t)bits);
+      else
+         store_le(block + used, bits);
+
+      used += bytes;
+   }
+
+   void archive_writer::write_bytes(const void* src, size_t n)
+   {
+      if (n <= block_size - used)
+      {
+         memcpy(block + used, src, n);
+         used += n;
+
+         return;
+      }
+
+      flush();
+      out.append(src, n);
+   }
+
+   //! Write the version and room for the length, returns where the record starts
+   size_t archive_writer::begin_record(uint32_t version)
+   {
+      write_varint(version);
+      write_byte(0);
+
+      return out.size() + used;
+   }
+
+   void archive_writer::end_record(size_t mark)
+   {
+      flush();
+
+      uint8_t bytes[max_varint_bytes];
+      size_t n = encode_varint(bytes, out.size() - mark);
+
+      out[mark - 1] = bytes[0];
+
+      if (n > 1)
+         out.insert(out.begin() + mark, bytes + 1, bytes + n);
+   }
+
+   void archive_writer::field(const string& value)
+   {
+      field(value.std_str());
+   }
+
+   void archive_writer::field(const std::string& value)
+   {
+      write_varint(value.size());
+      write_bytes(value.data(), value.size());
+   }
+
+   void archive_reader::fail(uint32_t status)
+   {
+      if (error == WHEEL_OK)
+         error = status;
+
+      // Nothing more can be read
+      stop = ptr;
+   }
+
+   bool archive_reader::read_varint_long(uint64_t& value)
+   {
+      uint64_t rval = 0;
+
+      if (remaining() >= 8)
+      {
+         uint64_t word = internal::load_bits64<WHEEL_LSB_FIRST>(ptr);
+         uint64_t ends = ~word & high_bits;
+
+         if (ends != 0)
+         {
+            // Bytes up to and including the first one without the high bit
+            uint32_t last = lowest_bit(ends);
+            uint64_t mask = last == 63 ? ~0ull : (1ull << (last + 1)) - 1;
+
+            value = gather_groups(word & mask & low_bits);
+            ptr += (last + 1) / 8;
+
+            return true;
+         }
+      }
+
+      // With ten bytes left, only the end of the varint needs checking
+      if (remaining() >= max_varint_bytes)
+      {
+         for (size_t i = 0; i < max_varint_bytes; ++i)
+         {
+            uint8_t byte = ptr[i];
+            rval |= (uint64_t)(byte & 0x7f) << (7 * i);
+
+            if (byte < 0x80)
+            {
+               if (i == max_varint_bytes - 1 && byte > 1)
+                  break;
+
+               ptr += i + 1;
+               value = rval;
+
+               return true;
+            }
+         }
+
+         fail(WHEEL_INVALID_FORMAT);
+         return false;
+      }
+
+      for (size_t i = 0; i < max_varint_bytes; ++i)
+      {
+         if (ptr == stop)
+         {
+            fail(WHEEL_UNEXPECTED_END_OF_FILE);
+            return false;
+         }
+
+         uint8_t byte = *ptr++;
+         rval |= (uint64_t)(byte & 0x7f) << (7 * i);
+
+         if (byte < 0x80)
+         {
+            // The tenth byte only has room for the top bit
+            if (i == max_varint_bytes - 1 && byte > 1)
+               break;
+
+            value = rval;
+            return true;
+         }
+      }
+
+      fail(WHEEL_INVALID_FORMAT);
+      return false;
+   }
+
+   bool archive_reader::read_fixed(uint64_t& bits, size_t bytes)
+   {
+      if (remaining() < bytes)
+      {
+         fail(WHEEL_UNEXPECTED_END_OF_FILE);
+         return false;
+      }
+
+      bits = bytes == 4 ? load_le<uint32_t>(ptr) : load_le<uint64_t>(ptr);
+      ptr += bytes;
+
+      return true;
+   }
+
+   //! Read a length, which cannot be more than the bytes left
+   bool archive_reader::read_length(size_t& length)
+   {
+      uint64_t wide;
+
+      if (!read_varint(wide))
+         return false;
+
+      if (wide > remaining())
+      {
+         fail(WHEEL_UNEXPECTED_END_OF_FILE);
+         return false;
+      }
+
+      length = (size_t)wide;
+
+      return true;
+   }
+
+   void archive_reader::field(string& value)
+   {
+      size_t length;
+
+      if (!read_length(length))
+         return;
+
+      value = string((const char*)ptr, length);
+      ptr += length;
+   }
+
+   void archive_reader::field(std::string& value)
+   {
+      size_t length;
+
+      if (!read_length(length))
+         return;
+
+      value.assign((const char*)ptr, length);
+      ptr += length;
+   }
+
+   void archive_reader::field(std::vector<bool>& value)
+   {
+      size_t length;
+
+      if (!read_length(length))
+         return;
+
+      value.clear();
+      value.reserve(length);
+
+      for (size_t i = 0; i < length; ++i)
+         value.push_back(ptr[i] != 0);
+
+      ptr += length;
+   }
+}
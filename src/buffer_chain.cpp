@@ -0,0 +1,152 @@
+/*!
+   @file
+   \brief Contains implementations for chains of buffers
+   \author Jari Ronkainen
+*/
+
+#include "../include/wheel_core_buffer_chain.h"
+
+namespace wheel
+{
+   size_t buffer_chain::gather(size_t offset, void* dst, size_t n) const
+   {
+      uint8_t* out = (uint8_t*)dst;
+      size_t copied = 0;
+
+      for (const buffer_view& segment : segments)
+      {
+         if (copied == n)
+            break;
+
+         // Segments before the offset
+         if (offset >= segment.size())
+         {
+            offset -= segment.size();
+            continue;
+         }
+
+         size_t part = std::min(segment.size() - offset, n - copied);
+         memcpy(out + copied, segment.data() + offset, part);
+
+         copied += part;
+         offset = 0;
+      }
+
+      return copied;
+   }
+
+   buffer_view buffer_chain::flatten(buffer_t& scratch) const
+   {
+      if (segments.size() <= 1)
+         return segments.empty() ? buffer_view() : segments[0];
+
+      scratch.clear();
+      scratch.reserve(length);
+
+      for (const buffer_view& segment : segments)
+         scratch.append(segment.data(), segment.size());
+
+      return buffer_view(scratch);
+   }
+
+   void chain_cursor::advance(size_t n)
+   {
+      position += n;
+
+      while (n > 0)
+      {
+         size_t left = chain->segment(index).size() - offset;
+
+         if (n < left)
+         {
+            offset += n;
+            return;
+         }
+
+         // Never stop at the end of a segment, so reads can start from index
+         n -= left;
+         ++index;
+         offset = 0;
+      }
+   }
+
+   void chain_cursor::copy(void* dst, size_t n)
+   {
+      uint8_t* out = (uint8_t*)dst;
+      position += n;
+
+      while (n > 0)
+      {
+         const buffer_view& current = chain->segment(index);
+         size_t part = std::min(current.size() - offset, n);
+
+         memcpy(out, current.data() + offset, part);
+
+         out += part;
+         n -= part;
+         offset += part;
+
+         if (offset == current.size())
+         {
+            ++index;
+            offset = 0;
+         }
+      }
+   }
+
+   bool chain_cursor::take(size_t n, buffer_view& out, buffer_t& scratch)
+   {
+      if (!can_read(n))
+         return false;
+
+      if (n == 0)
+      {
+         out = buffer_view();
+         return true;
+      }
+
+      const buffer_view& current = chain->segment(index);
+
+      if (current.has(offset, n))
+      {
+         out = current.subview(offset, n);
+         advance(n);
+
+         return true;
+      }
+
+      scratch.resize(n);
+      copy(scratch.data(), n);
+
+      out = buffer_view(scratch);
+
+      return true;
+   }
+
+   bool chain_cursor::take(size_t n, buffer_chain& out)
+   {
+      if (!can_read(n))
+         return false;
+
+      position += n;
+
+      while (n > 0)
+      {
+         const buffer_view& current = chain->segment(index);
+         size_t part = std::min(current.size() - offset, n);
+
+         out.append(current.subview(offset, part));
+
+         n -= part;
+         offset += part;
+
+         if (offset == current.size())
+         {
+            ++index;
+            offset = 0;
+         }
+      }
+
+      return true;
+   }
+}
@@ -0,0 +1,367 @@
+/*!
+   @file
+   \brief Contains implementations for recycling buffer storage
+   \author Jari Ronkainen
+
+   Size class k holds buffers with capacity in [32 << k, 32 << (k+1)).  A
+   request for n bytes is served from the smallest class whose every buffer
+   fits n, so it never has to grow, and new buffers are made with the
+   capacity of the bottom of their class so they return to the same class.
+*/
+
+#include "../include/wheel_core_buffer_pool.h"
+
+#include <atomic>
+#include <mutex>
+
+namespace wheel
+{
+   const size_t buffer_pool::min_capacity;
+   const size_t buffer_pool::max_capacity;
+   const size_t buffer_pool::class_count;
+   const size_t buffer_pool::thread_bytes;
+
+   namespace
+   {
+      //! Counters of one thread, only that thread writes them
+      /*!
+         Each acquire and release counts one of these, the totals are
+         sums of them.
+      */
+      struct counters_t
+      {
+         std::atomic<uint64_t> thread_hits;
+         std::atomic<uint64_t> shared_hits;
+         std::atomic<uint64_t> misses;
+         std::atomic<uint64_t> kept;         //!< Released into the cache of the thread
+         std::atomic<uint64_t> shared;       //!< ...into the shared cache
+         std::atomic<uint64_t> dropped;
+
+         counters_t() : thread_hits(0), shared_hits(0), misses(0), kept(0), shared(0), dropped(0) {}
+      };
+
+      //! No other thread writes, so a plain load and store is enough
+      inline void count(std::atomic<uint64_t>& counter)
+      {
+         counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+      }
+
+      inline void add(buffer_pool_stats_t& stats, const counters_t& c)
+      {
+         uint64_t thread_hits = c.thread_hits.load(std::memory_order_relaxed);
+         uint64_t shared_hits = c.shared_hits.load(std::memory_order_relaxed);
+         uint64_t misses      = c.misses.load(std::memory_order_relaxed);
+         uint64_t dropped     = c.dropped.load(std::memory_order_relaxed);
+
+         stats.acquired    += thread_hits + shared_hits + misses;
+         stats.thread_hits += thread_hits;
+         stats.shared_hits += shared_hits;
+         stats.misses      += misses;
+         stats.released    += c.kept.load(std::memory_order_relaxed) + c.shared.load(std::memory_order_relaxed) + dropped;
+         stats.dropped     += dropped;
+      }
+
+      struct thread_cache_t;
+
+      struct shared_cache_t
+      {
+         std::mutex              lock;
+         std::vector<buffer_t>   buffers[buffer_pool::class_count];
+
+         size_t                  bytes;
+         size_t                  limit;
+
+         //! Caches of running threads, and the counts of threads that have exited
+         std::vector<thread_cache_t*> threads;
+         buffer_pool_stats_t          retired;
+      };
+
+      shared_cache_t& shared()
+      {
+         static shared_cache_t cache { {}, {}, 0, 64 * 1024 * 1024, {}, {} };
+         return cache;
+      }
+
+      //! Index of the highest set bit, value is not 0
+      inline size_t highest_bit(size_t value)
+      {
+#ifdef __GNUC__
+         return sizeof(unsigned long long) * 8 - 1 - __builtin_clzll(value);
+#else
+         size_t rval = 0;
+
+         while (value >>= 1)
+            ++rval;
+
+         return rval;
+#endif
+      }
+
+      //! Class of a buffer of this capacity, class_count if there is none
+      inline size_t class_of(size_t capacity)
+      {
+         if (capacity < buffer_pool::min_capacity)
+            return buffer_pool::class_count;
+
+         return std::min(highest_bit(capacity / buffer_pool::min_capacity), buffer_pool::class_count);
+      }
+
+      //! Smallest class whose buffers all hold n bytes
+      inline size_t class_for(size_t n)
+      {
+         if (n <= buffer_pool::min_capacity)
+            return 0;
+
+         return highest_bit((n - 1) / buffer_pool::min_capacity) + 1;
+      }
+
+      //! Buffers a thread keeps of a class, many small ones but few large ones
+      inline size_t thread_limit(size_t k)
+      {
+         size_t n = buffer_pool::thread_bytes / (buffer_pool::min_capacity << k);
+
+         return std::max<size_t>(2, std::min<size_t>(64, n));
+      }
+
+      //! Moves a buffer into the shared cache if it has room
+      bool share(buffer_t& buffer, size_t k)
+      {
+         shared_cache_t& cache = shared();
+         std::lock_guard<std::mutex> guard(cache.lock);
+
+         if (cache.bytes + buffer.capacity() > cache.limit)
+            return false;
+
+         cache.bytes += buffer.capacity();
+         cache.buffers[k].push_back(std::move(buffer));
+
+         return true;
+      }
+
+      struct thread_cache_t
+      {
+         std::vector<buffer_t>   buffers[buffer_pool::class_count];
+         counters_t              counters;
+
+         thread_cache_t();
+        ~thread_cache_t();
+      };
+
+      // The cache of this thread once it has been made, and whether it has
+      // been destroyed.  Both are plain values, so using them costs no
+      // initialisation check; buffers released after the cache is gone are
+      // just freed.
+      thread_local thread_cache_t* thread_cache = nullptr;
+      thread_local bool thread_cache_gone = false;
+
+      thread_cache_t::thread_cache_t()
+      {
+         for (size_t k = 0; k < buffer_pool::class_count; ++k)
+            buffers[k].reserve(thread_limit(k));
+
+         shared_cache_t& cache = shared();
+         std::lock_guard<std::mutex> guard(cache.lock);
+
+         cache.threads.push_back(this);
+      }
+
+      thread_cache_t::~thread_cache_t()
+      {
+         thread_cache = nullptr;
+         thread_cache_gone = true;
+
+         // Whatever fits goes to the threads that are still running
+         for (size_t k = 0; k < buffer_pool::class_count; ++k)
+            for (buffer_t& buffer : buffers[k])
+               share(buffer, k);
+
+         shared_cache_t& cache = shared();
+         std::lock_guard<std::mutex> guard(cache.lock);
+
+         add(cache.retired, counters);
+         cache.threads.erase(std::find(cache.threads.begin(), cache.threads.end(), this));
+      }
+
+      //! Cache of this thread, made on first use, nullptr after it is gone
+      thread_cache_t* make_local()
+      {
+         if (thread_cache_gone)
+            return nullptr;
+
+         thread_local thread_cache_t cache;
+         thread_cache = &cache;
+
+         return thread_cache;
+      }
+
+      inline thread_cache_t* local()
+      {
+         thread_cache_t* cache = thread_cache;
+
+         return cache ? cache : make_local();
+      }
+
+      // Counts of the threads that have no cache, left or not yet made
+      counters_t cacheless;
+      std::mutex cacheless_lock;
+
+      buffer_t acquire_shared(thread_cache_t& cache, size_t k)
+      {
+         buffer_t rval;
+
+         {
+            shared_cache_t& shared_cache = shared();
+            std::lock_guard<std::mutex> guard(shared_cache.lock);
+
+            std::vector<buffer_t>& free = shared_cache.buffers[k];
+
+            if (!free.empty())
+            {
+               count(cache.counters.shared_hits);
+
+               rval.swap(free.back());
+               free.pop_back();
+               shared_cache.bytes -= rval.capacity();
+
+               return rval;
+            }
+         }
+
+         count(cache.counters.misses);
+         rval.reserve(buffer_pool::min_capacity << k);
+
+         return rval;
+      }
+
+      void release_shared(thread_cache_t& cache, buffer_t& buffer, size_t k)
+      {
+         if (k < buffer_pool::class_count && share(buffer, k))
+         {
+            count(cache.counters.shared);
+            return;
+         }
+
+         count(cache.counters.dropped);
+         buffer_t().swap(buffer);
+      }
+   }
+
+   buffer_t buffer_pool::acquire(size_t capacity)
+   {
+      size_t k = class_for(capacity);
+      thread_cache_t* cache = local();
+
+      if (cache == nullptr || k >= class_count)
+      {
+         buffer_t rval;
+
+         if (cache)
+         {
+            count(cache->counters.misses);
+         } else {
+            std::lock_guard<std::mutex> guard(cacheless_lock);
+            count(cacheless.misses);
+         }
+
+         rval.reserve(capacity);
+         return rval;
+      }
+
+      std::vector<buffer_t>& mine = cache->buffers[k];
+
+      if (mine.empty())
+         return acquire_shared(*cache, k);
+
+      count(cache->counters.thread_hits);
+
+      buffer_t rval(std::move(mine.back()));
+      mine.pop_back();
+
+      return rval;
+   }
+
+   void buffer_pool::release(buffer_t&& buffer)
+   {
+      // Moved-from buffers have nothing to give back
+      if (buffer.capacity() == 0)
+         return;
+
+      size_t k = class_of(buffer.capacity());
+      thread_cache_t* cache = local();
+
+      buffer.clear();
+      buffer.read_ptr = 0;
+
+      if (cache == nullptr)
+      {
+         {
+            std::lock_guard<std::mutex> guard(cacheless_lock);
+            count(cacheless.dropped);
+         }
+
+         buffer_t().swap(buffer);
+         return;
+      }
+
+      if (k < class_count)
+      {
+         std::vector<buffer_t>& mine = cache->buffers[k];
+
+         if (mine.size() < thread_limit(k))
+         {
+            count(cache->counters.kept);
+            mine.push_back(std::move(buffer));
+
+            return;
+         }
+      }
+
+      release_shared(*cache, buffer, k);
+   }
+
+   void buffer_pool::trim()
+   {
+      if (thread_cache_t* cache = local())
+      {
+         for (auto& mine : cache->buffers)
+            mine.clear();
+      }
+
+      shared_cache_t& cache = shared();
+      std::lock_guard<std::mutex> guard(cache.lock);
+
+      for (auto& free : cache.buffers)
+         std::vector<buffer_t>().swap(free);
+
+      cache.bytes = 0;
+   }
+
+   //! Most bytes the shared cache keeps, default 64 MiB
+   void buffer_pool::set_shared_limit(size_t bytes)
+   {
+      shared_cache_t& cache = shared();
+      std::lock_guard<std::mutex> guard(cache.lock);
+
+      cache.limit = bytes;
+   }
+
+   buffer_pool_stats_t buffer_pool::stats()
+   {
+      shared_cache_t& cache = shared();
+      std::lock_guard<std::mutex> guard(cache.lock);
+
+      buffer_pool_stats_t rval = cache.retired;
+
+      for (thread_cache_t* thread : cache.threads)
+         add(rval, thread->counters);
+
+      {
+         std::lock_guard<std::mutex> cacheless_guard(cacheless_lock);
+         add(rval, cacheless);
+      }
+
+      rval.shared_bytes = cache.bytes;
+
+      return rval;
+   }
+}
@@ -0,0 +1,426 @@
+/*!
+   @file
+   \brief Contains implementations for converting numbers to and from text
+   \author Jari Ronkainen
+
+   Integers are formatted two digits at a time and parsed straight from the
+   string storage.  Doubles go through snprintf()/strtod() on a stack buffer,
+   trying 15, 16 and 17 significant digits until the text reads back as the
+   same value, or fewer for subnormals.  The decimal point is translated to and from the C library's
+   locale, so the text always uses '.'.
+*/
+
+#include <wheel_core_charconv.h>
+
+#include <clocale>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <cstdint>
+
+namespace wheel
+{
+   namespace
+   {
+      const char digit_pairs[] =
+         "00010203040506070809"
+         "10111213141516171819"
+         "20212223242526272829"
+         "30313233343536373839"
+         "40414243444546474849"
+         "50515253545556575859"
+         "60616263646566676869"
+         "70717273747576777879"
+         "80818283848586878889"
+         "90919293949596979899";
+
+      //! Longest double the parser accepts, in characters
+      const size_t max_float_chars = 512;
+
+      //! Write the digits of value to the end of buf, returns the first digit
+      inline char* format_digits(char* end, uint64_t value)
+      {
+         char* pos = end;
+
+         while (value >= 100)
+         {
+            size_t pair = (value % 100) * 2;
+            value /= 100;
+
+            *--pos = digit_pairs[pair + 1];
+            *--pos = digit_pairs[pair];
+         }
+
+         if (value >= 10)
+         {
+            *--pos = digit_pairs[value * 2 + 1];
+            *--pos = digit_pairs[value * 2];
+         } else {
+            *--pos = '0' + value;
+         }
+
+         return pos;
+      }
+
+      number_result format_integer(char* first, char* last, bool negative, uint64_t magnitude)
+      {
+         char digits[24];
+         char* end = digits + sizeof(digits);
+         char* start = format_digits(end, magnitude);
+
+         if (negative)
+            *--start = '-';
+
+         size_t length = end - start;
+
+         if ((size_t)(last - first) < length)
+            return number_result { 0, WHEEL_OUT_OF_RANGE };
+
+         memcpy(first, start, length);
+         return number_result { length, WHEEL_OK };
+      }
+
+      inline uint32_t digit_value(uint32_t c)
+      {
+         if (c >= '0' && c <= '9')
+            return c - '0';
+         else if (c >= 'a' && c <= 'z')
+            return c - 'a' + 10;
+         else if (c >= 'A' && c <= 'Z')
+            return c - 'A' + 10;
+
+         return 99;
+      }
+
+      //! Parse an optionally negative integer no larger than the given limits
+      template <typename C>
+      number_result parse_integer(const C* s, size_t n, int base, bool allow_minus,
+                                  uint64_t max_positive, uint64_t max_negative,
+                                  bool& negative, uint64_t& magnitude)
+      {
+         size_t i = 0;
+
+         negative = false;
+
+         if (allow_minus && i < n && s[i] == '-')
+         {
+            negative = true;
+            ++i;
+         }
+
+         if (base == 0)
+         {
+            if (i + 2 < n && s[i] == '0' && (s[i + 1] == 'x' || s[i + 1] == 'X') && digit_value(s[i + 2]) < 16)
+            {
+               base = 16;
+               i += 2;
+            } else if (i < n && s[i] == '0') {
+               base = 8;
+            } else {
+               base = 10;
+            }
+         }
+
+         if (base < 2 || base > 36)
+            return number_result { 0, WHEEL_INVALID_VALUE };
+
+         const size_t start = i;
+         const uint64_t limit = negative ? max_negative : max_positive;
+
+         uint64_t value = 0;
+         bool overflow = false;
+
+         for (; i < n; ++i)
+         {
+            uint32_t d = digit_value(s[i]);
+
+            if (d >= (uint32_t)base)
+               break;
+
+            if (value > (limit - d) / base)
+               overflow = true;
+            else
+               value = value * base + d;
+         }
+
+         if (i == start)
+            return number_result { 0, WHEEL_INVALID_VALUE };
+
+         if (overflow)
+            return number_result { i, WHEEL_OUT_OF_RANGE };
+
+         magnitude = value;
+         return number_result { i, WHEEL_OK };
+      }
+
+      number_result parse_integer(const string_ref& text, int base, bool allow_minus,
+                                  uint64_t max_positive, uint64_t max_negative,
+                                  bool& negative, uint64_t& magnitude)
+      {
+         const void* chars = text.raw_data();
+
+         if (text.char_width() == 1)
+            return parse_integer((const uint8_t*)chars, text.length(), base, allow_minus, max_positive, max_negative, negative, magnitude);
+         else if (text.char_width() == 2)
+            return parse_integer((const char16_t*)chars, text.length(), base, allow_minus, max_positive, max_negative, negative, magnitude);
+
+         return parse_integer((const char32_t*)chars, text.length(), base, allow_minus, max_positive, max_negative, negative, magnitude);
+      }
+
+      inline uint32_t lower(uint32_t c)
+      {
+         return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+      }
+
+      template <typename C>
+      size_t match_word(const C* s, size_t n, size_t i, const char* word)
+      {
+         size_t length = strlen(word);
+
+         if (n - i < length)
+            return 0;
+
+         for (size_t k = 0; k < length; ++k)
+            if (lower(s[i + k]) != (uint32_t)word[k])
+               return 0;
+
+         return length;
+      }
+
+      template <typename C>
+      size_t scan_digits(const C* s, size_t n, size_t i)
+      {
+         while (i < n && s[i] >= '0' && s[i] <= '9')
+            ++i;
+
+         return i;
+      }
+
+      //! Length of the floating point number at the start of s, 0 if there is none
+      template <typename C>
+      size_t scan_float(const C* s, size_t n)
+      {
+         size_t i = 0;
+
+         if (i < n && s[i] == '-')
+            ++i;
+
+         size_t word = match_word(s, n, i, "infinity");
+
+         if (word == 0)
+            word = match_word(s, n, i, "inf");
+
+         if (word == 0)
+            word = match_word(s, n, i, "nan");
+
+         if (word != 0)
+            return i + word;
+
+         size_t int_end = scan_digits(s, n, i);
+         size_t end = int_end;
+         bool digits = int_end != i;
+
+         if (end < n && s[end] == '.')
+         {
+            size_t frac_end = scan_digits(s, n, end + 1);
+            digits = digits || frac_end != end + 1;
+            end = frac_end;
+         }
+
+         if (!digits)
+            return 0;
+
+         if (end < n && (s[end] == 'e' || s[end] == 'E'))
+         {
+            size_t exp = end + 1;
+
+            if (exp < n && (s[exp] == '+' || s[exp] == '-'))
+               ++exp;
+
+            size_t exp_end = scan_digits(s, n, exp);
+
+            if (exp_end != exp)
+               end = exp_end;
+         }
+
+         return end;
+      }
+
+      template <typename C>
+      number_result parse_float(const C* s, size_t n, double& value)
+      {
+         size_t length = scan_float(s, n);
+
+         if (length == 0)
+            return number_result { 0, WHEEL_INVALID_VALUE };
+
+         if (length >= max_float_chars)
+            return number_result { length, WHEEL_OUT_OF_RANGE };
+
+         const char point = *localeconv()->decimal_point;
+         char buffer[max_float_chars];
+
+         for (size_t i = 0; i < length; ++i)
+            buffer[i] = (s[i] == '.') ? point : (char)s[i];
+
+         buffer[length] = 0;
+
+         errno = 0;
+         double result = strtod(buffer, nullptr);
+
+         // Underflow is fine, the result is the nearest denormal or zero.
+         if (errno == ERANGE && std::isinf(result))
+            return number_result { length, WHEEL_OUT_OF_RANGE };
+
+         value = result;
+         return number_result { length, WHEEL_OK };
+      }
+   }
+
+   number_result to_chars(char* first, char* last, int32_t value)
+   {
+      return to_chars(first, last, (int64_t)value);
+   }
+
+   number_result to_chars(char* first, char* last, int64_t value)
+   {
+      // Negate as unsigned so INT64_MIN works
+      if (value < 0)
+         return format_integer(first, last, true, 0 - (uint64_t)value);
+
+      return format_integer(first, last, false, value);
+   }
+
+   number_result to_chars(char* first, char* last, uint32_t value)
+   {
+      return format_integer(first, last, false, value);
+   }
+
+   number_result to_chars(char* first, char* last, uint64_t value)
+   {
+      return format_integer(first, last, false, value);
+   }
+
+   number_result to_chars(char* first, char* last, double value)
+   {
+      char digits[max_number_chars + 8];
+      int length = 0;
+
+      if (std::isnan(value))
+      {
+         length = snprintf(digits, sizeof(digits), "nan");
+      } else if (std::isinf(value)) {
+         length = snprintf(digits, sizeof(digits), value < 0 ? "-inf" : "inf");
+      } else {
+         const char point = *localeconv()->decimal_point;
+
+         int precision = 15;
+
+         // A normal double holds almost 16 digits, so when fewer digits read
+         // back as the same value, rounding to 15 already gives them.  A
+         // subnormal holds fewer, down to one, and its precision is searched
+         // for; if some precision reads back, every longer one does too.
+         if (std::fpclassify(value) == FP_SUBNORMAL)
+         {
+            int low = 1, high = 17;
+
+            while (low < high)
+            {
+               int middle = (low + high) / 2;
+               snprintf(digits, sizeof(digits), "%.*g", middle, value);
+
+               if (strtod(digits, nullptr) == value)
+                  high = middle;
+               else
+                  low = middle + 1;
+            }
+
+            precision = low;
+         }
+
+         for (; precision <= 17; ++precision)
+         {
+            length = snprintf(digits, sizeof(digits), "%.*g", precision, value);
+
+            if (strtod(digits, nullptr) == value)
+               break;
+         }
+
+         for (int i = 0; i < length; ++i)
+            if (digits[i] == point)
+               digits[i] = '.';
+      }
+
+      if (last - first < length)
+         return number_result { 0, WHEEL_OUT_OF_RANGE };
+
+      memcpy(first, digits, length);
+      return number_result { (size_t)length, WHEEL_OK };
+   }
+
+   number_result from_chars(const string_ref& text, int32_t& value, int base)
+   {
+      bool negative;
+      uint64_t magnitude;
+
+      number_result rval = parse_integer(text, base, true, INT32_MAX, (uint64_t)INT32_MAX + 1, negative, magnitude);
+
+      if (rval.error == WHEEL_OK)
+         value = negative ? (int32_t)(0 - magnitude) : (int32_t)magnitude;
+
+      return rval;
+   }
+
+   number_result from_chars(const string_ref& text, int64_t& value, int base)
+   {
+      bool negative;
+      uint64_t magnitude;
+
+      number_result rval = parse_integer(text, base, true, INT64_MAX, (uint64_t)INT64_MAX + 1, negative, magnitude);
+
+      if (rval.error == WHEEL_OK)
+         value = negative ? (int64_t)(0 - magnitude) : (int64_t)magnitude;
+
+      return rval;
+   }
+
+   number_result from_chars(const string_ref& text, uint32_t& value, int base)
+   {
+      bool negative;
+      uint64_t magnitude;
+
+      number_result rval = parse_integer(text, base, false, UINT32_MAX, 0, negative, magnitude);
+
+      if (rval.error == WHEEL_OK)
+         value = (uint32_t)magnitude;
+
+      return rval;
+   }
+
+   number_result from_chars(const string_ref& text, uint64_t& value, int base)
+   {
+      bool negative;
+      uint64_t magnitude;
+
+      number_result rval = parse_integer(text, base, false, UINT64_MAX, 0, negative, magnitude);
+
+      if (rval.error == WHEEL_OK)
+         value = magnitude;
+
+      return rval;
+   }
+
+   number_result from_chars(const string_ref& text, double& value)
+   {
+      const void* chars = text.raw_data();
+
+      if (text.char_width() == 1)
+         return parse_float((const uint8_t*)chars, text.length(), value);
+      else if (text.char_width() == 2)
+         return parse_float((const char16_t*)chars, text.length(), value);
+
+      return parse_float((const char32_t*)chars, text.length(), value);
+   }
+}
@@ -0,0 +1,419 @@
+/*!
+   @file
+   \brief Contains implementations for CRC32
+   \author Jari Ronkainen
+
+   The CRC is the reflected one of zlib and PNG, polynomial 0xedb88320.
+   update_crc() works on the register as it is, crc32() inverts it before
+   and after.
+
+   Without hardware help the CRC is computed sixteen bytes at a time with
+   sixteen tables, table k giving the CRC of a byte followed by k zero
+   bytes.  The tables are built by the compiler, so there is nothing to
+   initialise at run time and nothing to race on.
+
+   On x86-64 with PCLMULQDQ, blocks of 64 bytes are folded with carry-less
+   multiplication and the result is brought down to 32 bits with a Barrett
+   reduction, as in Intel's "Fast CRC Computation for Generic Polynomials
+   Using PCLMULQDQ Instruction".  On ARMv8 the CRC32 instructions take
+   eight bytes at a time.  Which one is used is decided once, on the first
+   call.
+
+   crc32_combine() multiplies the first CRC by x^(8 * length) modulo the
+   polynomial, with the powers x^(2^n) in a table, as zlib does.
+*/
+
+#include <wheel_core_utility.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+   #define WHEEL_CRC32_USE_PCLMUL
+   #include <immintrin.h>
+#endif
+
+#if defined(__aarch64__) && defined(__GNUC__)
+   #if defined(__ARM_FEATURE_CRC32)
+      #define WHEEL_CRC32_USE_ARMV8
+      #define WHEEL_CRC32_ARMV8_TARGET
+   #elif defined(__linux__)
+      #define WHEEL_CRC32_USE_ARMV8
+      #define WHEEL_CRC32_ARMV8_RUNTIME
+      #define WHEEL_CRC32_ARMV8_TARGET __attribute__((target("+crc")))
+      #include <sys/auxv.h>
+      #include <asm/hwcap.h>
+   #endif
+#endif
+
+#ifdef WHEEL_CRC32_USE_ARMV8
+   #include <arm_acle.h>
+#endif
+
+namespace wheel
+{
+   namespace
+   {
+      const uint32_t crc_polynomial = 0xedb88320;
+
+      struct crc_tables_t
+      {
+         uint32_t table[16][256];
+      };
+
+      constexpr crc_tables_t make_crc_tables()
+      {
+         crc_tables_t rval {};
+
+         for (uint32_t n = 0; n < 256; ++n)
+         {
+            uint32_t c = n;
+
+            for (uint32_t k = 0; k < 8; ++k)
+               c = (c & 1) ? crc_polynomial ^ (c >> 1) : c >> 1;
+
+            rval.table[0][n] = c;
+         }
+
+         // One more zero byte after each of the previous table
+         for (uint32_t k = 1; k < 16; ++k)
+         {
+            for (uint32_t n = 0; n < 256; ++n)
+            {
+               uint32_t c = rval.table[k - 1][n];
+               rval.table[k][n] = rval.table[0][c & 0xff] ^ (c >> 8);
+            }
+         }
+
+         return rval;
+      }
+
+      constexpr crc_tables_t crc_tables = make_crc_tables();
+
+      inline uint32_t crc_bytewise(uint32_t c, const uint8_t* buf, size_t len)
+      {
+         const uint32_t (&t)[256] = crc_tables.table[0];
+
+         while (len--)
+            c = t[(c ^ *buf++) & 0xff] ^ (c >> 8);
+
+         return c;
+      }
+
+      uint32_t crc_slice8(uint32_t c, const uint8_t* buf, size_t len)
+      {
+         const uint32_t (&t)[16][256] = crc_tables.table;
+
+         for (; len >= 8; len -= 8, buf += 8)
+         {
+            uint32_t a = load_le<uint32_t>(buf) ^ c;
+            uint32_t b = load_le<uint32_t>(buf + 4);
+
+            c = t[7][a & 0xff] ^ t[6][(a >> 8) & 0xff] ^ t[5][(a >> 16) & 0xff] ^ t[4][a >> 24]
+              ^ t[3][b & 0xff] ^ t[2][(b >> 8) & 0xff] ^ t[1][(b >> 16) & 0xff] ^ t[0][b >> 24];
+         }
+
+         return crc_bytewise(c, buf, len);
+      }
+
+      uint32_t crc_slice16(uint32_t c, const uint8_t* buf, size_t len)
+      {
+         const uint32_t (&t)[16][256] = crc_tables.table;
+
+         for (; len >= 16; len -= 16, buf += 16)
+         {
+            uint32_t a = load_le<uint32_t>(buf) ^ c;
+            uint32_t b = load_le<uint32_t>(buf + 4);
+            uint32_t d = load_le<uint32_t>(buf + 8);
+            uint32_t e = load_le<uint32_t>(buf + 12);
+
+            c = t[15][a & 0xff] ^ t[14][(a >> 8) & 0xff] ^ t[13][(a >> 16) & 0xff] ^ t[12][a >> 24]
+              ^ t[11][b & 0xff] ^ t[10][(b >> 8) & 0xff] ^ t[9][(b >> 16) & 0xff]  ^ t[8][b >> 24]
+              ^ t[7][d & 0xff]  ^ t[6][(d >> 8) & 0xff]  ^ t[5][(d >> 16) & 0xff]  ^ t[4][d >> 24]
+              ^ t[3][e & 0xff]  ^ t[2][(e >> 8) & 0xff]  ^ t[1][(e >> 16) & 0xff]  ^ t[0][e >> 24];
+         }
+
+         return crc_bytewise(c, buf, len);
+      }
+
+#ifdef WHEEL_CRC32_USE_PCLMUL
+      //! Folds len bytes, len a multiple of 16 and at least 64
+      __attribute__((target("pclmul,sse4.1")))
+      uint32_t crc_pclmul_blocks(uint32_t crc, const uint8_t* buf, size_t len)
+      {
+         // x^(4*128+32) and x^(4*128-32), x^(128+32) and x^(128-32), x^64 mod P
+         const __m128i k1k2 = _mm_set_epi64x(0x01c6e41596ll, 0x0154442bd4ll);
+         const __m128i k3k4 = _mm_set_epi64x(0x00ccaa009ell, 0x01751997d0ll);
+         const __m128i k5k0 = _mm_set_epi64x(0, 0x0163cd6124ll);
+
+         // P and floor(x^64 / P), reflected
+         const __m128i poly = _mm_set_epi64x(0x01f7011641ll, 0x01db710641ll);
+
+         const __m128i low32 = _mm_setr_epi32(~0, 0, ~0, 0);
+
+         __m128i x1, x2, x3, x4, x5, x6, x7, x8;
+
+         x1 = _mm_loadu_si128((const __m128i*)(buf + 0x00));
+         x2 = _mm_loadu_si128((const __m128i*)(buf + 0x10));
+         x3 = _mm_loadu_si128((const __m128i*)(buf + 0x20));
+         x4 = _mm_loadu_si128((const __m128i*)(buf + 0x30));
+
+         x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(crc));
+
+         buf += 64;
+         len -= 64;
+
+         // Four lanes, each moved 512 bits on and the next block added
+         while (len >= 64)
+         {
+            x5 = _mm_clmulepi64_si128(x1, k1k2, 0x00);
+            x6 = _mm_clmulepi64_si128(x2, k1k2, 0x00);
+            x7 = _mm_clmulepi64_si128(x3, k1k2, 0x00);
+            x8 = _mm_clmulepi64_si128(x4, k1k2, 0x00);
+
+            x1 = _mm_clmulepi64_si128(x1, k1k2, 0x11);
+            x2 = _mm_clmulepi64_si128(x2, k1k2, 0x11);
+            x3 = _mm_clmulepi64_si128(x3, k1k2, 0x11);
+            x4 = _mm_clmulepi64_si128(x4, k1k2, 0x11);
+
+            x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128((const __m128i*)(buf + 0x00)));
+            x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128((const __m128i*)(buf + 0x10)));
+            x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128((const __m128i*)(buf + 0x20)));
+            x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128((const __m128i*)(buf + 0x30)));
+
+            buf += 64;
+            len -= 64;
+         }
+
+         // Lanes into one
+         x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+         x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+         x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+         x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+         x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+         x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+
+         x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+         x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+         x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+         // Blocks of 16 left over
+         while (len >= 16)
+         {
+            x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+            x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+            x1 = _mm_xor_si128(_mm_xor_si128(x1, _mm_loadu_si128((const __m128i*)buf)), x5);
+
+            buf += 16;
+            len -= 16;
+         }
+
+         // 128 bits to 64
+         x2 = _mm_clmulepi64_si128(x1, k3k4, 0x10);
+         x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+
+         x2 = _mm_srli_si128(x1, 4);
+         x1 = _mm_and_si128(x1, low32);
+         x1 = _mm_clmulepi64_si128(x1, k5k0, 0x00);
+         x1 = _mm_xor_si128(x1, x2);
+
+         // Barrett reduction to 32 bits
+         x2 = _mm_and_si128(x1, low32);
+         x2 = _mm_clmulepi64_si128(x2, poly, 0x10);
+         x2 = _mm_and_si128(x2, low32);
+         x2 = _mm_clmulepi64_si128(x2, poly, 0x00);
+         x1 = _mm_xor_si128(x1, x2);
+
+         return _mm_extract_epi32(x1, 1);
+      }
+
+      uint32_t crc_pclmul(uint32_t c, const uint8_t* buf, size_t len)
+      {
+         size_t blocks = len & ~(size_t)15;
+
+         if (blocks >= 64)
+         {
+            c = crc_pclmul_blocks(c, buf, blocks);
+
+            buf += blocks;
+            len -= blocks;
+         }
+
+         return crc_slice16(c, buf, len);
+      }
+
+      bool have_pclmul()
+      {
+         return __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1");
+      }
+#endif
+
+#ifdef WHEEL_CRC32_USE_ARMV8
+      WHEEL_CRC32_ARMV8_TARGET
+      uint32_t crc_armv8(uint32_t c, const uint8_t* buf, size_t len)
+      {
+         for (; len >= 8; len -= 8, buf += 8)
+            c = __crc32d(c, load_le<uint64_t>(buf));
+
+         while (len--)
+            c = __crc32b(c, *buf++);
+
+         return c;
+      }
+
+      bool have_armv8_crc()
+      {
+   #ifdef WHEEL_CRC32_ARMV8_RUNTIME
+         return (getauxval(AT_HWCAP) & HWCAP_CRC32) != 0;
+   #else
+         return true;
+   #endif
+      }
+#endif
+
+      internal::crc32_method_t fastest_method()
+      {
+#ifdef WHEEL_CRC32_USE_PCLMUL
+         if (have_pclmul())
+            return internal::WHEEL_CRC32_PCLMUL;
+#endif
+
+#ifdef WHEEL_CRC32_USE_ARMV8
+         if (have_armv8_crc())
+            return internal::WHEEL_CRC32_ARMV8;
+#endif
+
+         return internal::WHEEL_CRC32_SLICE16;
+      }
+
+      //! a * b modulo the polynomial, both reflected
+      constexpr uint32_t multiply_mod_p(uint32_t a, uint32_t b)
+      {
+         uint32_t m = 1u << 31;
+         uint32_t p = 0;
+
+         while (m != 0)
+         {
+            if (a & m)
+            {
+               p ^= b;
+
+               if ((a & (m - 1)) == 0)
+                  break;
+            }
+
+            m >>= 1;
+            b = (b & 1) ? (b >> 1) ^ crc_polynomial : b >> 1;
+         }
+
+         return p;
+      }
+
+      struct crc_powers_t
+      {
+         uint32_t power[32];      //!< x^(2^n) modulo the polynomial
+      };
+
+      constexpr crc_powers_t make_crc_powers()
+      {
+         crc_powers_t rval {};
+
+         // x^1, reflected
+         uint32_t p = 1u << 30;
+         rval.power[0] = p;
+
+         for (uint32_t n = 1; n < 32; ++n)
+            rval.power[n] = p = multiply_mod_p(p, p);
+
+         return rval;
+      }
+
+      constexpr crc_powers_t crc_powers = make_crc_powers();
+
+      //! x^(n * 2^k) modulo the polynomial
+      uint32_t x_to_the_n(uint64_t n, uint32_t k)
+      {
+         // x^0
+         uint32_t p = 1u << 31;
+
+         while (n)
+         {
+            if (n & 1)
+               p = multiply_mod_p(crc_powers.power[k & 31], p);
+
+            n >>= 1;
+            ++k;
+         }
+
+         return p;
+      }
+   }
+
+   namespace internal
+   {
+      bool crc32_supported(crc32_method_t method)
+      {
+         switch (method)
+         {
+            case WHEEL_CRC32_BYTEWISE:
+            case WHEEL_CRC32_SLICE8:
+            case WHEEL_CRC32_SLICE16:
+               return true;
+
+#ifdef WHEEL_CRC32_USE_PCLMUL
+            case WHEEL_CRC32_PCLMUL:
+               return have_pclmul();
+#endif
+
+#ifdef WHEEL_CRC32_USE_ARMV8
+            case WHEEL_CRC32_ARMV8:
+               return have_armv8_crc();
+#endif
+
+            default:
+               return false;
+         }
+      }
+
+      uint32_t update_crc(crc32_method_t method, uint32_t crc, const uint8_t* buf, size_t len)
+      {
+         switch (method)
+         {
+            case WHEEL_CRC32_BYTEWISE:
+               return crc_bytewise(crc, buf, len);
+
+            case WHEEL_CRC32_SLICE8:
+               return crc_slice8(crc, buf, len);
+
+#ifdef WHEEL_CRC32_USE_PCLMUL
+            case WHEEL_CRC32_PCLMUL:
+               return crc_pclmul(crc, buf, len);
+#endif
+
+#ifdef WHEEL_CRC32_USE_ARMV8
+            case WHEEL_CRC32_ARMV8:
+               return crc_armv8(crc, buf, len);
+#endif
+
+            default:
+               return crc_slice16(crc, buf, len);
+         }
+      }
+   }
+
+   uint32_t update_crc(uint32_t crc, const uint8_t* buf, size_t len)
+   {
+      // Initialised once, even when first called from several threads
+      static const internal::crc32_method_t method = fastest_method();
+
+      return internal::update_crc(method, crc, buf, len);
+   }
+
+   uint32_t crc32(const uint8_t* buf, size_t len)
+   {
+      return update_crc(0xffffffff, buf, len) ^ 0xffffffff;
+   }
+
+   uint32_t crc32_combine(uint32_t crc1, uint32_t crc2, size_t len2)
+   {
+      return multiply_mod_p(x_to_the_n(len2, 3), crc1) ^ crc2;
+   }
+}
@@ -8,6 +8,52 @@
 
 namespace wheel
 {
+   namespace
+   {
+      //! Room for the codes of most events
+      const size_t event_capacity = 32;
+   }
+
+   Event::Event() : data(buffer_pool::acquire(event_capacity))
+   {}
+
+   Event::Event(const Event& other) : data(buffer_pool::acquire(other.data.size()))
+   {
+      data.append(other.data.data(), other.data.size());
+      data.read_ptr = other.data.read_ptr;
+   }
+
+   Event::Event(Event&& other) : data(std::move(other.data))
+   {}
+
+   Event::~Event()
+   {
+      buffer_pool::release(std::move(data));
+   }
+
+   Event& Event::operator=(const Event& other)
+   {
+      if (this != &other)
+      {
+         data.assign(other.data.begin(), other.data.end());
+         data.read_ptr = other.data.read_ptr;
+      }
+
+      return *this;
+   }
+
+   Event& Event::operator=(Event&& other)
+   {
+      if (this != &other)
+      {
+         buffer_pool::release(std::move(data));
+         data.swap(other.data);
+         data.read_ptr = other.data.read_ptr;
+      }
+
+      return *this;
+   }
+
    //! Map an event to a function
    /*!
       Adds an event mapping
@@ -17,22 +63,32 @@ namespace wheel
       \param  func   Function to call in case of specified event.
    */
    void EventMapping::map_event(const wheel::Event& ev, const wheel::string& ident, std::function<void(wheel::Event& e)> func)
+   {
+      map_event(ev, symbol(ident), func);
+   }
+
+   void EventMapping::map_event(const wheel::Event& ev, const wheel::hashed_name& ident, std::function<void(wheel::Event& e)> func)
+   {
+      map_event(ev, symbol(ident), func);
+   }
+
+   void EventMapping::map_event(const wheel::Event& ev, const wheel::symbol& ident, std::function<void(wheel::Event& e)> func)
    {
       buffer_t& evd = (buffer_t&)ev.data;
       evd.seek(0);
       uint8_t ev_type = evd.read<uint8_t>();
 
-      if (ev_type == WHEEL_EVENT_TIMER)
+      // Only events that carry the whole pointer, and size, are tracked
+      if (ev_type == WHEEL_EVENT_TIMER && evd.can_read(sizeof(uint64_t)))
       {
          uint64_t ptr = evd.read<uint64_t>();
          ev_timers.push_back((Timer*)ptr);
       }
-      else if (ev_type == WHEEL_EVENT_VAR_CHANGED)
+      else if (ev_type == WHEEL_EVENT_VAR_CHANGED && evd.can_read(2 * sizeof(uint64_t)))
       {
          var_tracker_t var_tracker;
 
-         uint64_t ptr = evd.read<uint64_t>();
-
+         // Laid out as event_from_ptr() writes them
          var_tracker.ptr = (void*)evd.read<uint64_t>();
          var_tracker.data_size = evd.read<uint64_t>();
 
@@ -55,6 +111,23 @@ namespace wheel
     * \param ident   Name of the event to be removed
     */
    void EventMapping::unmap_event(const wheel::string& ident)
+   {
+      symbol sym;
+
+      // Idents that were never interned cannot have been mapped.
+      if (symbol::find(ident, sym))
+         unmap_event(sym);
+   }
+
+   void EventMapping::unmap_event(const wheel::hashed_name& ident)
+   {
+      symbol sym;
+
+      if (symbol::find(ident, sym))
+         unmap_event(sym);
+   }
+
+   void EventMapping::unmap_event(const wheel::symbol& ident)
    {
       for (auto it = map_data.begin(); it != map_data.end(); ++it)
       {
@@ -89,7 +162,7 @@ namespace wheel
             uint64_t ptr_val = (uint64_t) (*it);
             newevent.data.write<uint64_t>(ptr_val);
 
-            events.push_back(newevent);
+            events.push_back(std::move(newevent));
          }
       }
       for (auto it : erase_list)
@@ -103,12 +176,21 @@ namespace wheel
 
 
       // Trigger events
-      for (wheel::Event e : events)
-         for (auto ev : map_data)
-         {
+      std::vector<std::function<void(wheel::Event&)>> matched;
+
+      for (wheel::Event& e : events)
+      {
+         // Callbacks may map and unmap events, which rehashes map_data, so
+         // the matches are collected before any of them is called
+         matched.clear();
+
+         for (auto& ev : map_data)
             if (match_events(ev.first, e.data))
-               ev.second.func(e);
-         }
+               matched.push_back(ev.second.func);
+
+         for (auto& func : matched)
+            func(e);
+      }
    }
 
    //! Check events for a match
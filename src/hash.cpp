@@ -0,0 +1,473 @@
+/*!
+   @file
+   \brief Contains implementations for the selectable hash functions
+   \author Jari Ronkainen
+
+   wyhash is the final version 4 by Wang Yi, released into the public domain.
+   Keys are read eight or four bytes at a time as little-endian words and
+   mixed with 64x64->128 bit multiplies, folding the high half back into the
+   low half.  Short keys read overlapping words from both ends instead of
+   looping.
+
+   hasher is MurmurHash3 x64 128 by Austin Appleby, also in the public domain,
+   with the block loop split so that partial blocks are carried between
+   update() calls.
+*/
+
+#include <wheel_core_hash.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+
+namespace wheel
+{
+   namespace
+   {
+      const uint64_t wyp[4] = { 0x2d358dccaa6c78a5ull, 0x8bb84b93962eacc9ull,
+                                0x4b33a62ed433d4a3ull, 0x4d5a2da51de1aa47ull };
+
+      //! Full 128-bit product of a and b, low half to a and high half to b
+      inline void wymum(uint64_t& a, uint64_t& b)
+      {
+#ifdef __SIZEOF_INT128__
+         __uint128_t r = (__uint128_t)a * b;
+         a = (uint64_t)r;
+         b = (uint64_t)(r >> 64);
+#else
+         uint64_t ha = a >> 32, hb = b >> 32, la = (uint32_t)a, lb = (uint32_t)b;
+         uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+         uint64_t t = rl + (rm0 << 32);
+         uint64_t c = t < rl;
+         uint64_t lo = t + (rm1 << 32);
+         c += lo < t;
+         uint64_t hi = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+         a = lo;
+         b = hi;
+#endif
+      }
+
+      inline uint64_t wymix(uint64_t a, uint64_t b)
+      {
+         wymum(a, b);
+         return a ^ b;
+      }
+
+      inline uint64_t read64(const uint8_t* p)
+      {
+         uint64_t v;
+         memcpy(&v, p, 8);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+         v = __builtin_bswap64(v);
+#endif
+         return v;
+      }
+
+      inline uint64_t read32(const uint8_t* p)
+      {
+         uint32_t v;
+         memcpy(&v, p, 4);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+         v = __builtin_bswap32(v);
+#endif
+         return v;
+      }
+
+      //! Key stored in memory
+      struct memory_key
+      {
+         const uint8_t* bytes;
+
+         inline uint8_t byte(size_t i) const { return bytes[i]; }
+         inline uint64_t word32(size_t i) const { return read32(bytes + i); }
+         inline uint64_t word64(size_t i) const { return read64(bytes + i); }
+      };
+
+      //! Characters of a view as they would be stored at a narrower width
+      /*!
+         Makes each byte when it is read, so a wide view hashes like the
+         string holding its characters without copying them.
+      */
+      struct narrowed_key
+      {
+         const string_ref& chars;
+         uint8_t           width;
+
+         inline uint8_t byte(size_t i) const
+         {
+            size_t shift = i % width;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+            shift = width - 1 - shift;
+#endif
+            return (uint8_t)(chars[i / width] >> (8 * shift));
+         }
+
+         inline uint64_t word32(size_t i) const
+         {
+            uint64_t v = 0;
+
+            for (size_t k = 0; k < 4; ++k)
+               v |= (uint64_t)byte(i + k) << (8 * k);
+
+            return v;
+         }
+
+         inline uint64_t word64(size_t i) const
+         {
+            return word32(i) | (word32(i + 4) << 32);
+         }
+      };
+
+      //! One to three bytes, the first, middle and last
+      template <typename Key>
+      inline uint64_t read_short(Key key, size_t k)
+      {
+         return ((uint64_t)key.byte(0) << 16) | ((uint64_t)key.byte(k >> 1) << 8) | key.byte(k - 1);
+      }
+
+      template <typename Key>
+      uint64_t wyhash(Key key, size_t length, uint64_t seed)
+      {
+         size_t p = 0;
+         uint64_t a, b;
+
+         seed ^= wymix(seed ^ wyp[0], wyp[1]);
+
+         if (length <= 16)
+         {
+            if (length >= 4)
+            {
+               a = (key.word32(0) << 32) | key.word32((length >> 3) << 2);
+               b = (key.word32(length - 4) << 32) | key.word32(length - 4 - ((length >> 3) << 2));
+            } else if (length > 0) {
+               a = read_short(key, length);
+               b = 0;
+            } else {
+               a = b = 0;
+            }
+         } else {
+            size_t i = length;
+
+            if (i > 48)
+            {
+               uint64_t see1 = seed, see2 = seed;
+
+               do
+               {
+                  seed = wymix(key.word64(p) ^ wyp[1], key.word64(p + 8) ^ seed);
+                  see1 = wymix(key.word64(p + 16) ^ wyp[2], key.word64(p + 24) ^ see1);
+                  see2 = wymix(key.word64(p + 32) ^ wyp[3], key.word64(p + 40) ^ see2);
+                  p += 48;
+                  i -= 48;
+               } while (i > 48);
+
+               seed ^= see1 ^ see2;
+            }
+
+            while (i > 16)
+            {
+               seed = wymix(key.word64(p) ^ wyp[1], key.word64(p + 8) ^ seed);
+               i -= 16;
+               p += 16;
+            }
+
+            a = key.word64(p + i - 16);
+            b = key.word64(p + i - 8);
+         }
+
+         a ^= wyp[1];
+         b ^= seed;
+         wymum(a, b);
+
+         return wymix(a ^ wyp[0] ^ length, b ^ wyp[1]);
+      }
+
+      const uint64_t murmur_c1 = 0x87c37b91114253d5ull;
+      const uint64_t murmur_c2 = 0x4cf5ad432745937full;
+
+      inline uint64_t rotl(uint64_t x, int r)
+      {
+         return (x << r) | (x >> (64 - r));
+      }
+
+      inline uint64_t fmix(uint64_t k)
+      {
+         k ^= k >> 33;
+         k *= 0xff51afd7ed558ccdull;
+         k ^= k >> 33;
+         k *= 0xc4ceb9fe1a85ec53ull;
+         k ^= k >> 33;
+
+         return k;
+      }
+
+      inline uint64_t mix_k1(uint64_t k1)
+      {
+         return rotl(k1 * murmur_c1, 31) * murmur_c2;
+      }
+
+      inline uint64_t mix_k2(uint64_t k2)
+      {
+         return rotl(k2 * murmur_c2, 33) * murmur_c1;
+      }
+
+#ifdef WHEEL_SEEDED_HASH
+      //! Random seed from the system, or from the clock and addresses if there is none
+      uint64_t make_seed()
+      {
+         uint64_t seed = 0;
+
+         FILE* random = fopen("/dev/urandom", "rb");
+
+         if (random != nullptr)
+         {
+            if (fread(&seed, sizeof(seed), 1, random) != 1)
+               seed = 0;
+
+            fclose(random);
+         }
+
+         if (seed == 0)
+         {
+            // Address space randomisation makes the addresses differ between runs
+            uint64_t clock = std::chrono::high_resolution_clock::now().time_since_epoch().count();
+            uintptr_t stack = (uintptr_t)&seed;
+            uintptr_t code = (uintptr_t)&make_seed;
+
+            seed = fmix(clock ^ fmix(stack) ^ fmix(code + clock));
+         }
+
+         // 0 means deterministic hashing
+         return seed != 0 ? seed : 1;
+      }
+#endif
+   }
+
+   uint64_t hash_seed() noexcept
+   {
+#ifdef WHEEL_SEEDED_HASH
+      static const uint64_t seed = make_seed();
+      return seed;
+#else
+      return 0;
+#endif
+   }
+
+   namespace
+   {
+      template <typename Key>
+      size_t fnv1a(Key key, size_t length, uint64_t seed)
+      {
+         if (size_t_x64())
+         {
+            uint64_t hash = 0xCBF29CE484222325 ^ seed;
+
+            for (size_t i = 0; i < length; ++i)
+               hash = (hash ^ key.byte(i)) * 0x100000001B3;
+
+            return (size_t)hash;
+         }
+
+         uint32_t hash = 0x811C9DC5 ^ (uint32_t)seed;
+
+         for (size_t i = 0; i < length; ++i)
+            hash = (hash ^ key.byte(i)) * 0x1000193;
+
+         return hash;
+      }
+   }
+
+   size_t internal::seeded_hash(const void* data, size_t length, uint64_t salt) noexcept
+   {
+      return (size_t)wyhash(memory_key { (const uint8_t*)data }, length, hash_seed() ^ salt);
+   }
+
+   size_t fnv1a_policy::hash_bytes(const void* data, size_t length, uint64_t seed) noexcept
+   {
+      return fnv1a(memory_key { (const uint8_t*)data }, length, seed);
+   }
+
+   size_t fnv1a_policy::hash_chars(const string_ref& s, uint8_t width, uint64_t seed) noexcept
+   {
+      return fnv1a(narrowed_key { s, width }, s.length() * width, seed);
+   }
+
+   size_t wyhash_policy::hash_bytes(const void* data, size_t length, uint64_t seed) noexcept
+   {
+      return (size_t)wyhash(memory_key { (const uint8_t*)data }, length, seed);
+   }
+
+   size_t wyhash_policy::hash_chars(const string_ref& s, uint8_t width, uint64_t seed) noexcept
+   {
+      return (size_t)wyhash(narrowed_key { s, width }, s.length() * width, seed);
+   }
+
+   uint64_t internal::wyhash64(const void* data, size_t length, uint64_t seed) noexcept
+   {
+      return wyhash(memory_key { (const uint8_t*)data }, length, seed);
+   }
+
+   uint64_t internal::wyhash64(const string_ref& s, uint8_t width, uint64_t seed) noexcept
+   {
+      return wyhash(narrowed_key { s, width }, s.length() * width, seed);
+   }
+
+   hasher::hasher(uint64_t seed)
+   {
+      reset(seed);
+   }
+
+   void hasher::reset(uint64_t seed)
+   {
+      h1 = seed;
+      h2 = seed;
+      total = 0;
+      tail_length = 0;
+   }
+
+   //! Mix in count whole 16 byte blocks
+   void hasher::blocks(const uint8_t* data, size_t count)
+   {
+      uint64_t a = h1, b = h2;
+
+      for (size_t i = 0; i < count; ++i, data += 16)
+      {
+         a ^= mix_k1(read64(data));
+         a = rotl(a, 27) + b;
+         a = a * 5 + 0x52dce729;
+
+         b ^= mix_k2(read64(data + 8));
+         b = rotl(b, 31) + a;
+         b = b * 5 + 0x38495ab5;
+      }
+
+      h1 = a;
+      h2 = b;
+   }
+
+   void hasher::update(const void* data, size_t length)
+   {
+      const uint8_t* p = (const uint8_t*)data;
+
+      total += length;
+
+      // Complete a block left over from the previous call
+      if (tail_length != 0)
+      {
+         size_t fill = std::min(length, 16 - tail_length);
+
+         memcpy(tail + tail_length, p, fill);
+         tail_length += fill;
+         p += fill;
+         length -= fill;
+
+         if (tail_length < 16)
+            return;
+
+         blocks(tail, 1);
+         tail_length = 0;
+      }
+
+      blocks(p, length / 16);
+
+      tail_length = length % 16;
+      memcpy(tail, p + length - tail_length, tail_length);
+   }
+
+   void hasher::update(const buffer_t& buffer)
+   {
+      update(buffer.data(), buffer.size());
+   }
+
+   void hasher::update(const string& s)
+   {
+      char local[256];
+      size_t length = s.utf8_length();
+
+      // Short names are encoded on the stack
+      if (length <= sizeof(local))
+      {
+         s.encode_utf8(local);
+         update(local, length);
+
+         return;
+      }
+
+      std::string utf8(length, '\0');
+      s.encode_utf8(&utf8[0]);
+      update(utf8.data(), length);
+   }
+
+   fingerprint_t hasher::finalize() const
+   {
+      uint64_t a = h1, b = h2;
+      uint64_t k1 = 0, k2 = 0;
+
+      // Tail bytes are little-endian, whatever the host
+      for (size_t i = tail_length; i > 8; --i)
+         k2 = (k2 << 8) | tail[i - 1];
+
+      for (size_t i = std::min(tail_length, (size_t)8); i > 0; --i)
+         k1 = (k1 << 8) | tail[i - 1];
+
+      if (tail_length > 8)
+         b ^= mix_k2(k2);
+
+      if (tail_length > 0)
+         a ^= mix_k1(k1);
+
+      a ^= total;
+      b ^= total;
+
+      a += b;
+      b += a;
+
+      a = fmix(a);
+      b = fmix(b);
+
+      a += b;
+      b += a;
+
+      return fingerprint_t { a, b };
+   }
+
+   uint64_t hasher::finalize64() const
+   {
+      return finalize().low;
+   }
+
+   fingerprint_t fingerprint(const void* data, size_t length, uint64_t seed)
+   {
+      hasher h(seed);
+      h.update(data, length);
+
+      return h.finalize();
+   }
+
+   uint8_t internal::narrowest_width(const string_ref& s) noexcept
+   {
+      uint32_t bits = 0;
+
+      if (s.char_width() == 2)
+      {
+         const char16_t* chars = (const char16_t*)s.raw_data();
+
+         for (size_t i = 0; i < s.length(); ++i)
+            bits |= chars[i];
+      } else if (s.char_width() == 4) {
+         const char32_t* chars = (const char32_t*)s.raw_data();
+
+         for (size_t i = 0; i < s.length(); ++i)
+            bits |= chars[i];
+      }
+
+      if (bits < 0x100)
+         return 1;
+      else if (bits < 0x10000)
+         return 2;
+
+      return 4;
+   }
+}
@@ -10,6 +10,9 @@
 #include "../../include/wheel_core_debug.h"
 #include "../../include/wheel_core_string.h"
 #include "../../include/wheel_core_utility.h"
+#include "../../include/wheel_core_buffer_view.h"
+#include "../../include/wheel_core_buffer_chain.h"
+#include "../../include/wheel_core_buffer_pool.h"
 #include "../../include/wheel_core_library.h"
 #include "../../include/wheel_image_decoders.h"
 #include <cstring>
@@ -23,59 +26,146 @@ namespace wheel
    namespace image
    {
       /*!
-         Struct to store PNG chunk data
+         PNG chunk, refers to the file buffer
       */
       struct PNGChunk
       {
-         uint32_t    len;
-         char        type[4];
-         uint8_t*    data;
-         uint32_t    crc;
+         buffer_view type;
+         buffer_view data;
 
-         PNGChunk()
+         bool is(const char* tag) const { return type.equals(tag, 4); }
+      };
+
+      namespace
+      {
+         //! Finds the first chunk of a type
+         const PNGChunk* find_chunk(const std::vector<PNGChunk>& chunks, const char* tag)
          {
-            data = nullptr;
+            for (const PNGChunk& c : chunks)
+               if (c.is(tag))
+                  return &c;
+
+            return nullptr;
          }
-        ~PNGChunk()
+
+         inline uint8_t paeth(int32_t a, int32_t b, int32_t c)
          {
-            if (data != nullptr)
-               free(data);
+            int32_t p  = a + b - c;
+
+            int32_t pa = abs(p - a);
+            int32_t pb = abs(p - b);
+            int32_t pc = abs(p - c);
+
+            if ((pa <= pb) && (pa <= pc))
+               return a;
+            else if (pb <= pc)
+               return b;
+
+            return c;
          }
-      };
+
+         //! Reverses the filter of one scanline
+         /*!
+            \param filter    Filter type of the line
+            \param src       Filtered bytes of the line
+            \param dst       Output for the line
+            \param prev      Previous output line, nullptr on the first line
+            \param stride    Bytes per line
+            \param pixel     Bytes per pixel
+
+            \return <code>false</code> if the filter type is unknown
+         */
+         bool unfilter(uint8_t filter, const uint8_t* src, uint8_t* dst, const uint8_t* prev, size_t stride, size_t pixel)
+         {
+            switch (filter)
+            {
+               case 0:  // None
+                  memcpy(dst, src, stride);
+                  break;
+
+               case 1:  // Left
+                  for (size_t i = 0; i < stride; ++i)
+                     dst[i] = src[i] + (i < pixel ? 0 : dst[i - pixel]);
+                  break;
+
+               case 2:  // Up
+                  for (size_t i = 0; i < stride; ++i)
+                     dst[i] = src[i] + (prev ? prev[i] : 0);
+                  break;
+
+               case 3:  // Average
+                  for (size_t i = 0; i < stride; ++i)
+                  {
+                     uint32_t a = (i < pixel) ? 0 : dst[i - pixel];
+                     uint32_t b = prev ? prev[i] : 0;
+
+                     dst[i] = src[i] + ((a + b) >> 1);
+                  }
+                  break;
+
+               case 4:  // Paeth
+                  for (size_t i = 0; i < stride; ++i)
+                  {
+                     int32_t a = (i < pixel) ? 0 : dst[i - pixel];
+                     int32_t b = prev ? prev[i] : 0;
+                     int32_t c = (prev && i >= pixel) ? prev[i - pixel] : 0;
+
+                     dst[i] = src[i] + paeth(a, b, c);
+                  }
+                  break;
+
+               default:
+                  return false;
+            }
+
+            return true;
+         }
+      }
 
       /*!
-         Use zlib to deflate a buffer to a destination buffer
+         Use zlib to deflate a chain to a destination buffer, a segment at
+         a time
       */
-      size_t z_compress(const void* src, size_t len, buffer_t& destination)
+      size_t z_compress(const buffer_chain& source, buffer_t& destination)
       {
          z_stream stream;
 
          uint8_t temp_buffer[ZLIB_CHUNK];
 
-         buffer_t buffer;
+         buffer_t buffer = buffer_pool::acquire(source.size() / 2);
 
          stream.zalloc = Z_NULL;
          stream.zfree = Z_NULL;
-         stream.next_in = (uint8_t*)src;
-         stream.avail_in = len;
+         stream.opaque = Z_NULL;
+         stream.next_in = Z_NULL;
+         stream.avail_in = 0;
          stream.next_out = temp_buffer;
          stream.avail_out = ZLIB_CHUNK;
 
          deflateInit(&stream, Z_BEST_COMPRESSION);
 
-         while (stream.avail_in != 0)
+         for (const buffer_view& segment : source)
          {
-            if (deflate(&stream, Z_NO_FLUSH) != Z_OK)
-            {
-               log << "zlib error - deflating failed\n";
-               return 0;
-            }
+            stream.next_in = (uint8_t*)segment.data();
+            stream.avail_in = segment.size();
 
-            if (stream.avail_out == 0)
+            while (stream.avail_in != 0)
             {
-               buffer.insert(buffer.end(), temp_buffer, temp_buffer + ZLIB_CHUNK);
-               stream.next_out = temp_buffer;
-               stream.avail_out = ZLIB_CHUNK;
+               if (deflate(&stream, Z_NO_FLUSH) != Z_OK)
+               {
+                  log << "zlib error - deflating failed\n";
+                  deflateEnd(&stream);
+                  buffer_pool::release(std::move(buffer));
+
+                  return 0;
+               }
+
+               if (stream.avail_out == 0)
+               {
+                  buffer.insert(buffer.end(), temp_buffer, temp_buffer + ZLIB_CHUNK);
+                  stream.next_out = temp_buffer;
+                  stream.avail_out = ZLIB_CHUNK;
+               }
             }
          }
 
@@ -95,21 +185,40 @@ namespace wheel
          if (deflate_result != Z_STREAM_END)
          {
             log << "zlib error - deflating failed\n";
+            deflateEnd(&stream);
+            buffer_pool::release(std::move(buffer));
+
             return 0;
          }
 
          buffer.insert(buffer.end(), temp_buffer, temp_buffer + ZLIB_CHUNK - stream.avail_out);
          deflateEnd(&stream);
 
+         // The previous contents of the destination go back to the pool
          destination.swap(buffer);
+         buffer_pool::release(std::move(buffer));
 
          return destination.size();
       }
 
       /*!
-         Use zlib to inflate a buffer to a destination
+         Use zlib to deflate a buffer to a destination buffer
       */
-      size_t z_uncompress(const void* src, size_t len, buffer_t& destination)
+      size_t z_compress(const void* src, size_t len, buffer_t& destination)
+      {
+         buffer_chain source;
+         source.append(buffer_view(src, len));
+
+         return z_compress(source, destination);
+      }
+
+      /*!
+         Use zlib to inflate a chain to a destination, a segment at a time.
+         The output buffer is taken from the pool, reserving the capacity
+         of the destination if that is more, and the old storage of the
+         destination goes back.
+      */
+      size_t z_uncompress(const buffer_chain& source, buffer_t& destination)
       {
          z_stream stream;
 
@@ -117,39 +226,67 @@ namespace wheel
          stream.zfree = Z_NULL;
          stream.opaque = Z_NULL;
 
-         stream.avail_in = stream.total_in = len;
-         stream.next_in = (uint8_t*)src;
-
-         stream.avail_out = ZLIB_CHUNK;
+         stream.next_in = Z_NULL;
+         stream.avail_in = 0;
 
          uint8_t temp_buffer[ZLIB_CHUNK];
-         buffer_t buffer;
+         buffer_t buffer = buffer_pool::acquire(std::max(source.size() * 4, destination.capacity()));
 
          int ret;
 
          if ((ret = inflateInit(&stream)) != Z_OK)
          {
             log << "zlib error - inflating failed\n";
+            buffer_pool::release(std::move(buffer));
+
             return 0;
          }
 
-         while (ret != Z_STREAM_END)
+         for (const buffer_view& segment : source)
          {
-            stream.next_out   = temp_buffer;
-            stream.avail_out  = ZLIB_CHUNK;
+            stream.next_in = (uint8_t*)segment.data();
+            stream.avail_in = segment.size();
+
+            // Until the segment is used up and zlib has given out all it can
+            do
+            {
+               stream.next_out   = temp_buffer;
+               stream.avail_out  = ZLIB_CHUNK;
 
-            ret = inflate(&stream, Z_NO_FLUSH);
+               ret = inflate(&stream, Z_NO_FLUSH);
 
-            buffer.insert(buffer.end(), temp_buffer, temp_buffer + ZLIB_CHUNK - stream.avail_out);
+               buffer.insert(buffer.end(), temp_buffer, temp_buffer + ZLIB_CHUNK - stream.avail_out);
+            }
+            while (ret == Z_OK && (stream.avail_in != 0 || stream.avail_out == 0));
+
+            // Nothing left to give out before the next segment
+            if (ret == Z_BUF_ERROR && stream.avail_in == 0)
+               ret = Z_OK;
+
+            // Ended, or corrupt, keep what was inflated
+            if (ret != Z_OK)
+               break;
          }
 
          (void)inflateEnd(&stream);
 
          destination.swap(buffer);
+         buffer_pool::release(std::move(buffer));
 
          return destination.size();
       }
 
+      /*!
+         Use zlib to inflate a buffer to a destination
+      */
+      size_t z_uncompress(const void* src, size_t len, buffer_t& destination)
+      {
+         buffer_chain source;
+         source.append(buffer_view(src, len));
+
+         return z_uncompress(source, destination);
+      }
+
       /*!
          Use zlib to inflate a buffer to a destination
       */
@@ -165,127 +302,77 @@ namespace wheel
 
       //! Default PNG decoding function
       /*!
-
+         Parses the file in place, chunks are views to the buffer and only
+         the inflated image data is copied.
       */
       uint32_t decode_png(const wheel::string& name, buffer_t& buffer)
       {
          WCL_DEBUG_VERBOSE << "=== Loading PNG (" << name << ")\n";
 
-         std::vector<PNGChunk*> chunks;
- 
-         buffer.seek(8);
+         std::vector<PNGChunk> chunks;
+         byte_cursor in(buffer);
 
-         uint32_t idat_count = 0;
+         if (!in.skip(8))
+            return WHEEL_UNEXPECTED_END_OF_FILE;
 
          WCL_DEBUG_VERBOSE << "+ Reading chunks...\n";
 
-         // Read chunks to buffer.
-         while(buffer.pos() < buffer.size())
-         {
-            PNGChunk* next = new PNGChunk();
-
-            // Read chunk length
-            if (!buffer.can_read(sizeof(next->len)))
-            {
-               delete next;
-               return WHEEL_UNEXPECTED_END_OF_FILE;
-            }
-
-            next->len = buffer.read_le<uint32_t>();
-
-            // Read chunk type
-            if (!buffer.can_read(sizeof(next->type)))
-            {
-               delete next;
-               return WHEEL_UNEXPECTED_END_OF_FILE;
-            }
-
-            strncpy(next->type, (const char*)(&buffer[0] + buffer.pos()), 4);
-            string s(next->type, 4);
-            buffer.seek(buffer.pos() + 4);
-
-            // Read chunk data
-            if (!buffer.can_read(next->len))
-            {
-               delete next;
-               return WHEEL_UNEXPECTED_END_OF_FILE;
-            }
+         // Length and type, then data and CRC, each checked once
+         buffer_view header, crc;
 
-            next->data = (uint8_t*) malloc(next->len);
-            memcpy(next->data, (&buffer[0] + buffer.pos()), next->len);
-            buffer.seek(buffer.pos() + next->len);
+         while (in.take(8, header))
+         {
+            PNGChunk next;
+            next.type = header.subview(4, 4);
 
-            // Read chunk CRC checksum
-            if (!buffer.can_read(sizeof(next->crc)))
-            {
-               delete next;
+            if (!in.take(header.read_be<uint32_t>(0), next.data) || !in.take(4, crc))
                return WHEEL_UNEXPECTED_END_OF_FILE;
-            }
 
-            next->crc = buffer.read_le<uint32_t>();
-
-            // Check CRC
+            // CRC covers the type and the data
             uint32_t crc_check = 0xffffffff;
-            crc_check = update_crc(crc_check, (uint8_t*)next->type, sizeof(uint32_t));
-            crc_check = update_crc(crc_check, next->data, next->len);
+            crc_check = update_crc(crc_check, (uint8_t*)next.type.data(), next.type.size());
+            crc_check = update_crc(crc_check, (uint8_t*)next.data.data(), next.data.size());
             crc_check ^= 0xffffffff;
 
-            if (next->crc == crc_check)
+            string s((const char*)next.type.data(), 4);
+
+            if (crc.read_be<uint32_t>(0) == crc_check)
             {
                WCL_DEBUG_VERBOSE << "-- read chunk: " << s << "\n";
                chunks.push_back(next);
-               if (s == "IEND")
+               if (next.is("IEND"))
                {
                   WCL_DEBUG_VERBOSE << "\n";
                   break;
                }
             } else {
-               WCL_WARNING << "-- png chunk crc mismatch. (" << next->crc << "vs." << crc_check << ")\n";
+               WCL_WARNING << "-- png chunk crc mismatch. (" << crc.read_be<uint32_t>(0) << "vs." << crc_check << ")\n";
             }
          }
 
          WCL_DEBUG_VERBOSE << "+ PNG reading complete, decoding...\n";
 
-         Image* image = new Image;
-
          // Normally PNG should have IHDR as its first chunk (by specification), but we are lenient.
-         size_t   it = 0;
-         bool     found_ihdr = false;
-         for (it = 0; it < chunks.size(); ++it)
-         {
-            string s(chunks[it]->type, 4);
-            if (s == "IHDR")
-            {
-               found_ihdr = true;
-               break;
-            }
-         }
+         const PNGChunk* ihdr = find_chunk(chunks, "IHDR");
 
-         if (!found_ihdr)
+         if (ihdr == nullptr || ihdr->data.size() < 13)
          {
             WCL_ERROR << "-!- no IHDR chunk found, bailing out.\n";
-            for (auto chunk : chunks)
-               free(chunk->data);
-
             return WHEEL_INVALID_FORMAT;
          }
 
          WCL_DEBUG_VERBOSE << "-- parsing IHDR chunk\n";
 
-         image->width      = *(uint32_t*)chunks[it]->data;
-         image->height     = *(uint32_t*)(chunks[it]->data + 4);
-         image->bpp        = *(uint8_t*)(chunks[it]->data + 8);
+         Image* image = new Image;
 
-         uint8_t imgtype   = *(uint8_t*)(chunks[it]->data + 9);
-         uint8_t cmethod   = *(uint8_t*)(chunks[it]->data + 10);
-         uint8_t filter    = *(uint8_t*)(chunks[it]->data + 11);
-         uint8_t interlace = *(uint8_t*)(chunks[it]->data + 12);
+         image->width      = ihdr->data.read_be<uint32_t>(0);
+         image->height     = ihdr->data.read_be<uint32_t>(4);
+         image->bpp        = ihdr->data[8];
 
-         if (!big_endian())
-         {
-            image->width  = endian_swap(image->width);
-            image->height = endian_swap(image->height);
-         }
+         uint8_t imgtype   = ihdr->data[9];
+         uint8_t cmethod   = ihdr->data[10];
+         uint8_t filter    = ihdr->data[11];
+         uint8_t interlace = ihdr->data[12];
 
          WCL_DEBUG_VERBOSE << "++ Image header data\n";
          WCL_DEBUG_VERBOSE << "---- size: " << image->width << "x" << image->height << "x" << (uint32_t)image->bpp << "bpp \n";
@@ -294,10 +381,10 @@ namespace wheel
 
          bool supported_format = true;
 
-         if (image->bpp < 8)
+         if (image->bpp != 8)
          {
             supported_format = false;
-            WCL_DEBUG_VERBOSE << "-!-  bit depths below 8 are not currently supported.\n";
+            WCL_DEBUG_VERBOSE << "-!-  only bit depth of 8 is currently supported.\n";
          }
 
          if (imgtype == 0)
@@ -318,6 +405,7 @@ namespace wheel
             WCL_DEBUG_VERBOSE << "RGBA\n";
          } else {
             image->channels = 0;
+            supported_format = false;
             WCL_DEBUG_VERBOSE << "Unknown\n";
          }
 
@@ -358,8 +446,7 @@ namespace wheel
          if (!supported_format)
          {
             WCL_ERROR << "Unsupported PNG format.\n";
-            for (auto chunk : chunks)
-               free(chunk->data);
+            delete image;
 
             return WHEEL_INVALID_FORMAT;
          }
@@ -369,58 +456,51 @@ namespace wheel
          {
             WCL_DEBUG_VERBOSE << "+ Parsing palette information...\n";
 
-            uint32_t plte = ~0;
-            uint32_t trns = ~0;
+            const PNGChunk* plte = find_chunk(chunks, "PLTE");
+            const PNGChunk* trns = find_chunk(chunks, "tRNS");
 
-            for (it = 0; it < chunks.size(); ++it)
-            {
-               string s(chunks[it]->type, 4);
-               if (s == "PLTE")
-                  plte = it;
-               if (s == "tRNS")              
-                  trns = it;
-            }
-
-            if (plte == ~0)
+            if (plte == nullptr)
             {
                WCL_ERROR << "-- Paletted image with no palette chunk?\n";
-               for (auto chunk : chunks)
-                  free(chunk->data);
+               delete image;
 
                return WHEEL_INVALID_FORMAT;
             }
 
-            if (chunks[plte]->len % 3 != 0)
+            if (plte->data.size() % 3 != 0)
             {
                WCL_ERROR << "-- Invalid PLTE chunk.\n";
-               for (auto chunk : chunks)
-                  free(chunk->data);
+               delete image;
 
                return WHEEL_INVALID_FORMAT;
             }
 
-            size_t entries = chunks[plte]->len / 3;
-            size_t trns_entries = 0;
+            buffer_view palette = plte->data;
+            buffer_view alpha;
 
-            if (trns == ~0)
+            if (trns == nullptr)
             {
                WCL_DEBUG_VERBOSE << "-- no transparency\n";
             } else {
-               trns_entries = chunks[trns]->len;
+               alpha = trns->data;
             }
 
+            size_t entries = palette.size() / 3;
+
             WCL_DEBUG_VERBOSE << "-- palette entries: " << entries << "\n";
 
+            image->palette.reserve(entries);
+
             uint8_t r, g, b, a;
 
             for (size_t i = 0; i < entries; ++i)
             {
-               r = chunks[plte]->data[3 * i];
-               g = chunks[plte]->data[3 * i + 1];
-               b = chunks[plte]->data[3 * i + 2];
+               r = palette[3 * i];
+               g = palette[3 * i + 1];
+               b = palette[3 * i + 2];
 
-               if (i < trns_entries)
-                  a = chunks[trns]->data[i];
+               if (i < alpha.size())
+                  a = alpha[i];
                else
                   a = 0xff;
 
@@ -430,133 +510,79 @@ namespace wheel
             WCL_DEBUG_VERBOSE << "\n";
          }
 
+         // Then IDAT stuff, inflated straight from the file, however many chunks there are
+         buffer_chain compressed;
 
-         WCL_DEBUG_VERBOSE << "+ Concatenating IDAT chunks...\n";
-
-         // Then IDAT stuff...
-         buffer_t concatenated_data, image_data;
-         for (auto c : chunks)
+         for (const PNGChunk& c : chunks)
          {
-            string s(c->type, 4);
+            if (!c.is("IDAT"))
+               continue;
 
-            if (s == "IDAT")
-            {
-               WCL_DEBUG_VERBOSE << "-- Found IDAT chunk, size: " << c->len << "B\n";
-               concatenated_data.insert(concatenated_data.end(), c->data, c->data + c->len);
-            }
+            WCL_DEBUG_VERBOSE << "-- Found IDAT chunk, size: " << c.data.size() << "B\n";
+
+            compressed.append(c.data);
          }
-         WCL_DEBUG_VERBOSE << "-- Total size: " << concatenated_data.size() << " bytes\n\n";
+
+         WCL_DEBUG_VERBOSE << "-- Total size: " << compressed.size() << " bytes in " << compressed.segment_count() << " chunk(s)\n\n";
+
+         const size_t pixel  = image->channels;
+         const size_t stride = pixel * image->width;
+
+         // Deflate expands at most 1032:1, do not trust the header beyond that
+         pooled_buffer image_data(std::min((1 + stride) * image->height, compressed.size() * 1032));
 
          WCL_DEBUG_VERBOSE << "+ Uncompressing...\n";
-         z_uncompress((const void*)&concatenated_data[0], concatenated_data.size(), image_data);
-         WCL_DEBUG_VERBOSE << "-- Uncompressed size: " << image_data.size() << " bytes\n\n";
+         z_uncompress(compressed, *image_data);
+         WCL_DEBUG_VERBOSE << "-- Uncompressed size: " << image_data->size() << " bytes\n\n";
 
-         buffer_t* f_ptr = image->data_ptr();
-         f_ptr->clear();
+         // Checked before sizing the output, the header may claim anything
+         if (image->height != 0 && image_data->size() / image->height < 1 + stride)
+         {
+            WCL_ERROR << "-- image data is shorter than the image\n";
+            delete image;
+
+            return WHEEL_UNEXPECTED_END_OF_FILE;
+         }
 
-         image_data.seek(0);
+         buffer_t* f_ptr = image->data_ptr();
+         f_ptr->resize(stride * image->height);
 
-         uint8_t scanline_filter;
-         size_t col, decoded_bytes = 0;         
+         byte_cursor lines(*image_data);
+         buffer_view line;
 
          WCL_DEBUG_VERBOSE << "+ Decoding...\n";
          for (size_t row = 0; row < image->height; ++row)
          {
-            scanline_filter = image_data.read<uint8_t>();
-            col = 0;
-            while(col < image->width)
+            // Filter type byte and the filtered line
+            if (!lines.take(1 + stride, line))
             {
-               if (image->bpp == 8)
-               {
-                  for (size_t ch = 0; ch < image->channels; ++ch)
-                  {
-                     uint8_t pd = image_data.read<uint8_t>();
-
-                     // These make everything a bit cleaner
-                     int32_t a, b, c;
-
-                     if (col == 0)
-                        a = 0;
-                     else
-                        a = f_ptr->at(f_ptr->size() - 1 * image->channels);
-
-                     if (row == 0)
-                        b = 0;
-                     else
-                        b = f_ptr->at(f_ptr->size() - (image->channels * image->width));
-
-                     if (a == 0 && b == 0)
-                        c = 0;
-                     else
-                     {
-                        if (row == 0)
-                           c = 0;
-                        else if (col == 0)
-                           c = a;
-                        else
-                           c = f_ptr->at(f_ptr->size() - (image->channels * image->width) - 1 * image->channels);
-                     }
-
-                     if (scanline_filter == 0)        // No filter on this line
-                        f_ptr->push_back(pd);
-                     else if (scanline_filter == 1)   // Left
-                     {
-                        f_ptr->push_back(pd + a);
-                     }
-                     else if (scanline_filter == 2)   // Up
-                     {
-                        f_ptr->push_back(pd + b);
-                     }
-                     else if (scanline_filter == 3)   // Average
-                     {
-                        uint32_t result = (a + b) >> 1;
-                        f_ptr->push_back(pd + result);
-                     }
-                     else if (scanline_filter == 4)   // Paeth
-                     {
-                        int32_t p  = a + b - c;
-
-                        int32_t pa = abs(p - a);
-                        int32_t pb = abs(p - b);
-                        int32_t pc = abs(p - c);
-
-                        uint8_t pr;
-
-                        if ((pa <= pb) && (pa <= pc))
-                           pr = a;
-                        else if (pb <= pc)
-                           pr = b;
-                        else
-                           pr = c;
-
-                        f_ptr->push_back(pd + pr);
-                     }
-                     else // undefined
-                     {
-                        WCL_ERROR << (int)scanline_filter << "\n";
-                        assert(0 && "nonconforming PNG file");
-                     }
-                  }
-                  decoded_bytes++;
-                  col++;
-               }
-               else
-               {
-                  assert(0 && "nope!");
-               }
+               WCL_ERROR << "-- image data ends at line " << row << "\n";
+               delete image;
+
+               return WHEEL_UNEXPECTED_END_OF_FILE;
+            }
+
+            uint8_t*       dst  = f_ptr->data() + row * stride;
+            const uint8_t* prev = (row == 0) ? nullptr : dst - stride;
+
+            if (!unfilter(line[0], line.data() + 1, dst, prev, stride, pixel))
+            {
+               WCL_ERROR << "-- unknown scanline filter " << (int)line[0] << "\n";
+               delete image;
+
+               return WHEEL_INVALID_FORMAT;
             }
          }
          WCL_DEBUG_VERBOSE << "-- Decoded " << f_ptr->size() << " bytes of data.\n\n";
 
-         // We're done with the chunks, let them go.
-         for (auto chunk : chunks)
-            free(chunk->data);
-
          WCL_DEBUG << "+ Loaded PNG, file: " << name << ", size:" << image->width << "x" << image->height << ", channels: " << image->channels << "\n";
 
-         Library::AddResource(WHEEL_RESOURCE_IMAGE, name, image);
+         uint32_t rval = Library::AddResource(WHEEL_RESOURCE_IMAGE, name, image);
+
+         if (rval != WHEEL_OK)
+            delete image;
 
-         return WHEEL_OK;
+         return rval;
       }
    }
 }
@@ -8,7 +8,11 @@ namespace wheel
 {
 
    // Resource hash table, static.
-   std::unordered_map<wcl::string, resource_entry_t> Library::resources;
+   flat_map<symbol, resource_entry_t> Library::resources;
+
+   // Resources shipped with the program, static.
+   perfect_index Library::manifest;
+   std::vector<resource_entry_t> Library::manifest_resources;
 
    // Count of library instances
    uint32_t Library::instance_count = 0;
@@ -34,6 +38,41 @@ namespace wheel
          delete r.ptr;
    }
 
+   //! Entry holding the resource of an entry in resources, or nullptr if there is none
+   resource_entry_t* Library::holder_of(resource_entry_t& entry)
+   {
+      if (entry.slot != perfect_index::npos)
+         return manifest_resources[entry.slot].ptr ? &manifest_resources[entry.slot] : nullptr;
+
+      return entry.ptr ? &entry : nullptr;
+   }
+
+   //! Entry of a resource, or nullptr if there is none
+   resource_entry_t* Library::find_entry(const symbol& name)
+   {
+      auto it = resources.find(name);
+
+      if (it == resources.end())
+         return nullptr;
+
+      return holder_of(it->second);
+   }
+
+   //! Entry of a resource, made empty if there is none
+   resource_entry_t& Library::entry_for(const symbol& name)
+   {
+      auto it = resources.find(name);
+
+      // The manifest is searched once per name, later lookups find the slot by the symbol
+      if (it == resources.end())
+         it = resources.insert({name, resource_entry_t { 0, nullptr, manifest.find(name.str()) }}).first;
+
+      if (it->second.slot != perfect_index::npos)
+         return manifest_resources[it->second.slot];
+
+      return it->second;
+   }
+
    //! Add a buffer to resources
    /*!
       Static function to add resources to library.
@@ -44,26 +83,35 @@ namespace wheel
 
       \return  WHEEL_OK on success, otherwise wheel error
    */
-   uint32_t Library::AddBuffer(wheel_resource_t type, const wheel::string& name, const buffer_t& buffer)
+   uint32_t Library::AddBuffer(wheel_resource_t type, const symbol& name, const buffer_t& buffer)
    {
       // Make sure there is an instance of a library
       if (instance_count == 0)
          return WHEEL_UNINITIALISED_RESOURCE;
 
+      resource_entry_t& entry = entry_for(name);
+
       // If there already is a resource with the same name, free it from memory.
-      if (resources.count(name))
-      {
-         if (resources[name].ptr != nullptr)
-            delete resources[name].ptr;
-      }
+      if (entry.ptr != nullptr)
+         delete entry.ptr;
 
       // Then just put new stuff in.
-      resources[name].type = type;
-      resources[name].ptr = new Resource(type, buffer);
+      entry.type = type;
+      entry.ptr = new Resource(type, buffer);
 
       return WHEEL_OK;
    }
 
+   uint32_t Library::AddBuffer(wheel_resource_t type, const wheel::string& name, const buffer_t& buffer)
+   {
+      return AddBuffer(type, symbol(name), buffer);
+   }
+
+   uint32_t Library::AddBuffer(wheel_resource_t type, const hashed_name& name, const buffer_t& buffer)
+   {
+      return AddBuffer(type, symbol(name), buffer);
+   }
+
    //! Add a resource
    /*!
       Static function to add resources to library.
@@ -74,34 +122,74 @@ namespace wheel
 
       \return  WHEEL_OK on success, otherwise wheel error
    */
-   uint32_t Library::AddResource(wheel_resource_t type, const wheel::string& name, Resource* rptr)
+   uint32_t Library::AddResource(wheel_resource_t type, const symbol& name, Resource* rptr)
    {
       // Make sure there is an instance of a library
       if (instance_count == 0)
          return WHEEL_UNINITIALISED_RESOURCE;
 
+      resource_entry_t& entry = entry_for(name);
+
       // If there already is a resource with the same name, free it from memory.
-      if (resources.count(name))
-      {
-         if (resources[name].ptr != nullptr)
-            delete resources[name].ptr;
-      }
+      if (entry.ptr != nullptr)
+         delete entry.ptr;
 
       // Then just put new stuff in.
-      resources[name].type = type;
-      resources[name].ptr = rptr;
+      entry.type = type;
+      entry.ptr = rptr;
 
       return WHEEL_OK;
    }
 
+   uint32_t Library::AddResource(wheel_resource_t type, const wheel::string& name, Resource* rptr)
+   {
+      return AddResource(type, symbol(name), rptr);
+   }
+
+   uint32_t Library::AddResource(wheel_resource_t type, const hashed_name& name, Resource* rptr)
+   {
+      return AddResource(type, symbol(name), rptr);
+   }
+
    // ============================================================================
 
+   Resource* Library::operator[](const symbol& name)
+   {
+      resource_entry_t* entry = find_entry(name);
+
+      return entry ? entry->ptr : nullptr;
+   }
+
    Resource* Library::operator[](const string& name)
    {
-      if (resources.count(name) != 1)
+      // Names in the manifest are found without interning them
+      size_t i = manifest.find(name);
+
+      if (i != perfect_index::npos)
+         return manifest_resources[i].ptr;
+
+      symbol sym;
+
+      // Names that were never interned cannot be in the library.
+      if (!symbol::find(name, sym))
          return nullptr;
 
-      return resources[name].ptr;
+      return (*this)[sym];
+   }
+
+   Resource* Library::operator[](const hashed_name& name)
+   {
+      size_t i = manifest.find(name);
+
+      if (i != perfect_index::npos)
+         return manifest_resources[i].ptr;
+
+      auto it = resources.find(name);
+
+      if (it == resources.end())
+         return nullptr;
+
+      return it->second.ptr;
    }
 
    Library::Library()
@@ -125,8 +213,62 @@ namespace wheel
 
       // If no instances remaining, free resources.
       if (instance_count == 0)
-         for (auto r : resources)
+      {
+         // Entries of resources in the manifest hold nothing themselves
+         for (auto& r : resources)
             unload_resource(r.second);
+
+         for (auto& r : manifest_resources)
+         {
+            unload_resource(r);
+            r.ptr = nullptr;
+         }
+
+         resources.clear();
+      }
+   }
+
+   //! Set the resources shipped with the program
+   /*!
+      Resources named in the manifest are stored and found through its
+      perfect hash, with one probe and without interning the name, other
+      resources through the dynamic table as before.  Resources already in
+      the library are kept.
+   */
+   void Library::SetManifest(const perfect_index& index)
+   {
+      const resource_entry_t empty { 0, nullptr, perfect_index::npos };
+      std::vector<resource_entry_t> entries(index.size(), empty);
+
+      // Every resource has an entry, which now points to the new slot or holds the resource itself
+      for (auto& r : resources)
+      {
+         resource_entry_t resource = r.second;
+
+         if (resource.slot != perfect_index::npos)
+            resource = manifest_resources[resource.slot];
+
+         resource.slot = index.find(r.first.str());
+
+         if (resource.slot != perfect_index::npos)
+         {
+            entries[resource.slot] = resource;
+            r.second = resource_entry_t { 0, nullptr, resource.slot };
+         }
+         else
+         {
+            r.second = resource;
+         }
+      }
+
+      // Slots of resources that are no longer stored or named
+      resources.erase_if([](const std::pair<const symbol, resource_entry_t>& r)
+      {
+         return r.second.ptr == nullptr && r.second.slot == perfect_index::npos;
+      });
+
+      manifest = index;
+      manifest_resources.swap(entries);
    }
 
    //! Set handler for a file format
@@ -156,9 +298,10 @@ namespace wheel
    void Library::debug_listfiles()
    {
       std::cout << "::debug:: listing files in library.\n";
-      for (auto r : resources)
+      for (auto& r : resources)
       {
-         std::cout << r.first << "\n";
+         if (holder_of(r.second) != nullptr)
+            std::cout << r.first << "\n";
       }
    }
 
@@ -166,6 +309,16 @@ namespace wheel
    /*!
    */
    uint32_t Library::Load(const wcl::string& file)
+   {
+      return Load(symbol(file));
+   }
+
+   uint32_t Library::Load(const hashed_name& file)
+   {
+      return Load(symbol(file));
+   }
+
+   uint32_t Library::Load(const symbol& file)
    {
       wheel::buffer_t* file_buffer = (wheel::buffer_t*)wheel::GetBuffer(file);
          if (file_buffer == nullptr)
@@ -177,9 +330,9 @@ namespace wheel
 
       // If there is registered handler for the file type, use it
       if (file_handlers.count(file_type))
-         rval = file_handlers[file_type](file, *file_buffer);
+         rval = file_handlers[file_type](file.str(), *file_buffer);
       else
-         rval = file_handlers[WHEEL_FILE_FORMAT_UNKNOWN](file, *file_buffer);
+         rval = file_handlers[WHEEL_FILE_FORMAT_UNKNOWN](file.str(), *file_buffer);
 
       // We don't want to keep the original buffer.
       wheel::DeleteBuffer(file);
@@ -187,17 +340,68 @@ namespace wheel
       return rval;
    }
 
+   //! Unload a resource named in the manifest
+   uint32_t Library::unload_at(size_t index)
+   {
+      resource_entry_t& entry = manifest_resources[index];
+
+      if (entry.ptr == nullptr)
+         return WHEEL_UNINITIALISED_RESOURCE;
+
+      unload_resource(entry);
+      entry.ptr = nullptr;
+
+      return WHEEL_OK;
+   }
+
    //! Unload a file from resource library
    /*!
    */
+   uint32_t Library::Unload(const symbol& file)
+   {
+      auto it = resources.find(file);
+
+      if (it == resources.end())
+         return WHEEL_UNINITIALISED_RESOURCE;
+
+      if (it->second.slot != perfect_index::npos)
+         return unload_at(it->second.slot);
+
+      unload_resource(it->second);
+      resources.erase(it);
+
+      return WHEEL_OK;
+   }
+
    uint32_t Library::Unload(const wcl::string& file)
    {
-//         static std::unordered_map<wcl::string, resource_entry_t> resources;
-      if (resources.count(file) == 0)
+      size_t i = manifest.find(file);
+
+      if (i != perfect_index::npos)
+         return unload_at(i);
+
+      symbol sym;
+
+      if (!symbol::find(file, sym))
+         return WHEEL_UNINITIALISED_RESOURCE;
+
+      return Unload(sym);
+   }
+
+   uint32_t Library::Unload(const hashed_name& file)
+   {
+      size_t i = manifest.find(file);
+
+      if (i != perfect_index::npos)
+         return unload_at(i);
+
+      auto it = resources.find(file);
+
+      if (it == resources.end())
          return WHEEL_UNINITIALISED_RESOURCE;
 
-      unload_resource(resources[file]);
-      resources.erase(file);
+      unload_resource(it->second);
+      resources.erase(it);
 
       return WHEEL_OK;
    }
@@ -0,0 +1,188 @@
+/*!
+   @file
+   \brief Contains implementations for memory-mapped file buffers
+   \author Jari Ronkainen
+
+   Files are mapped private and read-only.  The descriptor is closed right
+   after mapping, the mapping keeps the file alive.  On systems without
+   mmap, map() fails and callers read the file into the buffer instead.
+*/
+
+#include "../include/wheel_core_mapped_buffer.h"
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace wheel
+{
+   namespace
+   {
+#ifndef _WIN32
+      int posix_advice(mapping_advice_t advice)
+      {
+         switch (advice)
+         {
+            case WHEEL_ADVICE_SEQUENTIAL: return MADV_SEQUENTIAL;
+            case WHEEL_ADVICE_RANDOM:     return MADV_RANDOM;
+            case WHEEL_ADVICE_WILLNEED:   return MADV_WILLNEED;
+            case WHEEL_ADVICE_DONTNEED:   return MADV_DONTNEED;
+            default:                      return MADV_NORMAL;
+         }
+      }
+#endif
+   }
+
+   //! Fails as at() of buffer_t does, with std::out_of_range or an abort without exceptions
+   void mapped_buffer::out_of_range(size_t where) const
+   {
+      (void)std::vector<uint8_t>().at(where);
+   }
+
+   mapped_buffer::mapped_buffer(mapped_buffer&& other) : ptr(nullptr), len(0), mapped(false), read_ptr(0)
+   {
+      *this = std::move(other);
+   }
+
+   mapped_buffer& mapped_buffer::operator=(mapped_buffer&& other)
+   {
+      if (this == &other)
+         return *this;
+
+      unmap();
+
+      // The pointer of a moved vector stays valid
+      contents.swap(other.contents);
+
+      ptr      = other.ptr;
+      len      = other.len;
+      mapped   = other.mapped;
+      read_ptr = other.read_ptr;
+
+      other.ptr      = nullptr;
+      other.len      = 0;
+      other.mapped   = false;
+      other.read_ptr = 0;
+
+      return *this;
+   }
+
+   void mapped_buffer::unmap()
+   {
+#ifndef _WIN32
+      if (mapped)
+         munmap((void*)ptr, len);
+#endif
+
+      ptr = nullptr;
+      len = 0;
+      mapped = false;
+      read_ptr = 0;
+
+      contents.clear();
+      contents.shrink_to_fit();
+   }
+
+   //! Map a file from the native filesystem
+   /*!
+      \param path      Native path of the file
+      \param advice    Expected access pattern
+
+      \return <code>WHEEL_OK</code> on success, <code>WHEEL_RESOURCE_UNAVAILABLE</code> if the file cannot be mapped.
+   */
+   uint32_t mapped_buffer::map(const char* path, mapping_advice_t advice)
+   {
+      unmap();
+
+#ifndef _WIN32
+      int fd = open(path, O_RDONLY);
+
+      if (fd < 0)
+         return WHEEL_RESOURCE_UNAVAILABLE;
+
+      struct stat info;
+
+      if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode))
+      {
+         close(fd);
+         return WHEEL_RESOURCE_UNAVAILABLE;
+      }
+
+      // Empty files cannot be mapped, but they are valid
+      if (info.st_size == 0)
+      {
+         close(fd);
+         return WHEEL_OK;
+      }
+
+      void* addr = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      close(fd);
+
+      if (addr == MAP_FAILED)
+         return WHEEL_RESOURCE_UNAVAILABLE;
+
+      ptr = (const uint8_t*)addr;
+      len = info.st_size;
+      mapped = true;
+
+      advise(advice);
+
+      return WHEEL_OK;
+#else
+      (void)path;
+      (void)advice;
+
+      return WHEEL_RESOURCE_UNAVAILABLE;
+#endif
+   }
+
+   //! Take contents that were read instead of mapped
+   void mapped_buffer::assign(buffer_t&& data)
+   {
+      unmap();
+
+      contents.swap(data);
+
+      ptr = contents.data();
+      len = contents.size();
+   }
+
+   void mapped_buffer::clear()
+   {
+      unmap();
+   }
+
+   //! Tell the system how a range of the file will be accessed
+   /*!
+      Only a hint, it does nothing for contents that were read instead of
+      mapped.
+
+      \return <code>WHEEL_OK</code>, or <code>WHEEL_INVALID_VALUE</code> if the system rejects the hint.
+   */
+   uint32_t mapped_buffer::advise(mapping_advice_t advice, size_t offset, size_t length) const
+   {
+#ifndef _WIN32
+      if (!mapped || offset >= len)
+         return WHEEL_OK;
+
+      if (length > len - offset)
+         length = len - offset;
+
+      // madvise wants a page aligned start
+      size_t page = (size_t)sysconf(_SC_PAGESIZE);
+      size_t start = offset - offset % page;
+
+      if (madvise((void*)(ptr + start), length + (offset - start), posix_advice(advice)) != 0)
+         return WHEEL_INVALID_VALUE;
+#else
+      (void)advice;
+      (void)offset;
+      (void)length;
+#endif
+
+      return WHEEL_OK;
+   }
+}
@@ -6,8 +6,10 @@
 
 #include <wheel_core_module.h>
 #include <wheel_core_debug.h>
+#include <wheel_core_search.h>
 
 #include <iostream>
+#include <algorithm>
 #include <cassert>
 // FIXME: dirent is UNIX-specific, windows uses something different.
 //        This should work with MingW32 though.
@@ -22,7 +24,7 @@ namespace wheel
       {
          module_handle_t library = nullptr;
 
-         library = dlopen(filename.std_str().c_str(), RTLD_NOW | RTLD_LOCAL);
+         library = dlopen(utf8_cstr(filename), RTLD_NOW | RTLD_LOCAL);
 
          if (!library)
          {
@@ -75,7 +77,7 @@ namespace wheel
    }
    ModuleLibrary::~ModuleLibrary()
    {
-      for (auto lib : modules)
+      for (auto& lib : modules)
       {
          module_handle_t lib_ptr = lib.second->library_handle;
 
@@ -99,7 +101,7 @@ namespace wheel
    uint32_t ModuleLibrary::Add(const string& filename)
    {
       module_handle_t library = nullptr;
-      library = dlopen(filename.std_str().c_str(), RTLD_NOW | RTLD_LOCAL);
+      library = dlopen(utf8_cstr(filename), RTLD_NOW | RTLD_LOCAL);
 
       if (!library)
       {
@@ -127,13 +129,14 @@ namespace wheel
       modinfo_t info;
       module->get_module_info(&info);
 
-      std::vector<string> moddeps, modprovs;     
-      moddeps = info.depends.split(",");
-      modprovs = info.provides.split(",");
+      // Views into info, nothing is copied until the checks are done.
+      std::vector<string_ref> moddeps, modprovs;
+      moddeps = string_ref(info.depends).split(U",");
+      modprovs = string_ref(info.provides).split(U",");
 
       // Check if equivalent system already exists.
-      for (string s : modprovs)
-         for (string s2 : provided)
+      for (const string_ref& s : modprovs)
+         for (const string& s2 : provided)
          {
             if (s == s2)
             {
@@ -150,16 +153,12 @@ namespace wheel
          }
 
       // Check for dependencies
-      for (string s : provided)
-         for (auto it = moddeps.begin(); it != moddeps.end(); ++it)
-            if (s == *it)
-            {
-               moddeps.erase(it);
-            }
+      for (const string& s : provided)
+         moddeps.erase(std::remove(moddeps.begin(), moddeps.end(), string_ref(s)), moddeps.end());
 
       if (moddeps.size() > 0)
       {
-         for (string s : moddeps)
+         for (const string_ref& s : moddeps)
             log << "missing deps:" << s << "\n";
 
          typedef Module* (*modptr_r_fun_t)(Module*);
@@ -172,29 +171,35 @@ namespace wheel
          return WHEEL_MISSING_DEPENDENCIES;
       }
 
-      modules.insert({filename, module});
+      modules.insert({symbol(filename), module});
 
       return WHEEL_OK;
    }
-   void ModuleLibrary::Remove(const string& ident)
+   void ModuleLibrary::Remove(const symbol& ident)
    {
-      for (auto it = modules.begin(); it != modules.end(); ++it)
-      {
-         if (it->first != ident)
-            continue;
+      auto it = modules.find(ident);
 
-         module_handle_t lib_ptr = it->second->library_handle;
+      if (it == modules.end())
+         return;
 
-         typedef Module* (*modptr_fun_t)(Module*);
+      module_handle_t lib_ptr = it->second->library_handle;
 
-         modptr_fun_t remove_module = (modptr_fun_t) dlsym(lib_ptr, "remove_module");
+      typedef Module* (*modptr_fun_t)(Module*);
 
-         remove_module(it->second);
-         dlclose(lib_ptr);
+      modptr_fun_t remove_module = (modptr_fun_t) dlsym(lib_ptr, "remove_module");
 
-         modules.erase(it);
-         break;
-      }
+      remove_module(it->second);
+      dlclose(lib_ptr);
+
+      modules.erase(it);
+   }
+
+   void ModuleLibrary::Remove(const string& ident)
+   {
+      symbol sym;
+
+      if (symbol::find(ident, sym))
+         Remove(sym);
    }
 
    uint32_t ModuleLibrary::Search(const string& path)
@@ -203,16 +208,19 @@ namespace wheel
 
       struct dirent* loc;
 
-      if ((dir = opendir(path.std_str().c_str())) == nullptr)
+      if ((dir = opendir(utf8_cstr(path))) == nullptr)
          return WHEEL_INVALID_PATH;
 
+      static const searcher so_ext(U".so");
+      static const searcher dll_ext(U".dll");
+
       while((loc = readdir(dir)))
       {
          string filename(loc->d_name);
          if ((filename == ".") || (filename == ".."))
             continue;
 
-         if ((filename.contains(".so")) || (filename.contains(".dll")))
+         if (so_ext.found_in(filename) || dll_ext.found_in(filename))
          {
             modset_t info;
             if (internal::Module_Check_Load(path + "/" + filename, &info.details))
@@ -263,8 +271,23 @@ namespace wheel
 
       \return  Pointer to the module requested.
    */
+   Module* ModuleLibrary::operator[](const symbol& ident)
+   {
+      auto it = modules.find(ident);
+
+      if (it == modules.end())
+         return nullptr;
+
+      return it->second;
+   }
+
    Module* ModuleLibrary::operator[](const string& ident)
    {
-      return modules[ident];
+      symbol sym;
+
+      if (!symbol::find(ident, sym))
+         return nullptr;
+
+      return (*this)[sym];
    }
 }
\ No newline at end of file
@@ -172,9 +172,11 @@ namespace wheel
 
       uint32_t GLFWRenderer::UseShader(const string& name)
       {
-         if (shaderlist.count(name) == 1)
+         auto it = shaderlist.find(name);
+
+         if (it != shaderlist.end())
          {
-            glUseProgram(shaderlist[name].program);
+            glUseProgram(it->second.program);
             return WHEEL_OK;
          }
 
@@ -3,6 +3,8 @@
 
 #include "../../../include/wheel_core_debug.h"
 #include "../../../include/wheel_core_resource.h"
+#include "../../../include/wheel_core_hash.h"
+#include "../../../include/wheel_core_flat_map.h"
 #include "../../../include/wheel_module_video.h"
 
 #include <glm/glm.hpp>
@@ -51,7 +53,7 @@ namespace wheel
             view_t      screen;
             shadowgl_t  shadow;
 
-            std::unordered_map<string, shader_info_t> shaderlist;
+            flat_map<string, shader_info_t, fast_hash<string>> shaderlist;
 
          public:
             // Module functions
@@ -245,7 +245,7 @@ namespace wheel
             }
 
             if (events != nullptr)
-               events->push_back(newevent);
+               events->push_back(std::move(newevent));
          }
          return WHEEL_OK;
       }
@@ -407,9 +407,11 @@ namespace wheel
 
       uint32_t SDLRenderer::UseShader(const string& name)
       {
-         if (shaderlist.count(name) == 1)
+         auto it = shaderlist.find(name);
+
+         if (it != shaderlist.end())
          {
-            glUseProgram(shaderlist[name]);
+            glUseProgram(it->second);
             return WHEEL_OK;
          }
 
@@ -8,6 +8,8 @@
 
 #include "../../../include/wheel_core_debug.h"
 #include "../../../include/wheel_core_resource.h"
+#include "../../../include/wheel_core_hash.h"
+#include "../../../include/wheel_core_flat_map.h"
 #include "../../../include/wheel_module_video.h"
 //#include "../../../include/wheel_math_geometry.hpp"
 #include <glm/glm.hpp>
@@ -72,7 +74,7 @@ namespace wheel
 
             shadowgl_t  shadow;
 
-            std::unordered_map<string, int32_t> shaderlist;
+            flat_map<string, int32_t, fast_hash<string>> shaderlist;
 
          public:
             // Module functions
@@ -0,0 +1,453 @@
+/*!
+   @file
+   \brief Contains implementations for the minimal perfect hash index
+   \author Jari Ronkainen
+
+   The index is built with hash and displace, as in PTHash: every name
+   hashes to one of n/4 buckets, and each bucket gets a pilot value that
+   moves all of its names to free slots.  Buckets are placed largest first,
+   trying pilots 0, 1, 2... until one fits, so most pilots stay small.  A
+   lookup hashes the name once, reads the pilot of its bucket and mixes it
+   in to get the slot.
+
+   Blob layout, little-endian:
+
+      "WPH1", flags (1 byte, bit 0: names wider than Latin-1), 3 zero bytes
+      count, bucket count               (uint32 each)
+      seed                              (uint64)
+      pilots                            (uint32 per bucket)
+      position of the name in each slot (uint32 per slot)
+      name offsets                      (uint32 per name, plus the end)
+      character widths                  (uint8 per name)
+      names, as stored by wheel::string
+*/
+
+#include <wheel_core_perfect_hash.h>
+#include <wheel_core_hash.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace wheel
+{
+   namespace
+   {
+      const size_t header_size = 24;
+      const uint8_t flag_wide = 0x01;
+
+      //! Builds that cannot place every name retry with another seed this many times
+      const uint32_t max_attempts = 16;
+
+      inline uint32_t read_le32(const uint8_t* p)
+      {
+         return load_le<uint32_t>(p);
+      }
+
+      inline uint64_t read_le64(const uint8_t* p)
+      {
+         return load_le<uint64_t>(p);
+      }
+
+      inline void write_le32(buffer_t& out, uint32_t v)
+      {
+         out.write_le(v);
+      }
+
+      inline void write_le64(buffer_t& out, uint64_t v)
+      {
+         out.write_le(v);
+      }
+
+      inline uint64_t mix(uint64_t k)
+      {
+         k ^= k >> 33;
+         k *= 0xff51afd7ed558ccdull;
+         k ^= k >> 33;
+         k *= 0xc4ceb9fe1a85ec53ull;
+         k ^= k >> 33;
+
+         return k;
+      }
+
+      //! Hash of a name stored at its narrowest width
+      inline uint64_t key_hash(const void* data, size_t length, uint8_t width, uint64_t seed)
+      {
+         return internal::wyhash64(data, length * width, seed ^ width);
+      }
+
+      //! Hash of a wider view, as if its characters were stored at width
+      inline uint64_t key_hash(const string_ref& name, uint8_t width, uint64_t seed)
+      {
+         return internal::wyhash64(name, width, seed ^ width);
+      }
+
+      inline uint32_t bucket_of(uint64_t hash, uint32_t bucket_count)
+      {
+         return (uint32_t)(((hash & 0xffffffff) * bucket_count) >> 32);
+      }
+
+      inline uint32_t slot_of(uint64_t hash, uint32_t pilot, uint32_t count)
+      {
+         return (uint32_t)(((mix(hash ^ (pilot * 0x9E3779B97F4A7C15ull)) >> 32) * count) >> 32);
+      }
+
+      //! Try to give every name a slot with the given seed
+      /*!
+         \return <code>WHEEL_OK</code>, <code>WHEEL_INVALID_VALUE</code> on a duplicate name,
+                 or <code>WHEEL_ERROR</code> if the seed does not work.
+      */
+      uint32_t place(const std::vector<string>& names, uint64_t seed, uint32_t bucket_count,
+                     std::vector<uint32_t>& pilots, std::vector<uint32_t>& order)
+      {
+         const uint32_t count = names.size();
+
+         std::vector<uint64_t> hashes(count);
+         std::vector<uint32_t> bucket_size(bucket_count, 0);
+
+         for (uint32_t i = 0; i < count; ++i)
+         {
+            hashes[i] = key_hash(names[i].raw_data(), names[i].length(), names[i].char_width(), seed);
+            ++bucket_size[bucket_of(hashes[i], bucket_count)];
+         }
+
+         // Names grouped by bucket
+         std::vector<uint32_t> first(bucket_count + 1, 0);
+
+         for (uint32_t b = 0; b < bucket_count; ++b)
+            first[b + 1] = first[b] + bucket_size[b];
+
+         std::vector<uint32_t> members(count);
+         std::vector<uint32_t> fill(first.begin(), first.end() - 1);
+
+         for (uint32_t i = 0; i < count; ++i)
+            members[fill[bucket_of(hashes[i], bucket_count)]++] = i;
+
+         // Largest buckets first, while there is the most room
+         std::vector<uint32_t> buckets(bucket_count);
+
+         for (uint32_t b = 0; b < bucket_count; ++b)
+            buckets[b] = b;
+
+         std::stable_sort(buckets.begin(), buckets.end(), [&](uint32_t l, uint32_t r) { return bucket_size[l] > bucket_size[r]; });
+
+         std::vector<uint8_t> taken(count, 0);
+         std::vector<uint32_t> slots;
+
+         const uint64_t max_pilot = 64 * (uint64_t)count + 1024;
+
+         pilots.assign(bucket_count, 0);
+         order.assign(count, 0);
+
+         for (uint32_t b : buckets)
+         {
+            if (bucket_size[b] == 0)
+               break;
+
+            const uint32_t* member = &members[first[b]];
+            const uint32_t size = bucket_size[b];
+
+            // Names with equal hashes cannot be told apart by any pilot
+            for (uint32_t i = 0; i < size; ++i)
+               for (uint32_t j = i + 1; j < size; ++j)
+                  if (hashes[member[i]] == hashes[member[j]])
+                     return (names[member[i]] == names[member[j]]) ? WHEEL_INVALID_VALUE : WHEEL_ERROR;
+
+            bool placed = false;
+
+            for (uint64_t pilot = 0; pilot < max_pilot && !placed; ++pilot)
+            {
+               slots.clear();
+               placed = true;
+
+               for (uint32_t i = 0; i < size && placed; ++i)
+               {
+                  uint32_t slot = slot_of(hashes[member[i]], (uint32_t)pilot, count);
+
+                  if (taken[slot] || std::find(slots.begin(), slots.end(), slot) != slots.end())
+                     placed = false;
+                  else
+                     slots.push_back(slot);
+               }
+
+               if (placed)
+               {
+                  pilots[b] = (uint32_t)pilot;
+
+                  for (uint32_t i = 0; i < size; ++i)
+                  {
+                     taken[slots[i]] = 1;
+                     order[slots[i]] = member[i];
+                  }
+               }
+            }
+
+            if (!placed)
+               return WHEEL_ERROR;
+         }
+
+         return WHEEL_OK;
+      }
+   }
+
+   perfect_index::perfect_index()
+   {
+      clear();
+   }
+
+   perfect_index::perfect_index(const perfect_index& other)
+   {
+      clear();
+      *this = other;
+   }
+
+   perfect_index& perfect_index::operator=(const perfect_index& other)
+   {
+      if (this == &other)
+         return *this;
+
+      if (other.blob == nullptr)
+      {
+         clear();
+      } else if (other.owned.empty()) {
+         assign(other.blob, other.blob_size);
+      } else {
+         owned = other.owned;
+         parse(owned.data(), owned.size());
+      }
+
+      return *this;
+   }
+
+   void perfect_index::clear()
+   {
+      owned.clear();
+
+      blob = nullptr;
+      blob_size = 0;
+
+      count = 0;
+      bucket_count = 0;
+      seed = 0;
+
+      pilots = order = offsets = widths = names = nullptr;
+   }
+
+   uint32_t perfect_index::assign(const void* data, size_t size)
+   {
+      owned.clear();
+      return parse((const uint8_t*)data, size);
+   }
+
+   uint32_t perfect_index::assign(buffer_t&& data)
+   {
+      owned = std::move(data);
+      return parse(owned.data(), owned.size());
+   }
+
+   //! Check a blob and point into it
+   /*!
+      \return <code>WHEEL_OK</code> on success, otherwise <code>WHEEL_INVALID_FORMAT</code>
+              and the index is left empty.
+   */
+   uint32_t perfect_index::parse(const uint8_t* data, size_t size)
+   {
+      const uint8_t* p = data;
+
+      if (p == nullptr || size < header_size || memcmp(p, "WPH1", 4) != 0)
+      {
+         clear();
+         return WHEEL_INVALID_FORMAT;
+      }
+
+      uint32_t n = read_le32(p + 8);
+      uint32_t b = read_le32(p + 12);
+
+      // Wide names are hashed as they are stored in memory
+      bool wrong_order = (p[4] & flag_wide) && big_endian();
+
+      uint64_t tables = header_size + 4 * (uint64_t)b + 4 * (uint64_t)n + 4 * ((uint64_t)n + 1) + n;
+
+      if (wrong_order || (n != 0 && b == 0) || tables > size)
+      {
+         clear();
+         return WHEEL_INVALID_FORMAT;
+      }
+
+      const uint8_t* off = p + header_size + 4 * (size_t)b + 4 * (size_t)n;
+      const uint8_t* wid = off + 4 * ((size_t)n + 1);
+
+      // Names must lie inside the blob, in whole characters
+      if (read_le32(off) != 0 || tables + read_le32(off + 4 * (size_t)n) != size)
+      {
+         clear();
+         return WHEEL_INVALID_FORMAT;
+      }
+
+      for (uint32_t i = 0; i < n; ++i)
+      {
+         uint32_t start = read_le32(off + 4 * (size_t)i);
+         uint32_t end = read_le32(off + 4 * (size_t)i + 4);
+         uint8_t w = wid[i];
+
+         if (end < start || (w != 1 && w != 2 && w != 4) || (end - start) % w != 0)
+         {
+            clear();
+            return WHEEL_INVALID_FORMAT;
+         }
+      }
+
+      const uint8_t* ord = p + header_size + 4 * (size_t)b;
+
+      for (uint32_t i = 0; i < n; ++i)
+      {
+         if (read_le32(ord + 4 * (size_t)i) >= n)
+         {
+            clear();
+            return WHEEL_INVALID_FORMAT;
+         }
+      }
+
+      blob = data;
+      blob_size = size;
+
+      count = n;
+      bucket_count = b;
+      seed = read_le64(p + 16);
+
+      pilots = p + header_size;
+      order = ord;
+      offsets = off;
+      widths = wid;
+      names = wid + n;
+
+      return WHEEL_OK;
+   }
+
+   size_t perfect_index::find(const string_ref& name) const
+   {
+      if (count == 0)
+         return npos;
+
+      // Views of literals may be wider than the stored names, they are
+      // hashed and compared by character instead of copied
+      const uint8_t width = (name.char_width() == 1) ? 1 : internal::narrowest_width(name);
+      const bool narrow = (width == name.char_width());
+      const size_t bytes = name.length() * width;
+
+      uint64_t hash = narrow ? key_hash(name.raw_data(), name.length(), width, seed) : key_hash(name, width, seed);
+      uint32_t pilot = read_le32(pilots + 4 * (size_t)bucket_of(hash, bucket_count));
+      uint32_t index = read_le32(order + 4 * (size_t)slot_of(hash, pilot, count));
+
+      uint32_t start = read_le32(offsets + 4 * (size_t)index);
+      uint32_t end = read_le32(offsets + 4 * (size_t)index + 4);
+
+      if (widths[index] != width || end - start != bytes)
+         return npos;
+
+      if (narrow ? memcmp(names + start, name.raw_data(), bytes) != 0
+                 : string_ref(names + start, width, name.length()) != name)
+         return npos;
+
+      return index;
+   }
+
+   size_t perfect_index::find(const hashed_name& name) const
+   {
+      if (count == 0)
+         return npos;
+
+      string_ref view;
+
+      if (name.view(view))
+         return find(view);
+
+      return find(string_ref(name.str()));
+   }
+
+   string perfect_index::name(size_t index) const
+   {
+      if (index >= count)
+         return string();
+
+      uint32_t start = read_le32(offsets + 4 * index);
+      uint32_t end = read_le32(offsets + 4 * index + 4);
+
+      return string(string_ref(names + start, widths[index], (end - start) / widths[index]));
+   }
+
+   uint32_t build_perfect_index(const std::vector<string>& names, buffer_t& blob)
+   {
+      const uint32_t count = names.size();
+
+      uint64_t name_bytes = 0;
+      uint8_t flags = 0;
+
+      for (const string& s : names)
+      {
+         name_bytes += s.length() * s.char_width();
+
+         if (s.char_width() != 1)
+            flags |= flag_wide;
+      }
+
+      if (names.size() >= 0xffffffff || name_bytes > 0xffffffff)
+         return WHEEL_OUT_OF_RANGE;
+
+      const uint32_t bucket_count = count / 4 + 1;
+
+      std::vector<uint32_t> pilots;
+      std::vector<uint32_t> order;
+
+      uint64_t seed = 0;
+      uint32_t rval = WHEEL_ERROR;
+
+      for (uint32_t attempt = 0; attempt < max_attempts && rval == WHEEL_ERROR; ++attempt)
+      {
+         seed = mix(0x5745454C00000000ull + attempt);
+         rval = place(names, seed, bucket_count, pilots, order);
+      }
+
+      if (rval != WHEEL_OK)
+         return rval;
+
+      blob.clear();
+      blob.reserve(header_size + 4 * (bucket_count + 2 * (size_t)count + 1) + count + name_bytes);
+
+      const char magic[] = "WPH1";
+      blob.insert(blob.end(), magic, magic + 4);
+      blob.push_back(flags);
+      blob.push_back(0);
+      blob.push_back(0);
+      blob.push_back(0);
+
+      write_le32(blob, count);
+      write_le32(blob, bucket_count);
+      write_le64(blob, seed);
+
+      for (uint32_t pilot : pilots)
+         write_le32(blob, pilot);
+
+      for (uint32_t index : order)
+         write_le32(blob, index);
+
+      uint32_t offset = 0;
+      write_le32(blob, offset);
+
+      for (const string& s : names)
+      {
+         offset += s.length() * s.char_width();
+         write_le32(blob, offset);
+      }
+
+      for (const string& s : names)
+         blob.push_back(s.char_width());
+
+      for (const string& s : names)
+      {
+         const uint8_t* bytes = (const uint8_t*)s.raw_data();
+         blob.insert(blob.end(), bytes, bytes + s.length() * s.char_width());
+      }
+
+      return WHEEL_OK;
+   }
+}
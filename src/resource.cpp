@@ -6,15 +6,186 @@
 
 #include <wheel_core_resource.h>
 #include <wheel_core_debug.h>
+#include <wheel_core_flat_map.h>
+#include <wheel_core_perfect_hash.h>
+#include <wheel_core_mapped_buffer.h>
 
 #include <physfs.h>
 
+#include <algorithm>
+#include <string>
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
 namespace wheel
 {
    namespace internal
    {
-      std::unordered_map<string, buffer_t*> file_cache;
+      struct cached_file_t
+      {
+         buffer_t*      data;
+         fingerprint_t  fingerprint;
+         size_t         slot;          //!< Position in the manifest, perfect_index::npos if not named in it
+      };
+
+      //! Every cached file by its symbol, files in the manifest only by their slot
+      flat_map<symbol, cached_file_t> file_cache;
       size_t cache_memory = 0;
+
+      //! Files named in the manifest are cached by their position in it, found without interning
+      perfect_index manifest;
+      std::vector<cached_file_t> manifest_files;
+
+      //! Mapped files, only the contents of files read from archives count in cache_memory
+      flat_map<symbol, mapped_buffer*> mapped_cache;
+   }
+
+   namespace
+   {
+      //! Files are read and fingerprinted this many bytes at a time
+      const size_t read_chunk_size = 256 * 1024;
+
+      //! Read a whole file, fingerprinting each chunk while it is still in cache
+      void read_file(PHYSFS_file* in, buffer_t& data, fingerprint_t& fingerprint)
+      {
+         size_t len = PHYSFS_fileLength(in);
+
+         data.resize(len+1);
+
+         hasher content;
+         uint8_t* ptr = (uint8_t*)data.getptr();
+
+         for (size_t pos = 0; pos < len;)
+         {
+            PHYSFS_sint64 count = PHYSFS_read(in, ptr + pos, 1, std::min(read_chunk_size, len - pos));
+
+            if (count <= 0)
+               break;
+
+            content.update(ptr + pos, count);
+            pos += count;
+         }
+
+         fingerprint = content.finalize();
+      }
+
+      //! Native path of a file in a mounted directory
+      /*!
+         \return <code>false</code> if the file is inside an archive, or the
+                 system cannot map files.
+      */
+      bool native_path(const char* filename, std::string& path)
+      {
+#ifndef _WIN32
+         const char* dir = PHYSFS_getRealDir(filename);
+
+         if (dir == nullptr)
+            return false;
+
+         struct stat info;
+
+         if (stat(dir, &info) != 0 || !S_ISDIR(info.st_mode))
+            return false;
+
+         // Names are relative to the mount point of the directory
+         std::string name = filename;
+         std::string mount = PHYSFS_getMountPoint(dir);
+
+         name.erase(0, name.find_first_not_of('/'));
+         mount.erase(0, mount.find_first_not_of('/'));
+
+         if (name.compare(0, mount.size(), mount) != 0)
+            return false;
+
+         path = dir;
+
+         if (path.empty() || path[path.size() - 1] != '/')
+            path += '/';
+
+         path.append(name, mount.size(), std::string::npos);
+
+         return true;
+#else
+         (void)filename;
+         (void)path;
+
+         return false;
+#endif
+      }
+
+      //! Cache entry of a file named in the manifest, or nullptr if it is not cached
+      internal::cached_file_t* manifest_entry(size_t slot)
+      {
+         return internal::manifest_files[slot].data ? &internal::manifest_files[slot] : nullptr;
+      }
+
+      //! Entry holding the file of a file_cache entry, or nullptr if it is not cached
+      internal::cached_file_t* holder_of(internal::cached_file_t& entry)
+      {
+         if (entry.slot != perfect_index::npos)
+            return manifest_entry(entry.slot);
+
+         return entry.data ? &entry : nullptr;
+      }
+
+      //! Cache entry of a file, or nullptr if it is not cached
+      internal::cached_file_t* find_cached(const symbol& filename)
+      {
+         auto it = internal::file_cache.find(filename);
+
+         if (it == internal::file_cache.end())
+            return nullptr;
+
+         return holder_of(it->second);
+      }
+
+      internal::cached_file_t* find_cached(const hashed_name& filename)
+      {
+         size_t i = internal::manifest.find(filename);
+
+         if (i != perfect_index::npos)
+            return manifest_entry(i);
+
+         auto it = internal::file_cache.find(filename);
+
+         if (it == internal::file_cache.end())
+            return nullptr;
+
+         return holder_of(it->second);
+      }
+
+      //! Names in the manifest are found without interning them
+      internal::cached_file_t* find_cached(const string& filename)
+      {
+         size_t i = internal::manifest.find(filename);
+
+         if (i != perfect_index::npos)
+            return manifest_entry(i);
+
+         symbol sym;
+
+         // A name that was never interned cannot be in the cache.
+         if (!symbol::find(filename, sym))
+            return nullptr;
+
+         return find_cached(sym);
+      }
+
+      size_t mapped_memory(const symbol& filename, const mapped_buffer& buffer)
+      {
+         return filename.length() * filename.str().char_width() + (buffer.is_mapped() ? 0 : buffer.size());
+      }
+
+      //! Free the buffer of a cache entry
+      void uncache(internal::cached_file_t& entry, const string& filename)
+      {
+         internal::cache_memory -= filename.length() * filename.char_width() + entry.data->size();
+
+         delete entry.data;
+         entry.data = nullptr;
+      }
    }
 
    Resource::Resource(wheel_resource_t type, const wheel::buffer_t& buffer) : format(type), data(buffer)
@@ -104,12 +275,20 @@ namespace wheel
 
       \return <code>true</code>If file is buffered, otherwise <code>false</code>
    */
+   bool IsCached(const symbol& filename)
+   {
+      return find_cached(filename) != nullptr;
+   }
+
    bool IsCached(const string& filename)
    {
-      if (internal::file_cache.count(filename) > 0)
-         return true;
+      return find_cached(filename) != nullptr;
+   }
 
-      return false;
+   //! Check a name hashed at compile time, without hashing
+   bool IsCached(const hashed_name& filename)
+   {
+      return find_cached(filename) != nullptr;
    }
 
    /*!
@@ -117,68 +296,129 @@ namespace wheel
 
       \return <code>WHEEL_OK</code> on success, or an error code depicting the error.
    */
-   uint32_t Buffer(const string& filename)
+   uint32_t Buffer(const symbol& filename)
    {
       if (IsCached(filename))
          return WHEEL_OK;
 
-      if (!PHYSFS_exists(filename.std_str().c_str()))
+      if (!PHYSFS_exists(filename.c_str()))
       {
          log << "physfs is unable to find resource: " << filename << "\n";
          ShowSearchPath();
          return WHEEL_RESOURCE_UNAVAILABLE;
       }
 
-      PHYSFS_file* in = PHYSFS_openRead(filename.std_str().c_str());
+      PHYSFS_file* in = PHYSFS_openRead(filename.c_str());
 
       if (in == nullptr)
          return WHEEL_RESOURCE_UNAVAILABLE;
 
-      size_t len = PHYSFS_fileLength(in);
-
-      buffer_t* data = new buffer_t;
-      data->resize(len+1);
+      internal::cached_file_t entry;
 
-      PHYSFS_read(in, (void*)data->getptr(), 1, len);
+      entry.data = new buffer_t;
+      read_file(in, *entry.data, entry.fingerprint);
       PHYSFS_close(in);
 
-      std::pair<string, buffer_t*> pair;
+      // The manifest is searched once per name, later lookups find the slot by the symbol
+      auto it = internal::file_cache.find(filename);
 
-      pair.first = filename;
-      pair.second = data;
+      if (it != internal::file_cache.end())
+         entry.slot = it->second.slot;
+      else
+         entry.slot = internal::manifest.find(filename.str());
 
-      internal::file_cache.insert(pair);
+      if (entry.slot != perfect_index::npos)
+      {
+         internal::manifest_files[entry.slot] = entry;
+         internal::file_cache.insert({filename, internal::cached_file_t { nullptr, fingerprint_t { 0, 0 }, entry.slot }});
+      }
+      else
+      {
+         internal::file_cache.insert({filename, entry});
+      }
 
-      internal::cache_memory += pair.first.length() * sizeof(char32_t) + pair.second->size();
+      internal::cache_memory += filename.length() * filename.str().char_width() + entry.data->size();
 
       return WHEEL_OK;
    }
 
+   uint32_t Buffer(const string& filename)
+   {
+      return Buffer(symbol(filename));
+   }
+
+   uint32_t Buffer(const hashed_name& filename)
+   {
+      return Buffer(symbol(filename));
+   }
+
    /*!
       Deletes all buffers from the cache and frees the memory.
    */
    void EmptyCache()
    {
-      for (auto it : internal::file_cache)
+      // Entries of files in the manifest have no data of their own
+      for (auto& it : internal::file_cache)
+         delete it.second.data;
+
+      for (auto& it : internal::manifest_files)
+      {
+         delete it.data;
+         it.data = nullptr;
+      }
+
+      for (auto& it : internal::mapped_cache)
          delete it.second;
 
+      internal::file_cache.clear();
+      internal::mapped_cache.clear();
       internal::cache_memory = 0;
    }
 
    /*!
       Deletes a buffer from the cache.
    */
-   void DeleteBuffer(const string& filename)
+   void DeleteBuffer(const symbol& filename)
    {
-      if (!IsCached(filename))
+      auto mapping = internal::mapped_cache.find(filename);
+
+      if (mapping != internal::mapped_cache.end())
+      {
+         internal::cache_memory -= mapped_memory(filename, *mapping->second);
+
+         delete mapping->second;
+         internal::mapped_cache.erase(mapping);
+      }
+
+      auto it = internal::file_cache.find(filename);
+
+      if (it == internal::file_cache.end())
          return;
 
-      internal::cache_memory -= filename.length() * sizeof(char32_t) + internal::file_cache[filename]->size();
+      internal::cached_file_t* entry = holder_of(it->second);
+
+      if (entry != nullptr)
+         uncache(*entry, filename.str());
+
+      internal::file_cache.erase(it);
+   }
+
+   // Cached and mapped files were buffered through their symbol, so a name
+   // that was never interned has nothing to delete.
+   void DeleteBuffer(const string& filename)
+   {
+      symbol sym;
 
-      delete internal::file_cache[filename];
-      internal::file_cache.erase(filename);
+      if (symbol::find(filename, sym))
+         DeleteBuffer(sym);
+   }
 
-      return;
+   void DeleteBuffer(const hashed_name& filename)
+   {
+      symbol sym;
+
+      if (symbol::find(filename, sym))
+         DeleteBuffer(sym);
    }
 
    /*!
@@ -186,15 +426,37 @@ namespace wheel
 
       \return  pointer to the cached buffer in buffer_t -format.
    */
+   buffer_t* GetBuffer(const symbol& filename)
+   {
+      internal::cached_file_t* entry = find_cached(filename);
+
+      if (entry != nullptr)
+         return entry->data;
+
+      if (Buffer(filename) != WHEEL_OK)
+         return nullptr;
+
+      return find_cached(filename)->data;
+   }
+
    buffer_t* GetBuffer(const string& filename)
    {
-      if (!IsCached(filename))
-         if (Buffer(filename) != WHEEL_OK)
-         {
-            return nullptr;
-         }
+      internal::cached_file_t* entry = find_cached(filename);
 
-      return internal::file_cache[filename];
+      if (entry != nullptr)
+         return entry->data;
+
+      return GetBuffer(symbol(filename));
+   }
+
+   buffer_t* GetBuffer(const hashed_name& filename)
+   {
+      internal::cached_file_t* entry = find_cached(filename);
+
+      if (entry != nullptr)
+         return entry->data;
+
+      return GetBuffer(symbol(filename));
    }
 
    /*!
@@ -203,28 +465,126 @@ namespace wheel
       \return buffer_t rvalue reference
    */
    buffer_t GetFile(const string& filename)
+   {
+      fingerprint_t fingerprint;
+      return GetFile(filename, fingerprint);
+   }
+
+   /*!
+      Retrieves a buffer without caching it, and fingerprints its contents
+      while reading.  The fingerprint is left untouched if the file cannot
+      be read.
+
+      \return buffer_t rvalue reference
+   */
+   buffer_t GetFile(const string& filename, fingerprint_t& fingerprint)
    {
       buffer_t data;
 
-      if (!PHYSFS_exists(filename.std_str().c_str()))
+      utf8_cstr path(filename);
+
+      if (!PHYSFS_exists(path))
       {
          log << "physfs is unable to find resource: " << filename << "\n";
          return std::move(data);
       }
 
-      PHYSFS_file* in = PHYSFS_openRead(filename.std_str().c_str());
+      PHYSFS_file* in = PHYSFS_openRead(path);
 
       if (in == nullptr)
          return std::move(data);
 
-      size_t len = PHYSFS_fileLength(in);
+      read_file(in, data, fingerprint);
+      PHYSFS_close(in);
+
+      return std::move(data);
+   }
+
+   /*!
+      Maps a file to memory without caching it.  Files in mounted
+      directories are mapped, so only the pages that are used get read.
+      Files inside archives cannot be mapped, they are read instead.
+
+      \param filename  Name of the file
+      \param out       Receives the file
+      \param advice    Expected access pattern of the mapped file
 
-      data.resize(len+1);
+      \return <code>WHEEL_OK</code> on success, <code>WHEEL_RESOURCE_UNAVAILABLE</code> if the file cannot be read.
+   */
+   uint32_t MapFile(const string& filename, mapped_buffer& out, mapping_advice_t advice)
+   {
+      utf8_cstr path(filename);
+
+      if (!PHYSFS_exists(path))
+      {
+         log << "physfs is unable to find resource: " << filename << "\n";
+         return WHEEL_RESOURCE_UNAVAILABLE;
+      }
+
+      std::string native;
+
+      if (native_path(path, native) && out.map(native.c_str(), advice) == WHEEL_OK)
+         return WHEEL_OK;
+
+      PHYSFS_file* in = PHYSFS_openRead(path);
+
+      if (in == nullptr)
+         return WHEEL_RESOURCE_UNAVAILABLE;
 
-      PHYSFS_read(in, (void*)data.getptr(), 1, len);
+      buffer_t data;
+      fingerprint_t fingerprint;
+
+      read_file(in, data, fingerprint);
       PHYSFS_close(in);
 
-      return std::move(data);
+      // Mapped files have no terminating byte, neither do these
+      data.pop_back();
+      out.assign(std::move(data));
+
+      return WHEEL_OK;
+   }
+
+   /*!
+      Retrieves a mapped file from the cache, mapping it on first use.
+      Mapped files are not fingerprinted, as that would read every page.
+      DeleteBuffer() and EmptyCache() release them.
+
+      \return pointer to the mapped file, or nullptr if it cannot be read.
+   */
+   const mapped_buffer* GetMappedBuffer(const symbol& filename)
+   {
+      auto it = internal::mapped_cache.find(filename);
+
+      if (it != internal::mapped_cache.end())
+         return it->second;
+
+      mapped_buffer* mapping = new mapped_buffer;
+
+      if (MapFile(filename.str(), *mapping) != WHEEL_OK)
+      {
+         delete mapping;
+         return nullptr;
+      }
+
+      internal::mapped_cache.insert({filename, mapping});
+      internal::cache_memory += mapped_memory(filename, *mapping);
+
+      return mapping;
+   }
+
+   const mapped_buffer* GetMappedBuffer(const string& filename)
+   {
+      return GetMappedBuffer(symbol(filename));
+   }
+
+   const mapped_buffer* GetMappedBuffer(const hashed_name& filename)
+   {
+      auto it = internal::mapped_cache.find(filename);
+
+      if (it != internal::mapped_cache.end())
+         return it->second;
+
+      return GetMappedBuffer(symbol(filename));
    }
 
    /*!
@@ -234,7 +594,7 @@ namespace wheel
    {
       PHYSFS_File* handle;
 
-      if((handle = PHYSFS_openWrite(file.std_str().c_str())) == NULL)
+      if((handle = PHYSFS_openWrite(utf8_cstr(file))) == NULL)
       {
          std::cout << "res unavail :: " << PHYSFS_getLastError() << "\n";
          return WHEEL_RESOURCE_UNAVAILABLE;
@@ -257,7 +617,7 @@ namespace wheel
    uint32_t AddToPath(const string& path, const string& mountpoint, int sorder)
    {
 //      log << "Adding search path: '" << path << "' to '" << mountpoint << "'\n";
-      if (PHYSFS_mount(path.std_str().c_str(), mountpoint.std_str().c_str(), sorder) == 0)
+      if (PHYSFS_mount(utf8_cstr(path), utf8_cstr(mountpoint), sorder) == 0)
          return WHEEL_RESOURCE_UNAVAILABLE;
 
 //      log << "Added to search path: " << path << "\n";
@@ -268,11 +628,95 @@ namespace wheel
    /*!
       \return Size of a cached buffer
    */
+   size_t BufferSize(const symbol& filename)
+   {
+      internal::cached_file_t* entry = find_cached(filename);
+
+      return entry ? entry->data->size() : 0;
+   }
+
    size_t BufferSize(const string& filename)
    {
-      if (!IsCached(filename))
-         return 0;
+      internal::cached_file_t* entry = find_cached(filename);
+
+      return entry ? entry->data->size() : 0;
+   }
+
+   size_t BufferSize(const hashed_name& filename)
+   {
+      internal::cached_file_t* entry = find_cached(filename);
+
+      return entry ? entry->data->size() : 0;
+   }
+
+   /*!
+      Fingerprint of the contents of a cached buffer, computed when the file
+      was read.  Equal fingerprints mean equal contents, so it can be used to
+      detect changed files or as a key for caching data derived from them.
+
+      \return <code>WHEEL_OK</code> on success, <code>WHEEL_RESOURCE_UNAVAILABLE</code> if the file is not cached.
+   */
+   uint32_t BufferFingerprint(const symbol& filename, fingerprint_t& fingerprint)
+   {
+      internal::cached_file_t* entry = find_cached(filename);
+
+      if (entry == nullptr)
+         return WHEEL_RESOURCE_UNAVAILABLE;
+
+      fingerprint = entry->fingerprint;
+      return WHEEL_OK;
+   }
+
+   uint32_t BufferFingerprint(const string& filename, fingerprint_t& fingerprint)
+   {
+      internal::cached_file_t* entry = find_cached(filename);
+
+      if (entry == nullptr)
+         return WHEEL_RESOURCE_UNAVAILABLE;
+
+      fingerprint = entry->fingerprint;
+      return WHEEL_OK;
+   }
+
+   /*!
+      Sets the names of the files shipped with the program.  Files named in
+      the manifest are cached and found through its perfect hash, with one
+      probe and without interning the name, other files through the dynamic
+      cache as before.  Files already in the cache are kept.
+   */
+   void SetManifest(const perfect_index& manifest)
+   {
+      const internal::cached_file_t empty { nullptr, fingerprint_t { 0, 0 }, perfect_index::npos };
+      std::vector<internal::cached_file_t> files(manifest.size(), empty);
+
+      // Every cached file has an entry, which now points to the new slot or holds the file itself
+      for (auto& entry : internal::file_cache)
+      {
+         internal::cached_file_t file = entry.second;
+
+         if (file.slot != perfect_index::npos)
+            file = internal::manifest_files[file.slot];
+
+         file.slot = manifest.find(entry.first.str());
+
+         if (file.slot != perfect_index::npos)
+         {
+            files[file.slot] = file;
+            entry.second = internal::cached_file_t { nullptr, fingerprint_t { 0, 0 }, file.slot };
+         }
+         else
+         {
+            entry.second = file;
+         }
+      }
+
+      // Slots of files that are no longer cached or named
+      internal::file_cache.erase_if([](const std::pair<const symbol, internal::cached_file_t>& entry)
+      {
+         return entry.second.data == nullptr && entry.second.slot == perfect_index::npos;
+      });
 
-      return internal::file_cache[filename]->size();
+      internal::manifest = manifest;
+      internal::manifest_files.swap(files);
    }
 }
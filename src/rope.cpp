@@ -0,0 +1,247 @@
+/*!
+   @file
+   \brief Contains implementations for ropes
+   \author Jari Ronkainen
+
+   The tree is kept balanced like an AVL tree: the heights of the children of
+   every node differ by at most one.  Concatenation walks down the taller tree
+   along its inner edge until the heights match and rotates on the way back
+   up, which creates O(log n) new nodes.  Substrings are made of two one-sided
+   cuts joined together, also O(log n).
+*/
+
+#include <wheel_core_rope.h>
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+namespace wheel
+{
+   namespace
+   {
+      using internal::rope_node;
+      using internal::rope_ptr;
+
+      //! Pieces shorter than this together are merged into a single leaf
+      const size_t merge_limit = 256;
+
+      inline uint32_t height(const rope_ptr& node)
+      {
+         return node ? node->height : 0;
+      }
+
+      rope_ptr make_leaf(const std::shared_ptr<const string>& text, size_t offset, size_t length)
+      {
+         if (length == 0)
+            return rope_ptr();
+
+         std::shared_ptr<rope_node> node = std::make_shared<rope_node>();
+
+         node->length = length;
+         node->height = 0;
+         node->leaf = text;
+         node->offset = offset;
+
+         return node;
+      }
+
+      rope_ptr make_node(const rope_ptr& left, const rope_ptr& right)
+      {
+         std::shared_ptr<rope_node> node = std::make_shared<rope_node>();
+
+         node->length = left->length + right->length;
+         node->height = std::max(left->height, right->height) + 1;
+         node->offset = 0;
+         node->left = left;
+         node->right = right;
+
+         return node;
+      }
+
+      rope_ptr merge_leaves(const rope_ptr& left, const rope_ptr& right)
+      {
+         std::shared_ptr<string> text = std::make_shared<string>();
+
+         text->reserve(left->length + right->length);
+         text->append(left->piece());
+         text->append(right->piece());
+
+         return make_leaf(text, 0, text->length());
+      }
+
+      //! Concatenate two balanced trees into a balanced tree
+      rope_ptr join(const rope_ptr& left, const rope_ptr& right)
+      {
+         if (!left)
+            return right;
+
+         if (!right)
+            return left;
+
+         if (left->leaf && right->leaf && left->length + right->length <= merge_limit)
+            return merge_leaves(left, right);
+
+         uint32_t hl = left->height;
+         uint32_t hr = right->height;
+
+         if (hl > hr + 1)
+         {
+            rope_ptr joined = join(left->right, right);
+
+            if (joined->height <= left->left->height + 1)
+               return make_node(left->left, joined);
+
+            // joined is two taller than left->left, rotate left
+            if (height(joined->left) <= height(joined->right))
+               return make_node(make_node(left->left, joined->left), joined->right);
+
+            const rope_ptr& inner = joined->left;
+
+            return make_node(make_node(left->left, inner->left), make_node(inner->right, joined->right));
+         }
+
+         if (hr > hl + 1)
+         {
+            rope_ptr joined = join(left, right->left);
+
+            if (joined->height <= right->right->height + 1)
+               return make_node(joined, right->right);
+
+            // joined is two taller than right->right, rotate right
+            if (height(joined->right) <= height(joined->left))
+               return make_node(joined->left, make_node(joined->right, right->right));
+
+            const rope_ptr& inner = joined->right;
+
+            return make_node(make_node(joined->left, inner->left), make_node(inner->right, right->right));
+         }
+
+         // Appending a short piece to a tree that ends with a short piece
+         if (right->leaf && !left->leaf && left->right->leaf
+          && left->right->length + right->length <= merge_limit)
+            return join(left->left, merge_leaves(left->right, right));
+
+         return make_node(left, right);
+      }
+
+      //! Characters [pos, pos + length) of node
+      rope_ptr slice(const rope_ptr& node, size_t pos, size_t length)
+      {
+         if (length == 0)
+            return rope_ptr();
+
+         if (pos == 0 && length == node->length)
+            return node;
+
+         if (node->leaf)
+            return make_leaf(node->leaf, node->offset + pos, length);
+
+         size_t split = node->left->length;
+
+         if (pos + length <= split)
+            return slice(node->left, pos, length);
+
+         if (pos >= split)
+            return slice(node->right, pos - split, length);
+
+         return join(slice(node->left, pos, split - pos), slice(node->right, 0, pos + length - split));
+      }
+   }
+
+   rope::rope(const string& s) : root(make_leaf(std::make_shared<string>(s), 0, s.length()))
+   {
+   }
+
+   rope::rope(string&& s)
+   {
+      size_t length = s.length();
+      root = make_leaf(std::make_shared<string>(std::move(s)), 0, length);
+   }
+
+   rope::rope(const string_ref& s) : root(make_leaf(std::make_shared<string>(s), 0, s.length()))
+   {
+   }
+
+   char32_t rope::operator[](size_t pos) const
+   {
+      assert(pos < length());
+
+      const rope_node* node = root.get();
+
+      while (!node->leaf)
+      {
+         if (pos < node->left->length)
+         {
+            node = node->left.get();
+         } else {
+            pos -= node->left->length;
+            node = node->right.get();
+         }
+      }
+
+      return (*node->leaf)[node->offset + pos];
+   }
+
+   //! Concatenate two ropes
+   /*!
+      Neither rope is modified, the result shares their pieces.
+   */
+   rope rope::operator+(const rope& other) const
+   {
+      return rope(join(root, other.root));
+   }
+
+   rope& rope::operator+=(const rope& other)
+   {
+      root = join(root, other.root);
+      return *this;
+   }
+
+   //! Append a copy of the characters of a view
+   rope& rope::append(const string_ref& s)
+   {
+      return *this += rope(s);
+   }
+
+   /*!
+      \param   pos      Position of the first character
+      \param   length   Number of characters, clamped to the end of the rope
+
+      \return  A rope sharing storage with this one, empty if pos is past the end.
+   */
+   rope rope::substr(size_t pos, size_t length) const
+   {
+      if (pos >= this->length())
+         return rope();
+
+      return rope(slice(root, pos, std::min(length, this->length() - pos)));
+   }
+
+   //! Flatten the rope into a single string
+   /*!
+      Copies every piece once into a new string, which then replaces the tree.
+      Later calls return the same string until the rope is modified.
+
+      \return  Reference to the flattened string, valid until the rope is modified or destroyed.
+   */
+   const string& rope::str() const
+   {
+      static const string empty_string;
+
+      if (!root)
+         return empty_string;
+
+      if (root->leaf && root->offset == 0 && root->length == root->leaf->length())
+         return *root->leaf;
+
+      std::shared_ptr<string> flat = std::make_shared<string>();
+
+      flat->reserve(root->length);
+      for_each_piece([&flat](const string_ref& piece) { flat->append(piece); });
+
+      root = make_leaf(flat, 0, flat->length());
+
+      return *flat;
+   }
+}
@@ -0,0 +1,337 @@
+/*!
+   @file
+   \brief Contains implementations for substring search
+   \author Jari Ronkainen
+
+   Needles of two characters or more are found with Boyer-Moore-Horspool.
+   Shift tables are indexed by the low byte of a character, characters that
+   share a low byte share the smallest shift, which keeps the tables small
+   for every storage width and is still correct.
+
+   When text and needle are stored at the same 1 or 2 byte width and the needle
+   is short, an SSE2 filter compares the first and last characters of the needle
+   against 16 (or 8) positions at a time, and only verifies the positions where
+   both match.
+*/
+
+#include <wheel_core_search.h>
+
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64)
+   #define WHEEL_SEARCH_SSE2
+   #include <emmintrin.h>
+#endif
+
+namespace wheel
+{
+   namespace
+   {
+      const size_t npos = string_ref::npos;
+
+      //! Longest needle the first/last filter is used for, Horspool skips well past this
+      const size_t filter_max = 32;
+
+      template <typename T, typename N>
+      inline bool equal_chars(const T* a, const N* b, size_t n)
+      {
+         for (size_t i = 0; i < n; ++i)
+            if ((uint32_t)a[i] != (uint32_t)b[i])
+               return false;
+
+         return true;
+      }
+
+      template <typename T>
+      inline bool equal_chars(const T* a, const T* b, size_t n)
+      {
+         return memcmp(a, b, n * sizeof(T)) == 0;
+      }
+
+      template <typename T, typename N>
+      size_t horspool(const T* text, size_t n, const N* needle, size_t m, size_t pos, const uint32_t* skip)
+      {
+         const uint32_t last = needle[m - 1];
+
+         for (size_t i = pos; i + m <= n; )
+         {
+            uint32_t c = text[i + m - 1];
+
+            if (c == last && equal_chars(text + i, needle, m - 1))
+               return i;
+
+            i += skip[c & 0xff];
+         }
+
+         return npos;
+      }
+
+      template <typename T, typename N>
+      size_t horspool_reverse(const T* text, size_t n, const N* needle, size_t m, size_t pos, const uint32_t* rskip)
+      {
+         const uint32_t first = needle[0];
+
+         size_t i = std::min(pos, n - m);
+
+         for (;;)
+         {
+            uint32_t c = text[i];
+
+            if (c == first && equal_chars(text + i + 1, needle + 1, m - 1))
+               return i;
+
+            size_t shift = rskip[c & 0xff];
+
+            if (shift > i)
+               return npos;
+
+            i -= shift;
+         }
+      }
+
+      template <typename T>
+      size_t horspool_text(const T* text, size_t n, const string_ref& needle, size_t pos, const uint32_t* skip)
+      {
+         const void* chars = needle.raw_data();
+         const size_t m = needle.length();
+
+         if (needle.char_width() == 1)
+            return horspool(text, n, (const uint8_t*)chars, m, pos, skip);
+         else if (needle.char_width() == 2)
+            return horspool(text, n, (const char16_t*)chars, m, pos, skip);
+
+         return horspool(text, n, (const char32_t*)chars, m, pos, skip);
+      }
+
+      template <typename T>
+      size_t horspool_reverse_text(const T* text, size_t n, const string_ref& needle, size_t pos, const uint32_t* rskip)
+      {
+         const void* chars = needle.raw_data();
+         const size_t m = needle.length();
+
+         if (needle.char_width() == 1)
+            return horspool_reverse(text, n, (const uint8_t*)chars, m, pos, rskip);
+         else if (needle.char_width() == 2)
+            return horspool_reverse(text, n, (const char16_t*)chars, m, pos, rskip);
+
+         return horspool_reverse(text, n, (const char32_t*)chars, m, pos, rskip);
+      }
+
+#ifdef WHEEL_SEARCH_SSE2
+      //! First/last character filter for Latin-1 text, needle at least 2 characters
+      size_t filter_search(const uint8_t* text, size_t n, const uint8_t* needle, size_t m, size_t pos)
+      {
+         const __m128i first = _mm_set1_epi8((char)needle[0]);
+         const __m128i last = _mm_set1_epi8((char)needle[m - 1]);
+
+         size_t i = pos;
+
+         for (; i + m - 1 + 16 <= n; i += 16)
+         {
+            __m128i a = _mm_loadu_si128((const __m128i*)(text + i));
+            __m128i b = _mm_loadu_si128((const __m128i*)(text + i + m - 1));
+
+            uint32_t mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, last)));
+
+            while (mask != 0)
+            {
+               size_t bit = __builtin_ctz(mask);
+
+               if (memcmp(text + i + bit + 1, needle + 1, m - 2) == 0)
+                  return i + bit;
+
+               mask &= mask - 1;
+            }
+         }
+
+         for (; i + m <= n; ++i)
+            if (text[i] == needle[0] && text[i + m - 1] == needle[m - 1] && memcmp(text + i + 1, needle + 1, m - 2) == 0)
+               return i;
+
+         return npos;
+      }
+
+      //! First/last character filter for UCS-2 text, needle at least 2 characters
+      size_t filter_search(const char16_t* text, size_t n, const char16_t* needle, size_t m, size_t pos)
+      {
+         const __m128i first = _mm_set1_epi16((short)needle[0]);
+         const __m128i last = _mm_set1_epi16((short)needle[m - 1]);
+
+         size_t i = pos;
+
+         for (; i + m - 1 + 8 <= n; i += 8)
+         {
+            __m128i a = _mm_loadu_si128((const __m128i*)(text + i));
+            __m128i b = _mm_loadu_si128((const __m128i*)(text + i + m - 1));
+
+            // Two mask bits per character, keep the low one
+            uint32_t mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi16(a, first), _mm_cmpeq_epi16(b, last))) & 0x5555;
+
+            while (mask != 0)
+            {
+               size_t idx = __builtin_ctz(mask) >> 1;
+
+               if (memcmp(text + i + idx + 1, needle + 1, (m - 2) * 2) == 0)
+                  return i + idx;
+
+               mask &= mask - 1;
+            }
+         }
+
+         for (; i + m <= n; ++i)
+            if (text[i] == needle[0] && text[i + m - 1] == needle[m - 1] && memcmp(text + i + 1, needle + 1, (m - 2) * 2) == 0)
+               return i;
+
+         return npos;
+      }
+#endif
+   }
+
+   namespace internal
+   {
+      //! Build the forward Horspool table, shift by the distance of a character from the needle end
+      void build_skip(const string_ref& needle, search_table_t& skip)
+      {
+         const size_t m = needle.length();
+         const uint32_t fill = (uint32_t)std::min<size_t>(m, UINT32_MAX);
+
+         std::fill(skip, skip + 256, fill);
+
+         for (size_t k = 0; k + 1 < m; ++k)
+            skip[needle[k] & 0xff] = (uint32_t)std::min<size_t>(m - 1 - k, UINT32_MAX);
+      }
+
+      //! Build the reverse Horspool table, shift by the distance of a character from the needle start
+      void build_rskip(const string_ref& needle, search_table_t& rskip)
+      {
+         const size_t m = needle.length();
+         const uint32_t fill = (uint32_t)std::min<size_t>(m, UINT32_MAX);
+
+         std::fill(rskip, rskip + 256, fill);
+
+         for (size_t k = m - 1; k >= 1 && k < m; --k)
+            rskip[needle[k] & 0xff] = (uint32_t)std::min<size_t>(k, UINT32_MAX);
+      }
+
+      //! Find the first occurrence of needle in text at or after pos
+      /*!
+         \param   skip  Table from build_skip(), built on the stack when not given
+
+         \return  Position of the match, npos if there is none.
+      */
+      size_t search_forward(const string_ref& text, const string_ref& needle, size_t pos, const search_table_t* skip)
+      {
+         const size_t n = text.length();
+         const size_t m = needle.length();
+
+         if (pos > n)
+            return npos;
+
+         if (m == 0)
+            return pos;
+
+         if (m > n - pos)
+            return npos;
+
+         if (m == 1)
+            return text.find(needle[0], pos);
+
+#ifdef WHEEL_SEARCH_SSE2
+         if (m <= filter_max && text.char_width() == needle.char_width())
+         {
+            if (text.char_width() == 1)
+               return filter_search((const uint8_t*)text.raw_data(), n, (const uint8_t*)needle.raw_data(), m, pos);
+            else if (text.char_width() == 2)
+               return filter_search((const char16_t*)text.raw_data(), n, (const char16_t*)needle.raw_data(), m, pos);
+         }
+#endif
+
+         search_table_t local;
+
+         if (skip == nullptr)
+         {
+            build_skip(needle, local);
+            skip = &local;
+         }
+
+         if (text.char_width() == 1)
+            return horspool_text((const uint8_t*)text.raw_data(), n, needle, pos, *skip);
+         else if (text.char_width() == 2)
+            return horspool_text((const char16_t*)text.raw_data(), n, needle, pos, *skip);
+
+         return horspool_text((const char32_t*)text.raw_data(), n, needle, pos, *skip);
+      }
+
+      //! Find the last occurrence of needle in text starting at or before pos
+      /*!
+         \param   rskip Table from build_rskip(), built on the stack when not given
+
+         \return  Position of the match, npos if there is none.
+      */
+      size_t search_backward(const string_ref& text, const string_ref& needle, size_t pos, const search_table_t* rskip)
+      {
+         const size_t n = text.length();
+         const size_t m = needle.length();
+
+         if (m > n)
+            return npos;
+
+         if (m == 0)
+            return std::min(pos, n);
+
+         if (m == 1)
+            return text.rfind(needle[0], pos);
+
+         search_table_t local;
+
+         if (rskip == nullptr)
+         {
+            build_rskip(needle, local);
+            rskip = &local;
+         }
+
+         if (text.char_width() == 1)
+            return horspool_reverse_text((const uint8_t*)text.raw_data(), n, needle, pos, *rskip);
+         else if (text.char_width() == 2)
+            return horspool_reverse_text((const char16_t*)text.raw_data(), n, needle, pos, *rskip);
+
+         return horspool_reverse_text((const char32_t*)text.raw_data(), n, needle, pos, *rskip);
+      }
+   }
+
+   //! Copy the needle and build its shift tables
+   searcher::searcher(const string_ref& seq) : needle(seq)
+   {
+      internal::build_skip(needle, skip);
+      internal::build_rskip(needle, rskip);
+   }
+
+   size_t searcher::find(const string_ref& text, size_t pos) const
+   {
+      return internal::search_forward(text, needle, pos, &skip);
+   }
+
+   size_t searcher::rfind(const string_ref& text, size_t pos) const
+   {
+      return internal::search_backward(text, needle, pos, &rskip);
+   }
+
+   /*!
+      Matches do not overlap, searching continues after the end of each match.
+      An empty needle matches nothing.
+   */
+   std::vector<size_t> searcher::find_all(const string_ref& text) const
+   {
+      std::vector<size_t> rval;
+
+      if (needle.empty())
+         return rval;
+
+      for (size_t pos = find(text); pos != string_ref::npos; pos = find(text, pos + needle.length()))
+         rval.push_back(pos);
+
+      return rval;
+   }
+}
@@ -1,6 +1,6 @@
 #include "../../include/wheel_core_debug.h"
 #include "../../include/wheel_core_string.h"
-#include "../../include/wheel_core_utility.h"
+#include "../../include/wheel_core_buffer_view.h"
 
 #include "../../include/wheel_sound_wav.h"
 
@@ -10,97 +10,103 @@ namespace wheel
 {
    namespace audio
    {
-      /*!
-         Struct to store WAV/RIFF chunk data
-      */
-      struct WAVChunk
-      {
-         uint32_t    len;
-         char        type[4];
-         uint8_t*    data;
-         uint32_t    crc;
-
-         WAVChunk()
-         {
-            data = nullptr;
-         }
-        ~WAVChunk()
-         {
-            if (data != nullptr)
-               free(data);
-         }
-      };
-
-      WAV::WAV()
+      WAV::WAV() : format_code(0), byte_rate(0), block_align(0), bits_per_sample(0)
       {}
 
       WAV::~WAV()
-      {
-         for (size_t i = 0; i < chunks.size(); ++i)
-            delete chunks[i];
-      }
+      {}
 
       void WAV::DisplayInfo()
       {
          log << "WAV data\n";
-         for (auto chunk : chunks)
+         for (const WAVChunk& chunk : chunks)
          {
-            string s(chunk->type, 4);
-            log << "   WAV Chunk: " << s << std::dec << ", length " << chunk->len << "\n";
+            string s(chunk.type, 4);
+            log << "   WAV Chunk: " << s << std::dec << ", length " << chunk.len << "\n";
 
             if (s == "fmt ")
             {
                log << "      Format:\n";
-               log << "         Compression code: " << *(uint16_t*)chunk->data + 0 << "\n";
-               log << "         Number of channels: " << *(uint16_t*)(chunk->data + 2) << "\n";
-               log << "         Sampling rate: " << *(uint32_t*)(chunk->data + 4) << "\n";
-               log << "         Avg. bytes per second: " << *(uint32_t*)(chunk->data + 8) << "\n";
-               log << "         Block align: " << *(uint16_t*)(chunk->data + 12) << "\n";
-               log << "         Sig. bits per sample: " << *(uint16_t*)(chunk->data + 14) << "\n";
+               log << "         Compression code: " << format_code << "\n";
+               log << "         Number of channels: " << channels << "\n";
+               log << "         Sampling rate: " << freqrate << "\n";
+               log << "         Avg. bytes per second: " << byte_rate << "\n";
+               log << "         Block align: " << block_align << "\n";
+               log << "         Sig. bits per sample: " << bits_per_sample << "\n";
             }
             if (s == "data")
             {
-               log << "      " << chunk->len << " bytes of WAVE data\n";
+               log << "      " << chunk.len << " bytes of WAVE data\n";
             }
          }
       }
 
+      //! Reads the format and the samples of a RIFF/WAVE file
+      /*!
+         The chunks are read in place, only the samples are copied to the
+         sound data.
+      */
       uint32_t WAV::Load(const buffer_t& buffer)
       {
-         size_t bufptr = 12;
+         byte_cursor in(buffer);
+         buffer_view riff, header, body;
+
+         if (!in.take(12, riff))
+            return WHEEL_UNEXPECTED_END_OF_FILE;
+
+         if (!riff.subview(0, 4).equals("RIFF", 4) || !riff.subview(8, 4).equals("WAVE", 4))
+            return WHEEL_INVALID_FORMAT;
+
+         bool found_fmt = false;
+         bool found_data = false;
 
-         while(bufptr < buffer.size())
+         while (in.take(8, header))
          {
-            WAVChunk* chunk = new WAVChunk;
+            WAVChunk chunk;
+            memcpy(chunk.type, header.data(), 4);
+            chunk.len = header.read_le<uint32_t>(4);
 
-            if (buffer.size() < bufptr + sizeof(char) * 4)
-            {
+            if (!in.take(chunk.len, body))
                return WHEEL_UNEXPECTED_END_OF_FILE;
-            }
-            strncpy(chunk->type, (const char*)(&buffer[0] + bufptr), 4);
 
-            bufptr += sizeof(char) * 4;
+            // Chunks are padded to even length, the last one may not be
+            if (chunk.len & 1)
+               in.skip(1);
 
-            chunk->len = buffer_read_le<uint32_t>(buffer, bufptr);
+            chunks.push_back(chunk);
 
-            if (buffer.size() < bufptr + chunk->len)
+            if (header.subview(0, 4).equals("fmt ", 4))
             {
-               delete chunk;
-               return WHEEL_UNEXPECTED_END_OF_FILE;
+               if (body.size() < 16)
+                  return WHEEL_INVALID_FORMAT;
+
+               format_code       = body.read_le<uint16_t>(0);
+               channels          = body.read_le<uint16_t>(2);
+               freqrate          = body.read_le<uint32_t>(4);
+               byte_rate         = body.read_le<uint32_t>(8);
+               block_align       = body.read_le<uint16_t>(12);
+               bits_per_sample   = body.read_le<uint16_t>(14);
+
+               bitrate = byte_rate * 8;
+               found_fmt = true;
+            }
+            else if (header.subview(0, 4).equals("data", 4))
+            {
+               sound.data.assign(body.begin(), body.end());
+               size = chunk.len;
+               found_data = true;
             }
+         }
 
-            chunk->data = (uint8_t*)malloc(chunk->len);
-            memcpy(chunk->data, (&buffer[0] + bufptr), chunk->len);
-            bufptr += chunk->len;
+         if (!found_fmt || !found_data)
+            return WHEEL_INVALID_FORMAT;
 
-            chunks.push_back(chunk);
+         if (byte_rate != 0)
+            len_us = (uint32_t)((uint64_t)size * 1000000 / byte_rate);
 
-            // We reached the end of file
-            if (bufptr == buffer.size() -1)
-               break;
-         }
+         sound.format = WHEEL_FILE_FORMAT_WAV;
 
          return WHEEL_OK;
       }
    }
-}
\ No newline at end of file
+}
@@ -5,10 +5,13 @@
 */
 
 #include <wheel_core_string.h>
+#include <wheel_core_string_ref.h>
+#include <wheel_core_charconv.h>
 
-#include "utf8.h"
+#include "utf8_simd.h"
 
 #include <utility>
+#include <algorithm>
 #include <cstdlib>
 #include <cstring>
 
@@ -18,78 +21,186 @@
 
 namespace wheel
 {
-   //! Default constructor.  Does nothing at the moment.
-   string::string()
+   static_assert(sizeof(void*) != 8 || sizeof(string) == 32, "string should fit in 32 bytes");
+
+   namespace internal
+   {
+      //! Narrowest storage width that can hold the given bits
+      inline uint8_t width_for(uint32_t c)
+      {
+         if (c < 0x100)
+            return 1;
+         else if (c < 0x10000)
+            return 2;
+
+         return 4;
+      }
+
+      //! Bitwise or of all characters, which is enough to tell the width needed
+      template <typename T>
+      inline uint32_t or_chars(const T* chars, size_t n)
+      {
+         uint32_t bits = 0;
+
+         for (size_t i = 0; i < n; ++i)
+            bits |= chars[i];
+
+         return bits;
+      }
+
+      //! Store a character at index pos of a storage of given width
+      inline void store_char(uint8_t* storage, uint8_t width, size_t pos, char32_t c)
+      {
+         if (width == 1)
+            storage[pos] = c;
+         else if (width == 2)
+            ((char16_t*)storage)[pos] = c;
+         else
+            ((char32_t*)storage)[pos] = c;
+      }
+
+      //! Copy n characters from src to dst, converting between widths
+      /*!
+         dst_width must be wide enough to hold every copied character.
+      */
+      template <typename D, typename S>
+      inline void copy_chars(D* dst, const S* src, size_t n)
+      {
+         for (size_t i = 0; i < n; ++i)
+            dst[i] = src[i];
+      }
+
+      inline void copy_chars(uint8_t* dst, uint8_t dst_width, const uint8_t* src, uint8_t src_width, size_t n)
+      {
+         if (dst_width == src_width)
+         {
+            memcpy(dst, src, n * dst_width);
+            return;
+         }
+
+         if (dst_width == 2)
+         {
+            if (src_width == 1)
+               copy_chars((char16_t*)dst, src, n);
+            else
+               copy_chars((char16_t*)dst, (const char32_t*)src, n);
+         } else if (dst_width == 4) {
+            if (src_width == 1)
+               copy_chars((char32_t*)dst, src, n);
+            else
+               copy_chars((char32_t*)dst, (const char16_t*)src, n);
+         } else {
+            if (src_width == 2)
+               copy_chars(dst, (const char16_t*)src, n);
+            else
+               copy_chars(dst, (const char32_t*)src, n);
+         }
+      }
+      //! A UTF-8 argument seen as a string_ref, without building a string
+      /*!
+         ASCII is viewed where it is.  Anything else is decoded into the
+         object, on the stack unless it is long.
+      */
+      class utf8_arg
+      {
+         private:
+            char32_t                local[64];
+            std::vector<char32_t>   heap;
+            string_ref              ref;
+
+         public:
+            explicit utf8_arg(const char* s)
+            {
+               const uint8_t* in = (const uint8_t*)s;
+               size_t n = strlen(s);
+
+               if (utf8_simd::ascii_run(in, n) == n)
+               {
+                  ref = string_ref(s, 1, n);
+                  return;
+               }
+
+               char32_t* out = local;
+
+               if (n > sizeof(local) / sizeof(char32_t))
+               {
+                  heap.resize(n);
+                  out = heap.data();
+               }
+
+               uint32_t overflow;
+               ref = string_ref(out, utf8_simd::decode(in, in + n, out, overflow));
+            }
+
+            // The view may point into the object
+            utf8_arg(const utf8_arg&) = delete;
+            utf8_arg& operator=(const utf8_arg&) = delete;
+
+            inline const string_ref& view() const { return ref; }
+      };
+   }
+
+   //! Default constructor.  Creates an empty string in the local storage.
+   string::string() : len(0), width(1), on_heap(0)
    {
    }
 
    //! Default copy constructor.
-   string::string(const string& other)
+   string::string(const string& other) : len(0), width(1), on_heap(0)
    {
-      // Use the assignment operator overload
-      *this = other;
+      assign(other.data(), other.width, other.len);
    }
 
    //! Default move constructor.
-   string::string(string&& other)
+   /*!
+      Heap storage is stolen from the other string, local storage is copied.
+   */
+   string::string(string&& other) : len(0), width(1), on_heap(0)
    {
       // Uses operator= other
       *this = std::move(other);
    }
 
+   //! Create from a single character
+   string::string(const char32_t c) : len(0), width(1), on_heap(0)
+   {
+      push_back(c);
+   }
+
    //! Create from integer value
    /*!
-      Creates a wcl string from an integer.
+      Creates a wcl string from an integer.  The digits are written straight
+      into the local storage, which holds any 64-bit integer.
    */
-   string::string(int64_t in)
+   string::string(int64_t in) : len(0), width(1), on_heap(0)
    {
-      char integer[32];
-
-      snprintf(integer, 15, "%ld", in);
-      std::string result;
-
-      utf8::replace_invalid(integer, integer + strlen(integer), back_inserter(result));
-      utf8::utf8to32(result.begin(), result.end(), back_inserter(data));
+      len = to_chars((char*)local, (char*)local + local_bytes, in).length;
    }
-   string::string(int32_t in)
+   string::string(int32_t in) : len(0), width(1), on_heap(0)
    {
-      char integer[32];
-
-      snprintf(integer, 15, "%d", in);
-      std::string result;
-
-      utf8::replace_invalid(integer, integer + strlen(integer), back_inserter(result));
-      utf8::utf8to32(result.begin(), result.end(), back_inserter(data));
+      len = to_chars((char*)local, (char*)local + local_bytes, in).length;
    }
 
    //! Create from integer value
    /*!
       Creates a wcl string from an integer.
    */
-   string::string(uint32_t in)
+   string::string(uint32_t in) : len(0), width(1), on_heap(0)
    {
-      char integer[32];
-
-      snprintf(integer, 15, "%d", in);
-      std::string result;
-
-      utf8::replace_invalid(integer, integer + strlen(integer), back_inserter(result));
-      utf8::utf8to32(result.begin(), result.end(), back_inserter(data));
+      len = to_chars((char*)local, (char*)local + local_bytes, in).length;
    }
 
    //! Create from floating point value
    /*!
-      Creates a wcl string from an double-precision float.
+      Creates a wcl string from an double-precision float, using the shortest
+      text that reads back as the same value.
    */
-   string::string(double in)
+   string::string(double in) : len(0), width(1), on_heap(0)
    {
-      char floatingpoint[32];
+      // Doubles can be longer than the local storage
+      char digits[max_number_chars];
 
-      snprintf(floatingpoint, 15, "%f", in);
-      std::string result;
-
-      utf8::replace_invalid(floatingpoint, floatingpoint + strlen(floatingpoint), back_inserter(result));
-      utf8::utf8to32(result.begin(), result.end(), back_inserter(data));
+      assign(digits, 1, to_chars(digits, digits + max_number_chars, in).length);
    }
 
    //! Create from c++11 char32_t array
@@ -99,15 +210,14 @@ namespace wheel
       character array is already UTF32- encoded and no conversions or
       checks are made to ensure this.
    */
-   string::string(const char32_t* in)
+   string::string(const char32_t* in) : len(0), width(1), on_heap(0)
    {
-      data.clear();
+      size_t n = 0;
+      while(in[n] != 0x00000000)
+         ++n;
 
-      while(*in != 0x00000000)
-      {
-         data.push_back(*in);
-         in++;
-      }
+      assign(in, 4, n);
+      shrink_width();
    }
 
    //! Create from character array
@@ -116,14 +226,9 @@ namespace wheel
       It is presumed that the character array data is encoded in either
       UTF-8 or ASCII format.
    */
-   string::string(const char* in)
+   string::string(const char* in) : len(0), width(1), on_heap(0)
    {
-      data.clear();
-
-      std::string result;
-
-      utf8::replace_invalid(in, in + strlen(in), back_inserter(result));
-      utf8::utf8to32(result.begin(), result.end(), back_inserter(data));
+      assign_utf8(in, strlen(in));
    }
 
    //! Create from character array, with
@@ -132,14 +237,9 @@ namespace wheel
       It is presumed that the character array data is encoded in either
       UTF-8 or ASCII format.
    */
-   string::string(const char* in, size_t length)
+   string::string(const char* in, size_t length) : len(0), width(1), on_heap(0)
    {
-      data.clear();
-
-      std::string result;
-
-      utf8::replace_invalid(in, in + length, back_inserter(result));
-      utf8::utf8to32(result.begin(), result.end(), back_inserter(data));
+      assign_utf8(in, length);
    }
 
    //! Copy construct from STL string
@@ -148,65 +248,262 @@ namespace wheel
       It is presumed that the std::string data is encoded in UTF-8 or
       ASCII format.
    */
-   string::string(const std::string& in)
+   string::string(const std::string& in) : len(0), width(1), on_heap(0)
    {
-      data.clear();
+      assign_utf8(in.data(), in.size());
+   }
 
-      std::string result;
-      
-      utf8::replace_invalid(in.begin(), in.end(), back_inserter(result));
-      utf8::unchecked::utf8to32(result.begin(), result.end(), back_inserter(data));
+   //! Create from a view
+   /*!
+      Copies the characters the view points to.  Views may be wider than
+      their contents need, so the copy is narrowed afterwards.
+   */
+   string::string(const string_ref& ref) : len(0), width(1), on_heap(0)
+   {
+      assign(ref.raw_data(), ref.char_width(), ref.length());
+      shrink_width();
    }
 
-   //! Destructor brief
+   //! Destructor, frees heap storage if the string has spilled over.
    string::~string()
    {
+      release();
+   }
+
+   //! Frees heap storage and returns to the local buffer
+   void string::release()
+   {
+      if (on_heap)
+         free(heap.ptr);
+
+      on_heap = 0;
+      len = 0;
+      width = 1;
    }
 
-   //! Get pointer to internal data
+   //! Make sure the storage can hold at least n bytes
    /*!
-      \return pointer to the string data.
-      \warning The string data is not required to be null-terminated
+      Storage grows geometrically, so repeated appends are amortised O(1).
    */
-   const char32_t* string::getptr() const
+   void string::reserve_bytes(size_t n)
    {
-      return &data[0];
+      size_t current = on_heap ? heap.cap : local_bytes;
+
+      if (n <= current)
+         return;
+
+      size_t newcap = std::max(n, current * 2);
+
+      uint8_t* newdata = (uint8_t*)malloc(newcap);
+      assert(newdata != nullptr && "out of memory");
+
+      if (len != 0)
+         memcpy(newdata, data(), len * width);
+
+      // The local characters are overwritten from here on
+      if (on_heap)
+         free(heap.ptr);
+
+      heap.ptr = newdata;
+      heap.cap = newcap;
+      on_heap = 1;
    }
 
-   //! Generate C-style string
-   /*
-      The string's contents are converted from internal UTF-32 format to an UTF-8 encoding
-      and returned as C-style string.
+   //! Make sure the string has room for at least n characters
+   /*!
+      The room is counted at the current character width, adding wider
+      characters later may still cause a reallocation.
+   */
+   void string::reserve(size_t n)
+   {
+      reserve_bytes(n * width);
+   }
 
-      \return <code>const char*</code> containing null-terminated string in UTF-8 format.
+   //! Return the number of characters the string can hold without reallocating
+   size_t string::capacity() const
+   {
+      return (on_heap ? heap.cap : local_bytes) / width;
+   }
 
-      \warning Preferred method to get C-style strings out is to instead call string.std_str().c_str(),
-               which gets you actual const char pointer instead of const pointer to const char that
-               points to static structures.
-      \warning This is also EXTREMELY THREAD-UNSAFE.
+   //! Replace the contents with n characters of src_width bytes each
+   /*!
+      The characters are stored at src_width, call shrink_width() afterwards
+      if src may contain only narrower characters.
    */
-   /*
-   const char* const string::c_str() const
+   void string::assign(const void* src, uint8_t src_width, size_t n)
+   {
+      len = 0;
+      width = src_width;
+
+      reserve_bytes(n * src_width);
+
+      if (n != 0)
+         memmove(data(), src, n * src_width);
+
+      len = n;
+   }
+
+   //! Replace the contents with decoded UTF-8
+   /*!
+      Decodes in a single pass straight into the storage.  Decoding starts at
+      one byte per character and the storage is widened in place the first
+      time a wider character is met.  A string never has more characters than
+      its UTF-8 form has bytes, so the storage is sized once per width.
+      Invalid sequences are replaced with U+FFFD.
+   */
+   void string::assign_utf8(const char* in, size_t n)
+   {
+      const uint8_t* pos = (const uint8_t*)in;
+      const uint8_t* end = pos + n;
+
+      uint32_t overflow = 0;
+
+      len = 0;
+      width = 1;
+
+      reserve_bytes(n);
+      len = utf8_simd::decode(pos, end, data(), overflow);
+
+      if (overflow == 0)
+         return;
+
+      change_width(internal::width_for(overflow));
+      reserve_bytes((len + 1 + (end - pos)) * width);
+      internal::store_char(data(), width, len++, overflow);
+
+      if (width == 2)
+      {
+         len += utf8_simd::decode(pos, end, (char16_t*)data() + len, overflow);
+
+         if (overflow == 0)
+            return;
+
+         change_width(4);
+         reserve_bytes((len + 1 + (end - pos)) * width);
+         internal::store_char(data(), width, len++, overflow);
+      }
+
+      len += utf8_simd::decode(pos, end, (char32_t*)data() + len, overflow);
+   }
+
+   //! Convert the storage to another character width
+   /*!
+      Converts in place; widening runs back to front and narrowing front to back
+      so no character is overwritten before it has been read.  Narrowing
+      assumes every character fits the new width.
+   */
+   void string::change_width(uint8_t new_width)
+   {
+      if (new_width == width)
+         return;
+
+      if (new_width > width)
+      {
+         reserve_bytes(len * new_width);
+
+         for (size_t i = len; i-- > 0;)
+            internal::store_char(data(), new_width, i, (*this)[i]);
+      } else {
+         for (size_t i = 0; i < len; ++i)
+            internal::store_char(data(), new_width, i, (*this)[i]);
+      }
+
+      width = new_width;
+   }
+
+   //! Narrow the storage to the smallest width that holds every character
+   void string::shrink_width()
+   {
+      if (width == 1)
+         return;
+
+      uint32_t bits = 0;
+
+      if (width == 2)
+         bits = internal::or_chars((const char16_t*)data(), len);
+      else
+         bits = internal::or_chars((const char32_t*)data(), len);
+
+      change_width(internal::width_for(bits));
+   }
+
+   //! Append a character to the end of the string
+   void string::push_back(char32_t c)
+   {
+      uint8_t needed = internal::width_for(c);
+
+      if (needed > width)
+         change_width(needed);
+
+      if (len == capacity())
+         reserve(len + 1);
+
+      internal::store_char(data(), width, len++, c);
+   }
+
+   //! Replace a character
+   /*!
+      Widens the storage if the new character does not fit, and narrows it
+      back if the replaced character was the only one needing the width.
+   */
+   void string::set(size_t pos, char32_t c)
+   {
+      assert(pos < len);
+
+      uint8_t old_needed = internal::width_for((*this)[pos]);
+      uint8_t needed = internal::width_for(c);
+
+      if (needed > width)
+         change_width(needed);
+
+      internal::store_char(data(), width, pos, c);
+
+      if (needed < width && old_needed == width)
+         shrink_width();
+   }
+
+   //! Encode the string as UTF-8 into out
+   /*!
+      out must have room for utf8_length() bytes.
+
+      \return Number of bytes written.
+   */
+   size_t string::encode_utf8(char* out) const
    {
-      static std::string result;
+      if (width == 1)
+         return utf8_simd::encode(data(), len, out);
+      else if (width == 2)
+         return utf8_simd::encode((const char16_t*)data(), len, out);
 
-      result.resize(0);
-      utf8::utf32to8(data.begin(), data.end(), std::back_inserter(result));
-      return result.c_str();
+      return utf8_simd::encode((const char32_t*)data(), len, out);
    }
+
+   //! Return the length of the string in UTF-8 encoding
+   /*
+      \return Number of bytes the string takes in UTF-8, without a terminator.
    */
+   size_t string::utf8_length() const
+   {
+      if (width == 1)
+         return utf8_simd::encoded_length(data(), len);
+      else if (width == 2)
+         return utf8_simd::encoded_length((const char16_t*)data(), len);
+
+      return utf8_simd::encoded_length((const char32_t*)data(), len);
+   }
 
    //! Generate std::string
    /*
-      The string's contents are converted from internal UTF-32 format to an UTF-8 encoding
+      The string's contents are converted from internal format to an UTF-8 encoding
       and returned as C++ STL string.
 
       \return <code>const std::string</code> containing the string in UTF-8 format.
    */
    const std::string string::std_str() const
    {
-      std::string result;
-      utf8::utf32to8(data.begin(), data.end(), std::back_inserter(result));
+      std::string result(utf8_length(), '\0');
+      encode_utf8(&result[0]);
+
       return result;
    }
 
@@ -219,36 +516,63 @@ namespace wheel
    //! Generate c-style string
    /*
       The C-style string is written to array given as a parameter, no allocation is made
-      so the array must be pre-allocated.
+      so the array must be pre-allocated to hold utf8_length() + 1 bytes.
 
       \return nothing
    */
    void string::to_c_str(char* array) const
    {
-      std::vector<char> utf8_result;
+      array[encode_utf8(array)] = '\0';
+   }
+
+   utf8_cstr::utf8_cstr(const string& s)
+   {
+      size_t n = s.utf8_length();
+      char* out = local;
 
-      utf8::utf32to8(data.begin(), data.end(), std::back_inserter(utf8_result));
+      if (n >= sizeof(local))
+      {
+         heap.reset(new char[n + 1]);
+         out = heap.get();
+      }
 
-      utf8_result.push_back('\0');
-      memcpy(array, &utf8_result[0], utf8_result.size());
+      out[s.encode_utf8(out)] = '\0';
+      ptr = out;
    }
 
    //! Return integer value
    /*
-      \return Integer value represented in the string.
+      Leading whitespace is skipped and the base is taken from the prefix like
+      strtoul() does.  Use from_chars() to find out whether the string held a
+      number at all.
+
+      \return Integer value represented in the string, 0 if there is none and
+              UINT32_MAX if it is too large.
    */
-   uint32_t string::to_uint32()
+   uint32_t string::to_uint32() const
    {
-      return strtoul(this->std_str().c_str(), nullptr, 0);
+      uint32_t value = 0;
+      number_result result = from_chars(string_ref(*this).trim_left(), value, 0);
+
+      if (result.error == WHEEL_OUT_OF_RANGE)
+         return UINT32_MAX;
+
+      return value;
    }
 
    //! Return floating point value
    /*
-      \return Double-precision floating point value represented in the string.
+      Leading whitespace is skipped, use from_chars() to find out whether the
+      string held a number at all.
+
+      \return Double-precision floating point value represented in the string, or 0.
    */
-   double string::to_float()
+   double string::to_float() const
    {
-      return atof(this->std_str().c_str());
+      double value = 0.0;
+      from_chars(string_ref(*this).trim_left(), value);
+
+      return value;
    }
 
    //! Return the length of the string
@@ -257,7 +581,7 @@ namespace wheel
    */
    size_t string::length() const
    {
-      return data.size();
+      return len;
    }
 
    //! Split a string by a delim
@@ -271,34 +595,11 @@ namespace wheel
    std::vector<string> string::split(const string& delim)
    {
       std::vector<string> rval;
-      if (data.size() == 0)
-         return rval;
-
-      size_t pos = 0;
-
-      for (size_t i = 0; i < data.size(); ++i)
-      {
-         if (match_char32(data[i], delim))
-         {
-            while(match_char32(data[pos], delim))
-               pos++;
-
-            string temp = this->substr(pos, i - pos);
-
-            if (temp.length() != 0)
-            {
-               rval.push_back(temp);
-               pos = i;
-            }
-         }
-      }
-
-      while(match_char32(data[pos], delim))
-         pos++;
+      string_ref rest(*this);
+      string_ref token;
 
-      string temp = this->substr(pos, data.size() - pos);
-      if (temp.length() != 0)
-         rval.push_back(temp);
+      while (rest.tokenize(token, delim))
+         rval.push_back(string(token));
 
       return rval;
    }
@@ -319,35 +620,104 @@ namespace wheel
    string string::substr(size_t pos, size_t len) const
    {
       string rval;
-      for (uint32_t it = pos; it < pos + len; ++it)
-      {
-         if (it > data.size())
-            return rval;
-         rval.data.push_back(data[it]);
-      }
+
+      if (pos >= this->len)
+         return rval;
+
+      rval.assign(data() + pos * width, width, std::min(len, this->len - pos));
+      rval.shrink_width();
+
       return rval;
    }
 
+   //! Find a sequence
+   /*!
+      \param   seq   Sequence to look for
+      \param   pos   Position to start the search from
+
+      \return  Position of the first occurrence of seq at or after pos, npos if not found.
+
+      \sa wheel::searcher for searching the same sequence repeatedly
+   */
+   size_t string::find(const string_ref& seq, size_t pos) const
+   {
+      return string_ref(*this).find(seq, pos);
+   }
+
+   size_t string::find(const char* seq, size_t pos) const
+   {
+      return find(internal::utf8_arg(seq).view(), pos);
+   }
+
+   size_t string::find(char32_t c, size_t pos) const
+   {
+      return string_ref(*this).find(c, pos);
+   }
+
+   //! Find the last occurrence of a sequence
+   /*!
+      \param   seq   Sequence to look for
+      \param   pos   Last position a match may start at
+
+      \return  Position of the last occurrence of seq, npos if not found.
+   */
+   size_t string::rfind(const string_ref& seq, size_t pos) const
+   {
+      return string_ref(*this).rfind(seq, pos);
+   }
+
+   size_t string::rfind(const char* seq, size_t pos) const
+   {
+      return rfind(internal::utf8_arg(seq).view(), pos);
+   }
+
+   size_t string::rfind(char32_t c, size_t pos) const
+   {
+      return string_ref(*this).rfind(c, pos);
+   }
+
+   //! Find the first of a set of characters
+   /*!
+      \return  Position of the first character at or after pos that is in chars, npos if none is.
+   */
+   size_t string::find_first_of(const string_ref& chars, size_t pos) const
+   {
+      return string_ref(*this).find_first_of(chars, pos);
+   }
+
+   size_t string::find_first_of(const char* chars, size_t pos) const
+   {
+      return find_first_of(internal::utf8_arg(chars).view(), pos);
+   }
+
+   //! Find all non-overlapping occurrences of a sequence
+   /*!
+      \return  Positions of the matches in order, empty if seq is empty.
+   */
+   std::vector<size_t> string::find_all(const string_ref& seq) const
+   {
+      return string_ref(*this).find_all(seq);
+   }
+
+   std::vector<size_t> string::find_all(const char* seq) const
+   {
+      return find_all(internal::utf8_arg(seq).view());
+   }
+
    //! Does a string contain a sequence
    /*!
       Searches a string for a sequence specified by argument seq.
 
       \return <code>true</code> if string contains sequence.
    */
-   bool string::contains(const string& seq)
+   bool string::contains(const string_ref& seq) const
    {
-      if (this->length() < seq.length())
-         return false;
-
-      size_t lastpos = this->length() - seq.length() + 1;
-
-      for (size_t i = 0; i < lastpos; ++i)
-      {
-         if (this->substr(i, seq.length()) == seq)
-            return true;
-      }
+      return find(seq) != npos;
+   }
 
-      return false;
+   bool string::contains(const char* seq) const
+   {
+      return find(seq) != npos;
    }
 
    //! Checks if the string is empty
@@ -367,7 +737,8 @@ namespace wheel
    */
    void string::clear()
    {
-      data.clear();
+      len = 0;
+      width = 1;
    }
 
    //! Copy assignment operator
@@ -378,8 +749,7 @@ namespace wheel
       if (this == &other)
          return *this;
 
-      data.resize(other.data.size());
-      memcpy(&data[0], &other.data[0], other.data.size() * sizeof(char32_t));
+      assign(other.data(), other.width, other.len);
 
       return *this;
    }
@@ -392,7 +762,22 @@ namespace wheel
       // Disallow moving to itself
       if (this != &other)
       {
-         data = std::move(other.data);
+         if (other.is_local())
+         {
+            assign(other.data(), other.width, other.len);
+         } else {
+            release();
+
+            heap = other.heap;
+            len = other.len;
+            width = other.width;
+            on_heap = 1;
+
+            other.on_heap = 0;
+         }
+
+         other.len = 0;
+         other.width = 1;
       }
 
       return *this;
@@ -424,16 +809,103 @@ namespace wheel
    */
    string string::operator+(const string& other) const
    {
-      string rval(*this);
-      for (auto c : other.data)
-         rval.data.push_back(c);
+      string rval;
+
+      rval.width = std::max<uint8_t>(width, other.width);
+      rval.reserve(len + other.len);
+
+      internal::copy_chars(rval.data(), rval.width, data(), width, len);
+      internal::copy_chars(rval.data() + len * rval.width, rval.width, other.data(), other.width, other.len);
+      rval.len = len + other.len;
 
       return rval;
    }
 
    string& string::operator+=(const string& other)
    {
-      *this = *this + other;
+      return append(string_ref(other));
+   }
+
+   //! Append characters in place
+   /*!
+      Only the appended characters are copied, the storage grows geometrically
+      so building a string piece by piece takes amortised linear time.  The
+      storage is widened only if the appended characters need it.
+
+      \param   other Characters to append, may point into this string.
+   */
+   string& string::append(const string_ref& other)
+   {
+      const uint8_t* src = (const uint8_t*)other.raw_data();
+      const uint8_t src_width = other.char_width();
+      const size_t n = other.length();
+
+      if (n == 0)
+         return *this;
+
+      // Growing or widening would move the characters out from under the view.
+      uintptr_t start = (uintptr_t)data();
+      uintptr_t end = start + (on_heap ? heap.cap : local_bytes);
+
+      if ((uintptr_t)src >= start && (uintptr_t)src < end)
+      {
+         string copy(other);
+         return append(string_ref(copy));
+      }
+
+      // Views may be stored wider than their characters need
+      uint8_t needed = src_width;
+
+      if (src_width > width)
+      {
+         if (src_width == 2)
+            needed = internal::width_for(internal::or_chars((const char16_t*)src, n));
+         else
+            needed = internal::width_for(internal::or_chars((const char32_t*)src, n));
+      }
+
+      reserve_bytes((len + n) * std::max<uint8_t>(width, needed));
+
+      if (needed > width)
+         change_width(needed);
+
+      internal::copy_chars(data() + len * width, width, src, src_width, n);
+      len += n;
+
+      return *this;
+   }
+
+   //! Append UTF-8 in place
+   string& string::append(const char* utf8)
+   {
+      return append(utf8, strlen(utf8));
+   }
+
+   /*!
+      ASCII is widened straight into the storage, anything else is decoded
+      into a temporary first.
+   */
+   string& string::append(const char* utf8, size_t length)
+   {
+      const uint8_t* in = (const uint8_t*)utf8;
+
+      if (utf8_simd::ascii_run(in, length) != length)
+      {
+         string decoded(utf8, length);
+         return append(string_ref(decoded));
+      }
+
+      reserve_bytes((len + length) * width);
+
+      if (width == 1)
+         utf8_simd::widen_ascii(data() + len, in, length);
+      else if (width == 2)
+         utf8_simd::widen_ascii((char16_t*)data() + len, in, length);
+      else
+         utf8_simd::widen_ascii((char32_t*)data() + len, in, length);
+
+      len += length;
+
       return *this;
    }
 
@@ -444,14 +916,11 @@ namespace wheel
    */
    bool string::operator==(const string& other) const
    {
-      if (data.size() != other.data.size())
+      // Storage width is canonical, so equal strings have identical bytes.
+      if ((len != other.len) || (width != other.width))
          return false;
 
-      for (size_t i = 0; i < data.size(); ++i)
-         if (data[i] != other.data[i])
-            return false;
-
-      return true;
+      return memcmp(data(), other.data(), len * width) == 0;
    }
    //! Comparison, not equal
    /*!
@@ -462,38 +931,86 @@ namespace wheel
    }
    //! Comparison, before
    /*!
-      Compares the two strings by their ASCII value.
+      Compares the two strings by code point, see compare().
    */
    bool string::operator<(const string& other) const
    {
-      for (size_t i = 0; i < std::min(length(), other.length()); ++i)
-         if (data[i] < other.data[i])
-            return true;
-         else if (data[i] > other.data[i])
-            return false;
-
-      return false;
+      return compare(other) < 0;
    }
 
    bool string::operator>(const string& other) const
    {
-      for (size_t i = 0; i < std::min(length(), other.length()); ++i)
-         if (data[i] < other.data[i])
-            return false;
-         else if (data[i] > other.data[i])
-            return true;
+      return compare(other) > 0;
+   }
 
-      return true;
+   bool string::operator<=(const string& other) const
+   {
+      return compare(other) <= 0;
    }
 
+   bool string::operator>=(const string& other) const
+   {
+      return compare(other) >= 0;
+   }
 
-   //! Conversion to const char*
+   //! Three-way comparison
    /*!
-      Converts string to const char*  (same as using c_str())
+      Compares by code point, a string that is a prefix of another orders
+      before it.
+
+      \return Negative, zero or positive if this string orders before, equal
+              to or after other.
+   */
+   int string::compare(const string_ref& other) const
+   {
+      return string_ref(*this).compare(other);
+   }
+
+   int string::compare(const char* other) const
+   {
+      return compare(internal::utf8_arg(other).view());
+   }
 
-   string::operator const char*()
+   //! Make a sort key from a string
+   sort_key::sort_key(const string& s) : prefix(0), bytes(s.utf8_length(), '\0')
    {
-      return this->c_str();
+      s.encode_utf8(&bytes[0]);
+
+      for (size_t i = 0; i < 8; ++i)
+      {
+         prefix <<= 8;
+
+         if (i < bytes.size())
+            prefix |= (uint8_t)bytes[i];
+      }
    }
+
+   //! Sort strings by code point
+   /*!
+      Computes a sort_key for every string once, sorts the keys and then moves
+      the strings into place, so no string is compared or copied during the
+      sort itself.
    */
-}
+   void sort_strings(std::vector<string>& list)
+   {
+      std::vector<std::pair<sort_key, size_t>> keys;
+      keys.reserve(list.size());
+
+      for (size_t i = 0; i < list.size(); ++i)
+         keys.emplace_back(sort_key(list[i]), i);
+
+      std::sort(keys.begin(), keys.end(),
+                [](const std::pair<sort_key, size_t>& a, const std::pair<sort_key, size_t>& b)
+                {
+                   return a.first < b.first;
+                });
+
+      std::vector<string> sorted;
+      sorted.reserve(list.size());
+
+      for (auto& key : keys)
+         sorted.push_back(std::move(list[key.second]));
+
+      list.swap(sorted);
+   }
+}
\ No newline at end of file
@@ -0,0 +1,106 @@
+/*!
+   @file
+   \brief Contains implementations for building strings piece by piece
+   \author Jari Ronkainen
+*/
+
+#include <wheel_core_string_builder.h>
+#include <wheel_core_charconv.h>
+
+#include <utility>
+
+namespace wheel
+{
+   string_builder& string_builder::append(const string_ref& text)
+   {
+      buffer.append(text);
+      return *this;
+   }
+
+   string_builder& string_builder::append(const string& text)
+   {
+      buffer.append(string_ref(text));
+      return *this;
+   }
+
+   string_builder& string_builder::append(const char32_t* text)
+   {
+      buffer.append(string_ref(text));
+      return *this;
+   }
+
+   string_builder& string_builder::append(const char* utf8)
+   {
+      buffer.append(utf8);
+      return *this;
+   }
+
+   string_builder& string_builder::append(const char* utf8, size_t length)
+   {
+      buffer.append(utf8, length);
+      return *this;
+   }
+
+   string_builder& string_builder::append(char32_t c)
+   {
+      buffer.push_back(c);
+      return *this;
+   }
+
+   //! Append a single byte as a character, meant for ASCII
+   string_builder& string_builder::append(char c)
+   {
+      buffer.push_back((uint8_t)c);
+      return *this;
+   }
+
+   //! Append count copies of a character
+   string_builder& string_builder::append(char32_t c, size_t count)
+   {
+      buffer.reserve(buffer.length() + count);
+
+      for (size_t i = 0; i < count; ++i)
+         buffer.push_back(c);
+
+      return *this;
+   }
+
+   string_builder& string_builder::append(int32_t value)
+   {
+      char digits[max_number_chars];
+      return append(digits, to_chars(digits, digits + sizeof(digits), value).length);
+   }
+
+   string_builder& string_builder::append(int64_t value)
+   {
+      char digits[max_number_chars];
+      return append(digits, to_chars(digits, digits + sizeof(digits), value).length);
+   }
+
+   string_builder& string_builder::append(uint32_t value)
+   {
+      char digits[max_number_chars];
+      return append(digits, to_chars(digits, digits + sizeof(digits), value).length);
+   }
+
+   string_builder& string_builder::append(uint64_t value)
+   {
+      char digits[max_number_chars];
+      return append(digits, to_chars(digits, digits + sizeof(digits), value).length);
+   }
+
+   //! Append a floating point value, shortest text that reads back as the same value
+   string_builder& string_builder::append(double value)
+   {
+      char digits[max_number_chars];
+      return append(digits, to_chars(digits, digits + sizeof(digits), value).length);
+   }
+
+   string string_builder::release()
+   {
+      string rval(std::move(buffer));
+      buffer.clear();
+
+      return rval;
+   }
+}
@@ -0,0 +1,388 @@
+/*!
+   @file
+   \brief Contains implementations for the non-owning string view class
+   \author Jari Ronkainen
+*/
+
+#include <wheel_core_string_ref.h>
+#include <wheel_core_search.h>
+#include <wheel_core_hash.h>
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+   #define WHEEL_STRING_REF_SSE2
+   #include <emmintrin.h>
+#endif
+
+namespace wheel
+{
+   namespace
+   {
+      inline bool in_set(char32_t c, const string_ref& chars)
+      {
+         for (size_t i = 0; i < chars.length(); ++i)
+            if (c == chars[i])
+               return true;
+
+         return false;
+      }
+
+      //! Offset of the first differing byte, n if there is none
+      inline size_t mismatch(const uint8_t* a, const uint8_t* b, size_t n)
+      {
+         size_t i = 0;
+
+#ifdef WHEEL_STRING_REF_SSE2
+         for (; i + 16 <= n; i += 16)
+         {
+            __m128i va = _mm_loadu_si128((const __m128i*)(a + i));
+            __m128i vb = _mm_loadu_si128((const __m128i*)(b + i));
+
+            uint32_t equal = _mm_movemask_epi8(_mm_cmpeq_epi8(va, vb));
+
+            if (equal != 0xffff)
+               return i + __builtin_ctz(~equal);
+         }
+#endif
+
+         while (i < n && a[i] == b[i])
+            ++i;
+
+         return i;
+      }
+
+      template <typename H>
+      inline H fnv1a_ref(const string_ref& s, H hash, H prime) noexcept
+      {
+         if (s.char_width() == 1)
+            return internal::fnv1a_chars((const uint8_t*)s.raw_data(), s.length(), hash, prime);
+         else if (s.char_width() == 2)
+            return internal::fnv1a_chars((const char16_t*)s.raw_data(), s.length(), hash, prime);
+
+         return internal::fnv1a_chars((const char32_t*)s.raw_data(), s.length(), hash, prime);
+      }
+   }
+
+   //! View a null-terminated UTF-32 string
+   string_ref::string_ref(const char32_t* s) : data((const uint8_t*)s), len(0), width(4)
+   {
+      while (s[len] != 0)
+         ++len;
+   }
+
+   //! View of a part of this view
+   /*!
+      \param   pos      Position of the first character
+      \param   length   Number of characters, clamped to the end of the view
+
+      \return  View into the same storage, empty if pos is past the end.
+   */
+   string_ref string_ref::substr(size_t pos, size_t length) const
+   {
+      if (pos >= len)
+         return string_ref(data, width, 0);
+
+      return string_ref(data + pos * width, width, std::min(length, len - pos));
+   }
+
+   //! Strip characters from both ends
+   /*!
+      \param   chars Characters to strip, whitespace by default
+
+      \return  View without the leading and trailing characters found in chars.
+   */
+   string_ref string_ref::trim(const string_ref& chars) const
+   {
+      return trim_left(chars).trim_right(chars);
+   }
+
+   string_ref string_ref::trim_left(const string_ref& chars) const
+   {
+      size_t first = 0;
+
+      while (first < len && in_set((*this)[first], chars))
+         ++first;
+
+      return substr(first);
+   }
+
+   string_ref string_ref::trim_right(const string_ref& chars) const
+   {
+      size_t last = len;
+
+      while (last > 0 && in_set((*this)[last - 1], chars))
+         --last;
+
+      return substr(0, last);
+   }
+
+   //! Take the next token from the front of the view
+   /*!
+      Skips leading delimiters, stores the characters up to the next delimiter
+      in token and removes them and the delimiter from this view.  Nothing is
+      copied, so a parser can walk a string without allocating.
+
+      \code
+         wheel::string_ref rest(line), token;
+
+         while (rest.tokenize(token, U","))
+            handle(token);
+      \endcode
+
+      \param   token Set to the token found
+      \param   delim Characters that separate tokens
+
+      \return  <code>false</code> when there are no tokens left.
+   */
+   bool string_ref::tokenize(string_ref& token, const string_ref& delim)
+   {
+      size_t first = 0;
+
+      while (first < len && in_set((*this)[first], delim))
+         ++first;
+
+      if (first == len)
+      {
+         *this = substr(len);
+         return false;
+      }
+
+      size_t last = first;
+
+      while (last < len && !in_set((*this)[last], delim))
+         ++last;
+
+      token = substr(first, last - first);
+      *this = substr(last);
+
+      return true;
+   }
+
+   //! Split a view by delimiters
+   /*!
+      Behaves like string::split(), empty tokens are dropped, but returns
+      views into this view's storage instead of new strings.
+
+      \param   delim Characters that separate tokens
+
+      \return  Views of the tokens.
+   */
+   std::vector<string_ref> string_ref::split(const string_ref& delim) const
+   {
+      std::vector<string_ref> rval;
+      string_ref rest(*this);
+      string_ref token;
+
+      while (rest.tokenize(token, delim))
+         rval.push_back(token);
+
+      return rval;
+   }
+
+   //! Find a character
+   /*!
+      \return  Position of the first occurrence of c at or after pos, npos if not found.
+   */
+   size_t string_ref::find(char32_t c, size_t pos) const
+   {
+      if (width == 1)
+      {
+         if (pos >= len || c > 0xff)
+            return npos;
+
+         const void* found = memchr(data + pos, (int)c, len - pos);
+         return found ? (const uint8_t*)found - data : npos;
+      }
+
+      for (size_t i = pos; i < len; ++i)
+         if ((*this)[i] == c)
+            return i;
+
+      return npos;
+   }
+
+   //! Find the last occurrence of a character
+   /*!
+      \return  Position of the last occurrence of c at or before pos, npos if not found.
+   */
+   size_t string_ref::rfind(char32_t c, size_t pos) const
+   {
+      if (len == 0)
+         return npos;
+
+      for (size_t i = std::min(pos, len - 1) + 1; i-- > 0; )
+         if ((*this)[i] == c)
+            return i;
+
+      return npos;
+   }
+
+   //! Find a sequence
+   /*!
+      Uses the same search as wheel::searcher, but builds any tables it needs
+      on the stack, so for repeated searches with the same sequence a searcher
+      is faster.
+
+      \return  Position of the first occurrence of seq at or after pos, npos if not found.
+   */
+   size_t string_ref::find(const string_ref& seq, size_t pos) const
+   {
+      return internal::search_forward(*this, seq, pos, nullptr);
+   }
+
+   //! Find the last occurrence of a sequence
+   /*!
+      \return  Position of the last occurrence of seq starting at or before pos, npos if not found.
+   */
+   size_t string_ref::rfind(const string_ref& seq, size_t pos) const
+   {
+      return internal::search_backward(*this, seq, pos, nullptr);
+   }
+
+   //! Find the first of a set of characters
+   /*!
+      \param   chars Characters to look for
+      \param   pos   Position to start from
+
+      \return  Position of the first character at or after pos that is in chars, npos if none is.
+   */
+   size_t string_ref::find_first_of(const string_ref& chars, size_t pos) const
+   {
+      // Characters below 256 are looked up from a bitmap, the rest from chars.
+      uint64_t low[4] = { 0, 0, 0, 0 };
+      bool wide = false;
+
+      for (size_t i = 0; i < chars.length(); ++i)
+      {
+         char32_t c = chars[i];
+
+         if (c < 256)
+            low[c >> 6] |= (uint64_t)1 << (c & 63);
+         else
+            wide = true;
+      }
+
+      for (size_t i = pos; i < len; ++i)
+      {
+         char32_t c = (*this)[i];
+
+         if (c < 256)
+         {
+            if (low[c >> 6] & ((uint64_t)1 << (c & 63)))
+               return i;
+         }
+         else if (wide && in_set(c, chars))
+            return i;
+      }
+
+      return npos;
+   }
+
+   //! Find all occurrences of a sequence
+   /*!
+      Matches do not overlap, searching continues after the end of each match.
+      An empty sequence matches nothing.
+
+      \return  Positions of the matches in order.
+   */
+   std::vector<size_t> string_ref::find_all(const string_ref& seq) const
+   {
+      std::vector<size_t> rval;
+
+      if (seq.empty())
+         return rval;
+
+      internal::search_table_t skip;
+      internal::build_skip(seq, skip);
+
+      for (size_t pos = internal::search_forward(*this, seq, 0, &skip);
+           pos != npos;
+           pos = internal::search_forward(*this, seq, pos + seq.len, &skip))
+         rval.push_back(pos);
+
+      return rval;
+   }
+
+   bool string_ref::starts_with(const string_ref& seq) const
+   {
+      return (seq.len <= len) && (substr(0, seq.len) == seq);
+   }
+
+   bool string_ref::ends_with(const string_ref& seq) const
+   {
+      return (seq.len <= len) && (substr(len - seq.len) == seq);
+   }
+
+   //! Compare characters with another view
+   /*!
+      Compares by code point, so the result does not depend on the storage
+      width of either view.  Latin-1 storage compares with memcmp(); wider
+      storage of the same width looks for the first differing byte with SSE2
+      and compares the character it is in.
+
+      \return  Negative, zero or positive if this view orders before, equal to
+               or after other.
+   */
+   int string_ref::compare(const string_ref& other) const
+   {
+      const size_t n = std::min(len, other.len);
+
+      if (width == other.width && width == 1)
+      {
+         int rval = (n != 0) ? memcmp(data, other.data, n) : 0;
+
+         if (rval != 0)
+            return rval;
+      } else if (width == other.width) {
+         size_t i = mismatch(data, other.data, n * width) / width;
+
+         if (i < n)
+            return ((*this)[i] < other[i]) ? -1 : 1;
+      } else {
+         for (size_t i = 0; i < n; ++i)
+         {
+            char32_t a = (*this)[i];
+            char32_t b = other[i];
+
+            if (a != b)
+               return (a < b) ? -1 : 1;
+         }
+      }
+
+      if (len == other.len)
+         return 0;
+
+      return (len < other.len) ? -1 : 1;
+   }
+
+   //! Copy the characters into a new string
+   string string_ref::str() const
+   {
+      return string(*this);
+   }
+
+   //! Hash<string> of a wheel::string with the same characters.
+   size_t string_ref::hash() const noexcept
+   {
+      if (hash_seed() != 0)
+      {
+         // Seeded hashes go over the storage, as if it were at the narrowest width
+         if (width != 1)
+         {
+            uint8_t narrowest = internal::narrowest_width(*this);
+
+            if (narrowest != width)
+               return (size_t)internal::wyhash64(*this, narrowest, hash_seed() ^ narrowest);
+         }
+
+         return internal::seeded_hash(data, len * width, width);
+      }
+
+      if (size_t_x64())
+         return (size_t)fnv1a_ref<uint64_t>(*this, 0xCBF29CE484222325, 0x100000001B3);
+
+      return (size_t)fnv1a_ref<uint32_t>(*this, 0x811C9DC5, 0x1000193);
+   }
+}
@@ -0,0 +1,210 @@
+/*!
+   @file
+   \brief Contains implementations for interned strings (symbols)
+   \author Jari Ronkainen
+*/
+
+#include <wheel_core_symbol.h>
+
+#include <mutex>
+#include <deque>
+#include <unordered_map>
+
+namespace wheel
+{
+   namespace internal
+   {
+      //! Global intern table
+      /*!
+         Entries live in a deque so their addresses never change, the index
+         maps string hashes to entries.  Lookups hash the string once and
+         compare characters only against entries with the same hash.
+      */
+      struct symbol_table
+      {
+         std::mutex                                      lock;
+         std::deque<symbol_entry>                        entries;
+         std::unordered_multimap<size_t, symbol_entry*>  index;
+
+         symbol_entry* lookup(const string& s, size_t hash)
+         {
+            auto range = index.equal_range(hash);
+
+            for (auto it = range.first; it != range.second; ++it)
+               if (it->second->str == s)
+                  return it->second;
+
+            return nullptr;
+         }
+
+         symbol_entry* lookup(const hashed_name& name, size_t hash)
+         {
+            auto range = index.equal_range(hash);
+
+            for (auto it = range.first; it != range.second; ++it)
+               if (name.matches(it->second->str))
+                  return it->second;
+
+            return nullptr;
+         }
+
+         symbol_entry* insert(const string& s, size_t hash)
+         {
+            entries.push_back(symbol_entry { s, hash, s.std_str() });
+            symbol_entry* entry = &entries.back();
+
+            index.insert({hash, entry});
+
+            return entry;
+         }
+      };
+
+      // The table is never destroyed, so symbols stay valid during static destruction.
+      symbol_table& get_symbol_table()
+      {
+         static symbol_table* table = new symbol_table;
+         return *table;
+      }
+
+      const symbol_entry* empty_symbol()
+      {
+         static const symbol_entry empty { string(), wheel::Hash<string>()(string()), std::string() };
+         return &empty;
+      }
+
+      const symbol_entry* intern(const string& s)
+      {
+         if (s.empty())
+            return empty_symbol();
+
+         size_t hash = wheel::Hash<string>()(s);
+
+         symbol_table& table = get_symbol_table();
+         std::lock_guard<std::mutex> guard(table.lock);
+
+         symbol_entry* entry = table.lookup(s, hash);
+
+         if (entry != nullptr)
+            return entry;
+
+         return table.insert(s, hash);
+      }
+
+      //! Intern a name, using the hash computed at compile time if hashing is deterministic
+      const symbol_entry* intern(const hashed_name& name)
+      {
+         size_t hash = name.hash();
+         symbol_table& table = get_symbol_table();
+
+         {
+            std::lock_guard<std::mutex> guard(table.lock);
+            symbol_entry* entry = table.lookup(name, hash);
+
+            if (entry != nullptr)
+               return entry;
+         }
+
+         string s = name.str();
+
+         if (s.empty())
+            return empty_symbol();
+
+         std::lock_guard<std::mutex> guard(table.lock);
+
+         // Another thread may have added it while the string was made
+         symbol_entry* entry = table.lookup(name, hash);
+
+         if (entry != nullptr)
+            return entry;
+
+         return table.insert(s, hash);
+      }
+   }
+
+   //! Create a symbol from a string, interning it if needed
+   symbol::symbol(const string& s) : entry(internal::intern(s))
+   {
+   }
+
+   symbol::symbol(const char* s) : entry(internal::intern(string(s)))
+   {
+   }
+
+   symbol::symbol(const char32_t* s) : entry(internal::intern(string(s)))
+   {
+   }
+
+   //! Create a symbol from a name hashed at compile time
+   /*!
+      With deterministic hashing the name is not hashed, and only the first
+      use of a name that is not yet interned builds a string of it.  Seeded
+      hashes cannot be known at compile time, so they are computed here.
+   */
+   symbol::symbol(const hashed_name& name) : entry(internal::intern(name))
+   {
+   }
+
+   //! Look up an interned string
+   /*!
+      Does not add the string to the table if it is not there.
+
+      \param   s        String to look up
+      \param   result   Set to the symbol for the string if found
+
+      \return  <code>true</code> if the string has been interned.
+   */
+   bool symbol::find(const string& s, symbol& result)
+   {
+      if (s.empty())
+      {
+         result = symbol();
+         return true;
+      }
+
+      size_t hash = wheel::Hash<string>()(s);
+
+      internal::symbol_table& table = internal::get_symbol_table();
+      std::lock_guard<std::mutex> guard(table.lock);
+
+      const internal::symbol_entry* entry = table.lookup(s, hash);
+
+      if (entry == nullptr)
+         return false;
+
+      result = symbol(entry);
+      return true;
+   }
+
+   //! Look up an interned name, without hashing it if hashing is deterministic
+   bool symbol::find(const hashed_name& name, symbol& result)
+   {
+      // The empty symbol lives outside the table
+      if (name.matches(string()))
+      {
+         result = symbol();
+         return true;
+      }
+
+      size_t hash = name.hash();
+
+      internal::symbol_table& table = internal::get_symbol_table();
+      std::lock_guard<std::mutex> guard(table.lock);
+
+      const internal::symbol_entry* entry = table.lookup(name, hash);
+
+      if (entry == nullptr)
+         return false;
+
+      result = symbol(entry);
+      return true;
+   }
+
+   //! Return the number of strings interned so far
+   size_t symbol::table_size()
+   {
+      internal::symbol_table& table = internal::get_symbol_table();
+      std::lock_guard<std::mutex> guard(table.lock);
+
+      return table.entries.size();
+   }
+}
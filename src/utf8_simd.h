@@ -0,0 +1,419 @@
+/*!
+   @file
+   \brief Single-pass UTF-8 validation, decoding and encoding used by the string class
+   \author Jari Ronkainen
+
+   Decodes UTF-8 straight into string storage of 1, 2 or 4 bytes per character.
+   Runs of ASCII are found and copied with SSE2, or AVX2 when the CPU supports it,
+   everything else goes through a scalar decoder.  Invalid input is replaced with
+   U+FFFD like utf8::replace_invalid() does, one for each invalid sequence.
+
+   Encoding computes the exact output length first and then writes blocks of
+   ASCII with SSE2, falling back to a scalar encoder for the rest.
+*/
+
+#ifndef WHEEL_UTF8_SIMD_HEADER
+#define WHEEL_UTF8_SIMD_HEADER
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+   #define WHEEL_UTF8_SSE2
+   #include <emmintrin.h>
+#endif
+
+#if defined(WHEEL_UTF8_SSE2) && defined(__GNUC__)
+   #define WHEEL_UTF8_AVX2
+   #include <immintrin.h>
+#endif
+
+namespace wheel
+{
+   namespace utf8_simd
+   {
+      static const uint32_t replacement_char = 0xfffd;
+
+      //! Length of a UTF-8 sequence from its lead byte, 0 if it is not a valid lead byte.
+      inline size_t sequence_length(uint8_t lead)
+      {
+         if (lead < 0x80)
+            return 1;
+         else if ((lead >> 5) == 0x6)
+            return 2;
+         else if ((lead >> 4) == 0xe)
+            return 3;
+         else if ((lead >> 3) == 0x1e)
+            return 4;
+
+         return 0;
+      }
+
+      inline bool is_trail(uint8_t c)
+      {
+         return (c >> 6) == 0x2;
+      }
+
+#ifdef WHEEL_UTF8_AVX2
+      __attribute__((target("avx2")))
+      inline size_t ascii_run_avx2(const uint8_t* in, size_t n)
+      {
+         size_t i = 0;
+
+         for (; i + 32 <= n; i += 32)
+         {
+            __m256i v = _mm256_loadu_si256((const __m256i*)(in + i));
+            uint32_t mask = _mm256_movemask_epi8(v);
+
+            if (mask != 0)
+               return i + __builtin_ctz(mask);
+         }
+
+         return i;
+      }
+
+      inline bool have_avx2()
+      {
+         static const bool avx2 = __builtin_cpu_supports("avx2");
+         return avx2;
+      }
+#endif
+
+      //! Number of ASCII bytes at the start of in, looking at most n bytes
+      inline size_t ascii_run(const uint8_t* in, size_t n)
+      {
+         size_t i = 0;
+
+#ifdef WHEEL_UTF8_AVX2
+         // Stops at the first non-ASCII byte or the last partial block,
+         // the loops below pick up from there.
+         if (n >= 64 && have_avx2())
+            i = ascii_run_avx2(in, n);
+#endif
+
+#ifdef WHEEL_UTF8_SSE2
+         for (; i + 16 <= n; i += 16)
+         {
+            __m128i v = _mm_loadu_si128((const __m128i*)(in + i));
+            uint32_t mask = _mm_movemask_epi8(v);
+
+            if (mask != 0)
+               return i + __builtin_ctz(mask);
+         }
+#endif
+
+         while (i < n && in[i] < 0x80)
+            ++i;
+
+         return i;
+      }
+
+      //! Copy n ASCII bytes into storage of type T
+      inline void widen_ascii(uint8_t* out, const uint8_t* in, size_t n)
+      {
+         memcpy(out, in, n);
+      }
+
+      inline void widen_ascii(char16_t* out, const uint8_t* in, size_t n)
+      {
+         size_t i = 0;
+
+#ifdef WHEEL_UTF8_SSE2
+         const __m128i zero = _mm_setzero_si128();
+
+         for (; i + 16 <= n; i += 16)
+         {
+            __m128i v = _mm_loadu_si128((const __m128i*)(in + i));
+            _mm_storeu_si128((__m128i*)(out + i), _mm_unpacklo_epi8(v, zero));
+            _mm_storeu_si128((__m128i*)(out + i + 8), _mm_unpackhi_epi8(v, zero));
+         }
+#endif
+
+         for (; i < n; ++i)
+            out[i] = in[i];
+      }
+
+      inline void widen_ascii(char32_t* out, const uint8_t* in, size_t n)
+      {
+         size_t i = 0;
+
+#ifdef WHEEL_UTF8_SSE2
+         const __m128i zero = _mm_setzero_si128();
+
+         for (; i + 16 <= n; i += 16)
+         {
+            __m128i v = _mm_loadu_si128((const __m128i*)(in + i));
+            __m128i lo = _mm_unpacklo_epi8(v, zero);
+            __m128i hi = _mm_unpackhi_epi8(v, zero);
+
+            _mm_storeu_si128((__m128i*)(out + i), _mm_unpacklo_epi16(lo, zero));
+            _mm_storeu_si128((__m128i*)(out + i + 4), _mm_unpackhi_epi16(lo, zero));
+            _mm_storeu_si128((__m128i*)(out + i + 8), _mm_unpacklo_epi16(hi, zero));
+            _mm_storeu_si128((__m128i*)(out + i + 12), _mm_unpackhi_epi16(hi, zero));
+         }
+#endif
+
+         for (; i < n; ++i)
+            out[i] = in[i];
+      }
+
+      //! Decode one non-ASCII sequence
+      /*!
+         Advances in past the sequence and returns the character, or
+         U+FFFD if the sequence is invalid.  Invalid sequences are skipped
+         the same way utf8::replace_invalid() skips them, except that a
+         sequence cut short by the end of the input is one U+FFFD, not one
+         for the lead byte and one for each trail byte.
+      */
+      inline uint32_t decode_sequence(const uint8_t*& in, const uint8_t* end)
+      {
+         const uint8_t* start = in;
+         size_t length = sequence_length(*in);
+
+         if (length == 0)
+         {
+            ++in;
+            return replacement_char;
+         }
+
+         uint32_t cp = *in;
+
+         for (size_t i = 1; i < length; ++i)
+         {
+            // Truncated sequence, everything left is part of it and is
+            // replaced with one character.
+            if (start + i == end)
+            {
+               in = end;
+               return replacement_char;
+            }
+
+            if (!is_trail(start[i]))
+            {
+               in = start + 1;
+               while (in != end && is_trail(*in))
+                  ++in;
+
+               return replacement_char;
+            }
+
+            cp = (cp << 6) | (start[i] & 0x3f);
+         }
+
+         // Strip the length marker bits of the lead byte
+         if (length == 2)
+            cp &= 0x7ff;
+         else if (length == 3)
+            cp &= 0xffff;
+         else
+            cp &= 0x1fffff;
+
+         bool valid = (cp <= 0x10ffff) && ((cp < 0xd800) || (cp > 0xdfff));
+         bool overlong = (length == 2 && cp < 0x80)
+                      || (length == 3 && cp < 0x800)
+                      || (length == 4 && cp < 0x10000);
+
+         if (!valid || overlong)
+         {
+            in = start + 1;
+            while (in != end && is_trail(*in))
+               ++in;
+
+            return replacement_char;
+         }
+
+         in = start + length;
+         return cp;
+      }
+
+      //! Decode UTF-8 into storage of type T
+      /*!
+         Decodes from in until end, or until a character that does not fit
+         in T is found.  That character is returned in overflow and in is left
+         just past it, so the caller can widen its storage and continue.
+
+         \param   in       Input position, advanced past everything consumed
+         \param   end      End of the input
+         \param   out      Output storage, must have room for (end - in) characters
+         \param   overflow Set to the first character that does not fit in T
+
+         \return  Number of characters written to out
+      */
+      template <typename T>
+      size_t decode(const uint8_t*& in, const uint8_t* end, T* out, uint32_t& overflow)
+      {
+         const uint32_t limit = (uint32_t)(T)~0;
+
+         T* const out_start = out;
+
+         while (in != end)
+         {
+            if (*in < 0x80)
+            {
+               size_t run = ascii_run(in, end - in);
+
+               widen_ascii(out, in, run);
+               out += run;
+               in += run;
+
+               continue;
+            }
+
+            uint32_t cp = decode_sequence(in, end);
+
+            if (cp > limit)
+            {
+               overflow = cp;
+               return out - out_start;
+            }
+
+            *out++ = cp;
+         }
+
+         overflow = 0;
+         return out - out_start;
+      }
+
+      //! Number of bytes the characters take when encoded as UTF-8
+      inline size_t encoded_length(const uint8_t* in, size_t n)
+      {
+         size_t rval = n;
+         size_t i = 0;
+
+#ifdef WHEEL_UTF8_SSE2
+         // Latin-1 characters above 0x7f take two bytes, count the high bits.
+         for (; i + 16 <= n; i += 16)
+         {
+            __m128i v = _mm_loadu_si128((const __m128i*)(in + i));
+            rval += __builtin_popcount(_mm_movemask_epi8(v));
+         }
+#endif
+
+         for (; i < n; ++i)
+            rval += in[i] >> 7;
+
+         return rval;
+      }
+
+      template <typename T>
+      inline size_t encoded_length(const T* in, size_t n)
+      {
+         size_t rval = n;
+
+         for (size_t i = 0; i < n; ++i)
+         {
+            uint32_t c = in[i];
+            rval += (c >= 0x80) + (c >= 0x800) + (c >= 0x10000);
+         }
+
+         return rval;
+      }
+
+      //! Encode a single character, returns the number of bytes written
+      inline size_t encode_char(uint32_t c, char* out)
+      {
+         if (c < 0x80)
+         {
+            out[0] = c;
+            return 1;
+         } else if (c < 0x800) {
+            out[0] = 0xc0 | (c >> 6);
+            out[1] = 0x80 | (c & 0x3f);
+            return 2;
+         } else if (c < 0x10000) {
+            out[0] = 0xe0 | (c >> 12);
+            out[1] = 0x80 | ((c >> 6) & 0x3f);
+            out[2] = 0x80 | (c & 0x3f);
+            return 3;
+         }
+
+         out[0] = 0xf0 | (c >> 18);
+         out[1] = 0x80 | ((c >> 12) & 0x3f);
+         out[2] = 0x80 | ((c >> 6) & 0x3f);
+         out[3] = 0x80 | (c & 0x3f);
+         return 4;
+      }
+
+#ifdef WHEEL_UTF8_SSE2
+      //! Pack a block of ASCII characters to bytes, false if the block is not all ASCII
+      inline bool pack_ascii(const uint8_t* in, char* out)
+      {
+         __m128i v = _mm_loadu_si128((const __m128i*)in);
+
+         if (_mm_movemask_epi8(v) != 0)
+            return false;
+
+         _mm_storeu_si128((__m128i*)out, v);
+         return true;
+      }
+
+      inline bool pack_ascii(const char16_t* in, char* out)
+      {
+         const __m128i high = _mm_set1_epi16((short)0xff80);
+
+         __m128i a = _mm_loadu_si128((const __m128i*)in);
+         __m128i b = _mm_loadu_si128((const __m128i*)(in + 8));
+
+         __m128i bits = _mm_and_si128(_mm_or_si128(a, b), high);
+
+         if (_mm_movemask_epi8(_mm_cmpeq_epi16(bits, _mm_setzero_si128())) != 0xffff)
+            return false;
+
+         _mm_storeu_si128((__m128i*)out, _mm_packus_epi16(a, b));
+         return true;
+      }
+
+      inline bool pack_ascii(const char32_t* in, char* out)
+      {
+         const __m128i high = _mm_set1_epi32((int)0xffffff80);
+
+         __m128i a = _mm_loadu_si128((const __m128i*)in);
+         __m128i b = _mm_loadu_si128((const __m128i*)(in + 4));
+         __m128i c = _mm_loadu_si128((const __m128i*)(in + 8));
+         __m128i d = _mm_loadu_si128((const __m128i*)(in + 12));
+
+         __m128i bits = _mm_and_si128(_mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d)), high);
+
+         if (_mm_movemask_epi8(_mm_cmpeq_epi32(bits, _mm_setzero_si128())) != 0xffff)
+            return false;
+
+         __m128i lo = _mm_packs_epi32(a, b);
+         __m128i hi = _mm_packs_epi32(c, d);
+
+         _mm_storeu_si128((__m128i*)out, _mm_packus_epi16(lo, hi));
+         return true;
+      }
+#endif
+
+      //! Encode characters as UTF-8
+      /*!
+         out must have room for encoded_length(in, n) bytes.
+
+         \return Number of bytes written.
+      */
+      template <typename T>
+      size_t encode(const T* in, size_t n, char* out)
+      {
+         char* const out_start = out;
+         size_t i = 0;
+
+         while (i < n)
+         {
+#ifdef WHEEL_UTF8_SSE2
+            if (in[i] < 0x80 && i + 16 <= n && pack_ascii(in + i, out))
+            {
+               i += 16;
+               out += 16;
+               continue;
+            }
+#endif
+            out += encode_char(in[i++], out);
+         }
+
+         return out - out_start;
+      }
+   }
+}
+
+#endif //WHEEL_UTF8_SIMD_HEADER
@@ -0,0 +1,31 @@
+/*!
+   @file
+   \brief Contains the checks used by the unit tests
+   \author Jari Ronkainen
+*/
+
+#ifndef WHEEL_TEST_HEADER
+#define WHEEL_TEST_HEADER
+
+#include <cstdio>
+
+namespace wheel_test
+{
+   static int failures = 0;
+}
+
+//! Report a failed condition and carry on with the rest of the test
+#define WHEEL_CHECK(cond)                                                        \
+   do                                                                            \
+   {                                                                             \
+      if (!(cond))                                                               \
+      {                                                                          \
+         printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond);         \
+         ++wheel_test::failures;                                                 \
+      }                                                                          \
+   } while (0)
+
+//! Exit code of a test, nonzero if any check failed
+#define WHEEL_TEST_RESULT() (wheel_test::failures == 0 ? 0 : 1)
+
+#endif //WHEEL_TEST_HEADER
@@ -0,0 +1,279 @@
+#include "test.h"
+
+#include <wheel_core_archive.h>
+
+#include <string>
+#include <vector>
+
+// Saves records of every supported field type and loads them back, checks
+// the varint encoding byte by byte, and that old and new versions of a
+// record read each other.  Truncated and corrupted input must fail without
+// reading past the end.
+
+namespace
+{
+   enum class color_t : uint16_t { red = 1, blue = 300 };
+
+   struct inner_t
+   {
+      int16_t        a;
+      std::string    s;
+
+      WHEEL_SERIALIZE(a, s)
+   };
+
+   struct v1_t
+   {
+      uint32_t       id;
+      wheel::string  name;
+
+      WHEEL_SERIALIZE_VERSION(1, id, name)
+   };
+
+   struct v2_t
+   {
+      uint32_t             id;
+      wheel::string        name;
+      std::vector<inner_t> extra;
+      uint64_t             big = 77;
+
+      WHEEL_SERIALIZE_VERSION(2, id, name, wheel::since(2, extra), wheel::since(2, big))
+   };
+
+   struct all_t
+   {
+      bool                    b;
+      char                    c;
+      uint8_t                 u8;
+      int8_t                  i8;
+      uint16_t                u16;
+      int32_t                 i32;
+      int64_t                 i64;
+      uint64_t                u64;
+      float                   f;
+      double                  d;
+      color_t                 color;
+      wheel::string           ws;
+      std::string             ss;
+      wheel::buffer_t         buffer;
+      std::vector<int32_t>    vi;
+      std::vector<bool>       flags;
+      std::vector<uint8_t>    bytes;
+      int                     array[3];
+      std::pair<uint32_t, std::string> pair;
+      std::vector<inner_t>    records;
+      v2_t                    nested;
+
+      WHEEL_SERIALIZE(b, c, u8, i8, u16, i32, i64, u64, f, d, color, ws, ss, buffer, vi, flags, bytes, array, pair, records, nested)
+   };
+
+   uint32_t state = 0x68e31da4;
+
+   uint32_t next_random()
+   {
+      state ^= state << 13;
+      state ^= state >> 17;
+      state ^= state << 5;
+
+      return state;
+   }
+
+   all_t sample()
+   {
+      all_t x;
+
+      x.b = true;
+      x.c = 'q';
+      x.u8 = 200;
+      x.i8 = -5;
+      x.u16 = 65535;
+      x.i32 = -123456;
+      x.i64 = INT64_MIN;
+      x.u64 = UINT64_MAX;
+      x.f = 1.5f;
+      x.d = -2.25;
+      x.color = color_t::blue;
+      x.ws = wheel::string(U"h\u00e4llo \u4e2d");
+      x.ss = "std";
+      x.buffer.push_back(1);
+      x.buffer.push_back(2);
+      x.vi = { -1, 0, 1, 1 << 30 };
+      x.flags = { true, false, false, true, true };
+      x.bytes = { 0, 255, 7 };
+      x.array[0] = 1;
+      x.array[1] = -2;
+      x.array[2] = 3;
+      x.pair = std::make_pair(9u, std::string("p"));
+      x.records = { inner_t { 1, "a" }, inner_t { -300, std::string(200, 'z') } };
+      x.nested.id = 5;
+      x.nested.name = "nested";
+      x.nested.extra = x.records;
+      x.nested.big = 1ull << 40;
+
+      return x;
+   }
+
+   void check_round_trip()
+   {
+      all_t x = sample();
+      wheel::buffer_t out;
+      wheel::archive::save(x, out);
+
+      all_t y {};
+      WHEEL_CHECK(wheel::archive::load(y, out) == WHEEL_OK);
+
+      WHEEL_CHECK(y.b && y.c == 'q' && y.u8 == 200 && y.i8 == -5 && y.u16 == 65535);
+      WHEEL_CHECK(y.i32 == -123456 && y.i64 == INT64_MIN && y.u64 == UINT64_MAX);
+      WHEEL_CHECK(y.f == 1.5f && y.d == -2.25 && y.color == color_t::blue);
+      WHEEL_CHECK(y.ws == x.ws && y.ss == "std" && y.buffer == x.buffer && y.vi == x.vi);
+      WHEEL_CHECK(y.flags == x.flags && y.bytes == x.bytes);
+      WHEEL_CHECK(y.array[0] == 1 && y.array[1] == -2 && y.array[2] == 3);
+      WHEEL_CHECK(y.pair.first == 9 && y.pair.second == "p");
+      WHEEL_CHECK(y.records.size() == 2 && y.records[1].a == -300 && y.records[1].s == x.records[1].s);
+      WHEEL_CHECK(y.nested.id == 5 && y.nested.name == x.nested.name);
+      WHEEL_CHECK(y.nested.extra.size() == 2 && y.nested.big == (1ull << 40));
+
+      // Every shorter input fails
+      for (size_t length = 0; length < out.size(); ++length)
+      {
+         all_t z {};
+         WHEEL_CHECK(wheel::archive::load(z, wheel::buffer_view(out.data(), length)) != WHEEL_OK);
+      }
+
+      // Corrupted input may load or fail, but stays inside the buffer
+      for (int i = 0; i < 5000; ++i)
+      {
+         wheel::buffer_t corrupted = out;
+
+         for (int k = 0; k < 4; ++k)
+            corrupted[next_random() % corrupted.size()] = (uint8_t)next_random();
+
+         all_t z {};
+         wheel::archive::load(z, corrupted);
+      }
+   }
+
+   void check_versions()
+   {
+      v2_t current;
+      current.id = 5;
+      current.name = "new";
+      current.extra = { inner_t { 7, "e" } };
+
+      wheel::buffer_t newer;
+      wheel::archive::save(current, newer);
+
+      // Old code skips the fields it does not know
+      v1_t old {};
+      WHEEL_CHECK(wheel::archive::load(old, newer) == WHEEL_OK);
+      WHEEL_CHECK(old.id == 5 && old.name == wheel::string("new"));
+
+      // New code leaves the fields the old data does not have as they were
+      v1_t previous;
+      previous.id = 3;
+      previous.name = "old";
+
+      wheel::buffer_t older;
+      wheel::archive::save(previous, older);
+
+      v2_t loaded;
+      loaded.big = 99;
+
+      WHEEL_CHECK(wheel::archive::load(loaded, older) == WHEEL_OK);
+      WHEEL_CHECK(loaded.id == 3 && loaded.name == wheel::string("old"));
+      WHEEL_CHECK(loaded.extra.empty() && loaded.big == 99);
+
+      // A record longer than a one byte length
+      v2_t long_record;
+      long_record.id = 1;
+      long_record.name = wheel::string(std::string(1000, 'x'));
+
+      wheel::buffer_t out;
+      wheel::archive::save(long_record, out);
+
+      v2_t back;
+      WHEEL_CHECK(wheel::archive::load(back, out) == WHEEL_OK && back.name == long_record.name);
+   }
+
+   void check_varints()
+   {
+      std::vector<uint64_t> values;
+      std::vector<int64_t> signed_values;
+
+      // Around every power of two
+      for (int k = 0; k < 64; ++k)
+      {
+         for (int d = -2; d <= 2; ++d)
+         {
+            uint64_t v = (1ull << k) + d;
+
+            values.push_back(v);
+            signed_values.push_back((int64_t)v);
+            signed_values.push_back((int64_t)(0 - v));
+         }
+      }
+
+      values.push_back(UINT64_MAX);
+
+      for (uint64_t v : values)
+      {
+         wheel::buffer_t out;
+         wheel::archive::save(v, out);
+
+         // LEB128, seven bits at a time from the lowest
+         std::vector<uint8_t> expected;
+         uint64_t rest = v;
+
+         do
+         {
+            uint8_t byte = rest & 0x7f;
+            rest >>= 7;
+
+            expected.push_back(rest ? byte | 0x80 : byte);
+         } while (rest);
+
+         WHEEL_CHECK(std::vector<uint8_t>(out.begin(), out.end()) == expected);
+
+         uint64_t back = 0;
+         WHEEL_CHECK(wheel::archive::load(back, out) == WHEEL_OK && back == v);
+      }
+
+      wheel::buffer_t out;
+      wheel::archive::save(values, out);
+      wheel::archive::save(signed_values, out);
+
+      std::vector<uint64_t> values_back;
+      std::vector<int64_t> signed_back;
+
+      wheel::archive_reader in(out);
+      in.field(values_back);
+      in.field(signed_back);
+
+      WHEEL_CHECK(in.status() == WHEEL_OK && in.remaining() == 0);
+      WHEEL_CHECK(values_back == values && signed_back == signed_values);
+
+      // Values that do not fit the field, and varints longer than ten bytes
+      wheel::buffer_t wide;
+      wheel::archive::save((uint32_t)70000, wide);
+
+      uint16_t narrow = 7;
+      WHEEL_CHECK(wheel::archive::load(narrow, wide) == WHEEL_OUT_OF_RANGE && narrow == 7);
+
+      wheel::buffer_t overlong;
+
+      for (int i = 0; i < 11; ++i)
+         overlong.push_back(0xff);
+
+      uint64_t u = 0;
+      WHEEL_CHECK(wheel::archive::load(u, overlong) == WHEEL_INVALID_FORMAT);
+   }
+}
+
+int main(void)
+{
+   check_round_trip();
+   check_versions();
+   check_varints();
+
+   return WHEEL_TEST_RESULT();
+}
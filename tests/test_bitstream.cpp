@@ -0,0 +1,162 @@
+#include "test.h"
+
+#include <wheel_core_bitstream.h>
+
+#include <vector>
+
+// Writes random bit fields with bit_writer and reads them back with
+// bit_reader, in both bit orders, into a buffer_t and into fixed memory.
+
+namespace
+{
+   uint64_t state = 0x853c49e6748fea9b;
+
+   uint64_t next_random()
+   {
+      state ^= state << 13;
+      state ^= state >> 7;
+      state ^= state << 17;
+
+      return state;
+   }
+
+   struct field_t
+   {
+      uint64_t value;
+      uint32_t bits;
+   };
+
+   template <wheel::bit_order_t Order>
+   void round_trip(bool fixed)
+   {
+      std::vector<field_t> fields;
+      size_t total = 0;
+
+      // Widths from 0 to 56, the most a single read takes
+      for (int i = 0; i < 5000; ++i)
+      {
+         uint32_t bits = next_random() % 57;
+         uint64_t value = bits ? next_random() >> (64 - bits) : 0;
+
+         fields.push_back(field_t { value, bits });
+         total += bits;
+      }
+
+      size_t bytes = (total + 7) / 8;
+
+      // A byte in front shows that the writer appends
+      wheel::buffer_t buffer;
+      buffer.push_back(0xab);
+
+      std::vector<uint8_t> memory(bytes);
+
+      if (fixed)
+      {
+         wheel::bit_writer<Order> out(memory.data(), memory.size());
+
+         for (const field_t& f : fields)
+            out.write(f.value, f.bits);
+
+         out.flush();
+
+         WHEEL_CHECK(!out.overflow());
+         WHEEL_CHECK(out.bit_position() == bytes * 8);
+      } else {
+         wheel::bit_writer<Order> out(buffer);
+
+         for (const field_t& f : fields)
+            out.write(f.value, f.bits);
+
+         out.flush();
+
+         WHEEL_CHECK(buffer.size() == 1 + bytes);
+         WHEEL_CHECK(buffer[0] == 0xab);
+      }
+
+      wheel::bit_reader<Order> in = fixed ? wheel::bit_reader<Order>(memory.data(), memory.size())
+                                          : wheel::bit_reader<Order>(wheel::buffer_view(buffer).subview(1));
+      size_t position = 0;
+
+      for (const field_t& f : fields)
+      {
+         // Refilling early must not change what is read
+         if (next_random() & 1)
+            in.refill();
+
+         WHEEL_CHECK(in.bit_position() == position);
+         WHEEL_CHECK(in.read(f.bits) == f.value);
+
+         position += f.bits;
+      }
+
+      WHEEL_CHECK(!in.overrun());
+      WHEEL_CHECK(in.bits_left() == bytes * 8 - total);
+
+      in.align_to_byte();
+      WHEEL_CHECK(in.bits_left() == 0 && !in.overrun());
+
+      // Reading past the end gives zeros and is noticed
+      WHEEL_CHECK(in.read(1) == 0);
+      WHEEL_CHECK(in.overrun());
+   }
+}
+
+int main(void)
+{
+   for (int round = 0; round < 10; ++round)
+   {
+      round_trip<wheel::WHEEL_LSB_FIRST>(false);
+      round_trip<wheel::WHEEL_LSB_FIRST>(true);
+      round_trip<wheel::WHEEL_MSB_FIRST>(false);
+      round_trip<wheel::WHEEL_MSB_FIRST>(true);
+   }
+
+   // 1, 0 and 101 in each order
+   {
+      wheel::buffer_t out;
+      wheel::bit_writer<wheel::WHEEL_MSB_FIRST> bits(out);
+
+      bits.write(1, 1);
+      bits.write(0, 1);
+      bits.write(5, 3);
+      bits.flush();
+
+      WHEEL_CHECK(out.size() == 1 && out[0] == 0xa8);
+   }
+
+   {
+      wheel::buffer_t out;
+      wheel::bit_writer<wheel::WHEEL_LSB_FIRST> bits(out);
+
+      bits.write(1, 1);
+      bits.write(0, 1);
+      bits.write(5, 3);
+      bits.flush();
+
+      WHEEL_CHECK(out.size() == 1 && out[0] == 0x15);
+   }
+
+   // A fixed writer stops at its end
+   {
+      uint8_t memory[3] = { 0, 0, 0 };
+      wheel::bit_writer<wheel::WHEEL_LSB_FIRST> bits(memory, 2);
+
+      bits.write(0xfff, 12);
+      WHEEL_CHECK(!bits.overflow());
+
+      bits.write(0xff, 8);
+      WHEEL_CHECK(bits.overflow());
+      WHEEL_CHECK(memory[2] == 0);
+   }
+
+   {
+      const uint8_t memory[2] = { 0x12, 0x34 };
+      wheel::bit_reader<wheel::WHEEL_MSB_FIRST> bits(memory, 2);
+
+      WHEEL_CHECK(bits.peek(12) == 0x123);
+      WHEEL_CHECK(bits.read(16) == 0x1234);
+      WHEEL_CHECK(!bits.overrun());
+   }
+
+   return WHEEL_TEST_RESULT();
+}
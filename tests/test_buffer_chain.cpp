@@ -0,0 +1,205 @@
+#include "test.h"
+
+#include <wheel_core_buffer_chain.h>
+
+#include <vector>
+
+// Splits data into chains of random segments and reads it back with
+// gather(), flatten() and chain_cursor, including values that straddle
+// segments and reads past the end.
+
+namespace
+{
+   uint32_t state = 0x2545f491;
+
+   uint32_t next_random()
+   {
+      state ^= state << 13;
+      state ^= state >> 17;
+      state ^= state << 5;
+
+      return state;
+   }
+
+   // Views to data, cut at random, some of them empty
+   void split(const std::vector<uint8_t>& data, wheel::buffer_chain& chain)
+   {
+      size_t offset = 0;
+
+      while (offset < data.size())
+      {
+         size_t n = std::min<size_t>(next_random() % 9, data.size() - offset);
+
+         chain.append(wheel::buffer_view(data.data() + offset, n));
+         offset += n;
+      }
+   }
+
+   void check_random()
+   {
+      std::vector<uint8_t> data(next_random() % 300);
+
+      for (uint8_t& byte : data)
+         byte = (uint8_t)next_random();
+
+      wheel::buffer_chain chain;
+      split(data, chain);
+
+      WHEEL_CHECK(chain.size() == data.size());
+
+      for (const wheel::buffer_view& segment : chain)
+         WHEEL_CHECK(!segment.empty());
+
+      wheel::buffer_t scratch;
+      wheel::buffer_view flat = chain.flatten(scratch);
+      WHEEL_CHECK(flat.equals(data.data(), data.size()));
+
+      size_t offset = data.empty() ? 0 : next_random() % data.size();
+      std::vector<uint8_t> gathered(data.size());
+
+      WHEEL_CHECK(chain.gather(offset, gathered.data(), gathered.size()) == data.size() - offset);
+      WHEEL_CHECK(std::equal(data.begin() + offset, data.end(), gathered.begin()));
+
+      // Mixed reads, compared with a byte_cursor over the same data
+      wheel::chain_cursor cursor(chain);
+      wheel::byte_cursor expected(wheel::buffer_view(data.data(), data.size()));
+
+      while (cursor.remaining())
+      {
+         WHEEL_CHECK(cursor.pos() == expected.pos());
+
+         switch (next_random() % 5)
+         {
+            case 0:
+               WHEEL_CHECK(cursor.read_be<uint32_t>() == expected.read_be<uint32_t>());
+               break;
+
+            case 1:
+               WHEEL_CHECK(cursor.read_le<uint64_t>() == expected.read_le<uint64_t>());
+               break;
+
+            case 2:
+               WHEEL_CHECK(cursor.read_be<uint16_t>() == expected.read_be<uint16_t>());
+               break;
+
+            case 3:
+            {
+               size_t n = next_random() % 12;
+               wheel::buffer_view view, reference;
+
+               WHEEL_CHECK(cursor.take(n, view, scratch) == expected.take(n, reference));
+
+               if (reference.size() == n)
+                  WHEEL_CHECK(view.equals(reference.data(), n));
+
+               break;
+            }
+
+            default:
+            {
+               size_t n = next_random() % 12;
+               wheel::buffer_chain part;
+
+               bool taken = cursor.take(n, part);
+               WHEEL_CHECK(taken == expected.can_read(n));
+
+               if (taken)
+               {
+                  wheel::buffer_t copy;
+                  WHEEL_CHECK(part.size() == n && part.flatten(copy).equals(expected.rest().data(), n));
+                  expected.skip(n);
+               }
+
+               break;
+            }
+         }
+
+         WHEEL_CHECK(cursor.failed() == expected.failed());
+      }
+
+      WHEEL_CHECK(expected.remaining() == 0);
+   }
+}
+
+int main(void)
+{
+   for (int round = 0; round < 2000; ++round)
+      check_random();
+
+   const uint8_t a[] = { 1, 2, 3, 4, 5 };
+   const uint8_t b[] = { 6, 7, 8 };
+   const uint8_t c[] = { 9, 10, 11, 12, 13, 14 };
+
+   wheel::buffer_chain chain;
+   chain.append(wheel::buffer_view(a, sizeof(a)));
+   chain.append(wheel::buffer_view(b, 0));
+   chain.append(wheel::buffer_view(b, sizeof(b)));
+
+   wheel::buffer_t owned;
+   owned.append(c, sizeof(c));
+   chain.append(std::move(owned));
+
+   // Empty segments are dropped
+   WHEEL_CHECK(chain.size() == 14 && chain.segment_count() == 3);
+
+   // One segment is not copied, several are
+   wheel::buffer_t scratch;
+   wheel::buffer_view flat = chain.flatten(scratch);
+   WHEEL_CHECK(flat.size() == 14 && flat.data() == scratch.data() && flat[13] == 14);
+
+   wheel::buffer_chain single;
+   single.append(wheel::buffer_view(a, sizeof(a)));
+   WHEEL_CHECK(single.flatten(scratch).data() == a);
+
+   // Values straddling segments
+   wheel::chain_cursor cursor(chain);
+   WHEEL_CHECK(cursor.read_be<uint32_t>() == 0x01020304);
+   WHEEL_CHECK(cursor.read_le<uint32_t>() == 0x08070605);
+
+   // take() copies only when it has to
+   wheel::buffer_view view;
+   WHEEL_CHECK(cursor.take(3, view, scratch) && view.data() == chain.segment(2).data());
+   WHEEL_CHECK(!cursor.take(4, view, scratch) && cursor.remaining() == 3);
+
+   // A short read ends the cursor
+   WHEEL_CHECK(cursor.read_be<uint32_t>() == 0);
+   WHEEL_CHECK(cursor.failed() && cursor.remaining() == 0);
+
+   wheel::chain_cursor straddle(chain);
+   WHEEL_CHECK(straddle.skip(4) && straddle.take(2, view, scratch));
+   WHEEL_CHECK(view.data() == scratch.data() && view[0] == 5 && view[1] == 6);
+
+   wheel::buffer_chain part;
+   wheel::chain_cursor sub(chain);
+   WHEEL_CHECK(sub.skip(4) && sub.take(8, part));
+   WHEEL_CHECK(part.size() == 8 && part.segment_count() == 3);
+
+   uint8_t tail[2];
+   WHEEL_CHECK(sub.read(tail, 2) && tail[1] == 14 && !sub.read(tail, 1));
+   WHEEL_CHECK(!sub.failed());
+
+   // Appending a chain to itself doubles it
+   wheel::buffer_chain doubled;
+   doubled.append(wheel::buffer_view(a, 3));
+   doubled.append(wheel::buffer_view(b, 2));
+
+   for (int i = 0; i < 3; ++i)
+      doubled.append(doubled);
+
+   WHEEL_CHECK(doubled.size() == 40 && doubled.segment_count() == 16);
+
+   wheel::chain_cursor repeated(doubled);
+   WHEEL_CHECK(repeated.skip(1) && repeated.read_be<uint32_t>() == 0x02030607);
+   WHEEL_CHECK(repeated.skip(33) && repeated.read_be<uint32_t>() == 0);
+   WHEEL_CHECK(repeated.failed() && repeated.pos() == 40);
+
+   // Moving keeps the owned storage in place
+   const uint8_t* storage = chain.segment(2).data();
+   wheel::buffer_chain moved(std::move(chain));
+   WHEEL_CHECK(moved.segment(2).data() == storage && moved.size() == 14);
+
+   moved.clear();
+   WHEEL_CHECK(moved.empty() && moved.segment_count() == 0);
+
+   return WHEEL_TEST_RESULT();
+}
@@ -0,0 +1,120 @@
+#include "test.h"
+
+#include <wheel_core_buffer_pool.h>
+#include <wheel_core_event.h>
+
+#include <thread>
+#include <vector>
+
+// Acquires and releases buffers on one thread and on many, and checks
+// that storage is handed back out of the pool instead of allocated again.
+
+int main(void)
+{
+   wheel::buffer_pool::trim();
+
+   wheel::buffer_t a = wheel::buffer_pool::acquire(100);
+   WHEEL_CHECK(a.capacity() >= 100 && a.empty());
+
+   const uint8_t* storage = a.data();
+   a.push_back(1);
+
+   wheel::buffer_pool::release(std::move(a));
+   WHEEL_CHECK(a.capacity() == 0);
+
+   // The same size class gives the same storage back, emptied
+   wheel::buffer_t b = wheel::buffer_pool::acquire(128);
+   WHEEL_CHECK(b.data() == storage && b.empty() && b.capacity() >= 128);
+
+   wheel::buffer_pool_stats_t stats = wheel::buffer_pool::stats();
+   WHEEL_CHECK(stats.thread_hits == 1 && stats.misses == 1 && stats.released == 1);
+
+   wheel::buffer_pool::release(std::move(b));
+
+   // ...and a larger one does not
+   wheel::buffer_t c = wheel::buffer_pool::acquire(129);
+   WHEEL_CHECK(c.data() != storage && c.capacity() >= 129);
+   wheel::buffer_pool::release(std::move(c));
+
+   // Buffers too small or too large to keep are freed
+   wheel::buffer_t tiny;
+   tiny.reserve(4);
+   wheel::buffer_pool::release(std::move(tiny));
+   WHEEL_CHECK(wheel::buffer_pool::stats().dropped == 1);
+
+   wheel::buffer_t huge = wheel::buffer_pool::acquire(40u << 20);
+   WHEEL_CHECK(huge.capacity() >= (40u << 20));
+   wheel::buffer_pool::release(std::move(huge));
+   WHEEL_CHECK(wheel::buffer_pool::stats().dropped == 2);
+
+   // What the thread cache cannot hold goes to the shared pool...
+   std::vector<wheel::buffer_t> many;
+
+   for (int i = 0; i < 20; ++i)
+      many.push_back(wheel::buffer_pool::acquire(40000));
+
+   for (wheel::buffer_t& buffer : many)
+      wheel::buffer_pool::release(std::move(buffer));
+
+   WHEEL_CHECK(wheel::buffer_pool::stats().shared_bytes > 0);
+
+   // ...where other threads find it
+   std::thread other([]
+   {
+      for (int i = 0; i < 12; ++i)
+      {
+         wheel::buffer_t buffer = wheel::buffer_pool::acquire(40000);
+         wheel::buffer_pool::release(std::move(buffer));
+      }
+   });
+
+   other.join();
+   WHEEL_CHECK(wheel::buffer_pool::stats().shared_hits >= 1);
+
+   // Threads acquiring, resizing and releasing at once
+   std::vector<std::thread> threads;
+
+   for (int n = 0; n < 4; ++n)
+   {
+      threads.emplace_back([n]
+      {
+         std::vector<wheel::buffer_t> held;
+
+         for (int i = 0; i < 20000; ++i)
+         {
+            held.push_back(wheel::buffer_pool::acquire((i * 37 + n) % 70000));
+            held.back().resize(held.back().capacity() / 2 + 1, 7);
+
+            if (held.size() > 16)
+            {
+               wheel::buffer_pool::release(std::move(held[i % 16]));
+               held[i % 16].swap(held.back());
+               held.pop_back();
+            }
+         }
+      });
+   }
+
+   for (std::thread& t : threads)
+      t.join();
+
+   {
+      wheel::pooled_buffer pooled(300);
+      pooled->push_back(3);
+
+      WHEEL_CHECK((*pooled)[0] == 3 && pooled->capacity() >= 300);
+   }
+
+   // Events keep their data in pooled buffers
+   wheel::Event e = wheel::describe_event(1, 2, 3);
+   wheel::Event copy = e;
+   WHEEL_CHECK(copy.data == e.data);
+
+   wheel::Event moved(std::move(copy));
+   WHEEL_CHECK(moved.data.size() == 3 && copy.data.empty());
+
+   wheel::buffer_pool::trim();
+   WHEEL_CHECK(wheel::buffer_pool::stats().shared_bytes == 0);
+
+   return WHEEL_TEST_RESULT();
+}
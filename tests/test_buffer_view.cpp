@@ -0,0 +1,81 @@
+#include "test.h"
+
+#include <wheel_core_buffer_view.h>
+#include <wheel_core_utility.h>
+
+// Reads through buffer_view, byte_cursor and buffer_t, in both byte
+// orders, and at the edges of the data.
+
+int main(void)
+{
+   const uint8_t bytes[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+
+   wheel::buffer_view view(bytes, sizeof(bytes));
+
+   WHEEL_CHECK(view.read_be<uint32_t>(1) == 0x02030405);
+   WHEEL_CHECK(view.read_le<uint32_t>(1) == 0x05040302);
+   WHEEL_CHECK(view.read_le<uint16_t>(7) == 0x0908);
+   WHEEL_CHECK(view.read_be<uint64_t>(1) == 0x0203040506070809);
+
+   WHEEL_CHECK(view.has(5, 4) && !view.has(6, 4) && !view.has(10, 0) && view.has(9, 0));
+   WHEEL_CHECK(view.subview(7).size() == 2);
+   WHEEL_CHECK(view.subview(20).empty());
+   WHEEL_CHECK(view.subview(3, 100).size() == 6);
+   WHEEL_CHECK(view.subview(2, 2).equals("\x03\x04", 2));
+
+   // take() and skip() refuse to go past the end and leave the cursor be
+   wheel::byte_cursor cursor(view);
+   wheel::buffer_view part;
+
+   WHEEL_CHECK(cursor.take(4, part) && part.size() == 4 && part[3] == 4);
+   WHEEL_CHECK(cursor.read_be<uint16_t>() == 0x0506);
+   WHEEL_CHECK(!cursor.take(4, part) && cursor.remaining() == 3);
+   WHEEL_CHECK(!cursor.skip(4) && cursor.pos() == 6);
+   WHEEL_CHECK(!cursor.failed());
+
+   // A short read gives 0, ends the cursor and is remembered
+   WHEEL_CHECK(cursor.read_le<uint32_t>() == 0);
+   WHEEL_CHECK(cursor.failed() && cursor.remaining() == 0);
+   WHEEL_CHECK(cursor.read_le<uint8_t>() == 0 && cursor.failed());
+
+   wheel::byte_cursor exact(view.subview(5));
+   WHEEL_CHECK(exact.read_le<uint32_t>() == 0x09080706);
+   WHEEL_CHECK(!exact.failed() && exact.remaining() == 0);
+
+   wheel::byte_cursor moved(view);
+   WHEEL_CHECK(moved.seek(9) && !moved.seek(10) && moved.pos() == 9);
+   WHEEL_CHECK(moved.rest().empty());
+
+   // buffer_t reads, positioned and from the read pointer
+   wheel::buffer_t buffer;
+   buffer.assign(bytes, bytes + sizeof(bytes));
+
+   WHEEL_CHECK(buffer.read<uint16_t>(1) == 0x0302);
+   WHEEL_CHECK(buffer.read_le<uint16_t>(1) == 0x0302);
+   WHEEL_CHECK(buffer.read_be<uint16_t>(1) == 0x0203);
+   WHEEL_CHECK(buffer.read_be<uint32_t>(5) == 0x06070809);
+   WHEEL_CHECK(buffer.read_le_unchecked<uint32_t>(5) == 0x09080706);
+   WHEEL_CHECK(buffer.read_be_unchecked<uint16_t>(0) == 0x0102);
+
+   buffer.seek(0);
+   WHEEL_CHECK(buffer.can_read(9) && !buffer.can_read(10));
+   WHEEL_CHECK(buffer.read<uint8_t>() == 1);
+   WHEEL_CHECK(buffer.read_be<uint32_t>() == 0x02030405);
+   WHEEL_CHECK(buffer.can_read(4) && !buffer.can_read(5));
+
+   size_t location = 1;
+   WHEEL_CHECK(wheel::buffer_read<uint32_t>(buffer, location) == 0x02030405 && location == 5);
+   WHEEL_CHECK(wheel::buffer_read_le<uint16_t>(buffer, location) == 0x0706 && location == 7);
+
+   // Writes read back in the same order
+   wheel::buffer_t written;
+   written.write<uint32_t>(0xdeadbeef);
+   written.write_be<uint16_t>(0x1234);
+
+   WHEEL_CHECK(written.size() == 6);
+   WHEEL_CHECK(written.read<uint32_t>(0) == 0xdeadbeef);
+   WHEEL_CHECK(written.read_be<uint16_t>(4) == 0x1234);
+   WHEEL_CHECK(written[4] == 0x12);
+
+   return WHEEL_TEST_RESULT();
+}
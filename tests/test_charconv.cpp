@@ -0,0 +1,199 @@
+#include "test.h"
+
+#include <wheel_core_charconv.h>
+#include <wheel_core_string.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+// Round trips numbers through to_chars() and from_chars(), and checks that
+// doubles are written with the fewest digits that read back.
+
+namespace
+{
+   uint64_t state = 0x9e3779b97f4a7c15;
+
+   uint64_t next_random()
+   {
+      state ^= state << 13;
+      state ^= state >> 7;
+      state ^= state << 17;
+
+      return state;
+   }
+
+   double from_bits(uint64_t bits)
+   {
+      double rval;
+      memcpy(&rval, &bits, sizeof(rval));
+
+      return rval;
+   }
+
+   wheel::string_ref view(const char* text, size_t length)
+   {
+      return wheel::string_ref(text, 1, length);
+   }
+
+   wheel::string_ref view(const char* text)
+   {
+      return view(text, strlen(text));
+   }
+
+   // Fewest significant digits that read back as value, the slow way
+   int shortest_digits(double value)
+   {
+      char digits[64];
+
+      for (int precision = 1; precision < 17; ++precision)
+      {
+         snprintf(digits, sizeof(digits), "%.*g", precision, value);
+
+         if (strtod(digits, nullptr) == value)
+            return precision;
+      }
+
+      return 17;
+   }
+
+   // Digits from the first to the last nonzero one, "1200" has two
+   int significant_digits(const char* text, size_t length)
+   {
+      int first = -1, last = -1, position = 0;
+
+      for (size_t i = 0; i < length && text[i] != 'e'; ++i)
+      {
+         if (text[i] < '0' || text[i] > '9')
+            continue;
+
+         if (text[i] != '0')
+         {
+            if (first < 0)
+               first = position;
+
+            last = position;
+         }
+
+         ++position;
+      }
+
+      return first < 0 ? 0 : last - first + 1;
+   }
+
+   void check_double(double value)
+   {
+      char buffer[wheel::max_number_chars];
+      wheel::number_result written = wheel::to_chars(buffer, buffer + sizeof(buffer), value);
+
+      WHEEL_CHECK(written.error == WHEEL_OK);
+
+      double back = -1;
+      wheel::number_result read = wheel::from_chars(view(buffer, written.length), back);
+
+      WHEEL_CHECK(read.error == WHEEL_OK);
+      WHEEL_CHECK(read.length == written.length);
+      WHEEL_CHECK(back == value);
+
+      if (value != 0)
+         WHEEL_CHECK(significant_digits(buffer, written.length) == shortest_digits(value));
+   }
+
+   template <typename T>
+   void check_integer(T value)
+   {
+      char buffer[wheel::max_number_chars];
+      wheel::number_result written = wheel::to_chars(buffer, buffer + sizeof(buffer), value);
+
+      T back = 0;
+      wheel::number_result read = wheel::from_chars(view(buffer, written.length), back);
+
+      WHEEL_CHECK(written.error == WHEEL_OK);
+      WHEEL_CHECK(read.error == WHEEL_OK && read.length == written.length);
+      WHEEL_CHECK(back == value);
+   }
+
+   bool writes(double value, const char* expected)
+   {
+      char buffer[wheel::max_number_chars];
+      wheel::number_result written = wheel::to_chars(buffer, buffer + sizeof(buffer), value);
+
+      return written.error == WHEEL_OK && written.length == strlen(expected)
+          && memcmp(buffer, expected, written.length) == 0;
+   }
+}
+
+int main(void)
+{
+   WHEEL_CHECK(writes(0.1, "0.1"));
+   WHEEL_CHECK(writes(1.5, "1.5"));
+   WHEEL_CHECK(writes(100.0, "100"));
+   WHEEL_CHECK(writes(1e300, "1e+300"));
+   WHEEL_CHECK(writes(-0.0, "-0"));
+
+   // Subnormals hold few digits
+   WHEEL_CHECK(writes(5e-324, "5e-324"));
+   WHEEL_CHECK(writes(1e-320, "1e-320"));
+
+   WHEEL_CHECK(writes(std::numeric_limits<double>::infinity(), "inf"));
+   WHEEL_CHECK(writes(-std::numeric_limits<double>::infinity(), "-inf"));
+   WHEEL_CHECK(writes(std::nan(""), "nan"));
+
+   check_double(std::numeric_limits<double>::max());
+   check_double(std::numeric_limits<double>::min());
+   check_double(std::numeric_limits<double>::denorm_min());
+
+   for (int i = 0; i < 100000; ++i)
+   {
+      double value = from_bits(next_random());
+
+      if (!std::isnan(value) && !std::isinf(value))
+         check_double(value);
+
+      // Subnormals, exponent bits all zero
+      check_double(from_bits(next_random() & 0x800fffffffffffff));
+
+      check_integer((int64_t)next_random());
+      check_integer((uint64_t)next_random());
+      check_integer((int32_t)next_random());
+      check_integer((uint32_t)next_random());
+   }
+
+   check_integer(std::numeric_limits<int64_t>::min());
+   check_integer(std::numeric_limits<int32_t>::min());
+   check_integer(std::numeric_limits<uint64_t>::max());
+
+   uint32_t u32 = 0;
+   int32_t i32 = 0;
+   uint64_t u64 = 0;
+   double d = 0;
+
+   WHEEL_CHECK(wheel::from_chars(view("4294967296"), u32).error == WHEEL_OUT_OF_RANGE);
+   WHEEL_CHECK(wheel::from_chars(view("2147483648"), i32).error == WHEEL_OUT_OF_RANGE);
+   WHEEL_CHECK(wheel::from_chars(view("-"), i32).error == WHEEL_INVALID_VALUE);
+   WHEEL_CHECK(wheel::from_chars(view("-5"), u32).error == WHEEL_INVALID_VALUE);
+   WHEEL_CHECK(wheel::from_chars(view("1e999"), d).error == WHEEL_OUT_OF_RANGE);
+   WHEEL_CHECK(wheel::from_chars(view("."), d).error == WHEEL_INVALID_VALUE);
+
+   // Parsing stops at the first character that is not part of the number
+   wheel::number_result partial = wheel::from_chars(view("4294967295x"), u32);
+   WHEEL_CHECK(partial.error == WHEEL_OK && partial.length == 10 && u32 == 4294967295u);
+
+   partial = wheel::from_chars(view(".5e"), d);
+   WHEEL_CHECK(partial.error == WHEEL_OK && partial.length == 2 && d == 0.5);
+
+   WHEEL_CHECK(wheel::from_chars(view("ff"), u64, 16).error == WHEEL_OK && u64 == 255);
+   WHEEL_CHECK(wheel::from_chars(view("0x1F"), u64, 0).error == WHEEL_OK && u64 == 31);
+   WHEEL_CHECK(wheel::from_chars(view("017"), u64, 0).error == WHEEL_OK && u64 == 15);
+
+   // Wider strings are read in place
+   partial = wheel::from_chars(wheel::string_ref(wheel::string(U"-Infinity\u20ac")), d);
+   WHEEL_CHECK(partial.error == WHEEL_OK && partial.length == 9 && std::isinf(d) && d < 0);
+
+   char tiny[2];
+   WHEEL_CHECK(wheel::to_chars(tiny, tiny + 2, (int32_t)123).error == WHEEL_OUT_OF_RANGE);
+
+   return WHEEL_TEST_RESULT();
+}
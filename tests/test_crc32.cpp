@@ -0,0 +1,120 @@
+#include "test.h"
+
+#include <wheel_core_utility.h>
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+// Checks crc32() against known values, every method this CPU supports
+// against the bytewise one at all alignments, and crc32_combine().
+
+namespace
+{
+   uint32_t state = 0x9e3779b9;
+
+   uint32_t next_random()
+   {
+      state ^= state << 13;
+      state ^= state >> 17;
+      state ^= state << 5;
+
+      return state;
+   }
+
+   uint32_t crc(const char* text)
+   {
+      return wheel::crc32((const uint8_t*)text, strlen(text));
+   }
+
+   uint32_t bytewise(const uint8_t* buf, size_t len)
+   {
+      return wheel::internal::update_crc(wheel::internal::WHEEL_CRC32_BYTEWISE, 0xffffffff, buf, len) ^ 0xffffffff;
+   }
+}
+
+int main(void)
+{
+   WHEEL_CHECK(crc("") == 0);
+   WHEEL_CHECK(crc("a") == 0xe8b7be43);
+   WHEEL_CHECK(crc("123456789") == 0xcbf43926);
+   WHEEL_CHECK(crc("The quick brown fox jumps over the lazy dog") == 0x414fa339);
+
+   std::vector<uint8_t> data(70000);
+
+   for (uint8_t& byte : data)
+      byte = (uint8_t)next_random();
+
+   static const wheel::internal::crc32_method_t methods[] =
+   {
+      wheel::internal::WHEEL_CRC32_BYTEWISE,
+      wheel::internal::WHEEL_CRC32_SLICE8,
+      wheel::internal::WHEEL_CRC32_SLICE16,
+      wheel::internal::WHEEL_CRC32_PCLMUL,
+      wheel::internal::WHEEL_CRC32_ARMV8
+   };
+
+   WHEEL_CHECK(wheel::internal::crc32_supported(wheel::internal::WHEEL_CRC32_BYTEWISE));
+
+   // Lengths around the block sizes of each method
+   static const size_t lengths[] = { 0, 1, 3, 7, 8, 15, 16, 17, 63, 64, 65, 79, 80, 127, 128, 129, 200, 1000, 4096, 65537 };
+
+   for (size_t offset = 0; offset < 17; ++offset)
+   {
+      for (size_t length : lengths)
+      {
+         const uint8_t* p = data.data() + offset;
+         uint32_t expected = bytewise(p, length);
+
+         WHEEL_CHECK(wheel::crc32(p, length) == expected);
+
+         for (wheel::internal::crc32_method_t method : methods)
+            if (wheel::internal::crc32_supported(method))
+               WHEEL_CHECK((wheel::internal::update_crc(method, 0xffffffff, p, length) ^ 0xffffffff) == expected);
+      }
+   }
+
+   // Continuing the register over pieces gives the same as all at once
+   uint32_t whole = wheel::crc32(data.data(), data.size());
+   uint32_t reg = 0xffffffff;
+
+   for (size_t offset = 0; offset < data.size(); )
+   {
+      size_t n = std::min<size_t>(next_random() % 3000, data.size() - offset);
+
+      reg = wheel::update_crc(reg, data.data() + offset, n);
+      offset += n;
+   }
+
+   WHEEL_CHECK((reg ^ 0xffffffff) == whole);
+
+   static const size_t first[] = { 0, 1, 100, 5000 };
+   static const size_t second[] = { 0, 1, 7, 999, 60000 };
+
+   for (size_t a : first)
+   {
+      for (size_t b : second)
+      {
+         uint32_t c1 = wheel::crc32(data.data(), a);
+         uint32_t c2 = wheel::crc32(data.data() + a, b);
+
+         WHEEL_CHECK(wheel::crc32_combine(c1, c2, b) == wheel::crc32(data.data(), a + b));
+      }
+   }
+
+   // Several threads at once
+   std::vector<std::thread> threads;
+   std::vector<uint32_t> results(4);
+
+   for (size_t i = 0; i < results.size(); ++i)
+      threads.emplace_back([&data, &results, i] { results[i] = wheel::crc32(data.data(), data.size()); });
+
+   for (std::thread& t : threads)
+      t.join();
+
+   for (uint32_t r : results)
+      WHEEL_CHECK(r == whole);
+
+   return WHEEL_TEST_RESULT();
+}
@@ -0,0 +1,52 @@
+#include "test.h"
+
+#include <wheel_core_event.h>
+
+#include <string>
+
+// Callbacks that map and unmap events while process() is calling them,
+// which grows the event table under the loop.
+
+namespace
+{
+   const uint8_t user_event = 200;
+   const uint8_t added_event = 201;
+}
+
+int main(void)
+{
+   wheel::EventMapping events;
+
+   int calls = 0;
+   int added_calls = 0;
+
+   events.map_event(wheel::describe_event(user_event, 1), "grow", [&](wheel::Event&)
+   {
+      ++calls;
+
+      for (int i = 0; i < 200; ++i)
+      {
+         wheel::string ident(("added " + std::to_string(i)).c_str());
+         events.map_event(wheel::describe_event(added_event, i), ident, [&](wheel::Event&) { ++added_calls; });
+      }
+
+      events.unmap_event("grow");
+   });
+
+   wheel::EventList list;
+   list.push_back(wheel::describe_event(user_event, 1));
+   list.push_back(wheel::describe_event(added_event, 7));
+
+   events.process(list);
+
+   WHEEL_CHECK(calls == 1);
+   WHEEL_CHECK(added_calls == 1);
+
+   // The callback unmapped itself
+   events.process(list);
+
+   WHEEL_CHECK(calls == 1);
+   WHEEL_CHECK(added_calls == 2);
+
+   return WHEEL_TEST_RESULT();
+}
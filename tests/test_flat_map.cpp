@@ -0,0 +1,239 @@
+#include "test.h"
+
+#include <wheel_core_flat_map.h>
+#include <wheel_core_string.h>
+#include <wheel_core_string_ref.h>
+#include <wheel_core_hash.h>
+
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+
+// Runs the same random inserts, finds and erases on a flat_map and an
+// std::unordered_map and checks that they hold the same entries.  Keys
+// are strings long enough to allocate, so every move of an entry is seen.
+
+namespace
+{
+   typedef wheel::flat_map<wheel::string, int, wheel::fast_hash<wheel::string>> name_map;
+
+   static_assert(std::is_same<name_map::value_type, std::pair<const wheel::string, int>>::value,
+                 "keys are const in the entries");
+   static_assert(std::is_same<decltype(name_map().begin()->first), const wheel::string>::value,
+                 "keys cannot be changed through an iterator");
+
+   uint32_t state = 0x6d2b79f5;
+
+   uint32_t next_random()
+   {
+      state ^= state << 13;
+      state ^= state >> 17;
+      state ^= state << 5;
+
+      return state;
+   }
+
+   std::string key_text(uint32_t n)
+   {
+      return "textures/props/a/rather/long/path/crate_" + std::to_string(n) + ".png";
+   }
+
+   size_t next_salt = 1;
+
+   //! Hash that differs between maps, so a map must keep the hash its entries were placed with
+   struct salted_hash
+   {
+      size_t salt;
+
+      salted_hash() : salt(next_salt++ * 0x2545F4914F6CDD1Dull) {}
+      size_t operator()(int key) const { return ((size_t)key * 0x9E3779B97F4A7C15ull) ^ salt; }
+   };
+
+   typedef wheel::flat_map<int, int, salted_hash> salted_map;
+
+   //! Key that can only be moved
+   struct unique_key
+   {
+      std::unique_ptr<int> n;
+
+      explicit unique_key(int k) : n(new int(k)) {}
+
+      bool operator==(const unique_key& other) const { return *n == *other.n; }
+   };
+
+   struct unique_hash
+   {
+      size_t operator()(const unique_key& key) const { return (size_t)*key.n; }
+   };
+
+   bool same_entries(const name_map& map, const std::unordered_map<std::string, int>& expected)
+   {
+      if (map.size() != expected.size())
+         return false;
+
+      size_t visited = 0;
+
+      for (const auto& entry : map)
+      {
+         auto it = expected.find(entry.first.std_str());
+
+         if (it == expected.end() || it->second != entry.second)
+            return false;
+
+         ++visited;
+      }
+
+      return visited == expected.size();
+   }
+}
+
+int main(void)
+{
+   name_map map;
+   std::unordered_map<std::string, int> expected;
+
+   // Few distinct keys, so that inserts, hits and erases mix
+   for (int round = 0; round < 20000; ++round)
+   {
+      uint32_t n = next_random() % 500;
+      std::string text = key_text(n);
+      wheel::string key(text.c_str());
+      int value = (int)next_random();
+
+      switch (next_random() % 5)
+      {
+         case 0:
+         case 1:
+         {
+            auto inserted = map.try_emplace(key, value);
+            auto reference = expected.emplace(text, value);
+
+            WHEEL_CHECK(inserted.second == reference.second);
+            WHEEL_CHECK(inserted.first->second == reference.first->second);
+            break;
+         }
+
+         case 2:
+            map[key] = value;
+            expected[text] = value;
+            break;
+
+         case 3:
+            WHEEL_CHECK(map.erase(key) == expected.erase(text));
+            break;
+
+         default:
+         {
+            // Found by a view, without making a key
+            auto it = map.find(wheel::string_ref(key));
+            auto reference = expected.find(text);
+
+            WHEEL_CHECK((it == map.end()) == (reference == expected.end()));
+
+            if (it != map.end() && reference != expected.end())
+               WHEEL_CHECK(it->second == reference->second);
+
+            break;
+         }
+      }
+
+      if (round % 1000 == 0)
+         WHEEL_CHECK(same_entries(map, expected));
+   }
+
+   WHEEL_CHECK(same_entries(map, expected));
+
+   // Copies and moves keep every entry
+   name_map copy(map);
+   WHEEL_CHECK(same_entries(copy, expected));
+
+   name_map moved(std::move(copy));
+   WHEEL_CHECK(same_entries(moved, expected));
+   WHEEL_CHECK(copy.empty());
+
+   // Erase the odd values, each entry must be seen as it is
+   size_t odd = 0;
+
+   for (auto it = expected.begin(); it != expected.end();)
+   {
+      if (it->second & 1)
+      {
+         it = expected.erase(it);
+         ++odd;
+      } else {
+         ++it;
+      }
+   }
+
+   WHEEL_CHECK(map.erase_if([](const name_map::value_type& entry) { return (entry.second & 1) != 0; }) == odd);
+   WHEEL_CHECK(same_entries(map, expected));
+
+   // Erasing through iterators, one at a time
+   while (!map.empty())
+   {
+      auto it = map.begin();
+
+      WHEEL_CHECK(expected.erase(it->first.std_str()) == 1);
+      map.erase(it);
+   }
+
+   WHEEL_CHECK(expected.empty());
+
+   // Reserved room is used without growing
+   map.reserve(1000);
+   size_t capacity = map.capacity();
+
+   for (uint32_t n = 0; n < 1000; ++n)
+      map.try_emplace(wheel::string(key_text(n).c_str()), (int)n);
+
+   WHEEL_CHECK(map.capacity() == capacity);
+   WHEEL_CHECK(map.size() == 1000);
+
+   map.clear();
+   WHEEL_CHECK(map.empty() && map.find(wheel::string(key_text(5).c_str())) == map.end());
+
+   // Assigning takes the hash of the other map along with its entries
+   salted_map first;
+
+   for (int k = 0; k < 100; ++k)
+      first[k] = -k;
+
+   salted_map assigned;
+   assigned[7] = 7;
+   assigned = first;
+
+   salted_map moved_to;
+   moved_to[7] = 7;
+   moved_to = std::move(first);
+
+   for (int k = 0; k < 100; ++k)
+   {
+      WHEEL_CHECK(assigned.find(k) != assigned.end() && assigned.find(k)->second == -k);
+      WHEEL_CHECK(moved_to.find(k) != moved_to.end() && moved_to.find(k)->second == -k);
+   }
+
+   // The moved-from map has the other hash now, and works with it
+   first[5] = 5;
+   WHEEL_CHECK(first.size() == 1 && first.find(5) != first.end());
+
+   // Keys that cannot be copied are moved as entries shift and the table grows
+   wheel::flat_map<unique_key, int, unique_hash> owners;
+
+   for (int k = 0; k < 200; ++k)
+      owners.try_emplace(unique_key(k * 3), k);
+
+   for (int k = 0; k < 200; k += 2)
+      WHEEL_CHECK(owners.erase(unique_key(k * 3)) == 1);
+
+   for (int k = 0; k < 200; ++k)
+   {
+      auto it = owners.find(unique_key(k * 3));
+      WHEEL_CHECK((it != owners.end()) == ((k & 1) != 0));
+
+      if (it != owners.end())
+         WHEEL_CHECK(*it->first.n == k * 3 && it->second == k);
+   }
+
+   return WHEEL_TEST_RESULT();
+}
@@ -0,0 +1,121 @@
+#include "test.h"
+
+#include <wheel_core_hash.h>
+#include <wheel_core_string.h>
+#include <wheel_core_string_ref.h>
+
+#include <algorithm>
+#include <string>
+
+// Checks the hasher against MurmurHash3 x64 128 reference values, that
+// the fingerprint does not depend on how the input is split, and that wide
+// views hash like the strings they equal.
+
+namespace
+{
+   bool is(const wheel::fingerprint_t& fp, uint64_t low, uint64_t high)
+   {
+      return fp.low == low && fp.high == high;
+   }
+}
+
+int main(void)
+{
+   // Reference values of MurmurHash3_x64_128 with seed 0
+   WHEEL_CHECK(is(wheel::fingerprint("", 0), 0, 0));
+   WHEEL_CHECK(is(wheel::fingerprint("hello", 5), 0xcbd8a7b341bd9b02, 0x5b1e906a48ae1d19));
+   WHEEL_CHECK(is(wheel::fingerprint("The quick brown fox jumps over the lazy dog", 43), 0xe34bbc7bbc071b6c, 0x7a433ca9c49a9347));
+
+   WHEEL_CHECK(wheel::fingerprint("hello", 5, 1) != wheel::fingerprint("hello", 5));
+
+   uint8_t data[1000];
+
+   for (size_t i = 0; i < sizeof(data); ++i)
+      data[i] = (uint8_t)(i * 7 + 3);
+
+   // Split at every block and tail boundary
+   static const size_t lengths[] = { 0, 1, 15, 16, 17, 31, 32, 33, 100, 999, 1000 };
+   static const size_t steps[] = { 1, 3, 7, 16, 17, 64 };
+
+   for (size_t length : lengths)
+   {
+      wheel::fingerprint_t whole = wheel::fingerprint(data, length);
+
+      for (size_t step : steps)
+      {
+         wheel::hasher h;
+
+         for (size_t i = 0; i < length; i += step)
+            h.update(data + i, std::min(step, length - i));
+
+         WHEEL_CHECK(h.finalize() == whole);
+         WHEEL_CHECK(h.finalize64() == whole.value64());
+         WHEEL_CHECK(h.length() == length);
+      }
+   }
+
+   // finalize() leaves the hasher usable, reset() starts over
+   wheel::hasher h;
+   h.update(data, 10);
+   (void)h.finalize();
+   h.update(data + 10, 90);
+   WHEEL_CHECK(h.finalize() == wheel::fingerprint(data, 100));
+
+   h.reset();
+   WHEEL_CHECK(h.length() == 0 && h.finalize() == wheel::fingerprint("", 0));
+
+   // Strings are fed as UTF-8, whatever width they are stored at
+   wheel::hasher s;
+   s.update(wheel::string("h\xc3\xa4"));
+   s.update(wheel::string("st"));
+   WHEEL_CHECK(s.finalize() == wheel::fingerprint("h\xc3\xa4st", 5));
+
+   // ...also when they are too long to encode on the stack
+   std::string utf8;
+
+   for (int i = 0; i < 200; ++i)
+      utf8 += "\xe2\x82\xac";
+
+   s.reset();
+   s.update(wheel::string(utf8.c_str()));
+   WHEEL_CHECK(s.finalize() == wheel::fingerprint(utf8.data(), utf8.size()));
+
+   wheel::buffer_t buffer;
+   buffer.append(data, 100);
+
+   s.reset();
+   s.update(buffer);
+   WHEEL_CHECK(s.finalize() == wheel::fingerprint(data, 100));
+
+   // Views wider than their characters hash like the strings holding them,
+   // at every length wyhash handles differently
+   typedef wheel::hash_with<wheel::string_ref, wheel::fnv1a_policy> fnv1a_ref;
+   typedef wheel::hash_with<wheel::string, wheel::fnv1a_policy> fnv1a_string;
+
+   for (size_t length = 0; length < 130; ++length)
+   {
+      for (char32_t top : { U'\x7f', U'\xff', U'\u4e2d' })
+      {
+         std::u32string wide(length, U'a');
+         std::u16string half(length, u'a');
+
+         for (size_t i = 0; i < length; ++i)
+         {
+            wide[i] = (i == length / 2) ? top : U'a' + (char32_t)(i * 7 % 26);
+            half[i] = (char16_t)wide[i];
+         }
+
+         wheel::string str(wide.c_str());
+         wheel::string_ref views[] = { wheel::string_ref(wide.data(), length), wheel::string_ref(half.data(), 2, length) };
+
+         for (const wheel::string_ref& view : views)
+         {
+            WHEEL_CHECK(fnv1a_ref()(view) == fnv1a_string()(str));
+            WHEEL_CHECK(wheel::fast_hash<wheel::string_ref>()(view) == wheel::fast_hash<wheel::string>()(str));
+            WHEEL_CHECK(view.hash() == str.hash());
+         }
+      }
+   }
+
+   return WHEEL_TEST_RESULT();
+}
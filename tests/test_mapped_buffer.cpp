@@ -0,0 +1,77 @@
+#include "test.h"
+
+#include <wheel_core_mapped_buffer.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+
+// Maps a file and reads it through mapped_buffer, and reads a buffer
+// given to one instead, in both byte orders and up to the last byte.
+
+namespace
+{
+   const uint8_t bytes[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+
+   void check_reads(wheel::mapped_buffer& file)
+   {
+      WHEEL_CHECK(file.size() == sizeof(bytes));
+
+      WHEEL_CHECK(file.read<uint16_t>(1) == 0x0302);
+      WHEEL_CHECK(file.read_le<uint32_t>(5) == 0x09080706);
+      WHEEL_CHECK(file.read_be<uint32_t>(5) == 0x06070809);
+      WHEEL_CHECK(file.read_le_unchecked<uint16_t>(7) == 0x0908);
+      WHEEL_CHECK(file.read_be_unchecked<uint64_t>(1) == 0x0203040506070809);
+
+      // Reads from the read pointer stop at the end
+      file.seek(0);
+      WHEEL_CHECK(file.read<uint8_t>() == 1);
+      WHEEL_CHECK(file.read_be<uint32_t>() == 0x02030405);
+      WHEEL_CHECK(file.read_le<uint32_t>() == 0x09080706);
+      WHEEL_CHECK(file.pos() == sizeof(bytes) && !file.can_read(1) && file.can_read(0));
+
+      file.seek(20);
+      WHEEL_CHECK(file.pos() == sizeof(bytes));
+
+      WHEEL_CHECK(file.view().subview(3, 2).equals("\x04\x05", 2));
+   }
+}
+
+int main(void)
+{
+   wheel::mapped_buffer file;
+
+   char path[] = "/tmp/wheel_mapped_XXXXXX";
+   int fd = mkstemp(path);
+   WHEEL_CHECK(fd >= 0);
+
+   if (fd >= 0)
+   {
+      WHEEL_CHECK(write(fd, bytes, sizeof(bytes)) == (ssize_t)sizeof(bytes));
+      close(fd);
+
+      WHEEL_CHECK(file.map(path, wheel::WHEEL_ADVICE_SEQUENTIAL) == WHEEL_OK);
+      WHEEL_CHECK(file.is_mapped());
+
+      check_reads(file);
+      remove(path);
+   }
+
+   WHEEL_CHECK(file.map("/nonexistent/wheel") != WHEEL_OK);
+   WHEEL_CHECK(file.empty() && !file.is_mapped());
+
+   // Contents that could not be mapped, behind the same interface
+   wheel::buffer_t contents;
+   contents.append(bytes, sizeof(bytes));
+
+   wheel::mapped_buffer copy;
+   copy.assign(std::move(contents));
+   WHEEL_CHECK(!copy.is_mapped());
+
+   check_reads(copy);
+
+   wheel::mapped_buffer moved(std::move(copy));
+   WHEEL_CHECK(moved.size() == sizeof(bytes) && copy.empty());
+
+   return WHEEL_TEST_RESULT();
+}
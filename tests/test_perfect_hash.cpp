@@ -0,0 +1,271 @@
+#include "test.h"
+
+#include <wheel_core_perfect_hash.h>
+#include <wheel_core_resource.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <set>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+// Builds perfect hash indices of random name sets of every width, finds
+// each name through every kind of view and rejects names outside the set,
+// duplicates and damaged blobs.  Then caches files with and without a
+// manifest, and moves them between the two with SetManifest().
+
+namespace
+{
+   uint32_t state = 0x3c6ef372;
+
+   uint32_t next_random()
+   {
+      state ^= state << 13;
+      state ^= state >> 17;
+      state ^= state << 5;
+
+      return state;
+   }
+
+   std::u32string random_name()
+   {
+      std::u32string rval(1 + next_random() % 16, U' ');
+
+      for (char32_t& c : rval)
+      {
+         switch (next_random() % 16)
+         {
+            case 0:  c = 0xc0 + next_random() % 0x40; break;
+            case 1:  c = 0x4e00 + next_random() % 0x100; break;
+            case 2:  c = 0x1f600 + next_random() % 0x40; break;
+            case 3:  c = U'/'; break;
+            default: c = U'a' + next_random() % 26; break;
+         }
+      }
+
+      return rval;
+   }
+
+   void check_index(size_t count)
+   {
+      std::set<std::u32string> unique;
+
+      while (unique.size() < count)
+         unique.insert(random_name());
+
+      std::vector<std::u32string> texts(unique.begin(), unique.end());
+      std::vector<wheel::string> names;
+
+      for (const std::u32string& text : texts)
+         names.push_back(wheel::string(text.c_str()));
+
+      wheel::buffer_t blob;
+      WHEEL_CHECK(wheel::build_perfect_index(names, blob) == WHEEL_OK);
+
+      // The same names give the same blob
+      wheel::buffer_t again;
+      WHEEL_CHECK(wheel::build_perfect_index(names, again) == WHEEL_OK && again == blob);
+
+      wheel::perfect_index index;
+      WHEEL_CHECK(index.assign(blob.data(), blob.size()) == WHEEL_OK);
+      WHEEL_CHECK(index.size() == count && index.data() == blob.data());
+
+      for (size_t i = 0; i < count; ++i)
+      {
+         WHEEL_CHECK(index.find(wheel::string_ref(names[i])) == i);
+         WHEEL_CHECK(index.name(i) == names[i]);
+
+         // Views wider than the stored names
+         WHEEL_CHECK(index.find(wheel::string_ref(texts[i].data(), texts[i].size())) == i);
+         WHEEL_CHECK(index.find(wheel::hashed_name(texts[i].data(), texts[i].size())) == i);
+
+         std::string utf8 = names[i].std_str();
+         WHEEL_CHECK(index.find(wheel::hashed_name(utf8.data(), utf8.size())) == i);
+      }
+
+      for (int i = 0; i < 200; ++i)
+      {
+         std::u32string text = random_name();
+
+         if (unique.count(text) == 0)
+            WHEEL_CHECK(index.find(wheel::string_ref(text.data(), text.size())) == wheel::perfect_index::npos);
+      }
+
+      WHEEL_CHECK(index.name(count) == wheel::string());
+
+      // A copy of an owned blob keeps working after the original is gone
+      wheel::perfect_index* owner = new wheel::perfect_index;
+      WHEEL_CHECK(owner->assign(std::move(again)) == WHEEL_OK);
+
+      wheel::perfect_index copy(*owner);
+      delete owner;
+
+      WHEEL_CHECK(copy.size() == count && copy.data() != blob.data());
+
+      for (size_t i = 0; i < count; ++i)
+         WHEEL_CHECK(copy.find(wheel::string_ref(names[i])) == i);
+   }
+
+   void check_damaged()
+   {
+      std::vector<wheel::string> names = { "a", "bb", wheel::string(U"\u4e2d"), "dddd" };
+
+      wheel::buffer_t blob;
+      WHEEL_CHECK(wheel::build_perfect_index(names, blob) == WHEEL_OK);
+
+      wheel::perfect_index index;
+
+      // Every shorter blob, and one with a byte too many
+      for (size_t length = 0; length < blob.size(); ++length)
+      {
+         WHEEL_CHECK(index.assign(blob.data(), length) == WHEEL_INVALID_FORMAT);
+         WHEEL_CHECK(index.empty() && index.data() == nullptr);
+         WHEEL_CHECK(index.find(wheel::string_ref(names[0])) == wheel::perfect_index::npos);
+      }
+
+      wheel::buffer_t longer = blob;
+      longer.push_back(0);
+      WHEEL_CHECK(index.assign(longer.data(), longer.size()) == WHEEL_INVALID_FORMAT);
+
+      wheel::buffer_t magic = blob;
+      magic[3] = '2';
+      WHEEL_CHECK(index.assign(magic.data(), magic.size()) == WHEEL_INVALID_FORMAT);
+
+      WHEEL_CHECK(index.assign(nullptr, 0) == WHEEL_INVALID_FORMAT);
+
+      // Duplicates, also of a string that was wider before
+      std::vector<wheel::string> twice = { "x", "y", "x" };
+      WHEEL_CHECK(wheel::build_perfect_index(twice, blob) == WHEEL_INVALID_VALUE);
+
+      wheel::string wide(U"\u4e2dy");
+      wide.set(0, U'y');
+      std::vector<wheel::string> widths = { "yy", wide };
+      WHEEL_CHECK(wheel::build_perfect_index(widths, blob) == WHEEL_INVALID_VALUE);
+
+      // An empty set finds nothing
+      WHEEL_CHECK(wheel::build_perfect_index(std::vector<wheel::string>(), blob) == WHEEL_OK);
+      WHEEL_CHECK(index.assign(blob.data(), blob.size()) == WHEEL_OK && index.empty());
+      WHEEL_CHECK(index.find(wheel::string_ref(names[0])) == wheel::perfect_index::npos);
+   }
+
+   wheel::buffer_t contents(const char* text)
+   {
+      wheel::buffer_t rval;
+      rval.append(text, strlen(text));
+
+      return rval;
+   }
+
+   bool holds(const wheel::buffer_t* buffer, const char* text)
+   {
+      return buffer != nullptr && buffer->size() > strlen(text) && memcmp(buffer->data(), text, strlen(text)) == 0;
+   }
+
+   wheel::perfect_index manifest_of(const std::vector<wheel::string>& names, wheel::buffer_t& blob)
+   {
+      wheel::perfect_index rval;
+
+      WHEEL_CHECK(wheel::build_perfect_index(names, blob) == WHEEL_OK);
+      WHEEL_CHECK(rval.assign(blob.data(), blob.size()) == WHEEL_OK);
+
+      return rval;
+   }
+
+   void check_manifest(const std::string& dir)
+   {
+      WHEEL_CHECK(wheel::SetWritePath(dir.c_str()) == WHEEL_OK);
+      WHEEL_CHECK(wheel::AddToPath(wheel::string(dir), wheel::string("/")) == WHEEL_OK);
+
+      WHEEL_CHECK(wheel::WriteBuffer("a.txt", contents("alpha")) == WHEEL_OK);
+      WHEEL_CHECK(wheel::WriteBuffer("b.txt", contents("bravo")) == WHEEL_OK);
+      WHEEL_CHECK(wheel::WriteBuffer("c.txt", contents("charlie")) == WHEEL_OK);
+      WHEEL_CHECK(wheel::WriteBuffer("d.txt", contents("alpha")) == WHEEL_OK);
+
+      // Cached before there is a manifest
+      WHEEL_CHECK(wheel::Buffer(wheel::string("a.txt")) == WHEEL_OK);
+      WHEEL_CHECK(wheel::Buffer(wheel::symbol("c.txt")) == WHEEL_OK);
+
+      wheel::buffer_t first_blob;
+      wheel::SetManifest(manifest_of({ "missing.txt", "a.txt", "b.txt" }, first_blob));
+
+      // a.txt moved to its slot, c.txt stayed where it was
+      WHEEL_CHECK(wheel::IsCached(wheel::string("a.txt")) && wheel::IsCached(wheel::symbol("a.txt")));
+      WHEEL_CHECK(wheel::IsCached(wheel::hashed_name("a.txt")) && holds(wheel::GetBuffer(wheel::hashed_name("a.txt")), "alpha"));
+      WHEEL_CHECK(wheel::IsCached(wheel::hashed_name("c.txt")) && holds(wheel::GetBuffer(wheel::hashed_name("c.txt")), "charlie"));
+      WHEEL_CHECK(!wheel::IsCached(wheel::hashed_name("b.txt")) && !wheel::IsCached(wheel::string("missing.txt")));
+
+      // Names that were never read are not cached, in the manifest or not
+      WHEEL_CHECK(!wheel::IsCached(wheel::hashed_name("d.txt")) && wheel::BufferSize(wheel::hashed_name("b.txt")) == 0);
+
+      WHEEL_CHECK(holds(wheel::GetBuffer(wheel::hashed_name("b.txt")), "bravo"));
+      WHEEL_CHECK(holds(wheel::GetBuffer(wheel::string("d.txt")), "alpha"));
+      WHEEL_CHECK(wheel::IsCached(wheel::symbol("b.txt")) && wheel::IsCached(wheel::string("d.txt")));
+      WHEEL_CHECK(wheel::BufferSize(wheel::symbol("b.txt")) == wheel::BufferSize(wheel::hashed_name("b.txt")));
+      WHEEL_CHECK(wheel::GetBuffer(wheel::hashed_name("missing.txt")) == nullptr);
+
+      // Equal contents, inside and outside the manifest, fingerprint alike
+      wheel::fingerprint_t fa, fb, fd;
+      WHEEL_CHECK(wheel::BufferFingerprint(wheel::string("a.txt"), fa) == WHEEL_OK);
+      WHEEL_CHECK(wheel::BufferFingerprint(wheel::symbol("b.txt"), fb) == WHEEL_OK);
+      WHEEL_CHECK(wheel::BufferFingerprint(wheel::string("d.txt"), fd) == WHEEL_OK);
+      WHEEL_CHECK(fa == fd && !(fa == fb));
+
+      // Deleting a file in the manifest leaves its slot empty
+      wheel::DeleteBuffer(wheel::hashed_name("a.txt"));
+      WHEEL_CHECK(!wheel::IsCached(wheel::hashed_name("a.txt")) && !wheel::IsCached(wheel::string("a.txt")));
+      WHEEL_CHECK(wheel::BufferFingerprint(wheel::string("a.txt"), fa) == WHEEL_RESOURCE_UNAVAILABLE);
+      WHEEL_CHECK(holds(wheel::GetBuffer(wheel::symbol("a.txt")), "alpha"));
+
+      // Another manifest moves the cached files between slots and the dynamic cache
+      wheel::buffer_t second_blob;
+      wheel::SetManifest(manifest_of({ "c.txt", "b.txt", "e.txt" }, second_blob));
+      first_blob.clear();
+
+      WHEEL_CHECK(holds(wheel::GetBuffer(wheel::hashed_name("a.txt")), "alpha"));
+      WHEEL_CHECK(holds(wheel::GetBuffer(wheel::hashed_name("b.txt")), "bravo"));
+      WHEEL_CHECK(holds(wheel::GetBuffer(wheel::string("c.txt")), "charlie"));
+      WHEEL_CHECK(holds(wheel::GetBuffer(wheel::symbol("d.txt")), "alpha"));
+      WHEEL_CHECK(!wheel::IsCached(wheel::hashed_name("e.txt")));
+
+      wheel::DeleteBuffer(wheel::string("a.txt"));
+      wheel::DeleteBuffer(wheel::symbol("c.txt"));
+      WHEEL_CHECK(!wheel::IsCached(wheel::hashed_name("a.txt")) && !wheel::IsCached(wheel::hashed_name("c.txt")));
+      WHEEL_CHECK(wheel::IsCached(wheel::hashed_name("b.txt")) && wheel::IsCached(wheel::hashed_name("d.txt")));
+
+      wheel::EmptyCache();
+      WHEEL_CHECK(!wheel::IsCached(wheel::hashed_name("b.txt")) && !wheel::IsCached(wheel::string("d.txt")));
+      WHEEL_CHECK(holds(wheel::GetBuffer(wheel::hashed_name("b.txt")), "bravo"));
+
+      wheel::SetManifest(wheel::perfect_index());
+      WHEEL_CHECK(holds(wheel::GetBuffer(wheel::hashed_name("b.txt")), "bravo"));
+
+      wheel::EmptyCache();
+   }
+}
+
+int main(int argc, char* argv[])
+{
+   static const size_t counts[] = { 1, 2, 3, 10, 100, 2000 };
+
+   for (size_t count : counts)
+      check_index(count);
+
+   check_damaged();
+
+   char dir[] = "/tmp/wheel_manifest_XXXXXX";
+   WHEEL_CHECK(mkdtemp(dir) != nullptr);
+   WHEEL_CHECK(wheel::Filesystem_Init(argc, argv) == WHEEL_OK);
+
+   check_manifest(dir);
+
+   wheel::Filesystem_Deinit();
+
+   for (const char* name : { "a.txt", "b.txt", "c.txt", "d.txt" })
+      remove((std::string(dir) + "/" + name).c_str());
+
+   rmdir(dir);
+
+   return WHEEL_TEST_RESULT();
+}
@@ -0,0 +1,161 @@
+#include "test.h"
+
+#include <wheel_core_rope.h>
+#include <wheel_core_string_builder.h>
+
+#include <cmath>
+#include <sstream>
+#include <string>
+
+// Appends to strings and string_builders, and edits ropes at random next
+// to a std::u32string that is edited the same way.
+
+namespace
+{
+   uint32_t state = 0x1b873593;
+
+   uint32_t next_random()
+   {
+      state ^= state << 13;
+      state ^= state >> 17;
+      state ^= state << 5;
+
+      return state;
+   }
+
+   std::u32string characters(const wheel::string& s)
+   {
+      std::u32string rval;
+
+      for (char32_t c : s)
+         rval.push_back(c);
+
+      return rval;
+   }
+
+   // Mostly ASCII, with some Cyrillic so that pieces have different widths
+   std::u32string random_piece(size_t length)
+   {
+      std::u32string rval;
+
+      for (size_t i = 0; i < length; ++i)
+         rval.push_back(next_random() % 3 ? (char32_t)('a' + next_random() % 26) : (char32_t)(0x400 + next_random() % 100));
+
+      return rval;
+   }
+
+   void check_append()
+   {
+      wheel::string s("abc");
+
+      // Appending a string, or a view of it, to itself
+      s += s;
+      WHEEL_CHECK(s == wheel::string("abcabc"));
+
+      s.append(wheel::string_ref(s).substr(1, 2));
+      WHEEL_CHECK(s == wheel::string("abcabcbc"));
+
+      s.append(U"\u20ac");
+      WHEEL_CHECK(s.char_width() == 2);
+
+      s.append("xy");
+      WHEEL_CHECK(s == wheel::string(U"abcabcbc\u20acxy"));
+
+      // A narrow part of a wide string appends without widening
+      wheel::string wide(U"a\u20ac");
+      wheel::string narrow("q");
+
+      narrow.append(wheel::string_ref(wide).substr(0, 1));
+      WHEEL_CHECK(narrow.char_width() == 1 && narrow == wheel::string("qa"));
+
+      narrow.append("\xc3\xa4\xf0\x9d\x84\x9e");
+      WHEEL_CHECK(narrow.char_width() == 4 && narrow == wheel::string(U"qa\u00e4\U0001d11e"));
+   }
+
+   void check_builder()
+   {
+      wheel::string_builder b;
+
+      b << "n=" << 42 << ' ' << (int64_t)-7 << U" \u20ac " << (uint64_t)18446744073709551615ull << " " << 1.5;
+      WHEEL_CHECK(b.str() == wheel::string(U"n=42 -7 \u20ac 18446744073709551615 1.5"));
+
+      b.append(U'-', 3);
+      WHEEL_CHECK(b.view().substr(b.length() - 3) == wheel::string_ref(U"---"));
+
+      size_t length = b.length();
+      wheel::string released = b.release();
+
+      WHEEL_CHECK(b.empty());
+      WHEEL_CHECK(released.length() == length);
+   }
+
+   void check_rope()
+   {
+      for (int round = 0; round < 200; ++round)
+      {
+         wheel::rope r;
+         std::u32string expected;
+
+         for (int step = 0; step < 300; ++step)
+         {
+            uint32_t op = next_random() % 4;
+
+            if (op < 2)
+            {
+               // Long and short pieces, at either end
+               std::u32string piece = random_piece(next_random() % (op ? 3 : 400));
+               wheel::string s(piece.c_str());
+
+               if (next_random() % 2)
+               {
+                  r += wheel::rope(s);
+                  expected += piece;
+               } else {
+                  r = wheel::rope(s) + r;
+                  expected = piece + expected;
+               }
+            } else if (op == 2 && !expected.empty()) {
+               size_t pos = next_random() % expected.size();
+               size_t length = next_random() % (expected.size() - pos + 1);
+
+               r = r.substr(pos, length);
+               expected = expected.substr(pos, length);
+            } else if (!expected.empty()) {
+               // Cut in two and joined again
+               size_t pos = next_random() % expected.size();
+
+               WHEEL_CHECK(r[pos] == expected[pos]);
+               r = r.substr(0, pos) + r.substr(pos);
+            }
+
+            WHEEL_CHECK(r.length() == expected.size());
+            WHEEL_CHECK(r.depth() <= 2 + 1.45 * std::log2((double)expected.size() + 2));
+         }
+
+         WHEEL_CHECK(characters(r.str()) == expected);
+
+         std::ostringstream out;
+         out << r;
+
+         WHEEL_CHECK(wheel::string(out.str()) == wheel::string(expected.c_str()));
+      }
+
+      // Appending one character at a time stays balanced
+      wheel::rope long_rope;
+
+      for (int i = 0; i < 100000; ++i)
+         long_rope += wheel::rope(wheel::string(U"x"));
+
+      WHEEL_CHECK(long_rope.length() == 100000);
+      WHEEL_CHECK(long_rope.depth() <= 2 + 1.45 * std::log2(100000.0 + 2));
+   }
+}
+
+int main(void)
+{
+   check_append();
+   check_builder();
+   check_rope();
+
+   return WHEEL_TEST_RESULT();
+}
@@ -0,0 +1,141 @@
+#include "test.h"
+
+#include <wheel_core_string.h>
+#include <wheel_core_string_ref.h>
+#include <wheel_core_search.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+// Checks the find family of wheel::string and wheel::searcher against a
+// plain search over std::u32string, on random texts that are stored at
+// every character width.
+
+namespace
+{
+   const size_t npos = wheel::string::npos;
+
+   uint32_t state = 0x2545f491;
+
+   uint32_t next_random()
+   {
+      state ^= state << 13;
+      state ^= state >> 17;
+      state ^= state << 5;
+
+      return state;
+   }
+
+   // A small alphabet, so that matches and near misses are common
+   std::u32string random_text(size_t length, const std::u32string& alphabet)
+   {
+      std::u32string rval;
+
+      for (size_t i = 0; i < length; ++i)
+         rval.push_back(alphabet[next_random() % alphabet.size()]);
+
+      return rval;
+   }
+
+   size_t naive_rfind(const std::u32string& text, const std::u32string& seq, size_t pos)
+   {
+      if (seq.size() > text.size())
+         return npos;
+
+      size_t start = std::min(pos, text.size() - seq.size());
+
+      for (size_t i = start + 1; i > 0; --i)
+         if (text.compare(i - 1, seq.size(), seq) == 0)
+            return i - 1;
+
+      return npos;
+   }
+
+   std::vector<size_t> naive_find_all(const std::u32string& text, const std::u32string& seq)
+   {
+      std::vector<size_t> rval;
+
+      if (seq.empty())
+         return rval;
+
+      for (size_t i = text.find(seq); i != std::u32string::npos; i = text.find(seq, i + seq.size()))
+         rval.push_back(i);
+
+      return rval;
+   }
+
+   void check_alphabet(const std::u32string& alphabet)
+   {
+      for (int round = 0; round < 300; ++round)
+      {
+         std::u32string text = random_text(next_random() % 200, alphabet);
+         std::u32string seq = random_text(1 + next_random() % 6, alphabet);
+
+         // Some needles are cut from the text so that they are found
+         if (round % 3 == 0 && text.size() > 8)
+            seq = text.substr(next_random() % (text.size() - 8), 1 + next_random() % 8);
+
+         wheel::string s(text.c_str());
+         wheel::string needle(seq.c_str());
+         std::string utf8 = needle.std_str();
+
+         size_t pos = text.empty() ? 0 : next_random() % (text.size() + 2);
+         size_t expected = text.find(seq, pos);
+
+         if (expected == std::u32string::npos)
+            expected = npos;
+
+         WHEEL_CHECK(s.find(needle, pos) == expected);
+         WHEEL_CHECK(s.find(utf8.c_str(), pos) == expected);
+         WHEEL_CHECK(wheel::searcher(needle).find(s, pos) == expected);
+
+         WHEEL_CHECK(s.rfind(needle, pos) == naive_rfind(text, seq, pos));
+         WHEEL_CHECK(s.rfind(utf8.c_str(), pos) == naive_rfind(text, seq, pos));
+         WHEEL_CHECK(s.rfind(needle) == naive_rfind(text, seq, npos));
+
+         WHEEL_CHECK(s.find_all(needle) == naive_find_all(text, seq));
+         WHEEL_CHECK(s.find_all(utf8.c_str()) == naive_find_all(text, seq));
+
+         size_t first_of = text.find_first_of(seq, pos);
+
+         if (first_of == std::u32string::npos)
+            first_of = npos;
+
+         WHEEL_CHECK(s.find_first_of(needle, pos) == first_of);
+         WHEEL_CHECK(s.find_first_of(utf8.c_str(), pos) == first_of);
+
+         WHEEL_CHECK(s.contains(utf8.c_str()) == (text.find(seq) != std::u32string::npos));
+      }
+   }
+}
+
+int main(void)
+{
+   check_alphabet(U"abc");
+   check_alphabet(U"ab\u00e4\u00f6");             // Latin-1, one byte per character
+   check_alphabet(U"a\u00e4\u4e2d\u6587");        // Two bytes
+   check_alphabet(U"a\u4e2d\U0001f600");          // Four bytes
+
+   // Needles longer than the decoding buffer on the stack
+   std::u32string long_seq = random_text(100, U"\u4e2d\u6587x");
+   std::u32string text = U"prefix " + long_seq + U" suffix";
+   wheel::string s(text.c_str());
+   std::string utf8 = wheel::string(long_seq.c_str()).std_str();
+
+   WHEEL_CHECK(s.find(utf8.c_str()) == 7);
+   WHEEL_CHECK(s.rfind(utf8.c_str()) == 7);
+   WHEEL_CHECK(s.compare((std::string("prefix ") + utf8 + " suffix").c_str()) == 0);
+
+   // Empty needles match where the search starts
+   WHEEL_CHECK(s.find("") == 0);
+   WHEEL_CHECK(s.find("", 3) == 3);
+   WHEEL_CHECK(s.find_all("").empty());
+   WHEEL_CHECK(s.find_first_of("") == npos);
+
+   // Invalid UTF-8 in a needle is searched as U+FFFD, as it would be stored
+   wheel::string replaced(U"a\ufffdb");
+   WHEEL_CHECK(replaced.find("\xff" "b") == 1);
+
+   return WHEEL_TEST_RESULT();
+}
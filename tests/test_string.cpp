@@ -0,0 +1,418 @@
+#include "test.h"
+
+#include <wheel_core_string.h>
+#include <wheel_core_string_ref.h>
+#include <wheel_core_symbol.h>
+
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Edits strings at random next to a std::u32string holding the same
+// characters, so the storage widens and narrows and moves between the
+// inline buffer and the heap.  Also checks UTF-8 decoding of invalid
+// input, ordering with compare() and sort keys, split() and symbols.
+
+namespace
+{
+   uint32_t state = 0x1b873593;
+
+   uint32_t next_random()
+   {
+      state ^= state << 13;
+      state ^= state >> 17;
+      state ^= state << 5;
+
+      return state;
+   }
+
+   //! A character of random width, never a surrogate
+   char32_t random_char()
+   {
+      switch (next_random() % 4)
+      {
+         case 0:  return U'a' + next_random() % 26;
+         case 1:  return 0x80 + next_random() % 0x80;
+         case 2:  return 0x100 + next_random() % (0xd800 - 0x100);
+         default: return 0x10000 + next_random() % 0x100000;
+      }
+   }
+
+   std::u32string random_text(size_t max_length)
+   {
+      std::u32string rval(next_random() % (max_length + 1), U' ');
+
+      for (char32_t& c : rval)
+         c = random_char();
+
+      return rval;
+   }
+
+   std::string to_utf8(const std::u32string& text)
+   {
+      std::string rval;
+
+      for (char32_t c : text)
+      {
+         if (c < 0x80)
+         {
+            rval += (char)c;
+         }
+         else if (c < 0x800)
+         {
+            rval += (char)(0xc0 | (c >> 6));
+            rval += (char)(0x80 | (c & 0x3f));
+         }
+         else if (c < 0x10000)
+         {
+            rval += (char)(0xe0 | (c >> 12));
+            rval += (char)(0x80 | ((c >> 6) & 0x3f));
+            rval += (char)(0x80 | (c & 0x3f));
+         }
+         else
+         {
+            rval += (char)(0xf0 | (c >> 18));
+            rval += (char)(0x80 | ((c >> 12) & 0x3f));
+            rval += (char)(0x80 | ((c >> 6) & 0x3f));
+            rval += (char)(0x80 | (c & 0x3f));
+         }
+      }
+
+      return rval;
+   }
+
+   bool same(const wheel::string& s, const std::u32string& expected)
+   {
+      if (s.length() != expected.size())
+         return false;
+
+      size_t needed = 1;
+
+      for (size_t i = 0; i < expected.size(); ++i)
+      {
+         if (s[i] != expected[i])
+            return false;
+
+         needed = std::max<size_t>(needed, expected[i] > 0xffff ? 4 : expected[i] > 0xff ? 2 : 1);
+      }
+
+      return s.char_width() >= needed && s.std_str() == to_utf8(expected);
+   }
+
+   int sign(int x)
+   {
+      return (x > 0) - (x < 0);
+   }
+
+   void check_random_edits()
+   {
+      wheel::string s;
+      std::u32string expected;
+
+      for (int step = 0; step < 20000; ++step)
+      {
+         switch (next_random() % 9)
+         {
+            case 0:
+            case 1:
+            {
+               char32_t c = random_char();
+
+               s.push_back(c);
+               expected.push_back(c);
+               break;
+            }
+
+            case 2:
+            {
+               if (expected.empty())
+                  break;
+
+               size_t pos = next_random() % expected.size();
+               char32_t c = random_char();
+
+               s.set(pos, c);
+               expected[pos] = c;
+               break;
+            }
+
+            case 3:
+            {
+               std::u32string piece = random_text(12);
+
+               s.append(wheel::string_ref(piece.data(), piece.size()));
+               expected += piece;
+               break;
+            }
+
+            case 4:
+            {
+               std::u32string piece = random_text(12);
+
+               s.append(to_utf8(piece).c_str());
+               expected += piece;
+               break;
+            }
+
+            case 5:
+            {
+               std::u32string piece = random_text(12);
+
+               s += wheel::string(piece.c_str());
+               expected += piece;
+               break;
+            }
+
+            case 6:
+            {
+               size_t pos = next_random() % (expected.size() + 1);
+               size_t n = next_random() % (expected.size() + 1);
+
+               s = s.substr(pos, n);
+               expected = expected.substr(pos, n);
+               break;
+            }
+
+            case 7:
+            {
+               // Copies and moves, between inline and heap storage
+               wheel::string copy(s);
+               WHEEL_CHECK(same(copy, expected) && copy == s);
+
+               wheel::string moved(std::move(copy));
+               s = moved;
+               s = std::move(moved);
+               break;
+            }
+
+            default:
+            {
+               // Appending a string to itself
+               if (expected.size() < 40)
+               {
+                  s.append(wheel::string_ref(s));
+                  expected += expected;
+               }
+
+               break;
+            }
+         }
+
+         if (expected.size() > 300 || next_random() % 200 == 0)
+         {
+            s.clear();
+            expected.clear();
+         }
+
+         WHEEL_CHECK(same(s, expected));
+         WHEEL_CHECK(s.capacity() >= s.length());
+      }
+
+      // Narrowing again once the wide characters are gone
+      wheel::string narrow("abc");
+      narrow.set(1, U'\U0001f600');
+      WHEEL_CHECK(narrow.char_width() == 4);
+      narrow.set(1, U'\u00e9');
+      WHEEL_CHECK(narrow.char_width() == 1 && same(narrow, U"a\u00e9c"));
+      WHEEL_CHECK(wheel::string(U"x\u4e2d\U0001f600").substr(0, 2).char_width() == 2);
+   }
+
+   void check_invalid_utf8()
+   {
+      struct case_t
+      {
+         const char*    utf8;
+         const char32_t* expected;
+      };
+
+      static const case_t cases[] =
+      {
+         { "\xe2\x82\xac", U"\u20ac" },
+         { "\xe2\x82", U"\ufffd" },                   // Truncated by the end
+         { "a\xf0\x9f\x98", U"a\ufffd" },
+         { "\xe2\x82z", U"\ufffdz" },                 // Cut short by another character
+         { "\xe2\x82\xe2\x82\xac", U"\ufffd\u20ac" },
+         { "\x80", U"\ufffd" },                       // Stray trail bytes
+         { "\x80\x80", U"\ufffd\ufffd" },
+         { "\xff", U"\ufffd" },
+         { "\xc0\xaf", U"\ufffd" },                   // Overlong
+         { "\xe0\x80\xaf", U"\ufffd" },
+         { "\xed\xa0\x80", U"\ufffd" },               // Surrogate
+         { "\xf4\x90\x80\x80", U"\ufffd" },           // Above U+10FFFF
+         { "x\xc3\xa9\xc3", U"x\u00e9\ufffd" },
+      };
+
+      for (const case_t& c : cases)
+      {
+         std::string utf8(c.utf8);
+         std::u32string expected(c.expected);
+
+         WHEEL_CHECK(same(wheel::string(utf8.c_str()), expected));
+
+         wheel::string appended("prefix");
+         appended.append(utf8.c_str(), utf8.size());
+         WHEEL_CHECK(same(appended, U"prefix" + expected));
+
+         // After a run of ASCII long enough for the vector loop
+         std::string ascii(40, 'q');
+         WHEEL_CHECK(same(wheel::string(ascii + utf8), std::u32string(40, U'q') + expected));
+
+         // Literal hashes decode the same way
+         WHEEL_CHECK(wheel::hash_literal(utf8.data(), utf8.size()) == wheel::hash_literal(expected.data(), expected.size()));
+      }
+   }
+
+   void check_ordering()
+   {
+      std::vector<std::u32string> texts;
+      std::vector<wheel::string> strings;
+
+      for (int i = 0; i < 400; ++i)
+      {
+         std::u32string text = random_text(10);
+
+         // Shared prefixes, also longer than a sort key's packed prefix
+         if (!texts.empty() && next_random() % 3 == 0)
+            text = texts[next_random() % texts.size()].substr(0, next_random() % 12) + text.substr(0, next_random() % 3);
+
+         texts.push_back(text);
+         strings.push_back(wheel::string(text.c_str()));
+      }
+
+      for (int i = 0; i < 5000; ++i)
+      {
+         size_t a = next_random() % texts.size();
+         size_t b = next_random() % texts.size();
+
+         int expected = sign(texts[a].compare(texts[b]));
+
+         WHEEL_CHECK(sign(strings[a].compare(strings[b])) == expected);
+         WHEEL_CHECK((strings[a] < strings[b]) == (expected < 0));
+         WHEEL_CHECK((strings[a] == strings[b]) == (expected == 0));
+         WHEEL_CHECK(sign(wheel::sort_key(strings[a]).compare(wheel::sort_key(strings[b]))) == expected);
+      }
+
+      std::sort(texts.begin(), texts.end());
+      wheel::sort_strings(strings);
+
+      for (size_t i = 0; i < texts.size(); ++i)
+         WHEEL_CHECK(same(strings[i], texts[i]));
+
+      // Equal characters in different widths
+      wheel::string wide(U"ab\u4e2d");
+      wide.set(2, U'c');
+      WHEEL_CHECK(wide.compare("abc") == 0 && wide.compare("abd") < 0 && wide.compare("ab") > 0);
+   }
+
+   void check_split()
+   {
+      const std::u32string delim = U" ,\u3000";
+
+      for (int round = 0; round < 500; ++round)
+      {
+         std::u32string text = random_text(30);
+
+         for (char32_t& c : text)
+            if (next_random() % 4 == 0)
+               c = delim[next_random() % delim.size()];
+
+         // Tokens are the runs between delimiters, empty ones dropped
+         std::vector<std::u32string> expected;
+         std::u32string token;
+
+         for (char32_t c : text + delim[0])
+         {
+            if (delim.find(c) == std::u32string::npos)
+            {
+               token += c;
+            }
+            else if (!token.empty())
+            {
+               expected.push_back(token);
+               token.clear();
+            }
+         }
+
+         wheel::string s(text.c_str());
+         std::vector<wheel::string_ref> views = wheel::string_ref(s).split(wheel::string_ref(delim.data(), delim.size()));
+         std::vector<wheel::string> copies = s.split(wheel::string(delim.c_str()));
+
+         WHEEL_CHECK(views.size() == expected.size() && copies.size() == expected.size());
+
+         for (size_t i = 0; i < std::min(views.size(), expected.size()); ++i)
+         {
+            WHEEL_CHECK(views[i] == wheel::string_ref(expected[i].data(), expected[i].size()));
+            WHEEL_CHECK(i >= copies.size() || same(copies[i], expected[i]));
+
+            // Views point into the string
+            const uint8_t* begin = (const uint8_t*)s.raw_data();
+            const uint8_t* view = (const uint8_t*)views[i].raw_data();
+            WHEEL_CHECK(view >= begin && view < begin + s.length() * s.char_width());
+         }
+      }
+
+      WHEEL_CHECK(wheel::string_ref(U"  \n\t ").split().empty());
+      WHEEL_CHECK(wheel::string_ref(U"one").split().size() == 1);
+   }
+
+   void check_symbols()
+   {
+      size_t before = wheel::symbol::table_size();
+
+      wheel::symbol found;
+      WHEEL_CHECK(!wheel::symbol::find(wheel::string("test.symbol"), found));
+
+      wheel::symbol a("test.symbol");
+      wheel::symbol b(wheel::string(U"test.symbol"));
+      wheel::symbol c(wheel::hashed_name("test.symbol"));
+      wheel::symbol other("test.symbol2");
+
+      // One entry for equal strings, compared by pointer
+      WHEEL_CHECK(a == b && a == c && a != other);
+      WHEEL_CHECK(a.c_str() == b.c_str() && std::string(a.c_str()) == "test.symbol");
+      WHEEL_CHECK(wheel::symbol::table_size() == before + 2);
+
+      WHEEL_CHECK(a.hash() == wheel::Hash<wheel::string>()(wheel::string("test.symbol")));
+      WHEEL_CHECK(a.hash() == wheel::hashed_name("test.symbol").hash());
+
+      WHEEL_CHECK(wheel::symbol::find(wheel::string("test.symbol"), found) && found == a);
+      WHEEL_CHECK(wheel::symbol::find(wheel::hashed_name("test.symbol2"), found) && found == other);
+      WHEEL_CHECK(!wheel::symbol::find(wheel::hashed_name("test.symbol3"), found));
+
+      WHEEL_CHECK(wheel::symbol("") == wheel::symbol() && wheel::symbol().empty());
+      WHEEL_CHECK(wheel::symbol::table_size() == before + 2);
+
+      // Threads interning the same names get the same entries
+      std::vector<std::thread> threads;
+      std::vector<std::vector<wheel::symbol>> results(4);
+
+      for (size_t t = 0; t < results.size(); ++t)
+      {
+         threads.emplace_back([&results, t]
+         {
+            for (int i = 0; i < 200; ++i)
+               results[t].push_back(wheel::symbol(wheel::string("thread.") + wheel::string((int32_t)i)));
+         });
+      }
+
+      for (std::thread& t : threads)
+         t.join();
+
+      for (size_t t = 1; t < results.size(); ++t)
+         WHEEL_CHECK(results[t] == results[0]);
+
+      WHEEL_CHECK(wheel::symbol::table_size() == before + 202);
+   }
+}
+
+int main(void)
+{
+   check_random_edits();
+   check_invalid_utf8();
+   check_ordering();
+   check_split();
+   check_symbols();
+
+   return WHEEL_TEST_RESULT();
+}